@@ -0,0 +1,246 @@
+#pragma once
+#include "JobSystem.h"
+#include <algorithm>
+#include <assert.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// フレームの間だけ使う一時的なメモリと、同じ大きさの物を何度も確保・解放するためのプール
+// どちらも std::pmr::memory_resource なので、std::pmr::vector などの確保先にもできる
+//
+//   frameArena.Reset();  // Novice::BeginFrame の直後
+//   LinearArena& arena = frameArena.GetThreadArena();  // 今のスレッドのサブアリーナ
+//   std::pmr::vector<CollisionPair> pairs(&arena);
+//   bvh.QueryOverlapPairs(pairs);
+//
+// アリーナの中身はデストラクタを呼ばずに捨てるので、置くのはトリビアルに破棄できる型だけにする
+
+
+//=====================================  線形アリーナ  ============================================
+// 確保は先頭からずらしていくだけで、解放は Reset でまとめて行う
+// 足りなくなったら追加のブロックを確保し、次の Reset で全体が1つのブロックに収まるように広げ直す
+// (数フレームで必要な大きさに落ち着き、それ以降はヒープから確保しない)
+
+class LinearArena : public std::pmr::memory_resource {
+public:
+	explicit LinearArena(size_t capacity = 64 * 1024) { Grow(capacity); }
+
+	LinearArena(const LinearArena&) = delete;
+	LinearArena& operator=(const LinearArena&) = delete;
+
+	// 初期化されていない count 個分の領域
+	template <typename T>
+	T* AllocateArray(size_t count) {
+		static_assert(std::is_trivially_destructible_v<T>, "アリーナにはデストラクタの要らない型だけを置く");
+		return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	// 全て解放する。前回までに溢れていれば、使った量の最大が1ブロックに収まるように確保し直す
+	// (境界をそろえる隙間はブロックの切れ目で変わるので、1/4 ほど余裕を持たせる)
+	void Reset() {
+		if (blocks_.size() > 1) {
+			size_t capacity = peak_ + peak_ / 4;
+			blocks_.clear();
+			capacity_ = 0;
+			Grow(capacity);
+		}
+		offset_ = 0;
+		used_ = 0;
+	}
+
+	size_t GetUsed() const { return used_; }        //!< Reset してから確保した量
+	size_t GetPeak() const { return peak_; }        //!< これまでで一番多く使った量
+	size_t GetCapacity() const { return capacity_; }  //!< 確保済みのブロックの合計
+	uint32_t GetBlockCount() const { return uint32_t(blocks_.size()); }
+
+private:
+	struct Block {
+		std::unique_ptr<std::byte[]> memory;
+		size_t size;
+	};
+
+	void Grow(size_t minimum) {
+		size_t size = (std::max)(minimum, blocks_.empty() ? size_t(0) : blocks_.back().size * 2);
+		blocks_.push_back({ std::make_unique<std::byte[]>(size), size });
+		capacity_ += size;
+		offset_ = 0;
+	}
+
+	// ブロックの offset 以降で alignment にそろった位置
+	static size_t AlignedOffset(const Block& block, size_t offset, size_t alignment) {
+		uintptr_t base = reinterpret_cast<uintptr_t>(block.memory.get());
+		return size_t(((base + offset + alignment - 1) & ~uintptr_t(alignment - 1)) - base);
+	}
+
+	void* do_allocate(size_t bytes, size_t alignment) override {
+		size_t begin = AlignedOffset(blocks_.back(), offset_, alignment);
+		if (begin + bytes > blocks_.back().size) {
+			Grow(bytes + alignment);
+			begin = AlignedOffset(blocks_.back(), 0, alignment);
+		}
+		// 境界をそろえるための隙間も使った量に含める (Reset で1ブロックに収めるため)
+		used_ += begin - offset_ + bytes;
+		offset_ = begin + bytes;
+		peak_ = (std::max)(peak_, used_);
+		return blocks_.back().memory.get() + begin;
+	}
+
+	// 個別には解放しない (Reset でまとめて解放する)
+	void do_deallocate(void*, size_t, size_t) override {}
+
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+	std::vector<Block> blocks_;
+	size_t offset_ = 0;  //!< 最後のブロックの使用済みの位置
+	size_t used_ = 0;
+	size_t peak_ = 0;
+	size_t capacity_ = 0;
+};
+
+//=================================================================================================
+
+
+//===================================  フレームアリーナ  ===========================================
+// スレッドごとに1つの LinearArena (サブアリーナ) を持ち、ジョブからはロックなしで確保できる
+// JobSystem のスレッドごとに1つ (メインスレッドとワーカー以外からは使えない)
+
+class FrameArena {
+public:
+	explicit FrameArena(const JobSystem& jobSystem, size_t capacityPerThread = 64 * 1024) : jobSystem_(&jobSystem) {
+		for (uint32_t i = 0; i < jobSystem.GetThreadCount(); ++i) {
+			arenas_.push_back(std::make_unique<LinearArena>(capacityPerThread));
+		}
+	}
+
+	// 今のスレッドのサブアリーナ。jobSystem のメインスレッドかワーカーから呼ぶ
+	LinearArena& GetThreadArena() {
+		assert(jobSystem_->IsOwnThread());
+		return *arenas_[JobSystem::GetThreadIndex()];
+	}
+
+	// 毎フレームの最初 (Novice::BeginFrame の直後) に呼ぶ。前のフレームで確保した物は全て使えなくなる
+	void Reset() {
+		for (const std::unique_ptr<LinearArena>& arena : arenas_) {
+			arena->Reset();
+		}
+	}
+
+	size_t GetUsed() const {
+		size_t used = 0;
+		for (const std::unique_ptr<LinearArena>& arena : arenas_) {
+			used += arena->GetUsed();
+		}
+		return used;
+	}
+
+private:
+	const JobSystem* jobSystem_;
+	std::vector<std::unique_ptr<LinearArena>> arenas_;
+};
+
+//=================================================================================================
+
+
+//=====================================  固定サイズのプール  ======================================
+// blockSize 以下の確保を、解放された領域のリスト (フリーリスト) から返す
+// まとめて確保したチャンクから切り出すので、何度確保・解放してもヒープは増えない
+// blockSize より大きい確保 (std::pmr::unordered_set のバケット配列など) は upstream に回す
+// スレッドセーフではない (1つの入れ物から使う)
+
+class FixedBlockPool : public std::pmr::memory_resource {
+public:
+	explicit FixedBlockPool(size_t blockSize, size_t blocksPerChunk = 256, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+		: blockSize_(RoundUp((std::max)(blockSize, sizeof(FreeBlock)), alignof(std::max_align_t))), blocksPerChunk_(blocksPerChunk), upstream_(upstream) {}
+
+	FixedBlockPool(const FixedBlockPool&) = delete;
+	FixedBlockPool& operator=(const FixedBlockPool&) = delete;
+
+	size_t GetBlockSize() const { return blockSize_; }
+	size_t GetAllocatedCount() const { return allocatedCount_; }  //!< 今使われているブロックの数
+	uint32_t GetChunkCount() const { return uint32_t(chunks_.size()); }
+
+private:
+	struct FreeBlock {
+		FreeBlock* next;
+	};
+
+	static size_t RoundUp(size_t value, size_t alignment) { return (value + alignment - 1) / alignment * alignment; }
+
+	bool Fits(size_t bytes, size_t alignment) const { return bytes <= blockSize_ && alignment <= alignof(std::max_align_t); }
+
+	void AddChunk() {
+		chunks_.push_back(std::make_unique<std::byte[]>(blockSize_ * blocksPerChunk_));
+		std::byte* chunk = chunks_.back().get();
+		for (size_t i = blocksPerChunk_; i > 0; --i) {
+			FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + (i - 1) * blockSize_);
+			block->next = freeList_;
+			freeList_ = block;
+		}
+	}
+
+	void* do_allocate(size_t bytes, size_t alignment) override {
+		if (!Fits(bytes, alignment)) {
+			return upstream_->allocate(bytes, alignment);
+		}
+		if (freeList_ == nullptr) {
+			AddChunk();
+		}
+		FreeBlock* block = freeList_;
+		freeList_ = block->next;
+		++allocatedCount_;
+		return block;
+	}
+
+	void do_deallocate(void* pointer, size_t bytes, size_t alignment) override {
+		if (!Fits(bytes, alignment)) {
+			upstream_->deallocate(pointer, bytes, alignment);
+			return;
+		}
+		FreeBlock* block = static_cast<FreeBlock*>(pointer);
+		block->next = freeList_;
+		freeList_ = block;
+		--allocatedCount_;
+	}
+
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+	size_t blockSize_;
+	size_t blocksPerChunk_;
+	std::pmr::memory_resource* upstream_;
+	std::vector<std::unique_ptr<std::byte[]>> chunks_;
+	FreeBlock* freeList_ = nullptr;
+	size_t allocatedCount_ = 0;
+};
+
+// T を1つずつ作る・壊すためのプール (木のノードなど)
+template <typename T>
+class ObjectPool {
+public:
+	explicit ObjectPool(size_t objectsPerChunk = 256) : pool_(sizeof(T), objectsPerChunk) {
+		static_assert(alignof(T) <= alignof(std::max_align_t), "プールのブロックより大きい境界は扱えない");
+	}
+
+	template <typename... Args>
+	T* Create(Args&&... args) {
+		void* memory = pool_.allocate(sizeof(T), alignof(T));
+		return new (memory) T(std::forward<Args>(args)...);
+	}
+
+	void Destroy(T* object) {
+		object->~T();
+		pool_.deallocate(object, sizeof(T), alignof(T));
+	}
+
+	size_t GetAliveCount() const { return pool_.GetAllocatedCount(); }
+
+private:
+	FixedBlockPool pool_;
+};
+
+//=================================================================================================
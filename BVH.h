@@ -0,0 +1,539 @@
+#pragma once
+#include "Geometry.h"
+#include "Profiler.h"
+#include <assert.h>
+#include <vector>
+#include <memory_resource>
+#include <cstddef>
+#include <cstdint>
+
+// AABB / Sphere / Triangle をまとめる境界ボリューム階層 (Bounding Volume Hierarchy)
+// 木はAABBだけで作り、各プリミティブの詳細な判定は MyMath.h の衝突判定関数で行う
+
+struct BVHNode {
+	AABB bounds;         //!< このノード以下を囲むAABB
+	uint32_t leftFirst;  //!< 内部ノード: 左の子の番号(右の子は+1) / 葉: indices_ の開始位置
+	uint32_t count;      //!< 葉のプリミティブ数 (0なら内部ノード)
+};
+
+
+//====================================  AABBの表面積  ==============================================
+inline float SurfaceArea(const AABB& aabb) {
+	float x = aabb.max.x - aabb.min.x;
+	float y = aabb.max.y - aabb.min.y;
+	float z = aabb.max.z - aabb.min.z;
+	return 2.0f * (x * y + y * z + z * x);
+}
+//=================================================================================================
+
+//=========================  線分とAABBの判定 (逆数を事前計算したスラブ法)  ===========================
+// invDiff は segment.diff の各成分の逆数。t が [0, 1] の範囲で交わるかを調べる
+inline bool IntersectSegmentAABB(const Vector3& origin, const Vector3& invDiff, const AABB& aabb) {
+	float tx0 = (aabb.min.x - origin.x) * invDiff.x;
+	float tx1 = (aabb.max.x - origin.x) * invDiff.x;
+	float ty0 = (aabb.min.y - origin.y) * invDiff.y;
+	float ty1 = (aabb.max.y - origin.y) * invDiff.y;
+	float tz0 = (aabb.min.z - origin.z) * invDiff.z;
+	float tz1 = (aabb.max.z - origin.z) * invDiff.z;
+
+	// 軸に平行な線分が面の上から始まるときの NaN は SlabNear / SlabFar で除く
+	float tmin = (std::max)((std::max)(SlabNear(tx0, tx1), SlabNear(ty0, ty1)), (std::max)(SlabNear(tz0, tz1), 0.0f));
+	float tmax = (std::min)((std::min)(SlabFar(tx0, tx1), SlabFar(ty0, ty1)), (std::min)(SlabFar(tz0, tz1), 1.0f));
+	return tmin <= tmax;
+}
+//=================================================================================================
+
+
+class BVH {
+public:
+	// 葉に入れるプリミティブの最大数
+	static const uint32_t kMaxLeafSize = 4;
+	// SAHで分割位置を探すときのビンの数
+	static const uint32_t kBinCount = 12;
+	// 探索中のスタックに使うスタック上のバッファ (普通の深さならヒープから確保しない。溢れたらヒープを使う)
+	static const size_t kQueryStackBytes = 2048;
+
+	// 各プリミティブのAABBから木を作り直す
+	// 作業用の配列はメンバーに残しておくので、2回目以降は数が増えたときしか確保しない
+	void Build(const AABB* bounds, uint32_t count);
+	// boundsOf(i) が i 番のプリミティブのAABBを返す版 (球や三角形からAABBの一時配列を作らずに済む)
+	template <typename BoundsOf>
+	void Build(uint32_t count, BoundsOf&& boundsOf);
+
+	// 木の形はそのままで、動いたプリミティブのAABBに合わせて各ノードを更新する (メモリは確保しない)
+	// bounds は Build と同じ数・同じ順番で渡す
+	void Refit(const AABB* bounds);
+	template <typename BoundsOf>
+	void Refit(BoundsOf&& boundsOf);
+
+	// AABBが重なっているプリミティブの組を列挙する
+	template <typename Callback>
+	void QueryOverlapPairs(Callback&& callback) const;
+	template <typename Allocator>
+	void QueryOverlapPairs(std::vector<CollisionPair, Allocator>& pairs) const;
+
+	// aabb と重なるプリミティブを列挙する
+	template <typename Callback>
+	void QueryAABB(const AABB& aabb, Callback&& callback) const;
+
+	// 線分がAABBを通過するプリミティブを列挙する。callback が false を返すと打ち切る
+	template <typename Callback>
+	void QuerySegment(const Segment& segment, Callback&& callback) const;
+
+	// 球を move だけ動かしたときに通過しうるプリミティブを列挙する。callback が false を返すと打ち切る
+	template <typename Callback>
+	void QuerySphereSweep(const Sphere& sphere, const Vector3& move, Callback&& callback) const;
+
+	const std::vector<BVHNode>& GetNodes() const { return nodes_; }
+	uint32_t GetPrimitiveCount() const { return uint32_t(indices_.size()); }
+
+private:
+	void BuildNodes();
+	void RefitNodes();
+	void Subdivide(uint32_t nodeIndex);
+	AABB CalculateLeafBounds(const BVHNode& node) const;
+
+	std::vector<BVHNode> nodes_;     //!< nodes_[0] が根
+	std::vector<uint32_t> indices_;  //!< 葉が参照するプリミティブ番号
+	std::vector<AABB> bounds_;       //!< 各プリミティブのAABB (プリミティブ番号順)
+	std::vector<Vector3> centroids_; //!< Build で使う各AABBの中心 (作業用)
+};
+
+
+//=======================================  木の構築  ==============================================
+inline void BVH::Build(const AABB* bounds, uint32_t count) {
+	Build(count, [bounds](uint32_t i) { return bounds[i]; });
+}
+
+template <typename BoundsOf>
+void BVH::Build(uint32_t count, BoundsOf&& boundsOf) {
+	MT3_PROFILE_ZONE("BVH::Build");
+	bounds_.resize(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		bounds_[i] = boundsOf(i);
+	}
+	BuildNodes();
+}
+
+// bounds_ から木を作る
+inline void BVH::BuildNodes() {
+	uint32_t count = uint32_t(bounds_.size());
+	nodes_.clear();
+	indices_.resize(count);
+	if (count == 0) {
+		return;
+	}
+
+	centroids_.resize(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		indices_[i] = i;
+		centroids_[i] = {
+			(bounds_[i].min.x + bounds_[i].max.x) * 0.5f,
+			(bounds_[i].min.y + bounds_[i].max.y) * 0.5f,
+			(bounds_[i].min.z + bounds_[i].max.z) * 0.5f,
+		};
+	}
+
+	// ノードは最大で 2 * count - 1 個
+	nodes_.reserve(count * 2);
+	nodes_.push_back({ {}, 0, count });
+	nodes_[0].bounds = CalculateLeafBounds(nodes_[0]);
+	Subdivide(0);
+}
+
+inline AABB BVH::CalculateLeafBounds(const BVHNode& node) const {
+	AABB result = bounds_[indices_[node.leftFirst]];
+	for (uint32_t i = 1; i < node.count; ++i) {
+		result = MergeAABB(result, bounds_[indices_[node.leftFirst + i]]);
+	}
+	return result;
+}
+
+// ビン分割のSAH (Surface Area Heuristic) で分割位置を決め、子ノードを作る
+inline void BVH::Subdivide(uint32_t nodeIndex) {
+	const std::vector<Vector3>& centroids = centroids_;
+	BVHNode node = nodes_[nodeIndex];
+	if (node.count <= kMaxLeafSize) {
+		return;
+	}
+
+	// 重心の範囲
+	AABB centroidBounds = { centroids[indices_[node.leftFirst]], centroids[indices_[node.leftFirst]] };
+	for (uint32_t i = 1; i < node.count; ++i) {
+		const Vector3& c = centroids[indices_[node.leftFirst + i]];
+		centroidBounds = MergeAABB(centroidBounds, { c, c });
+	}
+
+	struct Bin {
+		AABB bounds;
+		uint32_t count;
+	};
+
+	float bestCost = SurfaceArea(node.bounds) * float(node.count);  // 分割しない場合のコスト
+	int bestAxis = -1;
+	uint32_t bestSplit = 0;
+
+	for (int axis = 0; axis < 3; ++axis) {
+		float axisMin = (&centroidBounds.min.x)[axis];
+		float axisMax = (&centroidBounds.max.x)[axis];
+		if (axisMax <= axisMin) {
+			continue;
+		}
+		float scale = float(kBinCount) / (axisMax - axisMin);
+
+		Bin bins[kBinCount] = {};
+		for (uint32_t i = 0; i < node.count; ++i) {
+			uint32_t primitive = indices_[node.leftFirst + i];
+			uint32_t binIndex = (std::min)(kBinCount - 1, uint32_t(((&centroids[primitive].x)[axis] - axisMin) * scale));
+			bins[binIndex].bounds = (bins[binIndex].count == 0) ? bounds_[primitive] : MergeAABB(bins[binIndex].bounds, bounds_[primitive]);
+			bins[binIndex].count++;
+		}
+
+		// 左から/右から累積した面積と数
+		float leftArea[kBinCount - 1];
+		uint32_t leftCount[kBinCount - 1];
+		AABB accumulated = {};
+		uint32_t accumulatedCount = 0;
+		for (uint32_t i = 0; i < kBinCount - 1; ++i) {
+			if (bins[i].count > 0) {
+				accumulated = (accumulatedCount == 0) ? bins[i].bounds : MergeAABB(accumulated, bins[i].bounds);
+				accumulatedCount += bins[i].count;
+			}
+			leftArea[i] = (accumulatedCount > 0) ? SurfaceArea(accumulated) : 0.0f;
+			leftCount[i] = accumulatedCount;
+		}
+		accumulatedCount = 0;
+		for (uint32_t i = kBinCount - 1; i > 0; --i) {
+			if (bins[i].count > 0) {
+				accumulated = (accumulatedCount == 0) ? bins[i].bounds : MergeAABB(accumulated, bins[i].bounds);
+				accumulatedCount += bins[i].count;
+			}
+			if (leftCount[i - 1] == 0 || accumulatedCount == 0) {
+				continue;
+			}
+			float cost = leftArea[i - 1] * float(leftCount[i - 1]) + SurfaceArea(accumulated) * float(accumulatedCount);
+			if (cost < bestCost) {
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = i;
+			}
+		}
+	}
+
+	if (bestAxis < 0) {
+		return;
+	}
+
+	// 分割位置より左のビンに入るものを前に集める
+	float axisMin = (&centroidBounds.min.x)[bestAxis];
+	float scale = float(kBinCount) / ((&centroidBounds.max.x)[bestAxis] - axisMin);
+	uint32_t* first = indices_.data() + node.leftFirst;
+	uint32_t* middle = std::partition(first, first + node.count, [&](uint32_t primitive) {
+		uint32_t binIndex = (std::min)(kBinCount - 1, uint32_t(((&centroids[primitive].x)[bestAxis] - axisMin) * scale));
+		return binIndex < bestSplit;
+	});
+	uint32_t leftCount = uint32_t(middle - first);
+
+	uint32_t leftIndex = uint32_t(nodes_.size());
+	nodes_.push_back({ {}, node.leftFirst, leftCount });
+	nodes_.push_back({ {}, node.leftFirst + leftCount, node.count - leftCount });
+	nodes_[leftIndex].bounds = CalculateLeafBounds(nodes_[leftIndex]);
+	nodes_[leftIndex + 1].bounds = CalculateLeafBounds(nodes_[leftIndex + 1]);
+	nodes_[nodeIndex].leftFirst = leftIndex;
+	nodes_[nodeIndex].count = 0;
+
+	Subdivide(leftIndex);
+	Subdivide(leftIndex + 1);
+}
+//=================================================================================================
+
+//=======================================  木の更新  ==============================================
+inline void BVH::Refit(const AABB* bounds) {
+	Refit([bounds](uint32_t i) { return bounds[i]; });
+}
+
+template <typename BoundsOf>
+void BVH::Refit(BoundsOf&& boundsOf) {
+	MT3_PROFILE_ZONE("BVH::Refit");
+	for (uint32_t i = 0; i < uint32_t(bounds_.size()); ++i) {
+		bounds_[i] = boundsOf(i);
+	}
+	RefitNodes();
+}
+
+inline void BVH::RefitNodes() {
+	// 子ノードは必ず親より後ろにあるので、後ろから更新すれば子が先に終わっている
+	for (uint32_t i = uint32_t(nodes_.size()); i-- > 0;) {
+		BVHNode& node = nodes_[i];
+		if (node.count > 0) {
+			node.bounds = CalculateLeafBounds(node);
+		}
+		else {
+			node.bounds = MergeAABB(nodes_[node.leftFirst].bounds, nodes_[node.leftFirst + 1].bounds);
+		}
+	}
+}
+//=================================================================================================
+
+//====================================  重なっている組の列挙  =======================================
+template <typename Callback>
+void BVH::QueryOverlapPairs(Callback&& callback) const {
+	if (nodes_.empty()) {
+		return;
+	}
+
+	struct NodePair {
+		uint32_t a;
+		uint32_t b;
+	};
+	std::byte stackBuffer[kQueryStackBytes];
+	std::pmr::monotonic_buffer_resource stackResource(stackBuffer, sizeof(stackBuffer));
+	std::pmr::vector<NodePair> stack(&stackResource);
+	stack.reserve(kQueryStackBytes / 2 / sizeof(NodePair));
+	stack.push_back({ 0, 0 });
+
+	auto emit = [&](uint32_t p, uint32_t q) {
+		callback((std::min)(p, q), (std::max)(p, q));
+	};
+
+	while (!stack.empty()) {
+		NodePair pair = stack.back();
+		stack.pop_back();
+		const BVHNode& a = nodes_[pair.a];
+		const BVHNode& b = nodes_[pair.b];
+
+		if (pair.a == pair.b) {
+			// 同じノード内の組
+			if (a.count > 0) {
+				for (uint32_t i = 0; i < a.count; ++i) {
+					for (uint32_t j = i + 1; j < a.count; ++j) {
+						uint32_t p = indices_[a.leftFirst + i];
+						uint32_t q = indices_[a.leftFirst + j];
+						if (isCollisionAABB(bounds_[p], bounds_[q])) {
+							emit(p, q);
+						}
+					}
+				}
+			}
+			else {
+				stack.push_back({ a.leftFirst, a.leftFirst });
+				stack.push_back({ a.leftFirst + 1, a.leftFirst + 1 });
+				stack.push_back({ a.leftFirst, a.leftFirst + 1 });
+			}
+			continue;
+		}
+
+		if (!isCollisionAABB(a.bounds, b.bounds)) {
+			continue;
+		}
+
+		if (a.count > 0 && b.count > 0) {
+			for (uint32_t i = 0; i < a.count; ++i) {
+				for (uint32_t j = 0; j < b.count; ++j) {
+					uint32_t p = indices_[a.leftFirst + i];
+					uint32_t q = indices_[b.leftFirst + j];
+					if (isCollisionAABB(bounds_[p], bounds_[q])) {
+						emit(p, q);
+					}
+				}
+			}
+		}
+		else if (b.count > 0 || (a.count == 0 && SurfaceArea(a.bounds) >= SurfaceArea(b.bounds))) {
+			// 大きい方(内部ノードの方)を降りる
+			stack.push_back({ a.leftFirst, pair.b });
+			stack.push_back({ a.leftFirst + 1, pair.b });
+		}
+		else {
+			stack.push_back({ pair.a, b.leftFirst });
+			stack.push_back({ pair.a, b.leftFirst + 1 });
+		}
+	}
+}
+
+template <typename Allocator>
+inline void BVH::QueryOverlapPairs(std::vector<CollisionPair, Allocator>& pairs) const {
+	MT3_PROFILE_ZONE("BVH::QueryOverlapPairs");
+	QueryOverlapPairs([&](uint32_t a, uint32_t b) {
+		pairs.push_back({ a, b });
+	});
+}
+//=================================================================================================
+
+//=====================================  AABBとの重なり  ===========================================
+template <typename Callback>
+void BVH::QueryAABB(const AABB& aabb, Callback&& callback) const {
+	if (nodes_.empty()) {
+		return;
+	}
+
+	std::byte stackBuffer[kQueryStackBytes];
+	std::pmr::monotonic_buffer_resource stackResource(stackBuffer, sizeof(stackBuffer));
+	std::pmr::vector<uint32_t> stack(&stackResource);
+	stack.reserve(kQueryStackBytes / 2 / sizeof(uint32_t));
+	stack.push_back(0);
+	while (!stack.empty()) {
+		const BVHNode& node = nodes_[stack.back()];
+		stack.pop_back();
+		if (!isCollisionAABB(node.bounds, aabb)) {
+			continue;
+		}
+		if (node.count > 0) {
+			for (uint32_t i = 0; i < node.count; ++i) {
+				uint32_t primitive = indices_[node.leftFirst + i];
+				if (isCollisionAABB(bounds_[primitive], aabb)) {
+					callback(primitive);
+				}
+			}
+		}
+		else {
+			stack.push_back(node.leftFirst);
+			stack.push_back(node.leftFirst + 1);
+		}
+	}
+}
+//=================================================================================================
+
+//=======================================  線分との交差  ===========================================
+template <typename Callback>
+void BVH::QuerySegment(const Segment& segment, Callback&& callback) const {
+	if (nodes_.empty()) {
+		return;
+	}
+
+	Vector3 invDiff = { 1.0f / segment.diff.x, 1.0f / segment.diff.y, 1.0f / segment.diff.z };
+
+	std::byte stackBuffer[kQueryStackBytes];
+	std::pmr::monotonic_buffer_resource stackResource(stackBuffer, sizeof(stackBuffer));
+	std::pmr::vector<uint32_t> stack(&stackResource);
+	stack.reserve(kQueryStackBytes / 2 / sizeof(uint32_t));
+	stack.push_back(0);
+	while (!stack.empty()) {
+		const BVHNode& node = nodes_[stack.back()];
+		stack.pop_back();
+		if (!IntersectSegmentAABB(segment.origin, invDiff, node.bounds)) {
+			continue;
+		}
+		if (node.count > 0) {
+			for (uint32_t i = 0; i < node.count; ++i) {
+				if (!callback(indices_[node.leftFirst + i])) {
+					return;
+				}
+			}
+		}
+		else {
+			stack.push_back(node.leftFirst);
+			stack.push_back(node.leftFirst + 1);
+		}
+	}
+}
+//=================================================================================================
+
+//=====================================  球を動かしたときの交差  =======================================
+// 各ノードのAABBを半径だけ広げ、球の中心の軌跡(線分)と判定する
+template <typename Callback>
+void BVH::QuerySphereSweep(const Sphere& sphere, const Vector3& move, Callback&& callback) const {
+	if (nodes_.empty()) {
+		return;
+	}
+
+	Vector3 invDiff = { 1.0f / move.x, 1.0f / move.y, 1.0f / move.z };
+	float r = sphere.radius;
+
+	std::byte stackBuffer[kQueryStackBytes];
+	std::pmr::monotonic_buffer_resource stackResource(stackBuffer, sizeof(stackBuffer));
+	std::pmr::vector<uint32_t> stack(&stackResource);
+	stack.reserve(kQueryStackBytes / 2 / sizeof(uint32_t));
+	stack.push_back(0);
+	while (!stack.empty()) {
+		const BVHNode& node = nodes_[stack.back()];
+		stack.pop_back();
+		AABB expanded = {
+			{ node.bounds.min.x - r, node.bounds.min.y - r, node.bounds.min.z - r },
+			{ node.bounds.max.x + r, node.bounds.max.y + r, node.bounds.max.z + r },
+		};
+		if (!IntersectSegmentAABB(sphere.center, invDiff, expanded)) {
+			continue;
+		}
+		if (node.count > 0) {
+			for (uint32_t i = 0; i < node.count; ++i) {
+				if (!callback(indices_[node.leftFirst + i])) {
+					return;
+				}
+			}
+		}
+		else {
+			stack.push_back(node.leftFirst);
+			stack.push_back(node.leftFirst + 1);
+		}
+	}
+}
+//=================================================================================================
+
+
+//=============================  プリミティブごとの構築と詳細判定  ====================================
+
+inline void BuildBVH(BVH& bvh, const AABB* aabbs, uint32_t count) {
+	bvh.Build(aabbs, count);
+}
+
+// 球・三角形のAABBは bvh の中に直接書き込む (一時配列は作らない)
+inline void BuildBVH(BVH& bvh, const Sphere* spheres, uint32_t count) {
+	bvh.Build(count, [spheres](uint32_t i) { return MakeAABB(spheres[i]); });
+}
+
+inline void BuildBVH(BVH& bvh, const Triangle* triangles, uint32_t count) {
+	bvh.Build(count, [triangles](uint32_t i) { return MakeAABB(triangles[i]); });
+}
+
+// 毎フレーム呼んでもメモリは確保しない。count は Build と同じ数
+inline void RefitBVH(BVH& bvh, const Sphere* spheres, uint32_t count) {
+	assert(count == bvh.GetPrimitiveCount());
+	(void)count;
+	bvh.Refit([spheres](uint32_t i) { return MakeAABB(spheres[i]); });
+}
+
+// 衝突している球の組
+template <typename Allocator>
+inline void FindCollidingPairs(const BVH& bvh, const Sphere* spheres, std::vector<CollisionPair, Allocator>& pairs) {
+	MT3_PROFILE_ZONE("FindCollidingPairs(Sphere)");
+	bvh.QueryOverlapPairs([&](uint32_t a, uint32_t b) {
+		if (IsCollisionSphere(spheres[a], spheres[b])) {
+			pairs.push_back({ a, b });
+		}
+	});
+}
+
+// 衝突しているAABBの組 (木のAABBがそのまま形状なので詳細判定は不要)
+template <typename Allocator>
+inline void FindCollidingPairs(const BVH& bvh, const AABB* aabbs, std::vector<CollisionPair, Allocator>& pairs) {
+	(void)aabbs;
+	bvh.QueryOverlapPairs(pairs);
+}
+
+// 線分と衝突している三角形の番号
+template <typename Allocator>
+inline void FindSegmentHits(const BVH& bvh, const Triangle* triangles, const Segment& segment, std::vector<uint32_t, Allocator>& hits) {
+	MT3_PROFILE_ZONE("FindSegmentHits(Triangle)");
+	bvh.QuerySegment(segment, [&](uint32_t index) {
+		if (IsCollisionTriangle(triangles[index], segment)) {
+			hits.push_back(index);
+		}
+		return true;
+	});
+}
+
+// 線分と衝突しているAABBの番号
+// IsCollisionAABBSeg は t の範囲を制限しない直線の判定なので、線分 (0 <= t <= 1) のスラブ法で調べる
+template <typename Allocator>
+inline void FindSegmentHits(const BVH& bvh, const AABB* aabbs, const Segment& segment, std::vector<uint32_t, Allocator>& hits) {
+	MT3_PROFILE_ZONE("FindSegmentHits(AABB)");
+	Vector3 invDiff = { 1.0f / segment.diff.x, 1.0f / segment.diff.y, 1.0f / segment.diff.z };
+	bvh.QuerySegment(segment, [&](uint32_t index) {
+		if (IntersectSegmentAABB(segment.origin, invDiff, aabbs[index])) {
+			hits.push_back(index);
+		}
+		return true;
+	});
+}
+
+//=================================================================================================
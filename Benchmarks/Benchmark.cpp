@@ -0,0 +1,536 @@
+#include "Benchmark.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <memory>
+#include <regex>
+#include <sstream>
+#include <thread>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+namespace benchmark {
+
+//========================================  時間の計測  =============================================
+// CPU時間は std::clock() (Linux ではプロセス全体のCPU時間、Windows では経過時間になる)
+
+void State::StartKeepRunning() {
+	started_ = true;
+	remaining_ = maxIterations_;
+	ResumeTiming();
+}
+
+void State::FinishKeepRunning() {
+	if (!finished_) {
+		PauseTiming();
+		finished_ = true;
+	}
+}
+
+void State::PauseTiming() {
+	realSeconds_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - realStart_).count();
+	cpuSeconds_ += double(std::clock() - cpuStart_) / CLOCKS_PER_SEC;
+}
+
+void State::ResumeTiming() {
+	realStart_ = std::chrono::steady_clock::now();
+	cpuStart_ = std::clock();
+}
+
+void State::SetCounter(const std::string& name, double value) {
+	for (auto& counter : counters_) {
+		if (counter.first == name) {
+			counter.second = value;
+			return;
+		}
+	}
+	counters_.push_back({ name, value });
+}
+
+//=================================================================================================
+
+
+//=========================================  登録  ================================================
+
+static std::vector<std::unique_ptr<Benchmark>>& GetBenchmarks() {
+	static std::vector<std::unique_ptr<Benchmark>> benchmarks;
+	return benchmarks;
+}
+
+static std::vector<std::pair<std::string, std::string>>& GetCustomContext() {
+	static std::vector<std::pair<std::string, std::string>> context;
+	return context;
+}
+
+Benchmark* RegisterBenchmark(const char* name, Function function) {
+	GetBenchmarks().push_back(std::make_unique<Benchmark>(name, function));
+	return GetBenchmarks().back().get();
+}
+
+void AddCustomContext(const std::string& key, const std::string& value) {
+	GetCustomContext().push_back({ key, value });
+}
+
+#if defined(_MSC_VER) && !defined(__clang__)
+void UseCharPointer(const volatile char*) {}
+#endif
+
+//=================================================================================================
+
+
+//=========================================  実行  ================================================
+
+namespace {
+
+struct Options {
+	std::string filter;
+	double minTime = 0.5;
+	int repetitions = 1;
+	bool json = false;
+	std::string out;
+};
+
+// 1回分の結果
+struct Run {
+	std::string name;
+	std::string aggregateName;  //!< 空なら1回分の結果
+	int64_t iterations = 0;
+	int repetitions = 1;
+	int repetitionIndex = 0;
+	double realTime = 0.0;  //!< 1回あたり(ns)
+	double cpuTime = 0.0;   //!< 1回あたり(ns)
+	double itemsPerSecond = 0.0;
+	std::string label;
+	std::vector<std::pair<std::string, double>> counters;
+};
+
+const int64_t kMaxIterations = 1000000000;
+
+bool ParseFlag(const char* arg, const char* flag, std::string& value) {
+	size_t length = std::strlen(flag);
+	if (std::strncmp(arg, flag, length) == 0 && arg[length] == '=') {
+		value = arg + length + 1;
+		return true;
+	}
+	return false;
+}
+
+std::string MakeName(const Benchmark& benchmark, const std::vector<int64_t>& args) {
+	std::string name = benchmark.GetName();
+	for (int64_t arg : args) {
+		name += '/';
+		name += std::to_string(arg);
+	}
+	return name;
+}
+
+// iterations 回まわして結果を返す
+Run RunOnce(const Benchmark& benchmark, const std::vector<int64_t>& args, int64_t iterations) {
+	State state(iterations, args);
+	benchmark.GetFunction()(state);
+
+	Run run;
+	run.iterations = iterations;
+	run.realTime = state.GetRealSeconds() * 1e9 / double(iterations);
+	run.cpuTime = state.GetCpuSeconds() * 1e9 / double(iterations);
+	if (state.GetItemsProcessed() > 0 && state.GetRealSeconds() > 0.0) {
+		run.itemsPerSecond = double(state.GetItemsProcessed()) / state.GetRealSeconds();
+	}
+	run.label = state.GetLabel();
+	run.counters = state.GetCounters();
+	return run;
+}
+
+// min_time を超えるまで回数を増やしていく (Google Benchmark と同じ考え方)
+int64_t PredictIterations(const Benchmark& benchmark, const std::vector<int64_t>& args, double minTime) {
+	int64_t iterations = 1;
+	while (true) {
+		Run run = RunOnce(benchmark, args, iterations);
+		double seconds = run.realTime * double(iterations) * 1e-9;
+		if (seconds >= minTime || iterations >= kMaxIterations) {
+			return iterations;
+		}
+		double multiplier = minTime * 1.4 / (std::max)(seconds, 1e-9);
+		if (seconds / minTime <= 0.1) {
+			multiplier = (std::min)(multiplier, 10.0);
+		}
+		int64_t next = int64_t(double(iterations) * multiplier);
+		iterations = (std::min)(kMaxIterations, (std::max)(iterations + 1, next));
+	}
+}
+
+std::vector<Run> MakeAggregates(const std::vector<Run>& runs) {
+	double n = double(runs.size());
+	auto makeAggregate = [&](const char* aggregateName, auto&& select) {
+		Run aggregate = runs.front();
+		aggregate.name = runs.front().name;
+		aggregate.name += '_';
+		aggregate.name += aggregateName;
+		aggregate.aggregateName = aggregateName;
+		aggregate.iterations = int64_t(runs.size());
+		aggregate.repetitions = int(runs.size());
+		aggregate.realTime = select([](const Run& run) { return run.realTime; });
+		aggregate.cpuTime = select([](const Run& run) { return run.cpuTime; });
+		aggregate.itemsPerSecond = select([](const Run& run) { return run.itemsPerSecond; });
+		for (size_t i = 0; i < aggregate.counters.size(); ++i) {
+			aggregate.counters[i].second = select([i](const Run& run) { return run.counters[i].second; });
+		}
+		return aggregate;
+	};
+
+	auto mean = [&](auto&& value) {
+		double sum = 0.0;
+		for (const Run& run : runs) {
+			sum += value(run);
+		}
+		return sum / n;
+	};
+	auto median = [&](auto&& value) {
+		std::vector<double> values;
+		for (const Run& run : runs) {
+			values.push_back(value(run));
+		}
+		std::sort(values.begin(), values.end());
+		size_t half = values.size() / 2;
+		return (values.size() % 2 == 0) ? (values[half - 1] + values[half]) * 0.5 : values[half];
+	};
+	auto stddev = [&](auto&& value) {
+		double average = mean(value);
+		double sum = 0.0;
+		for (const Run& run : runs) {
+			sum += (value(run) - average) * (value(run) - average);
+		}
+		return std::sqrt(sum / (n - 1.0));
+	};
+
+	return {
+		makeAggregate("mean", mean),
+		makeAggregate("median", median),
+		makeAggregate("stddev", stddev),
+	};
+}
+
+std::string EscapeJson(const std::string& text) {
+	std::string result;
+	for (char c : text) {
+		if (c == '"' || c == '\\') {
+			result += '\\';
+		}
+		result += c;
+	}
+	return result;
+}
+
+std::string CurrentDate() {
+	std::time_t now = std::time(nullptr);
+	std::tm local = {};
+#if defined(_MSC_VER)
+	localtime_s(&local, &now);
+#else
+	localtime_r(&now, &local);
+#endif
+	char buffer[64];
+	std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S%z", &local);
+	return buffer;
+}
+
+// JSON の context に出す CPU の情報。調べられなかった項目は出力しない
+struct CpuCache {
+	std::string type;  //!< "Data" / "Instruction" / "Unified"
+	int level = 0;
+	int64_t size = 0;  //!< バイト数
+	int numSharing = 0;  //!< このキャッシュを共有する論理CPUの数
+};
+
+struct CpuInfo {
+	double mhz = 0.0;       //!< 0 なら不明
+	int scalingEnabled = -1;  //!< 周波数の自動調整 (1: あり、0: なし、-1: 不明)
+	std::vector<CpuCache> caches;
+};
+
+#if defined(__linux__)
+bool ReadTextFile(const std::string& path, std::string& text) {
+	std::ifstream file(path);
+	if (!file) {
+		return false;
+	}
+	std::getline(file, text);
+	return true;
+}
+
+// "0-3,8" のようなCPUの番号の並びに含まれる数
+int CountCpuList(const std::string& list) {
+	int count = 0;
+	std::istringstream stream(list);
+	std::string range;
+	while (std::getline(stream, range, ',')) {
+		size_t dash = range.find('-');
+		count += (dash == std::string::npos) ? 1 : std::atoi(range.c_str() + dash + 1) - std::atoi(range.c_str()) + 1;
+	}
+	return count;
+}
+#endif
+
+CpuInfo ReadCpuInfo() {
+	CpuInfo info;
+#if defined(__linux__)
+	std::ifstream cpuinfo("/proc/cpuinfo");
+	for (std::string line; std::getline(cpuinfo, line);) {
+		if (line.compare(0, 7, "cpu MHz") == 0 && line.find(':') != std::string::npos) {
+			info.mhz = std::atof(line.c_str() + line.find(':') + 1);
+			break;
+		}
+	}
+	std::string governor;
+	if (ReadTextFile("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor", governor)) {
+		info.scalingEnabled = (governor != "performance") ? 1 : 0;
+	}
+	for (int index = 0;; ++index) {
+		std::string directory = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+		CpuCache cache;
+		std::string level, size, shared;
+		if (!ReadTextFile(directory + "type", cache.type) || !ReadTextFile(directory + "level", level) || !ReadTextFile(directory + "size", size)) {
+			break;
+		}
+		cache.level = std::atoi(level.c_str());
+		// "48K" / "2048K" / "32M"
+		cache.size = std::atoll(size.c_str());
+		if (size.find('K') != std::string::npos) {
+			cache.size *= 1024;
+		}
+		else if (size.find('M') != std::string::npos) {
+			cache.size *= 1024 * 1024;
+		}
+		cache.numSharing = ReadTextFile(directory + "shared_cpu_list", shared) ? CountCpuList(shared) : 0;
+		info.caches.push_back(cache);
+	}
+#elif defined(_WIN32)
+	DWORD mhz = 0;
+	DWORD mhzSize = sizeof(mhz);
+	if (RegGetValueA(HKEY_LOCAL_MACHINE, "HARDWARE\\DESCRIPTION\\System\\CentralProcessor\\0", "~MHz", RRF_RT_REG_DWORD, nullptr, &mhz, &mhzSize) == ERROR_SUCCESS) {
+		info.mhz = double(mhz);
+	}
+	DWORD bytes = 0;
+	GetLogicalProcessorInformation(nullptr, &bytes);
+	std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> processors(bytes / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+	if (!processors.empty() && GetLogicalProcessorInformation(processors.data(), &bytes)) {
+		for (const SYSTEM_LOGICAL_PROCESSOR_INFORMATION& processor : processors) {
+			if (processor.Relationship != RelationCache) {
+				continue;
+			}
+			const CACHE_DESCRIPTOR& descriptor = processor.Cache;
+			CpuCache cache;
+			cache.type = (descriptor.Type == CacheData) ? "Data" : (descriptor.Type == CacheInstruction) ? "Instruction" : "Unified";
+			cache.level = descriptor.Level;
+			cache.size = descriptor.Size;
+			for (ULONG_PTR mask = processor.ProcessorMask; mask != 0; mask &= mask - 1) {
+				++cache.numSharing;
+			}
+			// 同じ種類のキャッシュはコアの数だけ出てくるので、1つだけ残す
+			bool duplicate = false;
+			for (const CpuCache& other : info.caches) {
+				duplicate = duplicate || (other.type == cache.type && other.level == cache.level && other.size == cache.size);
+			}
+			if (!duplicate) {
+				info.caches.push_back(cache);
+			}
+		}
+	}
+#endif
+	return info;
+}
+
+std::string ToJson(const std::vector<Run>& runs, const char* executable) {
+	std::ostringstream json;
+	json.precision(17);
+
+#if defined(NDEBUG)
+	const char* buildType = "release";
+#else
+	const char* buildType = "debug";
+#endif
+
+	json << "{\n";
+	json << "  \"context\": {\n";
+	json << "    \"date\": \"" << CurrentDate() << "\",\n";
+	json << "    \"executable\": \"" << EscapeJson(executable) << "\",\n";
+	json << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n";
+	CpuInfo cpu = ReadCpuInfo();
+	if (cpu.mhz > 0.0) {
+		json << "    \"mhz_per_cpu\": " << int64_t(cpu.mhz + 0.5) << ",\n";
+	}
+	if (cpu.scalingEnabled >= 0) {
+		json << "    \"cpu_scaling_enabled\": " << (cpu.scalingEnabled ? "true" : "false") << ",\n";
+	}
+	if (!cpu.caches.empty()) {
+		json << "    \"caches\": [\n";
+		for (size_t i = 0; i < cpu.caches.size(); ++i) {
+			const CpuCache& cache = cpu.caches[i];
+			json << "      {\n";
+			json << "        \"type\": \"" << cache.type << "\",\n";
+			json << "        \"level\": " << cache.level << ",\n";
+			json << "        \"size\": " << cache.size << ",\n";
+			json << "        \"num_sharing\": " << cache.numSharing << "\n";
+			json << "      }" << (i + 1 < cpu.caches.size() ? "," : "") << "\n";
+		}
+		json << "    ],\n";
+	}
+	for (const auto& [key, value] : GetCustomContext()) {
+		json << "    \"" << EscapeJson(key) << "\": \"" << EscapeJson(value) << "\",\n";
+	}
+	json << "    \"library_build_type\": \"" << buildType << "\"\n";
+	json << "  },\n";
+	json << "  \"benchmarks\": [\n";
+	for (size_t i = 0; i < runs.size(); ++i) {
+		const Run& run = runs[i];
+		std::string runName = run.aggregateName.empty() ? run.name : run.name.substr(0, run.name.size() - run.aggregateName.size() - 1);
+		json << "    {\n";
+		json << "      \"name\": \"" << EscapeJson(run.name) << "\",\n";
+		json << "      \"run_name\": \"" << EscapeJson(runName) << "\",\n";
+		json << "      \"run_type\": \"" << (run.aggregateName.empty() ? "iteration" : "aggregate") << "\",\n";
+		json << "      \"repetitions\": " << run.repetitions << ",\n";
+		if (run.aggregateName.empty()) {
+			json << "      \"repetition_index\": " << run.repetitionIndex << ",\n";
+		}
+		else {
+			json << "      \"aggregate_name\": \"" << run.aggregateName << "\",\n";
+		}
+		json << "      \"threads\": 1,\n";
+		json << "      \"iterations\": " << run.iterations << ",\n";
+		json << "      \"real_time\": " << run.realTime << ",\n";
+		json << "      \"cpu_time\": " << run.cpuTime << ",\n";
+		json << "      \"time_unit\": \"ns\"";
+		if (run.itemsPerSecond > 0.0) {
+			json << ",\n      \"items_per_second\": " << run.itemsPerSecond;
+		}
+		for (const auto& [name, value] : run.counters) {
+			json << ",\n      \"" << EscapeJson(name) << "\": " << value;
+		}
+		if (!run.label.empty()) {
+			json << ",\n      \"label\": \"" << EscapeJson(run.label) << "\"";
+		}
+		json << "\n    }" << (i + 1 < runs.size() ? "," : "") << "\n";
+	}
+	json << "  ]\n";
+	json << "}\n";
+	return json.str();
+}
+
+void PrintConsoleHeader() {
+	std::printf("%-48s %15s %15s %12s\n", "Benchmark", "Time", "CPU", "Iterations");
+	std::printf("%s\n", std::string(93, '-').c_str());
+}
+
+void PrintConsoleRun(const Run& run) {
+	std::printf("%-48s %12.1f ns %12.1f ns %12lld", run.name.c_str(), run.realTime, run.cpuTime, (long long)run.iterations);
+	if (run.itemsPerSecond > 0.0) {
+		std::printf(" items/s=%.4g", run.itemsPerSecond);
+	}
+	for (const auto& [name, value] : run.counters) {
+		std::printf(" %s=%.4g", name.c_str(), value);
+	}
+	if (!run.label.empty()) {
+		std::printf(" %s", run.label.c_str());
+	}
+	std::printf("\n");
+	std::fflush(stdout);
+}
+
+}  // namespace
+
+
+int RunSpecifiedBenchmarks(int argc, char** argv) {
+	Options options;
+	for (int i = 1; i < argc; ++i) {
+		std::string value;
+		if (ParseFlag(argv[i], "--benchmark_filter", value)) {
+			options.filter = value;
+		}
+		else if (ParseFlag(argv[i], "--benchmark_min_time", value)) {
+			options.minTime = std::atof(value.c_str());
+		}
+		else if (ParseFlag(argv[i], "--benchmark_repetitions", value)) {
+			options.repetitions = (std::max)(1, std::atoi(value.c_str()));
+		}
+		else if (ParseFlag(argv[i], "--benchmark_format", value)) {
+			options.json = (value == "json");
+		}
+		else if (ParseFlag(argv[i], "--benchmark_out", value)) {
+			options.out = value;
+		}
+		else {
+			std::fprintf(stderr, "unknown argument: %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	std::regex filter(options.filter.empty() ? std::string(".") : options.filter);
+
+	if (!options.json) {
+		PrintConsoleHeader();
+	}
+
+	std::vector<Run> runs;
+	for (const auto& benchmark : GetBenchmarks()) {
+		std::vector<std::vector<int64_t>> argSets = benchmark->GetArgSets();
+		if (argSets.empty()) {
+			argSets.push_back({});
+		}
+		for (const std::vector<int64_t>& args : argSets) {
+			std::string name = MakeName(*benchmark, args);
+			if (!std::regex_search(name, filter)) {
+				continue;
+			}
+
+			int64_t iterations = PredictIterations(*benchmark, args, options.minTime);
+			std::vector<Run> repetitions;
+			for (int repetition = 0; repetition < options.repetitions; ++repetition) {
+				Run run = RunOnce(*benchmark, args, iterations);
+				run.name = name;
+				run.repetitions = options.repetitions;
+				run.repetitionIndex = repetition;
+				repetitions.push_back(run);
+				if (!options.json) {
+					PrintConsoleRun(run);
+				}
+			}
+			runs.insert(runs.end(), repetitions.begin(), repetitions.end());
+
+			if (options.repetitions > 1) {
+				for (const Run& aggregate : MakeAggregates(repetitions)) {
+					runs.push_back(aggregate);
+					if (!options.json) {
+						PrintConsoleRun(aggregate);
+					}
+				}
+			}
+		}
+	}
+
+	std::string json = ToJson(runs, argc > 0 ? argv[0] : "");
+	if (options.json) {
+		std::fputs(json.c_str(), stdout);
+	}
+	if (!options.out.empty()) {
+		std::ofstream file(options.out);
+		if (!file) {
+			std::fprintf(stderr, "cannot open %s\n", options.out.c_str());
+			return 1;
+		}
+		file << json;
+	}
+	return 0;
+}
+
+//=================================================================================================
+
+}  // namespace benchmark
@@ -0,0 +1,186 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <string>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Google Benchmark と同じ書き方ができる最小限のベンチマーク
+//
+//   void BM_Multiply(benchmark::State& state) {
+//       for (auto _ : state) { benchmark::DoNotOptimize(Multiply(a, b)); }
+//   }
+//   BENCHMARK(BM_Multiply)->Arg(0)->Arg(1);
+//
+// 結果は Google Benchmark と同じ形式の JSON で出力できるので、
+// コミット間の比較には Google Benchmark の tools/compare.py がそのまま使える
+//
+// コマンドライン引数
+//   --benchmark_filter=<文字列>        名前にこの文字列を含むものだけ実行 (省略時は全て)
+//   --benchmark_min_time=<秒>          1つのベンチマークを最低何秒回すか (既定 0.5)
+//   --benchmark_repetitions=<回数>     繰り返し回数。2以上なら mean/median/stddev も出力する
+//   --benchmark_format=<console|json>  標準出力の形式
+//   --benchmark_out=<ファイル名>        JSON をファイルにも出力する
+
+namespace benchmark {
+
+class State {
+public:
+	State(int64_t maxIterations, const std::vector<int64_t>& args) : maxIterations_(maxIterations), args_(args) {}
+
+	// for (auto _ : state) で使う
+	struct Value {
+		~Value() {}  // 未使用変数の警告を出さないため
+	};
+
+	struct Iterator {
+		State* state;
+		int64_t remaining;
+
+		bool operator!=(const Iterator&) {
+			if (remaining != 0) {
+				return true;
+			}
+			state->FinishKeepRunning();
+			return false;
+		}
+		void operator++() { --remaining; }
+		Value operator*() const { return Value(); }
+	};
+
+	Iterator begin() {
+		StartKeepRunning();
+		return { this, maxIterations_ };
+	}
+	Iterator end() { return { this, 0 }; }
+
+	// while (state.KeepRunning()) で使う
+	bool KeepRunning() {
+		if (!started_) {
+			StartKeepRunning();
+		}
+		if (remaining_ == 0) {
+			FinishKeepRunning();
+			return false;
+		}
+		--remaining_;
+		return true;
+	}
+
+	// 計測を一時的に止める (準備処理を計測から外すとき)
+	void PauseTiming();
+	void ResumeTiming();
+
+	int64_t range(size_t index = 0) const { return args_[index]; }
+	int64_t iterations() const { return maxIterations_; }
+
+	void SetItemsProcessed(int64_t items) { itemsProcessed_ = items; }
+	void SetLabel(const std::string& label) { label_ = label; }
+
+	// 任意の値を結果に追加する (JSON では名前をキーにして出力)
+	void SetCounter(const std::string& name, double value);
+
+	double GetRealSeconds() const { return realSeconds_; }
+	double GetCpuSeconds() const { return cpuSeconds_; }
+	int64_t GetItemsProcessed() const { return itemsProcessed_; }
+	const std::string& GetLabel() const { return label_; }
+	const std::vector<std::pair<std::string, double>>& GetCounters() const { return counters_; }
+
+private:
+	void StartKeepRunning();
+	void FinishKeepRunning();
+
+	int64_t maxIterations_;
+	int64_t remaining_ = 0;
+	std::vector<int64_t> args_;
+	bool started_ = false;
+	bool finished_ = false;
+
+	std::chrono::steady_clock::time_point realStart_;
+	std::clock_t cpuStart_ = 0;
+	double realSeconds_ = 0.0;
+	double cpuSeconds_ = 0.0;
+
+	int64_t itemsProcessed_ = 0;
+	std::string label_;
+	std::vector<std::pair<std::string, double>> counters_;
+};
+
+using Function = void (*)(State&);
+
+// BENCHMARK() で登録した1つのベンチマーク
+class Benchmark {
+public:
+	Benchmark(const std::string& name, Function function) : name_(name), function_(function) {}
+
+	// 引数を1つ追加する。Arg を複数回呼ぶと引数ごとに別のベンチマークとして実行する
+	Benchmark* Arg(int64_t value) {
+		argSets_.push_back({ value });
+		return this;
+	}
+	Benchmark* Args(const std::vector<int64_t>& values) {
+		argSets_.push_back(values);
+		return this;
+	}
+
+	// 引数の追加などをまとめた関数を適用する
+	Benchmark* Apply(void (*function)(Benchmark*)) {
+		function(this);
+		return this;
+	}
+
+	const std::string& GetName() const { return name_; }
+	Function GetFunction() const { return function_; }
+	const std::vector<std::vector<int64_t>>& GetArgSets() const { return argSets_; }
+
+private:
+	std::string name_;
+	Function function_;
+	std::vector<std::vector<int64_t>> argSets_;
+};
+
+Benchmark* RegisterBenchmark(const char* name, Function function);
+
+// 引数を解析して登録されている全てのベンチマークを実行する。戻り値は main の戻り値
+int RunSpecifiedBenchmarks(int argc, char** argv);
+
+// 結果に出力する環境情報 (命令セットなど) を追加する
+void AddCustomContext(const std::string& key, const std::string& value);
+
+
+//==================================  最適化で消されないようにする  ===================================
+#if defined(_MSC_VER) && !defined(__clang__)
+void UseCharPointer(const volatile char*);
+
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+	UseCharPointer(&reinterpret_cast<const volatile char&>(value));
+	_ReadWriteBarrier();
+}
+
+inline void ClobberMemory() {
+	_ReadWriteBarrier();
+}
+#else
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+	asm volatile("" : : "r"(&value) : "memory");
+}
+
+inline void ClobberMemory() {
+	asm volatile("" : : : "memory");
+}
+#endif
+//=================================================================================================
+
+}  // namespace benchmark
+
+#define MT3_BENCHMARK_CONCAT2(a, b) a##b
+#define MT3_BENCHMARK_CONCAT(a, b) MT3_BENCHMARK_CONCAT2(a, b)
+
+#define BENCHMARK(function) \
+	[[maybe_unused]] static ::benchmark::Benchmark* MT3_BENCHMARK_CONCAT(benchmark_, __LINE__) = ::benchmark::RegisterBenchmark(#function, function)
@@ -0,0 +1,31 @@
+#include "Benchmark.h"
+#include "BenchmarkUtility.h"
+#include "Check.h"
+#include <cstdio>
+#include <cstring>
+
+int main(int argc, char** argv) {
+	// --check=<名前> のときはベンチマークを実行せず、正しさの確認だけをして終わる (Check.h)
+	const char* kCheck = "--check=";
+	for (int i = 1; i < argc; ++i) {
+		if (std::strncmp(argv[i], kCheck, std::strlen(kCheck)) == 0) {
+			return check::Run(argv[i] + std::strlen(kCheck));
+		}
+	}
+
+	// --render_frame=<path> のときはベンチマークを実行せず、1フレームの画像を書き出して終わる
+	const char* kRenderFrame = "--render_frame=";
+	for (int i = 1; i < argc; ++i) {
+		if (std::strncmp(argv[i], kRenderFrame, std::strlen(kRenderFrame)) == 0) {
+			const char* path = argv[i] + std::strlen(kRenderFrame);
+			if (!RenderFrameImage(path)) {
+				std::fprintf(stderr, "failed to write %s\n", path);
+				return 1;
+			}
+			return 0;
+		}
+	}
+
+	benchmark::AddCustomContext("simd_level", SimdLevelName(GetSimdLevel()));
+	return benchmark::RunSpecifiedBenchmarks(argc, argv);
+}
@@ -0,0 +1,160 @@
+#pragma once
+#include "Benchmark.h"
+#include "Geometry.h"
+#include "JobSystem.h"
+#include "SimdConfig.h"
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ベンチマークで共通に使う準備処理
+
+
+//====================================  命令セットの切り替え  ========================================
+// Arg(0/1/2) を SimdLevel (Scalar/SSE41/AVX2) として使う
+// CPU が対応していない命令セットは下がるので、ラベルには実際に使った命令セットを出す
+
+inline const char* SimdLevelName(SimdLevel level) {
+	switch (level) {
+	case SimdLevel::AVX2: return "AVX2";
+	case SimdLevel::SSE41: return "SSE4.1";
+	default: return "Scalar";
+	}
+}
+
+// ベンチマーク関数の先頭で作り、Arg の命令セットに切り替える
+// 関数を抜けるときに起動時に判定した命令セットへ戻すので、命令セットを指定しない他のベンチマークは
+// 実行順や --benchmark_filter によらず、いつも起動時の命令セットで動く
+class ScopedSimdLevel {
+public:
+	explicit ScopedSimdLevel(benchmark::State& state) {
+		SetSimdLevel(SimdLevel(state.range(0)));
+		state.SetLabel(SimdLevelName(GetSimdLevel()));
+	}
+
+	~ScopedSimdLevel() { SetSimdLevel(DetectSimdLevel()); }
+
+	ScopedSimdLevel(const ScopedSimdLevel&) = delete;
+	ScopedSimdLevel& operator=(const ScopedSimdLevel&) = delete;
+};
+
+// 全ての命令セットで登録する
+inline void AllSimdLevels(benchmark::Benchmark* benchmark) {
+	benchmark->Arg(int64_t(SimdLevel::Scalar))->Arg(int64_t(SimdLevel::SSE41))->Arg(int64_t(SimdLevel::AVX2));
+}
+
+//=================================================================================================
+
+
+//=====================================  ジョブシステム  ============================================
+// Apply(ThreadCounts) で、Arg をスレッド数として使う
+
+// 引数のスレッド数で作ったジョブシステム (ベンチマークごとに作り直さない)
+inline JobSystem& BenchmarkJobSystem(uint32_t threadCount) {
+	static std::vector<std::unique_ptr<JobSystem>> jobSystems;
+	for (const std::unique_ptr<JobSystem>& jobSystem : jobSystems) {
+		if (jobSystem->GetThreadCount() == threadCount) {
+			return *jobSystem;
+		}
+	}
+	jobSystems.push_back(std::make_unique<JobSystem>(threadCount));
+	return *jobSystems.back();
+}
+
+// 1, 2, 4, ... とハードウェアのスレッド数で登録する
+inline void ThreadCounts(benchmark::Benchmark* benchmark) {
+	uint32_t hardwareThreads = (std::max)(1u, std::thread::hardware_concurrency());
+	for (uint32_t threadCount = 1; threadCount < hardwareThreads; threadCount *= 2) {
+		benchmark->Arg(threadCount);
+	}
+	benchmark->Arg(hardwareThreads);
+}
+
+//=================================================================================================
+
+
+//=====================================  フレームの画像  ============================================
+
+// main.cpp の1フレームをソフトウェアラスタライザで描き、path に書き出す (FrameBenchmarks.cpp)
+// mt3_benchmarks --render_frame=frame.png で呼ばれる。描画結果を以前の画像と比べるのに使う
+bool RenderFrameImage(const std::string& path);
+
+//=================================================================================================
+
+
+//======================================  ランダムな入力  ============================================
+// 定数畳み込みされないように、毎回同じ乱数列から作った配列を順番に使う
+
+inline std::mt19937& BenchmarkRandom() {
+	static std::mt19937 random(12345);
+	return random;
+}
+
+inline float RandomFloat(float min, float max) {
+	return std::uniform_real_distribution<float>(min, max)(BenchmarkRandom());
+}
+
+inline Vector3 RandomVector3(float range) {
+	return { RandomFloat(-range, range), RandomFloat(-range, range), RandomFloat(-range, range) };
+}
+
+inline Matrix4x4 RandomMatrix() {
+	Matrix4x4 result;
+	for (int row = 0; row < 4; ++row) {
+		for (int column = 0; column < 4; ++column) {
+			result.m[row][column] = RandomFloat(-1.0f, 1.0f);
+		}
+	}
+	// 逆行列が求まるように対角を大きくしておく
+	for (int i = 0; i < 4; ++i) {
+		result.m[i][i] += 4.0f;
+	}
+	return result;
+}
+
+inline Matrix4x4 RandomAffineMatrix() {
+	return MakeAffineMatrix(
+		{ RandomFloat(0.5f, 2.0f), RandomFloat(0.5f, 2.0f), RandomFloat(0.5f, 2.0f) },
+		RandomVector3(3.14f),
+		RandomVector3(10.0f));
+}
+
+inline Sphere RandomSphere(float range) {
+	return { RandomVector3(range), RandomFloat(0.1f, 1.0f) };
+}
+
+inline AABB RandomAABB(float range) {
+	Vector3 center = RandomVector3(range);
+	Vector3 half = { RandomFloat(0.1f, 1.0f), RandomFloat(0.1f, 1.0f), RandomFloat(0.1f, 1.0f) };
+	return { SubtractVector(center, half), AddVector(center, half) };
+}
+
+inline Plane RandomPlane(float range) {
+	return { Normalize(RandomVector3(1.0f)), RandomFloat(-range, range) };
+}
+
+inline Segment RandomSegment(float range) {
+	return { RandomVector3(range), RandomVector3(range) };
+}
+
+inline Triangle RandomTriangle(float range) {
+	Vector3 center = RandomVector3(range);
+	Triangle triangle = {};
+	for (Vector3& vertex : triangle.vertices) {
+		vertex = AddVector(center, RandomVector3(1.0f));
+	}
+	return triangle;
+}
+
+template <typename T, typename Generator>
+std::vector<T> MakeRandomArray(size_t count, Generator&& generator) {
+	std::vector<T> result(count);
+	for (T& value : result) {
+		value = generator();
+	}
+	return result;
+}
+
+//=================================================================================================
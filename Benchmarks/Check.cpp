@@ -0,0 +1,51 @@
+#include "Check.h"
+#include <cstdarg>
+#include <cstdio>
+#include <vector>
+
+namespace check {
+
+namespace {
+
+struct Entry {
+	const char* name;
+	Function function;
+};
+
+std::vector<Entry>& GetChecks() {
+	static std::vector<Entry> checks;
+	return checks;
+}
+
+}  // namespace
+
+int Register(const char* name, Function function) {
+	GetChecks().push_back({ name, function });
+	return 0;
+}
+
+int Run(const std::string& name) {
+	for (const Entry& entry : GetChecks()) {
+		if (name == entry.name) {
+			if (!entry.function()) {
+				std::fprintf(stderr, "%s: FAILED\n", entry.name);
+				return 1;
+			}
+			std::printf("%s: OK\n", entry.name);
+			return 0;
+		}
+	}
+	std::fprintf(stderr, "unknown check: %s\n", name.c_str());
+	return 1;
+}
+
+bool Fail(const char* format, ...) {
+	va_list args;
+	va_start(args, format);
+	std::vfprintf(stderr, format, args);
+	va_end(args);
+	std::fputc('\n', stderr);
+	return false;
+}
+
+}  // namespace check
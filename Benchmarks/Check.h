@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+
+// ベンチマークの数値だけでは分からない正しさの確認 (SIMD版とスカラー版の一致、総当たりとの比較、描画結果など)
+// mt3_benchmarks --check=<名前> で1つ実行する。CMakeLists.txt の MT3_CHECKS に名前を書くと ctest から実行される
+//
+//   bool CheckTransformArray() {
+//       ...
+//       if (out != expected) {
+//           return check::Fail("point %u differs", i);
+//       }
+//       return true;
+//   }
+//   MT3_CHECK(CheckTransformArray);
+
+namespace check {
+
+using Function = bool (*)();
+
+int Register(const char* name, Function function);
+
+// 名前が一致するものを実行する。戻り値は main の戻り値 (見つからないときや失敗したときは 1)
+int Run(const std::string& name);
+
+// 失敗の内容を stderr に書いて false を返す (書式は printf と同じ)
+bool Fail(const char* format, ...);
+
+}  // namespace check
+
+#define MT3_CHECK_CONCAT2(a, b) a##b
+#define MT3_CHECK_CONCAT(a, b) MT3_CHECK_CONCAT2(a, b)
+
+#define MT3_CHECK(function) \
+	[[maybe_unused]] static int MT3_CHECK_CONCAT(check_, __LINE__) = ::check::Register(#function, function)
@@ -0,0 +1,1031 @@
+#include "BenchmarkUtility.h"
+#include "Check.h"
+#include "Arena.h"
+#include "BVH.h"
+#include "CollisionWorld.h"
+#include "Frustum.h"
+#include "SegmentPacket.h"
+#include "SpatialHashGrid.h"
+#include "SweptCollision.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iterator>
+#include <string>
+
+// 衝突判定とベジェ曲線のマイクロベンチマーク
+// 1回のループで kPairCount 組を判定し、当たった数を結果に使う
+
+namespace {
+
+const uint32_t kPairCount = 1024;
+const float kRange = 4.0f;  //!< 半分くらいの組が当たる広さ
+
+template <typename T>
+const std::vector<T>& Primitives(T (*generator)(float), uint32_t salt) {
+	// 同じ型でも別の配列を使えるように salt で分ける
+	static std::vector<T> arrays[2];
+	std::vector<T>& array = arrays[salt];
+	if (array.empty()) {
+		array = MakeRandomArray<T>(kPairCount, [&] { return generator(kRange); });
+	}
+	return array;
+}
+
+// a[i] と b[i] の組を判定する
+template <typename A, typename B, typename Test>
+void RunPairs(benchmark::State& state, const std::vector<A>& a, const std::vector<B>& b, Test&& test) {
+	for (auto _ : state) {
+		uint32_t hits = 0;
+		for (uint32_t i = 0; i < kPairCount; ++i) {
+			hits += test(a[i], b[i]) ? 1 : 0;
+		}
+		benchmark::DoNotOptimize(hits);
+	}
+	state.SetItemsProcessed(state.iterations() * kPairCount);
+}
+
+}  // namespace
+
+
+//====================================  1組ずつの衝突判定  ===========================================
+
+void BM_IsCollisionSphere(benchmark::State& state) {
+	RunPairs(state, Primitives(RandomSphere, 0), Primitives(RandomSphere, 1), IsCollisionSphere);
+}
+BENCHMARK(BM_IsCollisionSphere);
+
+void BM_IsCollisionPlane(benchmark::State& state) {
+	RunPairs(state, Primitives(RandomSphere, 0), Primitives(RandomPlane, 0), IsCollisionPlane);
+}
+BENCHMARK(BM_IsCollisionPlane);
+
+void BM_IsCollisionSegment(benchmark::State& state) {
+	RunPairs(state, Primitives(RandomSegment, 0), Primitives(RandomPlane, 0), IsCollisionSegment);
+}
+BENCHMARK(BM_IsCollisionSegment);
+
+void BM_IsCollisionTriangle(benchmark::State& state) {
+	RunPairs(state, Primitives(RandomTriangle, 0), Primitives(RandomSegment, 0), IsCollisionTriangle);
+}
+BENCHMARK(BM_IsCollisionTriangle);
+
+void BM_isCollisionAABB(benchmark::State& state) {
+	RunPairs(state, Primitives(RandomAABB, 0), Primitives(RandomAABB, 1), isCollisionAABB);
+}
+BENCHMARK(BM_isCollisionAABB);
+
+void BM_isCollisionSphereAABB(benchmark::State& state) {
+	RunPairs(state, Primitives(RandomAABB, 0), Primitives(RandomSphere, 0), isCollisionSphereAABB);
+}
+BENCHMARK(BM_isCollisionSphereAABB);
+
+void BM_IsCollisionAABBSeg(benchmark::State& state) {
+	RunPairs(state, Primitives(RandomAABB, 0), Primitives(RandomSegment, 0), IsCollisionAABBSeg);
+}
+BENCHMARK(BM_IsCollisionAABBSeg);
+
+//=================================================================================================
+
+
+//==================================  1つ対たくさん (CollisionWorld)  ================================
+
+void BM_CollisionWorldSphereVsPlanes(benchmark::State& state) {
+	ScopedSimdLevel simdLevel(state);
+	CollisionWorld world;
+	for (const Plane& plane : Primitives(RandomPlane, 0)) {
+		world.AddPlane(plane);
+	}
+	const std::vector<Sphere>& spheres = Primitives(RandomSphere, 0);
+	std::vector<uint64_t> hitMask(HitMaskWordCount(kPairCount));
+	uint32_t i = 0;
+	for (auto _ : state) {
+		uint32_t hits = world.SphereVsPlanes(spheres[i % kPairCount], hitMask.data());
+		benchmark::DoNotOptimize(hits);
+		++i;
+	}
+	state.SetItemsProcessed(state.iterations() * kPairCount);
+}
+BENCHMARK(BM_CollisionWorldSphereVsPlanes)->Apply(AllSimdLevels);
+
+void BM_CollisionWorldSphereVsAABBs(benchmark::State& state) {
+	ScopedSimdLevel simdLevel(state);
+	CollisionWorld world;
+	for (const AABB& aabb : Primitives(RandomAABB, 0)) {
+		world.AddAABB(aabb);
+	}
+	const std::vector<Sphere>& spheres = Primitives(RandomSphere, 0);
+	std::vector<uint64_t> hitMask(HitMaskWordCount(kPairCount));
+	uint32_t i = 0;
+	for (auto _ : state) {
+		uint32_t hits = world.SphereVsAABBs(spheres[i % kPairCount], hitMask.data());
+		benchmark::DoNotOptimize(hits);
+		++i;
+	}
+	state.SetItemsProcessed(state.iterations() * kPairCount);
+}
+BENCHMARK(BM_CollisionWorldSphereVsAABBs)->Apply(AllSimdLevels);
+
+//=================================================================================================
+
+
+//=====================================  視錐台カリング  ============================================
+
+namespace {
+
+// 原点を少し上から見るカメラ (kRange の範囲のうち一部だけが見える)
+Frustum BenchmarkFrustum() {
+	Matrix4x4 cameraMatrix = MakeAffineMatrix({ 1.0f, 1.0f, 1.0f }, { 0.26f, 0.0f, 0.0f }, { 0.0f, 1.9f, -6.49f });
+	Matrix4x4 projectionMatrix = MakePerspectiveFovMatrix(0.45f, 1280.0f / 720.0f, 0.1f, 100.0f);
+	return MakeFrustum(Multiply(Inverse(cameraMatrix), projectionMatrix));
+}
+
+}  // namespace
+
+void BM_FrustumVsSpheres(benchmark::State& state) {
+	ScopedSimdLevel simdLevel(state);
+	CollisionWorld world;
+	for (const Sphere& sphere : Primitives(RandomSphere, 0)) {
+		world.AddSphere(sphere);
+	}
+	Frustum frustum = BenchmarkFrustum();
+	std::vector<uint64_t> visibleMask(HitMaskWordCount(kPairCount));
+	for (auto _ : state) {
+		uint32_t visible = FrustumVsSpheres(frustum, world.GetSpheres(), visibleMask.data());
+		benchmark::DoNotOptimize(visible);
+	}
+	state.SetItemsProcessed(state.iterations() * kPairCount);
+}
+BENCHMARK(BM_FrustumVsSpheres)->Apply(AllSimdLevels);
+
+void BM_FrustumVsAABBs(benchmark::State& state) {
+	ScopedSimdLevel simdLevel(state);
+	CollisionWorld world;
+	for (const AABB& aabb : Primitives(RandomAABB, 0)) {
+		world.AddAABB(aabb);
+	}
+	Frustum frustum = BenchmarkFrustum();
+	std::vector<uint64_t> visibleMask(HitMaskWordCount(kPairCount));
+	for (auto _ : state) {
+		uint32_t visible = FrustumVsAABBs(frustum, world.GetAABBs(), visibleMask.data());
+		benchmark::DoNotOptimize(visible);
+	}
+	state.SetItemsProcessed(state.iterations() * kPairCount);
+}
+BENCHMARK(BM_FrustumVsAABBs)->Apply(AllSimdLevels);
+
+// 視錐台の確認 (ctest の CheckFrustum)。4種類の射影行列それぞれで
+// ・取り出した平面での点の判定が、クリップ空間の -w <= x, y <= w, 0 <= z <= w と一致するか (10万点)
+// ・SSE版・AVX2版のビットマスクがスカラー版と同じか
+namespace {
+
+bool CheckFrustum() {
+	struct Projection {
+		const char* name;
+		Matrix4x4 matrix;
+		DepthMode depthMode;
+	};
+	const float kFovY = 0.8f, kAspect = 1280.0f / 720.0f, kNear = 0.5f, kFar = 30.0f;
+	const Projection projections[] = {
+		{ "standard", MakePerspectiveFovMatrix(kFovY, kAspect, kNear, kFar), kDepthStandard },
+		{ "reverse-z", MakePerspectiveFovMatrixReverseZ(kFovY, kAspect, kNear, kFar), kDepthReverseZ },
+		{ "infinite", MakePerspectiveFovMatrixInfinite(kFovY, kAspect, kNear), kDepthStandard },
+		{ "reverse-z infinite", MakePerspectiveFovMatrixReverseZInfinite(kFovY, kAspect, kNear), kDepthReverseZ },
+	};
+	const uint32_t kPointCount = 100000;
+	const uint32_t kShapeCount = 1003;  // SIMD の幅で割り切れない数
+
+	for (const Projection& projection : projections) {
+		Matrix4x4 cameraMatrix = MakeAffineMatrix({ 1.0f, 1.0f, 1.0f }, RandomVector3(3.14f), RandomVector3(2.0f));
+		Matrix4x4 viewProjection = Multiply(Inverse(cameraMatrix), projection.matrix);
+		Frustum frustum = MakeFrustum(viewProjection, projection.depthMode);
+		const Matrix4x4& m = viewProjection;
+
+		uint32_t inside = 0, skipped = 0;
+		for (uint32_t i = 0; i < kPointCount; ++i) {
+			// カメラの前後に、視錐台より少し広い範囲で点を置く (半分はニアクリップ面の近く)
+			float viewZ = i % 2 == 0 ? RandomFloat(-1.0f, kNear * 4.0f) : RandomFloat(-1.0f, kFar * 1.3f);
+			float extent = (std::abs(viewZ) + 0.1f) * std::tan(kFovY * 0.5f) * 1.5f;
+			Vector3 p = Transform({ RandomFloat(-extent * kAspect, extent * kAspect), RandomFloat(-extent, extent), viewZ }, cameraMatrix);
+			double clip[4];
+			for (int column = 0; column < 4; ++column) {
+				clip[column] = double(p.x) * m.m[0][column] + double(p.y) * m.m[1][column] + double(p.z) * m.m[2][column] + m.m[3][column];
+			}
+			double w = clip[3];
+			const double margins[] = { w + clip[0], w - clip[0], w + clip[1], w - clip[1], clip[2], w - clip[2] };
+			// 境界のすぐ近くは float の丸めでどちらにもなりうるので比べない
+			bool expected = true, nearBoundary = false;
+			for (double margin : margins) {
+				expected = expected && margin >= 0.0;
+				nearBoundary = nearBoundary || std::abs(margin) < 1e-4 * (1.0 + std::abs(w));
+			}
+			if (nearBoundary) {
+				++skipped;
+				continue;
+			}
+			if (IsVisible(frustum, Sphere{ p, 0.0f }) != expected) {
+				return check::Fail("%s: point (%g, %g, %g) is %s the clip volume but the planes disagree",
+					projection.name, p.x, p.y, p.z, expected ? "inside" : "outside");
+			}
+			inside += expected ? 1 : 0;
+		}
+		if (inside == 0 || inside + skipped == kPointCount) {
+			return check::Fail("%s: %u of %u points inside, the test does not cover both sides", projection.name, inside, kPointCount);
+		}
+
+		CollisionWorld world;
+		for (uint32_t i = 0; i < kShapeCount; ++i) {
+			world.AddSphere(RandomSphere(kFar * 0.5f));
+			world.AddAABB(RandomAABB(kFar * 0.5f));
+		}
+		std::vector<uint64_t> expectedSpheres(HitMaskWordCount(kShapeCount)), expectedAABBs(HitMaskWordCount(kShapeCount));
+		SetSimdLevel(SimdLevel::Scalar);
+		FrustumVsSpheres(frustum, world.GetSpheres(), expectedSpheres.data());
+		FrustumVsAABBs(frustum, world.GetAABBs(), expectedAABBs.data());
+		for (SimdLevel level : { SimdLevel::SSE41, SimdLevel::AVX2 }) {
+			SetSimdLevel(level);
+			std::vector<uint64_t> spheres(HitMaskWordCount(kShapeCount)), aabbs(HitMaskWordCount(kShapeCount));
+			FrustumVsSpheres(frustum, world.GetSpheres(), spheres.data());
+			FrustumVsAABBs(frustum, world.GetAABBs(), aabbs.data());
+			if (spheres != expectedSpheres || aabbs != expectedAABBs) {
+				SetSimdLevel(DetectSimdLevel());
+				return check::Fail("%s: %s visibility masks differ from the scalar ones", projection.name, SimdLevelName(level));
+			}
+		}
+		SetSimdLevel(DetectSimdLevel());
+	}
+	return true;
+}
+MT3_CHECK(CheckFrustum);
+
+}  // namespace
+
+//=================================================================================================
+
+
+//======================================  一時メモリ  ==============================================
+// 毎フレーム作り直す組のリストを、ヒープから確保する場合とフレームアリーナから確保する場合
+
+namespace {
+
+const CollisionWorld& PairListWorld() {
+	static CollisionWorld world;
+	if (world.GetSphereCount() == 0) {
+		for (const Sphere& sphere : Primitives(RandomSphere, 0)) {
+			world.AddSphere(sphere);
+		}
+	}
+	return world;
+}
+
+}  // namespace
+
+void BM_PairListHeap(benchmark::State& state) {
+	const CollisionWorld& world = PairListWorld();
+	for (auto _ : state) {
+		std::vector<CollisionPair> pairs;
+		world.SpheresVsSpheres(pairs, *std::pmr::new_delete_resource());
+		benchmark::DoNotOptimize(pairs.data());
+	}
+	state.SetItemsProcessed(state.iterations() * kPairCount);
+}
+BENCHMARK(BM_PairListHeap);
+
+void BM_PairListArena(benchmark::State& state) {
+	const CollisionWorld& world = PairListWorld();
+	LinearArena arena;
+	for (auto _ : state) {
+		arena.Reset();
+		std::pmr::vector<CollisionPair> pairs(&arena);
+		world.SpheresVsSpheres(pairs, arena);
+		benchmark::DoNotOptimize(pairs.data());
+	}
+	state.SetCounter("arena_blocks", double(arena.GetBlockCount()));
+	state.SetItemsProcessed(state.iterations() * kPairCount);
+}
+BENCHMARK(BM_PairListArena);
+
+// 毎フレーム動いた球に合わせて BVH を更新し、重なっている組を探す (Refit はメモリを確保しない)
+void BM_BVHRefitSpheres(benchmark::State& state) {
+	std::vector<Sphere> spheres = Primitives(RandomSphere, 0);
+	BVH bvh;
+	BuildBVH(bvh, spheres.data(), kPairCount);
+	LinearArena arena;
+	float offset = 0.0f;
+	for (auto _ : state) {
+		offset = -offset + 0.01f;
+		for (Sphere& sphere : spheres) {
+			sphere.center.x += offset;
+		}
+		RefitBVH(bvh, spheres.data(), kPairCount);
+		arena.Reset();
+		std::pmr::vector<CollisionPair> pairs(&arena);
+		FindCollidingPairs(bvh, spheres.data(), pairs);
+		benchmark::DoNotOptimize(pairs.data());
+	}
+	state.SetItemsProcessed(state.iterations() * kPairCount);
+}
+BENCHMARK(BM_BVHRefitSpheres);
+
+// BVH の確認 (ctest の CheckBVH)
+// 同じ BVH を数を増やしたり減らしたりしながら作り直し (作業用の配列を使い回す)、
+// 組・線分の当たり・AABBとの重なりが総当たりと一致するか、Refit した後も一致するかを調べる
+namespace {
+
+bool SamePairs(std::vector<CollisionPair> pairs, const std::vector<CollisionPair>& expected) {
+	auto less = [](const CollisionPair& l, const CollisionPair& r) { return l.a != r.a ? l.a < r.a : l.b < r.b; };
+	std::sort(pairs.begin(), pairs.end(), less);
+	return pairs.size() == expected.size() &&
+		std::equal(pairs.begin(), pairs.end(), expected.begin(), [](const CollisionPair& l, const CollisionPair& r) { return l.a == r.a && l.b == r.b; });
+}
+
+bool SameIndices(std::vector<uint32_t> indices, const std::vector<uint32_t>& expected) {
+	std::sort(indices.begin(), indices.end());
+	return indices == expected;
+}
+
+bool CheckBVHSpheres(BVH& bvh, const std::vector<Sphere>& spheres, const char* stage) {
+	uint32_t count = uint32_t(spheres.size());
+	std::vector<CollisionPair> expected;
+	for (uint32_t a = 0; a < count; ++a) {
+		for (uint32_t b = a + 1; b < count; ++b) {
+			if (IsCollisionSphere(spheres[a], spheres[b])) {
+				expected.push_back({ a, b });
+			}
+		}
+	}
+	std::vector<CollisionPair> pairs;
+	FindCollidingPairs(bvh, spheres.data(), pairs);
+	if (!SamePairs(pairs, expected)) {
+		return check::Fail("%u spheres (%s): %zu pairs, brute force finds %zu", count, stage, pairs.size(), expected.size());
+	}
+
+	bool ok = true;
+	for (uint32_t query = 0; query < 50; ++query) {
+		AABB box = RandomAABB(8.0f);
+		std::vector<uint32_t> expectedIndices, indices;
+		for (uint32_t i = 0; i < count; ++i) {
+			if (isCollisionAABB(box, MakeAABB(spheres[i]))) {
+				expectedIndices.push_back(i);
+			}
+		}
+		bvh.QueryAABB(box, [&](uint32_t index) { indices.push_back(index); });
+		if (!SameIndices(indices, expectedIndices)) {
+			ok = check::Fail("%u spheres (%s): AABB query %u differs from brute force", count, stage, query);
+		}
+	}
+	return ok;
+}
+
+bool CheckBVH() {
+	bool ok = true;
+	BVH bvh;
+	for (uint32_t count : { 0u, 1u, 5u, 700u, 64u, 2000u, 3u, 300u }) {
+		std::vector<Sphere> spheres = MakeRandomArray<Sphere>(count, [] { return RandomSphere(8.0f); });
+		BuildBVH(bvh, spheres.data(), count);
+		ok = CheckBVHSpheres(bvh, spheres, "built") && ok;
+		for (uint32_t frame = 0; frame < 3; ++frame) {
+			for (Sphere& sphere : spheres) {
+				sphere.center = AddVector(sphere.center, RandomVector3(0.5f));
+			}
+			RefitBVH(bvh, spheres.data(), count);
+			ok = CheckBVHSpheres(bvh, spheres, "refit") && ok;
+		}
+	}
+
+	for (uint32_t count : { 1u, 9u, 500u }) {
+		std::vector<Triangle> triangles = MakeRandomArray<Triangle>(count, [] { return RandomTriangle(6.0f); });
+		std::vector<AABB> aabbs = MakeRandomArray<AABB>(count, [] { return RandomAABB(6.0f); });
+		BVH triangleBVH, aabbBVH;
+		BuildBVH(triangleBVH, triangles.data(), count);
+		BuildBVH(aabbBVH, aabbs.data(), count);
+		for (uint32_t query = 0; query < 200; ++query) {
+			Segment segment = RandomSegment(8.0f);
+			Vector3 invDiff = { 1.0f / segment.diff.x, 1.0f / segment.diff.y, 1.0f / segment.diff.z };
+			std::vector<uint32_t> expectedTriangles, expectedAABBs, hits;
+			for (uint32_t i = 0; i < count; ++i) {
+				if (IsCollisionTriangle(triangles[i], segment)) {
+					expectedTriangles.push_back(i);
+				}
+				if (IntersectSegmentAABB(segment.origin, invDiff, aabbs[i])) {
+					expectedAABBs.push_back(i);
+				}
+			}
+			FindSegmentHits(triangleBVH, triangles.data(), segment, hits);
+			if (!SameIndices(hits, expectedTriangles)) {
+				ok = check::Fail("%u triangles: segment %u hits differ from brute force", count, query);
+			}
+			hits.clear();
+			FindSegmentHits(aabbBVH, aabbs.data(), segment, hits);
+			if (!SameIndices(hits, expectedAABBs)) {
+				ok = check::Fail("%u AABBs: segment %u hits differ from brute force", count, query);
+			}
+		}
+	}
+	return ok;
+}
+MT3_CHECK(CheckBVH);
+
+}  // namespace
+
+//=================================================================================================
+
+
+//==================================  空間ハッシュグリッド  ===========================================
+// 毎フレーム作り直す 10万個の粒子 (直径 0.1 のセル)。Arg はスレッド数
+// 2回目以降の Build は作業用の配列を確保し直さず、ジョブシステムのスレッドで数える・書き込む
+
+namespace {
+
+const uint32_t kParticleCount = 100000;
+
+const std::vector<Sphere>& Particles() {
+	static std::vector<Sphere> particles;
+	if (particles.empty()) {
+		for (uint32_t i = 0; i < kParticleCount; ++i) {
+			particles.push_back({ RandomVector3(5.0f), RandomFloat(0.02f, 0.05f) });
+		}
+	}
+	return particles;
+}
+
+}  // namespace
+
+void BM_SpatialHashBuild(benchmark::State& state) {
+	JobSystem& jobSystem = BenchmarkJobSystem(uint32_t(state.range(0)));
+	const std::vector<Sphere>& particles = Particles();
+	SpatialHashGrid grid(0.1f);
+	for (auto _ : state) {
+		grid.Build(particles.data(), kParticleCount, &jobSystem);
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * kParticleCount);
+}
+BENCHMARK(BM_SpatialHashBuild)->Apply(ThreadCounts);
+
+// 1つだけ大きな球 (半径 2) があるときの重なりの列挙。大きな球はグリッドに入れないので、
+// 他の球の問い合わせの範囲は広がらない
+void BM_SpatialHashPairsWithLargeSphere(benchmark::State& state) {
+	std::vector<Sphere> particles = Particles();
+	particles[0].radius = 2.0f;
+	SpatialHashGrid grid(0.1f);
+	grid.Build(particles.data(), kParticleCount);
+	std::vector<CollisionPair> pairs;
+	for (auto _ : state) {
+		pairs.clear();
+		grid.QueryOverlapPairs(pairs);
+		benchmark::DoNotOptimize(pairs.data());
+	}
+	state.SetCounter("pairs", double(pairs.size()));
+	state.SetCounter("large", double(grid.GetLargeCount()));
+	state.SetItemsProcessed(state.iterations() * kParticleCount);
+}
+BENCHMARK(BM_SpatialHashPairsWithLargeSphere);
+
+// 空間ハッシュグリッドの確認 (ctest の CheckSpatialHashGrid)。重なっている組と近くの球を総当たりと比べる
+// 同じグリッドを大きさや大きな球の数の違う場面で作り直し、ジョブシステムありとなしの両方で構築する
+namespace {
+
+bool CheckSpatialHashGrid() {
+	struct Scene {
+		uint32_t count;
+		float range;
+		float maxRadius;
+		uint32_t largeCount;  //!< 半径がセルの大きさより大きい球の数
+	};
+	const Scene scenes[] = {
+		{ 0, 1.0f, 0.05f, 0 },
+		{ 1, 1.0f, 0.05f, 0 },
+		{ 2000, 1.0f, 0.05f, 0 },
+		{ 2000, 1.0f, 0.05f, 1 },
+		{ 5000, 3.0f, 0.1f, 15 },
+		{ 300, 0.5f, 0.1f, 300 },  // 全て大きな球
+	};
+	const float kCellSize = 0.1f;
+	SpatialHashGrid grid(kCellSize, 1 << 12);
+	JobSystem jobSystem(4);
+	std::vector<CollisionPair> pairs, expectedPairs;
+	std::vector<uint32_t> neighbors, expectedNeighbors;
+	auto pairLess = [](const CollisionPair& a, const CollisionPair& b) { return a.a != b.a ? a.a < b.a : a.b < b.b; };
+
+	for (uint32_t sceneIndex = 0; sceneIndex < std::size(scenes); ++sceneIndex) {
+		const Scene& scene = scenes[sceneIndex];
+		std::vector<Sphere> spheres;
+		for (uint32_t i = 0; i < scene.count; ++i) {
+			bool large = i < scene.largeCount;
+			spheres.push_back({ RandomVector3(scene.range), large ? RandomFloat(kCellSize * 1.5f, kCellSize * 10.0f) : RandomFloat(0.01f, scene.maxRadius) });
+		}
+		// 大きな球が先頭に固まらないように混ぜる
+		std::shuffle(spheres.begin(), spheres.end(), BenchmarkRandom());
+
+		expectedPairs.clear();
+		for (uint32_t i = 0; i < scene.count; ++i) {
+			for (uint32_t j = i + 1; j < scene.count; ++j) {
+				if (IsCollisionSphereSquared(spheres[i].center, spheres[i].radius, spheres[j].center, spheres[j].radius)) {
+					expectedPairs.push_back({ i, j });
+				}
+			}
+		}
+
+		for (JobSystem* buildJobSystem : { static_cast<JobSystem*>(nullptr), &jobSystem }) {
+			const char* mode = buildJobSystem ? "parallel" : "serial";
+			grid.Build(spheres.data(), scene.count, buildJobSystem);
+			if (grid.GetCount() != scene.count || grid.GetLargeCount() != scene.largeCount) {
+				return check::Fail("scene %u (%s): grid holds %u spheres, %u large (expected %u, %u)",
+					sceneIndex, mode, grid.GetCount(), grid.GetLargeCount(), scene.count, scene.largeCount);
+			}
+
+			pairs.clear();
+			grid.QueryOverlapPairs(pairs);
+			std::sort(pairs.begin(), pairs.end(), pairLess);
+			if (pairs.size() != expectedPairs.size() || !std::equal(pairs.begin(), pairs.end(), expectedPairs.begin(),
+				[](const CollisionPair& a, const CollisionPair& b) { return a.a == b.a && a.b == b.b; })) {
+				return check::Fail("scene %u (%s): %zu overlapping pairs, brute force found %zu", sceneIndex, mode, pairs.size(), expectedPairs.size());
+			}
+
+			for (uint32_t query = 0; query < 200; ++query) {
+				Vector3 center = RandomVector3(scene.range * 1.2f);
+				float radius = query % 10 == 0 ? RandomFloat(0.5f, 1.0f) : RandomFloat(0.0f, 0.2f);
+				neighbors.clear();
+				grid.QueryNeighbors(center, radius, [&](uint32_t index) { neighbors.push_back(index); });
+				std::sort(neighbors.begin(), neighbors.end());
+				expectedNeighbors.clear();
+				for (uint32_t i = 0; i < scene.count; ++i) {
+					if (IsCollisionSphereSquared(center, radius, spheres[i].center, spheres[i].radius)) {
+						expectedNeighbors.push_back(i);
+					}
+				}
+				if (neighbors != expectedNeighbors) {
+					return check::Fail("scene %u (%s): query %u found %zu neighbors, brute force found %zu",
+						sceneIndex, mode, query, neighbors.size(), expectedNeighbors.size());
+				}
+			}
+		}
+	}
+	return true;
+}
+MT3_CHECK(CheckSpatialHashGrid);
+
+}  // namespace
+
+//=================================================================================================
+
+
+//================================  線分パケットと三角形  ===========================================
+// 格子ごとに2つの三角形に分けたでこぼこの地面へ、三角形の辺や頂点の上の点を通る線分を撃つ
+// 地面に穴はなく、線分は地面のどの面よりも急なので、どの線分も必ずどれかの三角形に当たる
+// leaks は当たらなかった (隣り合う三角形の共有辺をすり抜けた) 線分の数
+
+namespace {
+
+const uint32_t kGroundCells = 16;  //!< 地面の1辺の格子の数
+const uint32_t kEdgeSegmentCount = 1024;
+
+struct GroundScene {
+	std::vector<Triangle> triangles;
+	std::vector<Segment> segments;
+};
+
+const GroundScene& GetGroundScene() {
+	static GroundScene scene;
+	if (scene.triangles.empty()) {
+		// 格子点を少しずらして、辺が軸にそろわないようにする
+		const uint32_t pointCount = kGroundCells + 1;
+		const float cellSize = 2.0f * kRange / float(kGroundCells);
+		std::vector<Vector3> points;
+		for (uint32_t z = 0; z < pointCount; ++z) {
+			for (uint32_t x = 0; x < pointCount; ++x) {
+				points.push_back({ -kRange + (float(x) + RandomFloat(-0.2f, 0.2f)) * cellSize, RandomFloat(-0.2f, 0.2f), -kRange + (float(z) + RandomFloat(-0.2f, 0.2f)) * cellSize });
+			}
+		}
+		auto addTriangle = [&](const Vector3& a, const Vector3& b, const Vector3& c) {
+			Triangle triangle = {};
+			triangle.vertices[0] = a;
+			triangle.vertices[1] = b;
+			triangle.vertices[2] = c;
+			scene.triangles.push_back(triangle);
+		};
+		for (uint32_t z = 0; z < kGroundCells; ++z) {
+			for (uint32_t x = 0; x < kGroundCells; ++x) {
+				const Vector3& p00 = points[z * pointCount + x];
+				const Vector3& p10 = points[z * pointCount + x + 1];
+				const Vector3& p01 = points[(z + 1) * pointCount + x];
+				const Vector3& p11 = points[(z + 1) * pointCount + x + 1];
+				// 対角線の向きを交互に変える
+				if ((x + z) % 2 == 0) {
+					addTriangle(p00, p01, p11);
+					addTriangle(p00, p11, p10);
+				}
+				else {
+					addTriangle(p00, p01, p10);
+					addTriangle(p10, p01, p11);
+				}
+			}
+		}
+		for (uint32_t i = 0; i < kEdgeSegmentCount; ++i) {
+			// 外周の格子は除く (外周の辺は片側にしか三角形がない)
+			uint32_t x = 1 + uint32_t(BenchmarkRandom()() % (kGroundCells - 2));
+			uint32_t z = 1 + uint32_t(BenchmarkRandom()() % (kGroundCells - 2));
+			const Triangle& triangle = scene.triangles[(z * kGroundCells + x) * 2 + BenchmarkRandom()() % 2];
+			uint32_t edge = uint32_t(BenchmarkRandom()() % 3);
+			const Vector3& a = triangle.vertices[edge];
+			const Vector3& b = triangle.vertices[(edge + 1) % 3];
+			// 8本に1本は頂点を通す
+			float s = (i % 8 == 0) ? 0.0f : RandomFloat(0.0f, 1.0f);
+			Vector3 target = AddVector(a, MultiplyVector(s, SubtractVector(b, a)));
+			// 上からと下から半分ずつ。狙った点が線分の真ん中になる
+			float height = (i % 2 == 0 ? 1.0f : -1.0f) * RandomFloat(1.5f, 3.0f);
+			Vector3 origin = AddVector(target, { RandomFloat(-0.5f, 0.5f), height, RandomFloat(-0.5f, 0.5f) });
+			scene.segments.push_back({ origin, MultiplyVector(2.0f, SubtractVector(target, origin)) });
+		}
+	}
+	return scene;
+}
+
+}  // namespace
+
+void BM_RaycastTrianglesSharedEdge(benchmark::State& state) {
+	ScopedSimdLevel simdLevel(state);
+	const GroundScene& scene = GetGroundScene();
+	uint32_t triangleCount = uint32_t(scene.triangles.size());
+	std::vector<SegmentHit> hits(kEdgeSegmentCount);
+	for (auto _ : state) {
+		RaycastTriangles(scene.segments.data(), kEdgeSegmentCount, scene.triangles.data(), triangleCount, hits.data());
+		benchmark::DoNotOptimize(hits.data());
+	}
+	uint32_t leaks = 0;
+	for (const SegmentHit& hit : hits) {
+		leaks += (hit.triangle == UINT32_MAX) ? 1 : 0;
+	}
+	state.SetCounter("leaks", double(leaks));
+	state.SetItemsProcessed(state.iterations() * kEdgeSegmentCount * triangleCount);
+}
+BENCHMARK(BM_RaycastTrianglesSharedEdge)->Apply(AllSimdLevels);
+
+// 線分パケットの確認 (ctest の CheckSegmentPacket)
+// ・共有辺や頂点を通る線分が、どの命令セットでも必ずどれかの三角形に当たる (すり抜けない)
+// ・三角形の集まりに対する結果が、どの命令セットでもスカラー版と同じ (パケットに入りきらない端数の線分を含む)
+// ・1つずつ判定して当たる三角形が、報告された交点より手前にない。辺から離れたところの当たりは IsCollisionTriangle でも当たる
+// ・activeMask で無効にしたレーンは、線分が三角形を通っていても当たりにならず、hit も書き換えない
+// ・AABBの面の上から面に沿って進む線分 (その軸の成分が0) が、スラブ法で外れにならない
+namespace {
+
+bool SameHits(const std::vector<SegmentHit>& a, const std::vector<SegmentHit>& b) {
+	for (size_t i = 0; i < a.size(); ++i) {
+		if (a[i].triangle != b[i].triangle || a[i].t != b[i].t || a[i].u != b[i].u || a[i].v != b[i].v) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool CheckSegmentPacket() {
+	const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2 };
+	bool ok = true;
+
+	const GroundScene& ground = GetGroundScene();
+	std::vector<SegmentHit> expected(kEdgeSegmentCount), hits(kEdgeSegmentCount);
+	for (SimdLevel level : levels) {
+		SetSimdLevel(level);
+		RaycastTriangles(ground.segments.data(), kEdgeSegmentCount, ground.triangles.data(), uint32_t(ground.triangles.size()), hits.data());
+		uint32_t leaks = 0;
+		for (const SegmentHit& hit : hits) {
+			leaks += (hit.triangle == UINT32_MAX) ? 1 : 0;
+		}
+		if (leaks != 0) {
+			ok = check::Fail("%s: %u segments slipped through shared edges or vertices", SimdLevelName(GetSimdLevel()), leaks);
+		}
+		if (level == SimdLevel::Scalar) {
+			expected = hits;
+		} else if (!SameHits(hits, expected)) {
+			ok = check::Fail("%s: shared-edge hits differ from the scalar ones", SimdLevelName(GetSimdLevel()));
+		}
+	}
+
+	const uint32_t kSoupSegmentCount = 37;  // 4 でも 8 でも割り切れない
+	for (uint32_t soup = 0; soup < 20; ++soup) {
+		std::vector<Triangle> triangles = MakeRandomArray<Triangle>(64, [] { return RandomTriangle(2.0f); });
+		std::vector<Segment> segments = MakeRandomArray<Segment>(kSoupSegmentCount, [] { return RandomSegment(3.0f); });
+		expected.resize(kSoupSegmentCount);
+		hits.resize(kSoupSegmentCount);
+		for (SimdLevel level : levels) {
+			SetSimdLevel(level);
+			RaycastTriangles(segments.data(), kSoupSegmentCount, triangles.data(), uint32_t(triangles.size()), hits.data());
+			if (level == SimdLevel::Scalar) {
+				expected = hits;
+			} else if (!SameHits(hits, expected)) {
+				ok = check::Fail("soup %u, %s: hits differ from the scalar ones", soup, SimdLevelName(GetSimdLevel()));
+			}
+		}
+		// 1つずつ判定したとき、当たった三角形は報告された一番近い交点より手前にはない
+		// 辺から離れたところの当たりは IsCollisionTriangle でも当たる (辺の近くは判定の違いで分かれるので除く)
+		for (uint32_t i = 0; i < kSoupSegmentCount; ++i) {
+			for (uint32_t j = 0; j < uint32_t(triangles.size()); ++j) {
+				SegmentHit single;
+				RaycastTriangles(&segments[i], 1, &triangles[j], 1, &single);
+				if (single.triangle == UINT32_MAX) {
+					continue;
+				}
+				if (single.t < expected[i].t) {
+					ok = check::Fail("soup %u: segment %u hits triangle %u before the reported nearest hit", soup, i, j);
+				}
+				bool nearEdge = (std::min)({ single.u, single.v, 1.0f - single.u - single.v }) < 1e-3f;
+				if (!nearEdge && !IsCollisionTriangle(triangles[j], segments[i])) {
+					ok = check::Fail("soup %u: segment %u hits triangle %u, but IsCollisionTriangle says it misses", soup, i, j);
+				}
+			}
+		}
+	}
+
+	// 全レーンが三角形を貫く線分のパケットで、一部のレーンを activeMask から外す
+	Triangle bigTriangle = { { { -10.0f, 0.0f, -10.0f }, { 10.0f, 0.0f, -10.0f }, { 0.0f, 0.0f, 10.0f } }, { 0.0f, 1.0f, 0.0f } };
+	std::vector<Segment> crossing = MakeRandomArray<Segment>(8, [] {
+		return Segment{ { RandomFloat(-1.0f, 1.0f), 1.0f, RandomFloat(-1.0f, 1.0f) }, { 0.0f, -2.0f, 0.0f } };
+	});
+	for (SimdLevel level : levels) {
+		SetSimdLevel(level);
+		SegmentPacket4 packet4 = MakeSegmentPacket<4>(crossing.data(), 4);
+		SegmentPacket8 packet8 = MakeSegmentPacket<8>(crossing.data(), 8);
+		packet4.activeMask = 0x5;
+		packet8.activeMask = 0x5A;
+		PacketHit<4> hit4;
+		PacketHit<8> hit8;
+		ResetPacketHit(hit4);
+		ResetPacketHit(hit8);
+		uint32_t mask4 = IntersectPacketTriangle(packet4, bigTriangle, 0, hit4);
+		uint32_t mask8 = IntersectPacketTriangle(packet8, bigTriangle, 0, hit8);
+		bool written = false;
+		for (uint32_t lane = 0; lane < 8; ++lane) {
+			written |= (lane < 4 && !(packet4.activeMask & (1u << lane)) && hit4.t[lane] != FLT_MAX);
+			written |= (!(packet8.activeMask & (1u << lane)) && hit8.t[lane] != FLT_MAX);
+		}
+		if (mask4 != packet4.activeMask || mask8 != packet8.activeMask || written) {
+			ok = check::Fail("%s: inactive lanes are reported or written as hits", SimdLevelName(GetSimdLevel()));
+		}
+	}
+
+	// 単位立方体の x = 0 と x = 1 の面の上から、面に沿って進む線分 (diff.x = 0 と -0)
+	AABB box = { { 0.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f } };
+	std::vector<Segment> faceSegments;
+	for (uint32_t i = 0; i < 8; ++i) {
+		float x = (i % 2 == 0) ? 0.0f : 1.0f;
+		Vector3 origin = { x, RandomFloat(0.1f, 0.9f), RandomFloat(0.1f, 0.9f) };
+		Vector3 diff = { (i % 4 < 2) ? 0.0f : -0.0f, RandomFloat(-0.5f, 0.5f), RandomFloat(-0.5f, 0.5f) };
+		faceSegments.push_back({ origin, diff });
+		Vector3 invDiff = { 1.0f / diff.x, 1.0f / diff.y, 1.0f / diff.z };
+		if (!IntersectSegmentAABB(origin, invDiff, box)) {
+			ok = check::Fail("face segment %u misses the box in IntersectSegmentAABB", i);
+		}
+	}
+	for (SimdLevel level : levels) {
+		SetSimdLevel(level);
+		for (uint32_t count : { 5u, 8u }) {
+			SegmentPacket4 packet4 = MakeSegmentPacket<4>(faceSegments.data(), (std::min)(count, 4u));
+			SegmentPacket8 packet8 = MakeSegmentPacket<8>(faceSegments.data(), count);
+			float tNear[8];
+			if (IntersectPacketAABB(packet4, box, tNear) != packet4.activeMask || IntersectPacketAABB(packet8, box, tNear) != packet8.activeMask) {
+				ok = check::Fail("%s: face segments miss the box in IntersectPacketAABB (%u lanes)", SimdLevelName(GetSimdLevel()), count);
+			}
+		}
+	}
+	SetSimdLevel(DetectSimdLevel());
+	return ok;
+}
+MT3_CHECK(CheckSegmentPacket);
+
+}  // namespace
+
+//=================================================================================================
+
+
+//====================================  連続衝突判定  =============================================
+// 薄い壁 (厚さ 0.04 の AABB) と床 (平面) の間を、小さい球が1フレームに壁の厚さより大きく動く場面
+// 1回の CCD と、移動を8回に分けてその瞬間の重なりを調べる方法を比べる
+// hits は当たった球の数。分けて調べる方は、途中で壁を通り過ぎたものを見逃す
+
+namespace {
+
+const uint32_t kMoverCount = 1024;
+const uint32_t kSubstepCount = 8;
+
+struct SweepScene {
+	CollisionWorld world;
+	std::vector<Sphere> spheres;
+	std::vector<Vector3> moves;
+};
+
+const SweepScene& GetSweepScene() {
+	static SweepScene scene;
+	if (scene.spheres.empty()) {
+		for (uint32_t i = 0; i < 64; ++i) {
+			Vector3 center = RandomVector3(kRange);
+			Vector3 half = { 0.02f, RandomFloat(0.5f, 1.5f), RandomFloat(0.5f, 1.5f) };
+			scene.world.AddAABB({ SubtractVector(center, half), AddVector(center, half) });
+		}
+		scene.world.AddPlane({ { 0.0f, 1.0f, 0.0f }, -kRange });
+		for (uint32_t i = 0; i < kMoverCount; ++i) {
+			scene.spheres.push_back({ RandomVector3(kRange), 0.05f });
+			scene.moves.push_back({ RandomFloat(-2.0f, 2.0f), RandomFloat(-1.0f, 0.5f), RandomFloat(-0.5f, 0.5f) });
+		}
+	}
+	return scene;
+}
+
+}  // namespace
+
+void BM_SweepSpheres(benchmark::State& state) {
+	const SweepScene& scene = GetSweepScene();
+	std::vector<SweepResult> results(kMoverCount);
+	uint32_t hits = 0;
+	for (auto _ : state) {
+		hits = SweepSpheres(scene.world, scene.spheres.data(), scene.moves.data(), kMoverCount, results.data());
+		benchmark::DoNotOptimize(results.data());
+	}
+	state.SetCounter("hits", double(hits));
+	state.SetItemsProcessed(state.iterations() * kMoverCount);
+}
+BENCHMARK(BM_SweepSpheres);
+
+void BM_SubstepSpheres(benchmark::State& state) {
+	const SweepScene& scene = GetSweepScene();
+	std::vector<uint64_t> aabbMask(HitMaskWordCount(scene.world.GetAABBCount()));
+	std::vector<uint64_t> planeMask(HitMaskWordCount(scene.world.GetPlaneCount()));
+	uint32_t hits = 0;
+	for (auto _ : state) {
+		hits = 0;
+		for (uint32_t i = 0; i < kMoverCount; ++i) {
+			for (uint32_t step = 1; step <= kSubstepCount; ++step) {
+				Sphere sphere = { AddVector(scene.spheres[i].center, MultiplyVector(float(step) / float(kSubstepCount), scene.moves[i])), scene.spheres[i].radius };
+				if (scene.world.SphereVsAABBs(sphere, aabbMask.data()) + scene.world.SphereVsPlanes(sphere, planeMask.data()) > 0) {
+					++hits;
+					break;
+				}
+			}
+		}
+		benchmark::DoNotOptimize(hits);
+	}
+	state.SetCounter("hits", double(hits));
+	state.SetItemsProcessed(state.iterations() * kMoverCount);
+}
+BENCHMARK(BM_SubstepSpheres);
+
+// 連続衝突判定の確認 (ctest の CheckSweep)。移動を細かく分けて、各時刻の距離を double で求めたもの (総当たり) と比べる
+// ・当たったとき: その時刻に接していて、それより前の時刻では重なっていない
+// ・当たらなかったとき: どの時刻でも重なっていない
+// 1ステップで進む距離より細かい違いは区別できないので、その分と丸めの分だけ許す
+namespace {
+
+struct Vector3d {
+	double x, y, z;
+};
+
+Vector3d ToDouble(const Vector3& v) { return { v.x, v.y, v.z }; }
+Vector3d Sub(const Vector3d& a, const Vector3d& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+Vector3d Mad(const Vector3d& a, double k, const Vector3d& b) { return { a.x + k * b.x, a.y + k * b.y, a.z + k * b.z }; }
+double Dot(const Vector3d& a, const Vector3d& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+double Length(const Vector3d& v) { return std::sqrt(Dot(v, v)); }
+
+// 点と三角形の最近接点 (Ericson, Real-Time Collision Detection 5.1.5)
+Vector3d ClosestPointOnTriangle(const Vector3d& p, const Vector3d& a, const Vector3d& b, const Vector3d& c) {
+	Vector3d ab = Sub(b, a), ac = Sub(c, a), ap = Sub(p, a);
+	double d1 = Dot(ab, ap), d2 = Dot(ac, ap);
+	if (d1 <= 0.0 && d2 <= 0.0) return a;
+	Vector3d bp = Sub(p, b);
+	double d3 = Dot(ab, bp), d4 = Dot(ac, bp);
+	if (d3 >= 0.0 && d4 <= d3) return b;
+	double vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0) return Mad(a, d1 / (d1 - d3), ab);
+	Vector3d cp = Sub(p, c);
+	double d5 = Dot(ab, cp), d6 = Dot(ac, cp);
+	if (d6 >= 0.0 && d5 <= d6) return c;
+	double vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0) return Mad(a, d2 / (d2 - d6), ac);
+	double va = d3 * d6 - d5 * d4;
+	if (va <= 0.0 && (d4 - d3) >= 0.0 && (d5 - d6) >= 0.0) return Mad(b, (d4 - d3) / ((d4 - d3) + (d5 - d6)), Sub(c, b));
+	double denom = 1.0 / (va + vb + vc);
+	return Mad(Mad(a, vb * denom, ab), vc * denom, ac);
+}
+
+double BoxGap(const Vector3d& minA, const Vector3d& maxA, const AABB& b) {
+	double gap = -DBL_MAX;
+	gap = (std::max)(gap, (std::max)(minA.x - b.max.x, b.min.x - maxA.x));
+	gap = (std::max)(gap, (std::max)(minA.y - b.max.y, b.min.y - maxA.y));
+	gap = (std::max)(gap, (std::max)(minA.z - b.max.z, b.min.z - maxA.z));
+	return gap;
+}
+
+double SphereBoxGap(const Vector3d& center, double radius, const AABB& box) {
+	Vector3d closest = {
+		(std::clamp)(center.x, double(box.min.x), double(box.max.x)),
+		(std::clamp)(center.y, double(box.min.y), double(box.max.y)),
+		(std::clamp)(center.z, double(box.min.z), double(box.max.z)),
+	};
+	return Length(Sub(center, closest)) - radius;
+}
+
+// gap(t) は時刻 t (0 ～ 1) での2つの図形の隙間 (重なっていれば負)。moveLength は移動量の長さ
+template <typename Gap>
+bool CheckSweepCase(const char* name, uint32_t index, bool hit, const SweepHit& sweepHit, double moveLength, Gap&& gap, uint32_t& hitCount) {
+	const uint32_t kStepCount = 4096;
+	const double tolerance = 1e-3 + moveLength / kStepCount;
+	if (hit) {
+		++hitCount;
+		if (!(sweepHit.time >= 0.0f && sweepHit.time <= 1.0f)) {
+			return check::Fail("%s %u: time %g is out of [0, 1]", name, index, sweepHit.time);
+		}
+		if (std::abs(Length(ToDouble(sweepHit.normal)) - 1.0) > 1e-3) {
+			return check::Fail("%s %u: normal is not a unit vector", name, index);
+		}
+		if (sweepHit.time > 0.0f && std::abs(gap(sweepHit.time)) > tolerance) {
+			return check::Fail("%s %u: shapes are %g apart at the reported time %g", name, index, gap(sweepHit.time), sweepHit.time);
+		}
+	}
+	double end = hit ? double(sweepHit.time) : 1.0;
+	for (uint32_t step = 0; step <= kStepCount; ++step) {
+		double t = double(step) / kStepCount;
+		if (t >= end) {
+			break;
+		}
+		if (gap(t) < -tolerance) {
+			return check::Fail("%s %u: shapes overlap by %g at time %g, but the sweep reported %s", name, index, -gap(t), t,
+				hit ? ("a later time " + std::to_string(sweepHit.time)).c_str() : "no hit");
+		}
+	}
+	return true;
+}
+
+bool CheckSweep() {
+	const uint32_t kCaseCount = 1500;
+	uint32_t hits[4] = {};
+	for (uint32_t i = 0; i < kCaseCount; ++i) {
+		Sphere sphere = { RandomVector3(2.0f), RandomFloat(0.1f, 0.8f) };
+		Vector3 move = RandomVector3(3.0f);
+		Vector3d start = ToDouble(sphere.center), moveD = ToDouble(move);
+		double moveLength = Length(moveD);
+		auto centerAt = [&](double t) { return Mad(start, t, moveD); };
+		SweepHit hit = {};
+
+		Plane plane = RandomPlane(1.0f);
+		bool planeHit = SweepSphereVsPlane(sphere, move, plane, hit);
+		if (!CheckSweepCase("sphere/plane", i, planeHit, hit, moveLength, [&](double t) {
+			return std::abs(Dot(ToDouble(plane.normal), centerAt(t)) - plane.distance) - sphere.radius;
+		}, hits[0])) {
+			return false;
+		}
+
+		AABB box = RandomAABB(1.0f);
+		bool boxHit = SweepSphereVsAABB(sphere, move, box, hit);
+		if (!CheckSweepCase("sphere/aabb", i, boxHit, hit, moveLength, [&](double t) {
+			return SphereBoxGap(centerAt(t), sphere.radius, box);
+		}, hits[1])) {
+			return false;
+		}
+
+		Triangle triangle = RandomTriangle(1.0f);
+		bool triangleHit = SweepSphereVsTriangle(sphere, move, triangle, hit);
+		if (!CheckSweepCase("sphere/triangle", i, triangleHit, hit, moveLength, [&](double t) {
+			Vector3d center = centerAt(t);
+			Vector3d closest = ClosestPointOnTriangle(center, ToDouble(triangle.vertices[0]), ToDouble(triangle.vertices[1]), ToDouble(triangle.vertices[2]));
+			return Length(Sub(center, closest)) - sphere.radius;
+		}, hits[2])) {
+			return false;
+		}
+
+		AABB moving = RandomAABB(2.0f);
+		bool aabbHit = SweepAABBVsAABB(moving, move, box, hit);
+		if (!CheckSweepCase("aabb/aabb", i, aabbHit, hit, moveLength, [&](double t) {
+			return BoxGap(Mad(ToDouble(moving.min), t, moveD), Mad(ToDouble(moving.max), t, moveD), box);
+		}, hits[3])) {
+			return false;
+		}
+	}
+	// 当たる場合と当たらない場合の両方を確かめているか
+	for (uint32_t count : hits) {
+		if (count == 0 || count == kCaseCount) {
+			return check::Fail("the random cases do not cover both hits and misses");
+		}
+	}
+	return true;
+}
+MT3_CHECK(CheckSweep);
+
+}  // namespace
+
+//=================================================================================================
+
+
+//=======================================  ベジェ曲線  ==============================================
+
+void BM_Bezier(benchmark::State& state) {
+	std::vector<Vector3> points = MakeRandomArray<Vector3>(3, [] { return RandomVector3(2.0f); });
+	for (auto _ : state) {
+		for (int index = 0; index <= 32; ++index) {
+			Vector3 result = Bezier(points[0], points[1], points[2], index / 32.0f);
+			benchmark::DoNotOptimize(result);
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * 33);
+}
+BENCHMARK(BM_Bezier);
+
+//=================================================================================================
@@ -0,0 +1,109 @@
+#include "BenchmarkUtility.h"
+#include "Curve.h"
+
+// 曲線の評価のベンチマーク
+// 1回のループで kSampleCount 点 (または kSampleCount 本の曲線) を評価する
+
+namespace {
+
+const uint32_t kSampleCount = 1024;
+
+std::vector<float> RandomParameters() {
+	return MakeRandomArray<float>(kSampleCount, [] { return RandomFloat(0.0f, 1.0f); });
+}
+
+CubicPolynomial RandomCubicBezier() {
+	return MakeCubicBezierPolynomial(RandomVector3(2.0f), RandomVector3(2.0f), RandomVector3(2.0f), RandomVector3(2.0f));
+}
+
+}  // namespace
+
+
+//====================================  1つの曲線・たくさんの t  =====================================
+
+// ド・カステリョで1点ずつ (比較用)
+void BM_CubicBezierDeCasteljau(benchmark::State& state) {
+	Vector3 p[4] = { RandomVector3(2.0f), RandomVector3(2.0f), RandomVector3(2.0f), RandomVector3(2.0f) };
+	std::vector<float> t = RandomParameters();
+	std::vector<Vector3> out(kSampleCount);
+	for (auto _ : state) {
+		for (uint32_t i = 0; i < kSampleCount; ++i) {
+			out[i] = CubicBezier(p[0], p[1], p[2], p[3], t[i]);
+		}
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * kSampleCount);
+}
+BENCHMARK(BM_CubicBezierDeCasteljau);
+
+void BM_EvaluateCubicArray(benchmark::State& state) {
+	ScopedSimdLevel simdLevel(state);
+	CubicPolynomial curve = RandomCubicBezier();
+	std::vector<float> t = RandomParameters();
+	std::vector<Vector3> out(kSampleCount);
+	for (auto _ : state) {
+		EvaluateCubicArray(curve, t.data(), out.data(), kSampleCount);
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * kSampleCount);
+}
+BENCHMARK(BM_EvaluateCubicArray)->Apply(AllSimdLevels);
+
+//=================================================================================================
+
+
+//==================================  たくさんの曲線・それぞれの t  ===================================
+
+void BM_EvaluateCubicCurves(benchmark::State& state) {
+	ScopedSimdLevel simdLevel(state);
+	CubicCurvesSoA curves;
+	for (uint32_t i = 0; i < kSampleCount; ++i) {
+		curves.Add(RandomCubicBezier());
+	}
+	std::vector<float> t = RandomParameters();
+	std::vector<Vector3> out(kSampleCount);
+	for (auto _ : state) {
+		EvaluateCubicCurves(curves, t.data(), out.data());
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * kSampleCount);
+}
+BENCHMARK(BM_EvaluateCubicCurves)->Apply(AllSimdLevels);
+
+//=================================================================================================
+
+
+//====================================  Bスプライン・弧長  ===========================================
+
+void BM_EvaluateBSpline(benchmark::State& state) {
+	const uint32_t degree = uint32_t(state.range(0));
+	std::vector<Vector3> points = MakeRandomArray<Vector3>(16, [] { return RandomVector3(2.0f); });
+	std::vector<float> knots;
+	MakeClampedKnots(uint32_t(points.size()), degree, knots);
+	std::vector<float> t = RandomParameters();
+	for (auto _ : state) {
+		for (uint32_t i = 0; i < kSampleCount; ++i) {
+			Vector3 result = EvaluateBSpline(points.data(), uint32_t(points.size()), degree, knots.data(), t[i]);
+			benchmark::DoNotOptimize(result);
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * kSampleCount);
+}
+BENCHMARK(BM_EvaluateBSpline)->Arg(2)->Arg(3)->Arg(5);
+
+void BM_ArcLengthParameter(benchmark::State& state) {
+	CubicPolynomial curve = RandomCubicBezier();
+	ArcLengthTable table;
+	table.Build([&](float t) { return EvaluateCubic(curve, t); }, 256);
+	std::vector<float> fractions = RandomParameters();
+	for (auto _ : state) {
+		for (uint32_t i = 0; i < kSampleCount; ++i) {
+			float t = table.ParameterAtFraction(fractions[i]);
+			benchmark::DoNotOptimize(t);
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * kSampleCount);
+}
+BENCHMARK(BM_ArcLengthParameter);
+
+//=================================================================================================
@@ -0,0 +1,683 @@
+#include "BenchmarkUtility.h"
+#include "Check.h"
+#include "MyMath.h"
+#include "Arena.h"
+#include "FrameGraph.h"
+#include "Profiler.h"
+#include "SoftwareRasterizer.h"
+#include "WorldOrigin.h"
+#include <span>
+
+// main.cpp の1フレーム分の更新・描画処理を再現するマクロベンチマーク
+// Novice は NoviceStub/Novice.h に置き換えているので、描画関数の計算だけを計測する
+// (main.cpp を変更したときはここも合わせる)
+
+namespace {
+
+const int kWindowWidth = 1280;
+const int kWindowHeight = 720;
+constexpr Matrix4x4 kViewportMatrix = MakeViewportMatrix(0.0f, 0.0f, float(kWindowWidth), float(kWindowHeight), 0.0f, 1.0f);
+const double kRebaseDistance = 1000.0;
+
+struct FrameState {
+	Vector3 cameraScale = { 1.0f, 1.0f, 1.0f };
+	Vector3 cameraRotate = { 0.26f, 0.0f, 0.0f };
+	Vec3d cameraTranslate = { 0.0, 1.9, -6.49 };
+	// カメラが原点から kRebaseDistance 以内なので、ワールド座標と原点からの座標は同じになる
+	Vector3 controlPoint[3] = {
+		{ -0.8f, 0.58f, 1.0f },
+		{ 1.76f, 1.0f, -0.3f },
+		{ 0.94f, -0.7f, 2.3f },
+	};
+};
+
+// 更新処理 (main.cpp の「更新処理ここから」～「ここまで」)
+ScreenTransform UpdateFrame(const FrameState& frame) {
+	WorldOrigin worldOrigin(kRebaseDistance);
+	worldOrigin.Rebase(frame.cameraTranslate);
+	Matrix4x4 cameraMatrix = MakeAffineMatrix(frame.cameraScale, frame.cameraRotate, worldOrigin.ToLocal(frame.cameraTranslate));
+	Matrix4x4 viewMatrix = InverseAffine(cameraMatrix);
+	Matrix4x4 projectMatrix = MakePerspectiveFovMatrixReverseZ(0.45f, float(kWindowWidth) / float(kWindowHeight), 0.1f, 100.0f);
+	return MakeScreenTransform(viewMatrix, projectMatrix, kViewportMatrix, kDepthReverseZ);
+}
+
+// 描画処理 (main.cpp の「描画処理ここから」～「ここまで」、ImGui は除く)
+void DrawFrame(const FrameState& frame, const ScreenTransform& screenTransform) {
+	DrawGrid(screenTransform);
+	DrawBezier(frame.controlPoint[0], frame.controlPoint[1], frame.controlPoint[2], screenTransform, BLUE);
+	DrawSphere(Sphere{ frame.controlPoint[0], 0.01f }, screenTransform, BLACK);
+	DrawSphere(Sphere{ frame.controlPoint[1], 0.01f }, screenTransform, BLACK);
+	DrawSphere(Sphere{ frame.controlPoint[2], 0.01f }, screenTransform, BLACK);
+}
+
+// 1回あたりの描画呼び出し数を結果に出す
+void ReportDrawCalls(benchmark::State& state) {
+	const Novice::StubStats& stats = Novice::GetStubStats();
+	state.SetCounter("lines_per_iteration", double(stats.lineCount) / double(state.iterations()));
+	state.SetCounter("triangles_per_iteration", double(stats.triangleCount) / double(state.iterations()));
+	benchmark::DoNotOptimize(stats.coordinateSum);
+}
+
+}  // namespace
+
+
+//=========================================  1フレーム  =============================================
+
+void BM_Frame(benchmark::State& state) {
+	ScopedSimdLevel simdLevel(state);
+	FrameState frame;
+	Novice::ResetStubStats();
+	for (auto _ : state) {
+		// 毎フレーム少しだけカメラを動かす (ImGui で操作したときと同じ)
+		frame.cameraRotate.y += 0.001f;
+		ScreenTransform screenTransform = UpdateFrame(frame);
+		DrawFrame(frame, screenTransform);
+	}
+	ReportDrawCalls(state);
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Frame)->Apply(AllSimdLevels);
+
+// main.cpp と同じく LineBatch にためて、フレームの最後に1回だけ描く
+// スタブの DrawLine はほぼ何もしないので、BM_Frame との差は並べ替え・重複の削除にかかる時間になる
+void BM_FrameBatched(benchmark::State& state) {
+	ScopedSimdLevel simdLevel(state);
+	FrameState frame;
+	LineBatch lineBatch;
+	NoviceLineBackend lineBackend;
+	SetLineBatch(&lineBatch);
+	Novice::ResetStubStats();
+	for (auto _ : state) {
+		frame.cameraRotate.y += 0.001f;
+		ScreenTransform screenTransform = UpdateFrame(frame);
+		DrawFrame(frame, screenTransform);
+		lineBatch.Flush(lineBackend);
+	}
+	SetLineBatch(nullptr);
+	ReportDrawCalls(state);
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FrameBatched)->Apply(AllSimdLevels);
+
+void BM_FrameUpdate(benchmark::State& state) {
+	ScopedSimdLevel simdLevel(state);
+	FrameState frame;
+	for (auto _ : state) {
+		frame.cameraRotate.y += 0.001f;
+		ScreenTransform screenTransform = UpdateFrame(frame);
+		benchmark::DoNotOptimize(screenTransform);
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FrameUpdate)->Apply(AllSimdLevels);
+
+// ワールドの原点から 20km 離れた場所で、カメラと制御点の位置から画面上の位置を求める
+// 0: 全て float のワールド座標で計算する、1: WorldOrigin で原点をカメラに移してから計算する
+// screen_error_px は、同じ配置をワールドの原点で計算したときとの画面上のずれの最大値
+void BM_FrameUpdateFarFromOrigin(benchmark::State& state) {
+	const Vec3d kFarOffset = { 20000.0, 0.0, 20000.0 };
+	bool rebase = state.range(0) != 0;
+	FrameState frame;
+
+	auto project = [&](const Vector3& camera, const Vector3* points, Vector3* screen) {
+		Matrix4x4 cameraMatrix = MakeAffineMatrix(frame.cameraScale, frame.cameraRotate, camera);
+		Matrix4x4 viewMatrix = InverseAffine(cameraMatrix);
+		Matrix4x4 projectMatrix = MakePerspectiveFovMatrix(0.45f, float(kWindowWidth) / float(kWindowHeight), 0.1f, 100.0f);
+		ScreenTransform screenTransform = MakeScreenTransform(viewMatrix, projectMatrix, kViewportMatrix);
+		for (int index = 0; index < 3; ++index) {
+			screen[index] = Transform(points[index], screenTransform.matrix);
+		}
+	};
+
+	Vector3 reference[3];
+	project(ToVector3(VecCast<float>(frame.cameraTranslate)), frame.controlPoint, reference);
+
+	Vec3d cameraWorld = frame.cameraTranslate + kFarOffset;
+	Vec3d controlPointWorld[3];
+	for (int index = 0; index < 3; ++index) {
+		controlPointWorld[index] = VecCast<double>(ToVec3f(frame.controlPoint[index])) + kFarOffset;
+	}
+
+	Vector3 screen[3];
+	for (auto _ : state) {
+		Vector3 camera;
+		Vector3 controlPoint[3];
+		if (rebase) {
+			WorldOrigin worldOrigin(kRebaseDistance);
+			worldOrigin.Rebase(cameraWorld);
+			camera = worldOrigin.ToLocal(cameraWorld);
+			worldOrigin.ToLocal(controlPointWorld, controlPoint, 3);
+		} else {
+			camera = ToVector3(VecCast<float>(cameraWorld));
+			for (int index = 0; index < 3; ++index) {
+				controlPoint[index] = ToVector3(VecCast<float>(controlPointWorld[index]));
+			}
+		}
+		project(camera, controlPoint, screen);
+		benchmark::DoNotOptimize(screen);
+	}
+
+	double error = 0.0;
+	for (int index = 0; index < 3; ++index) {
+		error = (std::max)(error, double(std::hypot(screen[index].x - reference[index].x, screen[index].y - reference[index].y)));
+	}
+	state.SetCounter("screen_error_px", error);
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FrameUpdateFarFromOrigin)->Arg(0)->Arg(1);
+
+//=================================================================================================
+
+
+//======================================  描画関数ごと  =============================================
+
+void BM_DrawGrid(benchmark::State& state) {
+	ScopedSimdLevel simdLevel(state);
+	ScreenTransform screenTransform = UpdateFrame(FrameState());
+	Novice::ResetStubStats();
+	for (auto _ : state) {
+		DrawGrid(screenTransform);
+	}
+	ReportDrawCalls(state);
+}
+BENCHMARK(BM_DrawGrid)->Apply(AllSimdLevels);
+
+void BM_DrawSphere(benchmark::State& state) {
+	ScopedSimdLevel simdLevel(state);
+	FrameState frame;
+	ScreenTransform screenTransform = UpdateFrame(frame);
+	Novice::ResetStubStats();
+	for (auto _ : state) {
+		// 以前の固定の分割数 (12) と比べられるようにする
+		DrawSphere(Sphere{ frame.controlPoint[0], 0.5f }, screenTransform, BLACK, 12);
+	}
+	ReportDrawCalls(state);
+}
+BENCHMARK(BM_DrawSphere)->Apply(AllSimdLevels);
+
+// main.cpp の制御点の球 (画面上で数ピクセル。分割数は自動で選ぶ)
+void BM_DrawSphereSmall(benchmark::State& state) {
+	ScopedSimdLevel simdLevel(state);
+	FrameState frame;
+	ScreenTransform screenTransform = UpdateFrame(frame);
+	Novice::ResetStubStats();
+	for (auto _ : state) {
+		DrawSphere(Sphere{ frame.controlPoint[0], 0.01f }, screenTransform, BLACK);
+	}
+	ReportDrawCalls(state);
+}
+BENCHMARK(BM_DrawSphereSmall)->Apply(AllSimdLevels);
+
+void BM_DrawBezier(benchmark::State& state) {
+	ScopedSimdLevel simdLevel(state);
+	FrameState frame;
+	ScreenTransform screenTransform = UpdateFrame(frame);
+	Novice::ResetStubStats();
+	for (auto _ : state) {
+		DrawBezier(frame.controlPoint[0], frame.controlPoint[1], frame.controlPoint[2], screenTransform, BLUE);
+	}
+	ReportDrawCalls(state);
+}
+BENCHMARK(BM_DrawBezier)->Apply(AllSimdLevels);
+
+// 数ピクセルしかない小さい曲線 (パスエディタのオーバーレイのような場合)
+void BM_DrawBezierSmall(benchmark::State& state) {
+	ScopedSimdLevel simdLevel(state);
+	FrameState frame;
+	ScreenTransform screenTransform = UpdateFrame(frame);
+	Vector3 controlPoint[3];
+	for (int index = 0; index < 3; ++index) {
+		controlPoint[index] = MultiplyVector(0.02f, frame.controlPoint[index]);
+	}
+	Novice::ResetStubStats();
+	for (auto _ : state) {
+		DrawBezier(controlPoint[0], controlPoint[1], controlPoint[2], screenTransform, BLUE);
+	}
+	ReportDrawCalls(state);
+}
+BENCHMARK(BM_DrawBezierSmall)->Apply(AllSimdLevels);
+
+//=================================================================================================
+
+
+//====================================  線分をまとめて描く  ==========================================
+
+// 共有辺のある AABB を並べたときの Flush (並べ替え・重複の削除) の速さ
+// 引数は AABB の数。描画側はメモリに書き出すだけなので、Flush 自体の時間になる
+void BM_LineBatchFlush(benchmark::State& state) {
+	ScreenTransform screenTransform = UpdateFrame(FrameState());
+	uint32_t count = uint32_t(state.range(0));
+	LineBatch lineBatch;
+	MemoryLineBackend lineBackend;
+	SetLineBatch(&lineBatch);
+	for (auto _ : state) {
+		state.PauseTiming();
+		lineBackend.Clear();
+		for (uint32_t i = 0; i < count; ++i) {
+			float x = -2.0f + 0.25f * float(i % 16);
+			float z = -2.0f + 0.25f * float(i / 16 % 16);
+			DrawAABB(AABB{ { x, 0.0f, z }, { x + 0.25f, 0.25f, z + 0.25f } }, screenTransform, i % 2 == 0 ? RED : BLUE);
+		}
+		state.ResumeTiming();
+		lineBatch.Flush(lineBackend);
+	}
+	SetLineBatch(nullptr);
+	// 色が切り替わる回数 (色ごとにまとまっていれば深度のまとまりの数程度になる)
+	const std::vector<ScreenLine>& lines = lineBackend.GetLines();
+	uint32_t colorChanges = 0;
+	for (size_t i = 1; i < lines.size(); ++i) {
+		colorChanges += lines[i].color != lines[i - 1].color ? 1 : 0;
+	}
+	state.SetCounter("lines_per_iteration", double(lineBatch.GetSubmittedCount()));
+	state.SetCounter("color_changes", double(colorChanges));
+	state.SetItemsProcessed(state.iterations() * count * 12);
+}
+BENCHMARK(BM_LineBatchFlush)->Arg(16)->Arg(256);
+
+// LineBatch::Flush の確認 (ctest の CheckLineBatch)。座標が16ビットに収まるときと収まらないときの両方の並べ替えを、
+// 素直に書いたもの (同じ線分は一番手前だけ残し、深度のまとまり → 色 → 深度 → 座標 の順に並べる) と比べる
+namespace {
+
+bool CheckLineBatch() {
+	struct Line {
+		ScreenLine line;
+		uint32_t depthOrder;
+	};
+	const uint32_t colors[] = { RED, BLUE, BLACK, WHITE };
+	LineBatch lineBatch;
+	MemoryLineBackend lineBackend;
+	std::vector<Line> lines;
+	std::vector<ScreenLine> expected;
+	for (uint32_t batch = 0; batch < 800; ++batch) {
+		bool wide = batch % 2 == 1;
+		uint32_t lineCount = uint32_t(RandomFloat(0.0f, 300.0f));
+		lines.clear();
+		for (uint32_t i = 0; i < lineCount; ++i) {
+			// 重複や逆向きの線分が出るように、狭い範囲の座標と少ない色・深度から選ぶ
+			auto coordinate = [] { return int32_t(RandomFloat(-4.0f, 4.0f)); };
+			Line line = { { coordinate(), coordinate(), coordinate(), coordinate(), colors[uint32_t(RandomFloat(0.0f, 4.0f)) % 4] },
+				DepthDrawOrder(RandomFloat(0.5f, 0.6f), kDepthReverseZ) };
+			if (wide && i == 0) {
+				line.line.x1 = 100000;
+			}
+			lines.push_back(line);
+			lineBatch.Add(line.line.x0, line.line.y0, line.line.x1, line.line.y1, line.line.color, line.depthOrder);
+		}
+		lineBackend.Clear();
+		lineBatch.Flush(lineBackend);
+
+		for (Line& line : lines) {
+			ScreenLine& l = line.line;
+			if (l.x1 < l.x0 || (l.x1 == l.x0 && l.y1 < l.y0)) {
+				std::swap(l.x0, l.x1);
+				std::swap(l.y0, l.y1);
+			}
+		}
+		std::vector<Line> kept;
+		for (const Line& line : lines) {
+			auto same = std::find_if(kept.begin(), kept.end(), [&](const Line& k) { return k.line == line.line; });
+			if (same == kept.end()) {
+				kept.push_back(line);
+			} else {
+				same->depthOrder = (std::max)(same->depthOrder, line.depthOrder);
+			}
+		}
+		const uint32_t shift = 32 - LineBatch::kDepthBucketBits;
+		std::sort(kept.begin(), kept.end(), [shift](const Line& a, const Line& b) {
+			if ((a.depthOrder >> shift) != (b.depthOrder >> shift)) return (a.depthOrder >> shift) < (b.depthOrder >> shift);
+			if (a.line.color != b.line.color) return a.line.color < b.line.color;
+			return a.depthOrder != b.depthOrder ? a.depthOrder < b.depthOrder : a.line < b.line;
+		});
+		expected.clear();
+		for (const Line& line : kept) {
+			expected.push_back(line.line);
+		}
+		if (lineBackend.GetLines() != expected) {
+			return check::Fail("batch %u (%s coordinates, %u lines): Flush submitted %zu lines that differ from the reference (%zu lines)",
+				batch, wide ? "wide" : "16-bit", lineCount, lineBackend.GetLines().size(), expected.size());
+		}
+	}
+	return true;
+}
+MT3_CHECK(CheckLineBatch);
+
+}  // namespace
+
+//=================================================================================================
+
+
+//=====================================  ジョブシステム  ============================================
+
+// main.cpp と同じフレームグラフ (更新 → カリング → 線の生成 → まとめる) と、その後の Flush
+void BM_FrameGraph(benchmark::State& state) {
+	JobSystem& jobSystem = BenchmarkJobSystem(uint32_t(state.range(0)));
+	FrameState frame;
+	LineBatch lineBatch;
+	ThreadLineBatches threadLineBatches(jobSystem);
+	NoviceLineBackend lineBackend;
+	FrameArena frameArena(jobSystem);
+
+	ScreenTransform screenTransform;
+	std::span<const uint32_t> visibleControlPoints;
+	FrameGraph frameGraph;
+	uint32_t updatePass = frameGraph.AddPass("update", [&] {
+		screenTransform = UpdateFrame(frame);
+	});
+	uint32_t cullPass = frameGraph.AddPass("cull", [&] {
+		LinearArena& arena = frameArena.GetThreadArena();
+		uint32_t* visible = arena.AllocateArray<uint32_t>(3);
+		uint32_t visibleCount = 0;
+		for (uint32_t index = 0; index < 3; ++index) {
+			if (IsVisible(screenTransform.frustum, Sphere{ frame.controlPoint[index], 0.01f })) {
+				visible[visibleCount++] = index;
+			}
+		}
+		visibleControlPoints = { visible, visibleCount };
+	}, { updatePass });
+	uint32_t tessellatePass = frameGraph.AddPass("tessellate", [&] {
+		jobSystem.ParallelFor(2 + uint32_t(visibleControlPoints.size()), 1, [&](uint32_t begin, uint32_t end) {
+			SetLineBatch(&threadLineBatches.Get());
+			for (uint32_t item = begin; item < end; ++item) {
+				if (item == 0) {
+					DrawGrid(screenTransform);
+				} else if (item == 1) {
+					DrawBezier(frame.controlPoint[0], frame.controlPoint[1], frame.controlPoint[2], screenTransform, BLUE);
+				} else {
+					DrawSphere(Sphere{ frame.controlPoint[visibleControlPoints[item - 2]], 0.01f }, screenTransform, BLACK);
+				}
+			}
+			SetLineBatch(nullptr);
+		});
+	}, { cullPass });
+	frameGraph.AddPass("submit", [&] {
+		threadLineBatches.MergeInto(lineBatch);
+	}, { tessellatePass });
+
+	Novice::ResetStubStats();
+	for (auto _ : state) {
+		frameArena.Reset();
+		frameGraph.Execute(jobSystem);
+		lineBatch.Flush(lineBackend);
+	}
+	ReportDrawCalls(state);
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FrameGraph)->Arg(1)->Arg(4);
+
+// たくさんの球 (画面内に並べた 1024 個) の線の生成をスレッド数を変えて並列に行う
+void BM_ParallelDrawSpheres(benchmark::State& state) {
+	const uint32_t kSphereCount = 1024;
+	JobSystem& jobSystem = BenchmarkJobSystem(uint32_t(state.range(0)));
+	ScreenTransform screenTransform = UpdateFrame(FrameState());
+	std::vector<Sphere> spheres;
+	for (uint32_t i = 0; i < kSphereCount; ++i) {
+		spheres.push_back({ { -2.0f + 4.0f * float(i % 32) / 32.0f, 0.2f, -2.0f + 4.0f * float(i / 32) / 32.0f }, 0.05f });
+	}
+	LineBatch lineBatch;
+	ThreadLineBatches threadLineBatches(jobSystem);
+
+	for (auto _ : state) {
+		jobSystem.ParallelFor(kSphereCount, 64, [&](uint32_t begin, uint32_t end) {
+			SetLineBatch(&threadLineBatches.Get());
+			for (uint32_t i = begin; i < end; ++i) {
+				DrawSphere(spheres[i], screenTransform, BLACK);
+			}
+			SetLineBatch(nullptr);
+		});
+		threadLineBatches.MergeInto(lineBatch);
+		state.PauseTiming();
+		state.SetCounter("lines_per_iteration", double(lineBatch.GetLineCount()));
+		lineBatch.Clear();  // Flush の時間は BM_LineBatchFlush で測る
+		state.ResumeTiming();
+	}
+	state.SetItemsProcessed(state.iterations() * kSphereCount);
+}
+BENCHMARK(BM_ParallelDrawSpheres)->Apply(ThreadCounts);
+
+// ジョブシステムの確認 (ctest の CheckJobSystem)。結果は atomic を使わない普通の変数に書くので、
+// MT3_SANITIZE_THREAD でビルドすると、Wait や FrameGraph の依存関係で同期が取れていないところを ThreadSanitizer が見つける
+namespace {
+
+bool CheckJobSystem() {
+	const uint32_t kCount = 100000;
+	std::vector<uint32_t> values(kCount);
+	for (uint32_t threadCount : { 1u, 2u, 4u, 8u }) {
+		{
+			JobSystem jobSystem(threadCount);
+
+			// 全ての要素がちょうど1回ずつ処理され、呼んだスレッドがこの JobSystem のものか
+			std::atomic<uint32_t> foreignCalls{ 0 };
+			jobSystem.ParallelFor(kCount, 64, [&](uint32_t begin, uint32_t end) {
+				if (!jobSystem.IsOwnThread() || JobSystem::GetThreadIndex() >= threadCount) {
+					foreignCalls.fetch_add(1, std::memory_order_relaxed);
+				}
+				for (uint32_t i = begin; i < end; ++i) {
+					values[i] += i;
+				}
+			});
+			for (uint32_t i = 0; i < kCount; ++i) {
+				if (values[i] != i) {
+					return check::Fail("%u threads: ParallelFor wrote %u to element %u", threadCount, values[i], i);
+				}
+				values[i] = 0;
+			}
+			if (foreignCalls != 0) {
+				return check::Fail("%u threads: %u ranges ran on a thread with a wrong index", threadCount, foreignCalls.load());
+			}
+
+			// ParallelFor の中の ParallelFor (待っている間に他のジョブを実行する)
+			jobSystem.ParallelFor(16, 1, [&](uint32_t outerBegin, uint32_t outerEnd) {
+				for (uint32_t outer = outerBegin; outer < outerEnd; ++outer) {
+					jobSystem.ParallelFor(kCount / 16, 100, [&](uint32_t begin, uint32_t end) {
+						for (uint32_t i = begin; i < end; ++i) {
+							values[outer * (kCount / 16) + i] = outer + 1;
+						}
+					});
+				}
+			});
+			for (uint32_t i = 0; i < kCount; ++i) {
+				if (values[i] != i / (kCount / 16) + 1) {
+					return check::Fail("%u threads: nested ParallelFor wrote %u to element %u", threadCount, values[i], i);
+				}
+				values[i] = 0;
+			}
+
+			// ひし形の依存関係 (a → b, c → d)。b と c は a の、d は b と c の結果を読む
+			uint32_t a = 0, b = 0, c = 0, d = 0;
+			uint32_t frameIndex = 0;
+			FrameGraph frameGraph;
+			uint32_t passA = frameGraph.AddPass("a", [&] { a = frameIndex; });
+			uint32_t passB = frameGraph.AddPass("b", [&] { b = a + 1; }, { passA });
+			uint32_t passC = frameGraph.AddPass("c", [&] { c = a + 2; }, { passA });
+			frameGraph.AddPass("d", [&] { d = b + c; }, { passB, passC });
+			for (frameIndex = 0; frameIndex < 200; ++frameIndex) {
+				frameGraph.Execute(jobSystem);
+				if (d != frameIndex * 2 + 3) {
+					return check::Fail("%u threads: frame graph pass d saw %u in frame %u", threadCount, d, frameIndex);
+				}
+			}
+
+			// ワーカーが作った JobSystem は、そのワーカーの番号を変えない
+			if (threadCount > 1) {
+				std::atomic<uint32_t> changed{ 0 };
+				jobSystem.ParallelFor(threadCount * 4, 1, [&](uint32_t, uint32_t) {
+					uint32_t before = JobSystem::GetThreadIndex();
+					{
+						JobSystem nested(2);
+					}
+					if (JobSystem::GetThreadIndex() != before) {
+						changed.fetch_add(1, std::memory_order_relaxed);
+					}
+				});
+				if (changed != 0) {
+					return check::Fail("%u threads: creating a JobSystem changed the index of %u threads", threadCount, changed.load());
+				}
+			}
+		}
+		// このスレッドで作った JobSystem が全て壊れたので、番号は元に戻る
+		if (JobSystem::GetThreadIndex() != JobSystem::kNoThreadIndex) {
+			return check::Fail("%u threads: the main thread kept index %u", threadCount, JobSystem::GetThreadIndex());
+		}
+	}
+	return true;
+}
+MT3_CHECK(CheckJobSystem);
+
+}  // namespace
+
+//=================================================================================================
+
+
+//================================  ソフトウェアラスタライザ  =======================================
+
+namespace {
+
+// KamataEngine の画面のクリア色 (0.1, 0.25, 0.5) と同じ
+const uint32_t kBackgroundColor = 0x1A4080FF;
+
+// main.cpp の1フレームを framebuffer に描く
+void RasterizeFrame(const FrameState& frame, LineBatch& lineBatch, SoftwareRasterizer& rasterizer, Framebuffer& framebuffer, JobSystem* jobSystem) {
+	RasterLineBackend lineBackend(rasterizer);
+	SetLineBatch(&lineBatch);
+	DrawFrame(frame, UpdateFrame(frame));
+	SetLineBatch(nullptr);
+	lineBatch.Flush(lineBackend);
+	framebuffer.Clear(kBackgroundColor);
+	rasterizer.Render(jobSystem);
+}
+
+}  // namespace
+
+bool RenderFrameImage(const std::string& path) {
+	Framebuffer framebuffer(kWindowWidth, kWindowHeight);
+	SoftwareRasterizer rasterizer(framebuffer);
+	LineBatch lineBatch;
+	RasterizeFrame(FrameState(), lineBatch, rasterizer, framebuffer, nullptr);
+	return framebuffer.Write(path);
+}
+
+// 描画結果の確認 (ctest の check_FrameImage)
+// Reference/frame.png は --render_frame で書き出した1フレーム (容量を抑えるため圧縮し直してある)、
+// kReferenceFrameHash はその画素の FNV-1a。命令セットやスレッド数を変えても同じ画像になることも確かめる
+// 描画を意図して変えたときは、画像を書き出し直し、失敗したときに表示されるハッシュに置き換える
+namespace {
+
+const uint64_t kReferenceFrameHash = 0x0F9CD256A26C5A9Aull;
+
+uint64_t HashPixels(const std::vector<uint32_t>& pixels) {
+	uint64_t hash = 0xCBF29CE484222325ull;
+	for (uint32_t pixel : pixels) {
+		for (int shift = 0; shift < 32; shift += 8) {
+			hash = (hash ^ ((pixel >> shift) & 0xFF)) * 0x100000001B3ull;
+		}
+	}
+	return hash;
+}
+
+bool CheckFrameImage() {
+	const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2 };
+	bool ok = true;
+	for (SimdLevel level : levels) {
+		for (uint32_t threadCount : { 0u, 4u }) {
+			SetSimdLevel(level);
+			Framebuffer framebuffer(kWindowWidth, kWindowHeight);
+			SoftwareRasterizer rasterizer(framebuffer);
+			LineBatch lineBatch;
+			RasterizeFrame(FrameState(), lineBatch, rasterizer, framebuffer, threadCount == 0 ? nullptr : &BenchmarkJobSystem(threadCount));
+			uint64_t hash = HashPixels(framebuffer.GetPixels());
+			if (hash != kReferenceFrameHash) {
+				// 見比べられるように書き出しておく
+				std::string path = std::string("frame_") + SimdLevelName(GetSimdLevel()) + "_" + std::to_string(threadCount) + ".png";
+				framebuffer.Write(path);
+				ok = check::Fail("%s, %u threads: hash 0x%016llX (expected 0x%016llX), written to %s",
+					SimdLevelName(GetSimdLevel()), threadCount, (unsigned long long)hash, (unsigned long long)kReferenceFrameHash, path.c_str());
+			}
+		}
+	}
+	SetSimdLevel(DetectSimdLevel());
+	return ok;
+}
+MT3_CHECK(CheckFrameImage);
+
+}  // namespace
+
+// 線の生成から画面に描き終わるまで。引数はスレッド数 (タイルを並列に描く)
+void BM_RasterizeFrame(benchmark::State& state) {
+	JobSystem& jobSystem = BenchmarkJobSystem(uint32_t(state.range(0)));
+	FrameState frame;
+	Framebuffer framebuffer(kWindowWidth, kWindowHeight);
+	SoftwareRasterizer rasterizer(framebuffer);
+	LineBatch lineBatch;
+	for (auto _ : state) {
+		frame.cameraRotate.y += 0.001f;
+		RasterizeFrame(frame, lineBatch, rasterizer, framebuffer, &jobSystem);
+		benchmark::DoNotOptimize(framebuffer.GetPixels().data());
+	}
+	state.SetCounter("lines_per_iteration", double(lineBatch.GetSubmittedCount()));
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RasterizeFrame)->Apply(ThreadCounts);
+
+// 画面の大きさ程度の三角形の塗りつぶし (1行分の判定を SIMD で行う)
+void BM_RasterizeTriangles(benchmark::State& state) {
+	ScopedSimdLevel simdLevel(state);
+	const uint32_t kTriangleCount = 64;
+	Framebuffer framebuffer(kWindowWidth, kWindowHeight);
+	SoftwareRasterizer rasterizer(framebuffer);
+	std::vector<int32_t> vertices;
+	for (uint32_t i = 0; i < kTriangleCount * 6; ++i) {
+		vertices.push_back(int32_t(RandomFloat(0.0f, float(i % 2 == 0 ? kWindowWidth : kWindowHeight))));
+	}
+	for (auto _ : state) {
+		for (uint32_t i = 0; i < kTriangleCount; ++i) {
+			const int32_t* v = &vertices[i * 6];
+			rasterizer.DrawTriangle(v[0], v[1], v[2], v[3], v[4], v[5], 0xFFFFFFFF - i, kRasterFillSolid);
+		}
+		rasterizer.Render();
+		benchmark::DoNotOptimize(framebuffer.GetPixels().data());
+	}
+	state.SetItemsProcessed(state.iterations() * kTriangleCount);
+}
+BENCHMARK(BM_RasterizeTriangles)->Apply(AllSimdLevels);
+
+//=================================================================================================
+
+
+//======================================  プロファイラ  ============================================
+
+// 空のゾーン1回あたりの時間 (0: 計測を止めたとき、1: 計測して EndFrame で集計するまで)
+void BM_ProfileZone(benchmark::State& state) {
+	const uint32_t kZoneCount = 256;
+	GetProfiler().SetEnabled(state.range(0) != 0);
+	for (auto _ : state) {
+		for (uint32_t i = 0; i < kZoneCount; ++i) {
+			MT3_PROFILE_ZONE("BM_ProfileZone");
+			benchmark::ClobberMemory();
+		}
+		GetProfiler().EndFrame();
+	}
+	GetProfiler().SetEnabled(false);
+	GetProfiler().Clear();
+	state.SetItemsProcessed(state.iterations() * kZoneCount);
+}
+BENCHMARK(BM_ProfileZone)->Arg(0)->Arg(1);
+
+// 1フレーム分の処理を、描画関数のゾーンを計測しながら行う (BM_Frame との差が計測の負荷)
+void BM_FrameProfiled(benchmark::State& state) {
+	FrameState frame;
+	Novice::ResetStubStats();
+	GetProfiler().SetEnabled(true);
+	for (auto _ : state) {
+		frame.cameraRotate.y += 0.001f;
+		ScreenTransform screenTransform = UpdateFrame(frame);
+		DrawFrame(frame, screenTransform);
+		GetProfiler().EndFrame();
+	}
+	GetProfiler().SetEnabled(false);
+	GetProfiler().Clear();
+	ReportDrawCalls(state);
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FrameProfiled);
+
+//=================================================================================================
@@ -0,0 +1,392 @@
+#include "BenchmarkUtility.h"
+#include "Check.h"
+#include "MakeMatrix.h"
+#include "Quaternion.h"
+#include "ScreenTransform.h"
+#include "TransformBatch.h"
+#include <cstring>
+
+// 行列・ベクトル演算のマイクロベンチマーク
+// 入力は kInputCount 個の配列を順番に使い、1回のループで1回 (配列版は kPointCount 点) 計算する
+
+namespace {
+
+const uint32_t kInputCount = 256;
+const uint32_t kPointCount = 1024;
+
+const std::vector<Matrix4x4>& Matrices() {
+	static std::vector<Matrix4x4> matrices = MakeRandomArray<Matrix4x4>(kInputCount, RandomMatrix);
+	return matrices;
+}
+
+const std::vector<Matrix4x4>& AffineMatrices() {
+	static std::vector<Matrix4x4> matrices = MakeRandomArray<Matrix4x4>(kInputCount, RandomAffineMatrix);
+	return matrices;
+}
+
+const std::vector<Vector3>& Points() {
+	static std::vector<Vector3> points = MakeRandomArray<Vector3>(kPointCount, [] { return RandomVector3(10.0f); });
+	return points;
+}
+
+}  // namespace
+
+
+//========================================  行列の積・逆行列  =======================================
+
+void BM_Multiply(benchmark::State& state) {
+	ScopedSimdLevel simdLevel(state);
+	const std::vector<Matrix4x4>& matrices = Matrices();
+	uint32_t i = 0;
+	for (auto _ : state) {
+		Matrix4x4 result = Multiply(matrices[i % kInputCount], matrices[(i + 1) % kInputCount]);
+		benchmark::DoNotOptimize(result);
+		++i;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Multiply)->Apply(AllSimdLevels);
+
+// テンプレート版の積 (展開したスカラー計算)
+template <typename T>
+void BM_MultiplyMat(benchmark::State& state) {
+	std::vector<Mat<4, 4, T>> matrices;
+	for (const Matrix4x4& matrix : Matrices()) {
+		matrices.push_back(MatCast<T>(ToMat4f(matrix)));
+	}
+	uint32_t i = 0;
+	for (auto _ : state) {
+		Mat<4, 4, T> result = Multiply(matrices[i % kInputCount], matrices[(i + 1) % kInputCount]);
+		benchmark::DoNotOptimize(result);
+		++i;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MultiplyMat<float>);
+BENCHMARK(BM_MultiplyMat<double>);
+
+void BM_Inverse(benchmark::State& state) {
+	ScopedSimdLevel simdLevel(state);
+	const std::vector<Matrix4x4>& matrices = Matrices();
+	uint32_t i = 0;
+	for (auto _ : state) {
+		Matrix4x4 result = Inverse(matrices[i % kInputCount]);
+		benchmark::DoNotOptimize(result);
+		++i;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Inverse)->Apply(AllSimdLevels);
+
+void BM_InverseAffine(benchmark::State& state) {
+	const std::vector<Matrix4x4>& matrices = AffineMatrices();
+	uint32_t i = 0;
+	for (auto _ : state) {
+		Matrix4x4 result = InverseAffine(matrices[i % kInputCount]);
+		benchmark::DoNotOptimize(result);
+		++i;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_InverseAffine);
+
+void BM_Transpose(benchmark::State& state) {
+	ScopedSimdLevel simdLevel(state);
+	const std::vector<Matrix4x4>& matrices = Matrices();
+	uint32_t i = 0;
+	for (auto _ : state) {
+		Matrix4x4 result = Transpose(matrices[i % kInputCount]);
+		benchmark::DoNotOptimize(result);
+		++i;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Transpose)->Apply(AllSimdLevels);
+
+//=================================================================================================
+
+
+//========================================  行列の作成  =============================================
+
+void BM_MakeAffineMatrix(benchmark::State& state) {
+	const std::vector<Vector3>& points = Points();
+	uint32_t i = 0;
+	for (auto _ : state) {
+		Vector3 scale = { 1.0f, 1.0f, 1.0f };
+		Matrix4x4 result = MakeAffineMatrix(scale, points[i % kPointCount], points[(i + 1) % kPointCount]);
+		benchmark::DoNotOptimize(result);
+		++i;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MakeAffineMatrix);
+
+void BM_MakeAffineMatrices(benchmark::State& state) {
+	const std::vector<Vector3>& points = Points();
+	std::vector<float> sx(kPointCount, 1.0f), sy(kPointCount, 1.0f), sz(kPointCount, 1.0f);
+	std::vector<float> rx(kPointCount), ry(kPointCount), rz(kPointCount);
+	std::vector<float> tx(kPointCount), ty(kPointCount), tz(kPointCount);
+	for (uint32_t i = 0; i < kPointCount; ++i) {
+		rx[i] = points[i].x;
+		ry[i] = points[i].y;
+		rz[i] = points[i].z;
+		tx[i] = points[i].z;
+		ty[i] = points[i].x;
+		tz[i] = points[i].y;
+	}
+	AffineSoA srt = { sx.data(), sy.data(), sz.data(), rx.data(), ry.data(), rz.data(), tx.data(), ty.data(), tz.data() };
+	std::vector<Matrix4x4> out(kPointCount);
+	for (auto _ : state) {
+		MakeAffineMatrices(srt, out.data(), kPointCount);
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * kPointCount);
+}
+BENCHMARK(BM_MakeAffineMatrices);
+
+// 回転行列を3つ作って掛ける (オイラー角の素直な実装) のと、クォータニオンから1回で作るのとの比較
+void BM_MakeRotateMatrixChain(benchmark::State& state) {
+	const std::vector<Vector3>& points = Points();
+	uint32_t i = 0;
+	for (auto _ : state) {
+		const Vector3& rotate = points[i % kPointCount];
+		Matrix4x4 result = Multiply(Multiply(MakeRotateXMatrix(rotate.x), MakeRotateYMatrix(rotate.y)), MakeRotateZMatrix(rotate.z));
+		benchmark::DoNotOptimize(result);
+		++i;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MakeRotateMatrixChain);
+
+void BM_MakeAffineMatrixQuaternion(benchmark::State& state) {
+	const std::vector<Vector3>& points = Points();
+	uint32_t i = 0;
+	for (auto _ : state) {
+		Vector3 scale = { 1.0f, 1.0f, 1.0f };
+		Quaternion rotate = MakeRotateQuaternion(points[i % kPointCount]);
+		Matrix4x4 result = MakeAffineMatrixQuaternion(scale, rotate, points[(i + 1) % kPointCount]);
+		benchmark::DoNotOptimize(result);
+		++i;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MakeAffineMatrixQuaternion);
+
+//=================================================================================================
+
+
+//=====================================  クォータニオン  ============================================
+
+namespace {
+
+const std::vector<Quaternion>& Rotations(uint32_t seed) {
+	static std::vector<Quaternion> rotations[2];
+	if (rotations[seed].empty()) {
+		for (uint32_t i = 0; i < kPointCount; ++i) {
+			rotations[seed].push_back(MakeRotateQuaternion(RandomVector3(3.0f)));
+		}
+	}
+	return rotations[seed];
+}
+
+}  // namespace
+
+// kPointCount 組の向きをまとめて補間する (ボーンのキーフレーム補間を想定)
+void BM_Slerp(benchmark::State& state) {
+	const std::vector<Quaternion>& from = Rotations(0);
+	const std::vector<Quaternion>& to = Rotations(1);
+	std::vector<Quaternion> result(kPointCount);
+	for (auto _ : state) {
+		for (uint32_t i = 0; i < kPointCount; ++i) {
+			result[i] = Slerp(from[i], to[i], 0.3f);
+		}
+		benchmark::DoNotOptimize(result.data());
+	}
+	state.SetItemsProcessed(state.iterations() * kPointCount);
+}
+BENCHMARK(BM_Slerp);
+
+void BM_SlerpArray(benchmark::State& state) {
+	const std::vector<Quaternion>& from = Rotations(0);
+	const std::vector<Quaternion>& to = Rotations(1);
+	std::vector<Quaternion> result(kPointCount);
+	for (auto _ : state) {
+		SlerpArray(from.data(), to.data(), 0.3f, result.data(), kPointCount);
+		benchmark::DoNotOptimize(result.data());
+	}
+	state.SetItemsProcessed(state.iterations() * kPointCount);
+}
+BENCHMARK(BM_SlerpArray);
+
+void BM_RotateVectors(benchmark::State& state) {
+	ScopedSimdLevel simdLevel(state);
+	const std::vector<Vector3>& points = Points();
+	std::vector<Vector3> result(kPointCount);
+	Quaternion rotate = Rotations(0)[0];
+	for (auto _ : state) {
+		RotateVectors(rotate, points.data(), result.data(), kPointCount);
+		benchmark::DoNotOptimize(result.data());
+	}
+	state.SetItemsProcessed(state.iterations() * kPointCount);
+}
+BENCHMARK(BM_RotateVectors)->Apply(AllSimdLevels);
+
+//=================================================================================================
+
+
+//=========================================  座標変換  ==============================================
+
+void BM_Transform(benchmark::State& state) {
+	const std::vector<Matrix4x4>& matrices = Matrices();
+	const std::vector<Vector3>& points = Points();
+	uint32_t i = 0;
+	for (auto _ : state) {
+		Vector3 result = Transform(points[i % kPointCount], matrices[i % kInputCount]);
+		benchmark::DoNotOptimize(result);
+		++i;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Transform);
+
+void BM_TransformArray(benchmark::State& state) {
+	ScopedSimdLevel simdLevel(state);
+	const Matrix4x4& matrix = Matrices()[0];
+	const std::vector<Vector3>& points = Points();
+	std::vector<Vector3> out(kPointCount);
+	for (auto _ : state) {
+		TransformArray(points.data(), out.data(), kPointCount, matrix);
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * kPointCount);
+}
+BENCHMARK(BM_TransformArray)->Apply(AllSimdLevels);
+
+void BM_TransformArraySoA(benchmark::State& state) {
+	ScopedSimdLevel simdLevel(state);
+	const Matrix4x4& matrix = Matrices()[0];
+	const std::vector<Vector3>& points = Points();
+	std::vector<float> x(kPointCount), y(kPointCount), z(kPointCount);
+	for (uint32_t i = 0; i < kPointCount; ++i) {
+		x[i] = points[i].x;
+		y[i] = points[i].y;
+		z[i] = points[i].z;
+	}
+	std::vector<float> outX(kPointCount), outY(kPointCount), outZ(kPointCount);
+	for (auto _ : state) {
+		TransformArraySoA(x.data(), y.data(), z.data(), outX.data(), outY.data(), outZ.data(), kPointCount, matrix);
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * kPointCount);
+}
+BENCHMARK(BM_TransformArraySoA)->Apply(AllSimdLevels);
+
+// 点の配列の変換の確認 (ctest の CheckTransformArray)
+// SSE版・AVX2版 (AoS と SoA) がスカラー版とビット単位で同じ結果になるか。端数の点の数と、src と dst が同じ配列の場合も調べる
+namespace {
+
+bool CheckTransformArray() {
+	const uint32_t counts[] = { 1, 3, 4, 7, 8, 9, 15, 16, 17, 1001 };
+	bool ok = true;
+	for (bool affine : { true, false }) {
+		Matrix4x4 matrix = affine ? RandomAffineMatrix() : RandomMatrix();
+		for (uint32_t count : counts) {
+			std::vector<Vector3> points = MakeRandomArray<Vector3>(count, [] { return RandomVector3(10.0f); });
+			std::vector<float> x(count), y(count), z(count);
+			for (uint32_t i = 0; i < count; ++i) {
+				x[i] = points[i].x;
+				y[i] = points[i].y;
+				z[i] = points[i].z;
+			}
+			SetSimdLevel(SimdLevel::Scalar);
+			std::vector<Vector3> expected(count);
+			TransformArray(points.data(), expected.data(), count, matrix);
+
+			for (SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2 }) {
+				SetSimdLevel(level);
+				std::vector<Vector3> out(count), inPlace = points;
+				TransformArray(points.data(), out.data(), count, matrix);
+				TransformArray(inPlace.data(), inPlace.data(), count, matrix);
+				std::vector<float> outX(count), outY(count), outZ(count);
+				TransformArraySoA(x.data(), y.data(), z.data(), outX.data(), outY.data(), outZ.data(), count, matrix);
+				for (uint32_t i = 0; i < count; ++i) {
+					const Vector3& e = expected[i];
+					bool same = std::memcmp(&out[i], &e, sizeof(Vector3)) == 0 && std::memcmp(&inPlace[i], &e, sizeof(Vector3)) == 0 &&
+						std::memcmp(&outX[i], &e.x, sizeof(float)) == 0 && std::memcmp(&outY[i], &e.y, sizeof(float)) == 0 && std::memcmp(&outZ[i], &e.z, sizeof(float)) == 0;
+					if (!same) {
+						ok = check::Fail("%s, %s matrix, %u points: point %u differs from the scalar result",
+							SimdLevelName(GetSimdLevel()), affine ? "affine" : "projective", count, i);
+						break;
+					}
+				}
+			}
+		}
+	}
+	SetSimdLevel(DetectSimdLevel());
+	return ok;
+}
+MT3_CHECK(CheckTransformArray);
+
+}  // namespace
+
+void BM_ToScreenArray(benchmark::State& state) {
+	ScopedSimdLevel simdLevel(state);
+	Matrix4x4 view = InverseAffine(MakeAffineMatrix({ 1.0f, 1.0f, 1.0f }, { 0.26f, 0.0f, 0.0f }, { 0.0f, 1.9f, -6.49f }));
+	Matrix4x4 projection = MakePerspectiveFovMatrix(0.45f, 1280.0f / 720.0f, 0.1f, 100.0f);
+	Matrix4x4 viewport = MakeViewportMatrix(0, 0, 1280.0f, 720.0f, 0.0f, 1.0f);
+	ScreenTransform screen = MakeScreenTransform(view, projection, viewport);
+	const std::vector<Vector3>& points = Points();
+	std::vector<Vector3> out(kPointCount);
+	for (auto _ : state) {
+		ToScreenArray(points.data(), out.data(), kPointCount, screen);
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * kPointCount);
+}
+BENCHMARK(BM_ToScreenArray)->Apply(AllSimdLevels);
+
+//=================================================================================================
+
+
+//=========================================  深度  =================================================
+
+// 射影の種類ごとの深度の精度。引数は 0: 標準、1: ReverseZ、2: 無限遠、3: ReverseZ + 無限遠
+// カメラから 1 ～ 10000 の距離に等比で並べた点の深度を求め、隣の点と違う深度になった割合を distinct_depth に出す
+// (1 に近いほど遠くまで前後関係を区別でき、並べ替えや深度テストで z ファイティングが起きにくい)
+void BM_DepthPrecision(benchmark::State& state) {
+	const uint32_t kDepthPointCount = 16384;
+	const float kNear = 0.1f;
+	const float kFar = 10000.0f;
+	DepthMode depthMode = state.range(0) % 2 == 0 ? kDepthStandard : kDepthReverseZ;
+	Matrix4x4 projection;
+	switch (state.range(0)) {
+	case 0: projection = MakePerspectiveFovMatrix(0.45f, 1280.0f / 720.0f, kNear, kFar); break;
+	case 1: projection = MakePerspectiveFovMatrixReverseZ(0.45f, 1280.0f / 720.0f, kNear, kFar); break;
+	case 2: projection = MakePerspectiveFovMatrixInfinite(0.45f, 1280.0f / 720.0f, kNear); break;
+	default: projection = MakePerspectiveFovMatrixReverseZInfinite(0.45f, 1280.0f / 720.0f, kNear); break;
+	}
+	Matrix4x4 viewport = MakeViewportMatrix(0, 0, 1280.0f, 720.0f, 0.0f, 1.0f);
+	ScreenTransform screen = MakeScreenTransform(MakeIdentity4x4(), projection, viewport, depthMode);
+
+	std::vector<Vector3> points(kDepthPointCount);
+	for (uint32_t i = 0; i < kDepthPointCount; ++i) {
+		points[i] = { 0.0f, 0.0f, std::pow(kFar, float(i) / float(kDepthPointCount - 1)) };
+	}
+	std::vector<float> depths(kDepthPointCount);
+	for (auto _ : state) {
+		for (uint32_t i = 0; i < kDepthPointCount; ++i) {
+			depths[i] = ToDepth(points[i], screen);
+		}
+		benchmark::ClobberMemory();
+	}
+
+	uint32_t distinct = 0;
+	for (uint32_t i = 1; i < kDepthPointCount; ++i) {
+		distinct += IsDepthCloser(depths[i - 1], depths[i], depthMode) ? 1 : 0;
+	}
+	state.SetCounter("distinct_depth", double(distinct) / double(kDepthPointCount - 1));
+	state.SetItemsProcessed(state.iterations() * kDepthPointCount);
+}
+BENCHMARK(BM_DepthPrecision)->Arg(0)->Arg(1)->Arg(2)->Arg(3);
+
+//=================================================================================================
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+
+// ベンチマーク用の Novice の代わり
+// DebugDraw.h が使う関数だけを用意し、描画はせずに呼ばれた回数と座標の合計だけを記録する
+// (座標を使うので、描画前の計算が最適化で消されない)
+
+enum FillMode {
+	kFillModeSolid,      //!< 塗りつぶし
+	kFillModeWireFrame,  //!< ワイヤーフレーム
+};
+
+enum ColorCode {
+	RED = 0xFF0000FF,
+	GREEN = 0x00FF00FF,
+	BLUE = 0x0000FFFF,
+	WHITE = 0xFFFFFFFF,
+	BLACK = 0x000000FF,
+};
+
+namespace Novice {
+
+struct StubStats {
+	uint64_t lineCount = 0;
+	uint64_t triangleCount = 0;
+	uint64_t printCount = 0;
+	int64_t coordinateSum = 0;
+};
+
+inline StubStats& GetStubStats() {
+	static StubStats stats;
+	return stats;
+}
+
+inline void ResetStubStats() {
+	GetStubStats() = StubStats();
+}
+
+inline void DrawLine(int x1, int y1, int x2, int y2, unsigned int color) {
+	StubStats& stats = GetStubStats();
+	stats.lineCount++;
+	stats.coordinateSum += int64_t(x1) + y1 + x2 + y2 + (color & 1);
+}
+
+inline void DrawTriangle(int x1, int y1, int x2, int y2, int x3, int y3, unsigned int color, FillMode fillMode) {
+	StubStats& stats = GetStubStats();
+	stats.triangleCount++;
+	stats.coordinateSum += int64_t(x1) + y1 + x2 + y2 + x3 + y3 + (color & 1) + fillMode;
+}
+
+inline void ScreenPrintf(int x, int y, const char*, ...) {
+	StubStats& stats = GetStubStats();
+	stats.printCount++;
+	stats.coordinateSum += int64_t(x) + y;
+}
+
+}  // namespace Novice
@@ -0,0 +1,494 @@
+#pragma once
+#include "Geometry.h"
+#include "Profiler.h"
+#include "SimdConfig.h"
+#include <vector>
+#include <bit>
+#include <cstdint>
+#include <memory_resource>
+
+// 衝突判定用のプリミティブを種類ごとに SoA (要素ごとの配列) で持つ入れ物
+// 「1つ対たくさん」の判定を SSE/AVX2 でまとめて行い、結果はビットマスクか番号のリストで返す
+// ビットマスクは 64個ずつ uint64_t に詰める (i番目 → hitMask[i / 64] の i % 64 ビット目)
+
+struct SphereSoA {
+	std::vector<float> centerX, centerY, centerZ;
+	std::vector<float> radius;
+};
+
+struct AABBSoA {
+	std::vector<float> minX, minY, minZ;
+	std::vector<float> maxX, maxY, maxZ;
+};
+
+struct PlaneSoA {
+	std::vector<float> normalX, normalY, normalZ;
+	std::vector<float> distance;
+};
+
+struct TriangleSoA {
+	std::vector<float> x0, y0, z0;
+	std::vector<float> x1, y1, z1;
+	std::vector<float> x2, y2, z2;
+};
+
+// 球と別の種類のプリミティブ (平面・AABB) の組。番号はそれぞれの配列の中の番号なので、大小の関係はない
+// (同じ種類どうしの組は CollisionPair)
+struct SpherePrimitivePair {
+	uint32_t sphere;     //!< 球の番号
+	uint32_t primitive;  //!< 相手の番号
+};
+
+// count個分のビットマスクに必要な uint64_t の数
+inline uint32_t HitMaskWordCount(uint32_t count) {
+	return (count + 63) / 64;
+}
+
+// ビットマスクから当たった番号を取り出して indices の後ろに追加する
+template <typename Allocator>
+inline void HitMaskToIndices(const uint64_t* hitMask, uint32_t count, std::vector<uint32_t, Allocator>& indices) {
+	for (uint32_t word = 0; word < HitMaskWordCount(count); ++word) {
+		uint64_t bits = hitMask[word];
+		while (bits != 0) {
+			indices.push_back(word * 64 + uint32_t(std::countr_zero(bits)));
+			bits &= bits - 1;
+		}
+	}
+}
+
+// ビットマスクの当たった番号ごとに callback(index) を呼ぶ (番号のリストを作らない)
+template <typename Callback>
+inline void ForEachHit(const uint64_t* hitMask, uint32_t count, Callback&& callback) {
+	for (uint32_t word = 0; word < HitMaskWordCount(count); ++word) {
+		uint64_t bits = hitMask[word];
+		while (bits != 0) {
+			callback(word * 64 + uint32_t(std::countr_zero(bits)));
+			bits &= bits - 1;
+		}
+	}
+}
+
+
+class CollisionWorld {
+public:
+	uint32_t AddSphere(const Sphere& sphere);
+	uint32_t AddAABB(const AABB& aabb);
+	uint32_t AddPlane(const Plane& plane);
+	uint32_t AddTriangle(const Triangle& triangle);
+	void Clear();
+
+	uint32_t GetSphereCount() const { return uint32_t(spheres_.radius.size()); }
+	uint32_t GetAABBCount() const { return uint32_t(aabbs_.minX.size()); }
+	uint32_t GetPlaneCount() const { return uint32_t(planes_.distance.size()); }
+	uint32_t GetTriangleCount() const { return uint32_t(triangles_.x0.size()); }
+
+	const SphereSoA& GetSpheres() const { return spheres_; }
+	const AABBSoA& GetAABBs() const { return aabbs_; }
+	const PlaneSoA& GetPlanes() const { return planes_; }
+	const TriangleSoA& GetTriangles() const { return triangles_; }
+
+	//---------------------------- 1つ対たくさん (ビットマスク) ----------------------------
+	// hitMask には HitMaskWordCount(対象の数) 個の領域が必要。戻り値は当たった数
+
+	// 球と全ての平面 (IsCollisionPlane)
+	uint32_t SphereVsPlanes(const Sphere& sphere, uint64_t* hitMask) const;
+	// 球と全てのAABB (isCollisionSphereAABB)
+	uint32_t SphereVsAABBs(const Sphere& sphere, uint64_t* hitMask) const;
+	// 球と全ての球 (IsCollisionSphere)
+	uint32_t SphereVsSpheres(const Sphere& sphere, uint64_t* hitMask) const;
+	// AABBと全てのAABB (isCollisionAABB)
+	uint32_t AABBVsAABBs(const AABB& aabb, uint64_t* hitMask) const;
+	// 線分と全ての三角形 (IsCollisionTriangle)
+	uint32_t SegmentVsTriangles(const Segment& segment, uint64_t* hitMask) const;
+
+	//---------------------------- たくさん対たくさん (番号の組) ----------------------------
+	// 球と別の種類の組は SpherePrimitivePair、球同士の組は CollisionPair (a < b) で返す
+	// pairs は std::pmr::vector にしてフレームアリーナ (Arena.h) から確保してもよい
+	// scratch は作業用のマスク (相手の数 / 8 バイト) の確保先。呼び出すスレッドのアリーナ
+	// (FrameArena::GetThreadArena) を渡せば、1つの CollisionWorld を複数のスレッドから同時に調べてよい
+
+	template <typename Allocator>
+	void SpheresVsPlanes(std::vector<SpherePrimitivePair, Allocator>& pairs, std::pmr::memory_resource& scratch) const;
+	template <typename Allocator>
+	void SpheresVsAABBs(std::vector<SpherePrimitivePair, Allocator>& pairs, std::pmr::memory_resource& scratch) const;
+	// 球同士 (a < b)
+	template <typename Allocator>
+	void SpheresVsSpheres(std::vector<CollisionPair, Allocator>& pairs, std::pmr::memory_resource& scratch) const;
+
+private:
+	SphereSoA spheres_;
+	AABBSoA aabbs_;
+	PlaneSoA planes_;
+	TriangleSoA triangles_;
+};
+
+
+//=======================================  登録  ==================================================
+inline uint32_t CollisionWorld::AddSphere(const Sphere& sphere) {
+	spheres_.centerX.push_back(sphere.center.x);
+	spheres_.centerY.push_back(sphere.center.y);
+	spheres_.centerZ.push_back(sphere.center.z);
+	spheres_.radius.push_back(sphere.radius);
+	return GetSphereCount() - 1;
+}
+
+inline uint32_t CollisionWorld::AddAABB(const AABB& aabb) {
+	aabbs_.minX.push_back(aabb.min.x);
+	aabbs_.minY.push_back(aabb.min.y);
+	aabbs_.minZ.push_back(aabb.min.z);
+	aabbs_.maxX.push_back(aabb.max.x);
+	aabbs_.maxY.push_back(aabb.max.y);
+	aabbs_.maxZ.push_back(aabb.max.z);
+	return GetAABBCount() - 1;
+}
+
+inline uint32_t CollisionWorld::AddPlane(const Plane& plane) {
+	planes_.normalX.push_back(plane.normal.x);
+	planes_.normalY.push_back(plane.normal.y);
+	planes_.normalZ.push_back(plane.normal.z);
+	planes_.distance.push_back(plane.distance);
+	return GetPlaneCount() - 1;
+}
+
+inline uint32_t CollisionWorld::AddTriangle(const Triangle& triangle) {
+	triangles_.x0.push_back(triangle.vertices[0].x);
+	triangles_.y0.push_back(triangle.vertices[0].y);
+	triangles_.z0.push_back(triangle.vertices[0].z);
+	triangles_.x1.push_back(triangle.vertices[1].x);
+	triangles_.y1.push_back(triangle.vertices[1].y);
+	triangles_.z1.push_back(triangle.vertices[1].z);
+	triangles_.x2.push_back(triangle.vertices[2].x);
+	triangles_.y2.push_back(triangle.vertices[2].y);
+	triangles_.z2.push_back(triangle.vertices[2].z);
+	return GetTriangleCount() - 1;
+}
+
+inline void CollisionWorld::Clear() {
+	*this = CollisionWorld();
+}
+//=================================================================================================
+
+
+//==================================  スカラー版 (1要素ずつ)  ========================================
+// SIMD版の端数処理にも使う。begin から count までを判定してビットを立てる
+
+inline void SphereVsPlanesScalar(const PlaneSoA& planes, const Sphere& sphere, uint32_t begin, uint32_t count, uint64_t* hitMask) {
+	for (uint32_t i = begin; i < count; ++i) {
+		float d = planes.normalX[i] * sphere.center.x + planes.normalY[i] * sphere.center.y + planes.normalZ[i] * sphere.center.z - planes.distance[i];
+		if (std::fabs(d) <= sphere.radius) {
+			hitMask[i / 64] |= uint64_t(1) << (i % 64);
+		}
+	}
+}
+
+inline void SphereVsAABBsScalar(const AABBSoA& aabbs, const Sphere& sphere, uint32_t begin, uint32_t count, uint64_t* hitMask) {
+	for (uint32_t i = begin; i < count; ++i) {
+		float x = std::clamp(sphere.center.x, aabbs.minX[i], aabbs.maxX[i]) - sphere.center.x;
+		float y = std::clamp(sphere.center.y, aabbs.minY[i], aabbs.maxY[i]) - sphere.center.y;
+		float z = std::clamp(sphere.center.z, aabbs.minZ[i], aabbs.maxZ[i]) - sphere.center.z;
+		if (x * x + y * y + z * z <= sphere.radius * sphere.radius) {
+			hitMask[i / 64] |= uint64_t(1) << (i % 64);
+		}
+	}
+}
+
+inline void SphereVsSpheresScalar(const SphereSoA& spheres, const Sphere& sphere, uint32_t begin, uint32_t count, uint64_t* hitMask) {
+	for (uint32_t i = begin; i < count; ++i) {
+		float x = spheres.centerX[i] - sphere.center.x;
+		float y = spheres.centerY[i] - sphere.center.y;
+		float z = spheres.centerZ[i] - sphere.center.z;
+		float r = spheres.radius[i] + sphere.radius;
+		if (x * x + y * y + z * z <= r * r) {
+			hitMask[i / 64] |= uint64_t(1) << (i % 64);
+		}
+	}
+}
+
+inline void AABBVsAABBsScalar(const AABBSoA& aabbs, const AABB& aabb, uint32_t begin, uint32_t count, uint64_t* hitMask) {
+	for (uint32_t i = begin; i < count; ++i) {
+		if (aabbs.minX[i] <= aabb.max.x && aabbs.maxX[i] >= aabb.min.x &&
+			aabbs.minY[i] <= aabb.max.y && aabbs.maxY[i] >= aabb.min.y &&
+			aabbs.minZ[i] <= aabb.max.z && aabbs.maxZ[i] >= aabb.min.z) {
+			hitMask[i / 64] |= uint64_t(1) << (i % 64);
+		}
+	}
+}
+
+//=================================================================================================
+
+#if MT3_SIMD_X86
+
+//====================================  SSE版 (4要素ずつ)  ===========================================
+
+SIMD_TARGET_SSE41
+inline uint32_t SphereVsPlanesSSE(const PlaneSoA& planes, const Sphere& sphere, uint32_t count, uint64_t* hitMask) {
+	__m128 cx = _mm_set1_ps(sphere.center.x), cy = _mm_set1_ps(sphere.center.y), cz = _mm_set1_ps(sphere.center.z);
+	__m128 r = _mm_set1_ps(sphere.radius);
+	__m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&planes.normalX[i]), cx), _mm_mul_ps(_mm_loadu_ps(&planes.normalY[i]), cy)), _mm_mul_ps(_mm_loadu_ps(&planes.normalZ[i]), cz));
+		d = _mm_and_ps(_mm_sub_ps(d, _mm_loadu_ps(&planes.distance[i])), absMask);
+		hitMask[i / 64] |= uint64_t(_mm_movemask_ps(_mm_cmple_ps(d, r))) << (i % 64);
+	}
+	return i;
+}
+
+SIMD_TARGET_SSE41
+inline uint32_t SphereVsAABBsSSE(const AABBSoA& aabbs, const Sphere& sphere, uint32_t count, uint64_t* hitMask) {
+	__m128 cx = _mm_set1_ps(sphere.center.x), cy = _mm_set1_ps(sphere.center.y), cz = _mm_set1_ps(sphere.center.z);
+	__m128 r2 = _mm_set1_ps(sphere.radius * sphere.radius);
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		// clamp(c, min, max) = min(max(c, min), max)
+		__m128 x = _mm_sub_ps(_mm_min_ps(_mm_max_ps(cx, _mm_loadu_ps(&aabbs.minX[i])), _mm_loadu_ps(&aabbs.maxX[i])), cx);
+		__m128 y = _mm_sub_ps(_mm_min_ps(_mm_max_ps(cy, _mm_loadu_ps(&aabbs.minY[i])), _mm_loadu_ps(&aabbs.maxY[i])), cy);
+		__m128 z = _mm_sub_ps(_mm_min_ps(_mm_max_ps(cz, _mm_loadu_ps(&aabbs.minZ[i])), _mm_loadu_ps(&aabbs.maxZ[i])), cz);
+		__m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+		hitMask[i / 64] |= uint64_t(_mm_movemask_ps(_mm_cmple_ps(d2, r2))) << (i % 64);
+	}
+	return i;
+}
+
+SIMD_TARGET_SSE41
+inline uint32_t SphereVsSpheresSSE(const SphereSoA& spheres, const Sphere& sphere, uint32_t count, uint64_t* hitMask) {
+	__m128 cx = _mm_set1_ps(sphere.center.x), cy = _mm_set1_ps(sphere.center.y), cz = _mm_set1_ps(sphere.center.z);
+	__m128 radius = _mm_set1_ps(sphere.radius);
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128 x = _mm_sub_ps(_mm_loadu_ps(&spheres.centerX[i]), cx);
+		__m128 y = _mm_sub_ps(_mm_loadu_ps(&spheres.centerY[i]), cy);
+		__m128 z = _mm_sub_ps(_mm_loadu_ps(&spheres.centerZ[i]), cz);
+		__m128 r = _mm_add_ps(_mm_loadu_ps(&spheres.radius[i]), radius);
+		__m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+		hitMask[i / 64] |= uint64_t(_mm_movemask_ps(_mm_cmple_ps(d2, _mm_mul_ps(r, r)))) << (i % 64);
+	}
+	return i;
+}
+
+SIMD_TARGET_SSE41
+inline uint32_t AABBVsAABBsSSE(const AABBSoA& aabbs, const AABB& aabb, uint32_t count, uint64_t* hitMask) {
+	__m128 minX = _mm_set1_ps(aabb.min.x), minY = _mm_set1_ps(aabb.min.y), minZ = _mm_set1_ps(aabb.min.z);
+	__m128 maxX = _mm_set1_ps(aabb.max.x), maxY = _mm_set1_ps(aabb.max.y), maxZ = _mm_set1_ps(aabb.max.z);
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128 m = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(&aabbs.minX[i]), maxX), _mm_cmpge_ps(_mm_loadu_ps(&aabbs.maxX[i]), minX));
+		m = _mm_and_ps(m, _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(&aabbs.minY[i]), maxY), _mm_cmpge_ps(_mm_loadu_ps(&aabbs.maxY[i]), minY)));
+		m = _mm_and_ps(m, _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(&aabbs.minZ[i]), maxZ), _mm_cmpge_ps(_mm_loadu_ps(&aabbs.maxZ[i]), minZ)));
+		hitMask[i / 64] |= uint64_t(_mm_movemask_ps(m)) << (i % 64);
+	}
+	return i;
+}
+
+//=================================================================================================
+
+
+//===================================  AVX2版 (8要素ずつ)  ===========================================
+
+SIMD_TARGET_AVX2
+inline uint32_t SphereVsPlanesAVX2(const PlaneSoA& planes, const Sphere& sphere, uint32_t count, uint64_t* hitMask) {
+	__m256 cx = _mm256_set1_ps(sphere.center.x), cy = _mm256_set1_ps(sphere.center.y), cz = _mm256_set1_ps(sphere.center.z);
+	__m256 r = _mm256_set1_ps(sphere.radius);
+	__m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+	uint32_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(&planes.normalX[i]), cx), _mm256_mul_ps(_mm256_loadu_ps(&planes.normalY[i]), cy)), _mm256_mul_ps(_mm256_loadu_ps(&planes.normalZ[i]), cz));
+		d = _mm256_and_ps(_mm256_sub_ps(d, _mm256_loadu_ps(&planes.distance[i])), absMask);
+		hitMask[i / 64] |= uint64_t(_mm256_movemask_ps(_mm256_cmp_ps(d, r, _CMP_LE_OQ))) << (i % 64);
+	}
+	return i;
+}
+
+SIMD_TARGET_AVX2
+inline uint32_t SphereVsAABBsAVX2(const AABBSoA& aabbs, const Sphere& sphere, uint32_t count, uint64_t* hitMask) {
+	__m256 cx = _mm256_set1_ps(sphere.center.x), cy = _mm256_set1_ps(sphere.center.y), cz = _mm256_set1_ps(sphere.center.z);
+	__m256 r2 = _mm256_set1_ps(sphere.radius * sphere.radius);
+	uint32_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 x = _mm256_sub_ps(_mm256_min_ps(_mm256_max_ps(cx, _mm256_loadu_ps(&aabbs.minX[i])), _mm256_loadu_ps(&aabbs.maxX[i])), cx);
+		__m256 y = _mm256_sub_ps(_mm256_min_ps(_mm256_max_ps(cy, _mm256_loadu_ps(&aabbs.minY[i])), _mm256_loadu_ps(&aabbs.maxY[i])), cy);
+		__m256 z = _mm256_sub_ps(_mm256_min_ps(_mm256_max_ps(cz, _mm256_loadu_ps(&aabbs.minZ[i])), _mm256_loadu_ps(&aabbs.maxZ[i])), cz);
+		__m256 d2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z));
+		hitMask[i / 64] |= uint64_t(_mm256_movemask_ps(_mm256_cmp_ps(d2, r2, _CMP_LE_OQ))) << (i % 64);
+	}
+	return i;
+}
+
+SIMD_TARGET_AVX2
+inline uint32_t SphereVsSpheresAVX2(const SphereSoA& spheres, const Sphere& sphere, uint32_t count, uint64_t* hitMask) {
+	__m256 cx = _mm256_set1_ps(sphere.center.x), cy = _mm256_set1_ps(sphere.center.y), cz = _mm256_set1_ps(sphere.center.z);
+	__m256 radius = _mm256_set1_ps(sphere.radius);
+	uint32_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 x = _mm256_sub_ps(_mm256_loadu_ps(&spheres.centerX[i]), cx);
+		__m256 y = _mm256_sub_ps(_mm256_loadu_ps(&spheres.centerY[i]), cy);
+		__m256 z = _mm256_sub_ps(_mm256_loadu_ps(&spheres.centerZ[i]), cz);
+		__m256 r = _mm256_add_ps(_mm256_loadu_ps(&spheres.radius[i]), radius);
+		__m256 d2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z));
+		hitMask[i / 64] |= uint64_t(_mm256_movemask_ps(_mm256_cmp_ps(d2, _mm256_mul_ps(r, r), _CMP_LE_OQ))) << (i % 64);
+	}
+	return i;
+}
+
+SIMD_TARGET_AVX2
+inline uint32_t AABBVsAABBsAVX2(const AABBSoA& aabbs, const AABB& aabb, uint32_t count, uint64_t* hitMask) {
+	__m256 minX = _mm256_set1_ps(aabb.min.x), minY = _mm256_set1_ps(aabb.min.y), minZ = _mm256_set1_ps(aabb.min.z);
+	__m256 maxX = _mm256_set1_ps(aabb.max.x), maxY = _mm256_set1_ps(aabb.max.y), maxZ = _mm256_set1_ps(aabb.max.z);
+	uint32_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 m = _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(&aabbs.minX[i]), maxX, _CMP_LE_OQ), _mm256_cmp_ps(_mm256_loadu_ps(&aabbs.maxX[i]), minX, _CMP_GE_OQ));
+		m = _mm256_and_ps(m, _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(&aabbs.minY[i]), maxY, _CMP_LE_OQ), _mm256_cmp_ps(_mm256_loadu_ps(&aabbs.maxY[i]), minY, _CMP_GE_OQ)));
+		m = _mm256_and_ps(m, _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(&aabbs.minZ[i]), maxZ, _CMP_LE_OQ), _mm256_cmp_ps(_mm256_loadu_ps(&aabbs.maxZ[i]), minZ, _CMP_GE_OQ)));
+		hitMask[i / 64] |= uint64_t(_mm256_movemask_ps(m)) << (i % 64);
+	}
+	return i;
+}
+
+//=================================================================================================
+
+#else
+
+// x86 以外では GetSimdLevel() が常に Scalar なので呼ばれない。DispatchSimd から参照するためだけの定義
+inline uint32_t SphereVsPlanesSSE(const PlaneSoA&, const Sphere&, uint32_t, uint64_t*) { return 0; }
+inline uint32_t SphereVsAABBsSSE(const AABBSoA&, const Sphere&, uint32_t, uint64_t*) { return 0; }
+inline uint32_t SphereVsSpheresSSE(const SphereSoA&, const Sphere&, uint32_t, uint64_t*) { return 0; }
+inline uint32_t AABBVsAABBsSSE(const AABBSoA&, const AABB&, uint32_t, uint64_t*) { return 0; }
+inline uint32_t SphereVsPlanesAVX2(const PlaneSoA&, const Sphere&, uint32_t, uint64_t*) { return 0; }
+inline uint32_t SphereVsAABBsAVX2(const AABBSoA&, const Sphere&, uint32_t, uint64_t*) { return 0; }
+inline uint32_t SphereVsSpheresAVX2(const SphereSoA&, const Sphere&, uint32_t, uint64_t*) { return 0; }
+inline uint32_t AABBVsAABBsAVX2(const AABBSoA&, const AABB&, uint32_t, uint64_t*) { return 0; }
+
+#endif
+
+
+//===============================  1つ対たくさん (ビットマスク)  ======================================
+
+inline uint32_t CountHits(const uint64_t* hitMask, uint32_t count) {
+	uint32_t hits = 0;
+	for (uint32_t word = 0; word < HitMaskWordCount(count); ++word) {
+		hits += uint32_t(std::popcount(hitMask[word]));
+	}
+	return hits;
+}
+
+// hitMask を0にしてから SIMD版 (sse / avx2 は処理した要素数を返す) で処理できるところまで処理し、
+// 残りを scalar(begin) で処理する。戻り値は当たった数
+template <typename Scalar, typename SSE, typename AVX2>
+inline uint32_t DispatchSimd(uint32_t count, uint64_t* hitMask, Scalar&& scalar, SSE&& sse, AVX2&& avx2) {
+	std::fill(hitMask, hitMask + HitMaskWordCount(count), uint64_t(0));
+	uint32_t done = 0;
+	switch (GetSimdLevel()) {
+	case SimdLevel::AVX2: done = avx2(); break;
+	case SimdLevel::SSE41: done = sse(); break;
+	default: break;
+	}
+	scalar(done);
+	return CountHits(hitMask, count);
+}
+
+inline uint32_t CollisionWorld::SphereVsPlanes(const Sphere& sphere, uint64_t* hitMask) const {
+	const uint32_t count = GetPlaneCount();
+	return DispatchSimd(count, hitMask,
+		[&](uint32_t begin) { SphereVsPlanesScalar(planes_, sphere, begin, count, hitMask); },
+		[&] { return SphereVsPlanesSSE(planes_, sphere, count, hitMask); },
+		[&] { return SphereVsPlanesAVX2(planes_, sphere, count, hitMask); });
+}
+
+inline uint32_t CollisionWorld::SphereVsAABBs(const Sphere& sphere, uint64_t* hitMask) const {
+	const uint32_t count = GetAABBCount();
+	return DispatchSimd(count, hitMask,
+		[&](uint32_t begin) { SphereVsAABBsScalar(aabbs_, sphere, begin, count, hitMask); },
+		[&] { return SphereVsAABBsSSE(aabbs_, sphere, count, hitMask); },
+		[&] { return SphereVsAABBsAVX2(aabbs_, sphere, count, hitMask); });
+}
+
+inline uint32_t CollisionWorld::SphereVsSpheres(const Sphere& sphere, uint64_t* hitMask) const {
+	const uint32_t count = GetSphereCount();
+	return DispatchSimd(count, hitMask,
+		[&](uint32_t begin) { SphereVsSpheresScalar(spheres_, sphere, begin, count, hitMask); },
+		[&] { return SphereVsSpheresSSE(spheres_, sphere, count, hitMask); },
+		[&] { return SphereVsSpheresAVX2(spheres_, sphere, count, hitMask); });
+}
+
+inline uint32_t CollisionWorld::AABBVsAABBs(const AABB& aabb, uint64_t* hitMask) const {
+	const uint32_t count = GetAABBCount();
+	return DispatchSimd(count, hitMask,
+		[&](uint32_t begin) { AABBVsAABBsScalar(aabbs_, aabb, begin, count, hitMask); },
+		[&] { return AABBVsAABBsSSE(aabbs_, aabb, count, hitMask); },
+		[&] { return AABBVsAABBsAVX2(aabbs_, aabb, count, hitMask); });
+}
+
+// 三角形は1つずつ IsCollisionTriangle と同じ判定を SoA から行う
+inline uint32_t CollisionWorld::SegmentVsTriangles(const Segment& segment, uint64_t* hitMask) const {
+	MT3_PROFILE_ZONE("CollisionWorld::SegmentVsTriangles");
+	uint32_t count = GetTriangleCount();
+	std::fill(hitMask, hitMask + HitMaskWordCount(count), uint64_t(0));
+	for (uint32_t i = 0; i < count; ++i) {
+		Triangle triangle = {
+			{
+				{ triangles_.x0[i], triangles_.y0[i], triangles_.z0[i] },
+				{ triangles_.x1[i], triangles_.y1[i], triangles_.z1[i] },
+				{ triangles_.x2[i], triangles_.y2[i], triangles_.z2[i] },
+			},
+			{},
+		};
+		if (IsCollisionTriangle(triangle, segment)) {
+			hitMask[i / 64] |= uint64_t(1) << (i % 64);
+		}
+	}
+	return CountHits(hitMask, count);
+}
+
+//=================================================================================================
+
+
+//===============================  たくさん対たくさん (番号の組)  =====================================
+
+template <typename Allocator>
+inline void CollisionWorld::SpheresVsPlanes(std::vector<SpherePrimitivePair, Allocator>& pairs, std::pmr::memory_resource& scratch) const {
+	MT3_PROFILE_ZONE("CollisionWorld::SpheresVsPlanes");
+	std::pmr::vector<uint64_t> hitMask(HitMaskWordCount(GetPlaneCount()), &scratch);
+	for (uint32_t i = 0; i < GetSphereCount(); ++i) {
+		Sphere sphere = { { spheres_.centerX[i], spheres_.centerY[i], spheres_.centerZ[i] }, spheres_.radius[i] };
+		if (SphereVsPlanes(sphere, hitMask.data()) == 0) {
+			continue;
+		}
+		ForEachHit(hitMask.data(), GetPlaneCount(), [&](uint32_t plane) {
+			pairs.push_back({ i, plane });
+		});
+	}
+}
+
+template <typename Allocator>
+inline void CollisionWorld::SpheresVsAABBs(std::vector<SpherePrimitivePair, Allocator>& pairs, std::pmr::memory_resource& scratch) const {
+	MT3_PROFILE_ZONE("CollisionWorld::SpheresVsAABBs");
+	std::pmr::vector<uint64_t> hitMask(HitMaskWordCount(GetAABBCount()), &scratch);
+	for (uint32_t i = 0; i < GetSphereCount(); ++i) {
+		Sphere sphere = { { spheres_.centerX[i], spheres_.centerY[i], spheres_.centerZ[i] }, spheres_.radius[i] };
+		if (SphereVsAABBs(sphere, hitMask.data()) == 0) {
+			continue;
+		}
+		ForEachHit(hitMask.data(), GetAABBCount(), [&](uint32_t aabb) {
+			pairs.push_back({ i, aabb });
+		});
+	}
+}
+
+template <typename Allocator>
+inline void CollisionWorld::SpheresVsSpheres(std::vector<CollisionPair, Allocator>& pairs, std::pmr::memory_resource& scratch) const {
+	MT3_PROFILE_ZONE("CollisionWorld::SpheresVsSpheres");
+	std::pmr::vector<uint64_t> hitMask(HitMaskWordCount(GetSphereCount()), &scratch);
+	for (uint32_t i = 0; i < GetSphereCount(); ++i) {
+		Sphere sphere = { { spheres_.centerX[i], spheres_.centerY[i], spheres_.centerZ[i] }, spheres_.radius[i] };
+		if (SphereVsSpheres(sphere, hitMask.data()) <= 1) {
+			continue;  // 自分自身しか当たっていない
+		}
+		ForEachHit(hitMask.data(), GetSphereCount(), [&](uint32_t other) {
+			if (other > i) {
+				pairs.push_back({ i, other });
+			}
+		});
+	}
+}
+
+//=================================================================================================
@@ -0,0 +1,442 @@
+#pragma once
+#include "Geometry.h"
+#include "SimdConfig.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// 曲線 (3次/N次ベジェ、一様/非一様Bスプライン、Catmull-Rom)
+//
+// 3次の曲線 (3次ベジェ、Catmull-Rom、一様3次Bスプライン) は区間ごとに
+//   P(t) = ((a t + b) t + c) t + d   (0 <= t <= 1)
+// の多項式 CubicPolynomial に直してから評価する。多項式にしておけば
+// ホーナー法で1点あたり乗算9回・加算9回で求まり、SIMDで多数の t や多数の曲線をまとめて評価できる
+// (スカラー版とSIMD版は同じ順番で計算するので結果は一致する)
+
+static const uint32_t kMaxCurvePoints = 32;  //!< N次ベジェ・Bスプラインで1回の評価に使う制御点の上限
+
+
+//====================================  3次の多項式  ================================================
+
+struct CubicPolynomial {
+	Vector3 a;  //!< t^3 の係数
+	Vector3 b;  //!< t^2 の係数
+	Vector3 c;  //!< t の係数
+	Vector3 d;  //!< 定数項
+};
+
+inline float Horner(float a, float b, float c, float d, float t) {
+	return ((a * t + b) * t + c) * t + d;
+}
+
+inline Vector3 EvaluateCubic(const CubicPolynomial& curve, float t) {
+	return {
+		Horner(curve.a.x, curve.b.x, curve.c.x, curve.d.x, t),
+		Horner(curve.a.y, curve.b.y, curve.c.y, curve.d.y, t),
+		Horner(curve.a.z, curve.b.z, curve.c.z, curve.d.z, t),
+	};
+}
+
+// 接線 P'(t) = (3a t + 2b) t + c
+inline Vector3 EvaluateCubicTangent(const CubicPolynomial& curve, float t) {
+	return {
+		(3.0f * curve.a.x * t + 2.0f * curve.b.x) * t + curve.c.x,
+		(3.0f * curve.a.y * t + 2.0f * curve.b.y) * t + curve.c.y,
+		(3.0f * curve.a.z * t + 2.0f * curve.b.z) * t + curve.c.z,
+	};
+}
+
+// エルミート曲線 (始点 p0・終点 p1・それぞれの接線 m0, m1) を多項式にする
+inline CubicPolynomial MakeHermitePolynomial(const Vector3& p0, const Vector3& m0, const Vector3& p1, const Vector3& m1) {
+	CubicPolynomial result;
+	result.a = { 2.0f * p0.x - 2.0f * p1.x + m0.x + m1.x, 2.0f * p0.y - 2.0f * p1.y + m0.y + m1.y, 2.0f * p0.z - 2.0f * p1.z + m0.z + m1.z };
+	result.b = { -3.0f * p0.x + 3.0f * p1.x - 2.0f * m0.x - m1.x, -3.0f * p0.y + 3.0f * p1.y - 2.0f * m0.y - m1.y, -3.0f * p0.z + 3.0f * p1.z - 2.0f * m0.z - m1.z };
+	result.c = m0;
+	result.d = p0;
+	return result;
+}
+
+//=================================================================================================
+
+
+//=====================================  3次ベジェ曲線  ==============================================
+
+inline CubicPolynomial MakeCubicBezierPolynomial(const Vector3& p0, const Vector3& p1, const Vector3& p2, const Vector3& p3) {
+	CubicPolynomial result;
+	result.a = { -p0.x + 3.0f * (p1.x - p2.x) + p3.x, -p0.y + 3.0f * (p1.y - p2.y) + p3.y, -p0.z + 3.0f * (p1.z - p2.z) + p3.z };
+	result.b = { 3.0f * (p0.x - 2.0f * p1.x + p2.x), 3.0f * (p0.y - 2.0f * p1.y + p2.y), 3.0f * (p0.z - 2.0f * p1.z + p2.z) };
+	result.c = { 3.0f * (p1.x - p0.x), 3.0f * (p1.y - p0.y), 3.0f * (p1.z - p0.z) };
+	result.d = p0;
+	return result;
+}
+
+// 1点だけ求めるときはド・カステリョ (Lerp の繰り返し) の方が誤差が小さい
+inline Vector3 CubicBezier(const Vector3& p0, const Vector3& p1, const Vector3& p2, const Vector3& p3, float t) {
+	Vector3 p01 = Lerp(p0, p1, t);
+	Vector3 p12 = Lerp(p1, p2, t);
+	Vector3 p23 = Lerp(p2, p3, t);
+	return Lerp(Lerp(p01, p12, t), Lerp(p12, p23, t), t);
+}
+
+//=================================================================================================
+
+
+//=====================================  N次ベジェ曲線  ==============================================
+// 制御点 count 個 (count - 1 次) をド・カステリョのアルゴリズムで評価する
+inline Vector3 BezierCurve(const Vector3* points, uint32_t count, float t) {
+	assert(count >= 1 && count <= kMaxCurvePoints);
+	Vector3 work[kMaxCurvePoints];
+	std::copy(points, points + count, work);
+	for (uint32_t level = count - 1; level > 0; --level) {
+		for (uint32_t i = 0; i < level; ++i) {
+			work[i] = Lerp(work[i], work[i + 1], t);
+		}
+	}
+	return work[0];
+}
+
+//=================================================================================================
+
+
+//=====================================  Catmull-Rom  ===============================================
+// p1 から p2 までの区間。p0, p3 は前後の点
+// alpha = 0 で一様、0.5 で centripetal (尖りやループが出にくい)、1 で chordal
+inline CubicPolynomial MakeCatmullRomPolynomial(const Vector3& p0, const Vector3& p1, const Vector3& p2, const Vector3& p3, float alpha = 0.0f) {
+	if (alpha == 0.0f) {
+		// 一様: 接線は (p2 - p0) / 2, (p3 - p1) / 2
+		Vector3 m1 = MultiplyVector(0.5f, SubtractVector(p2, p0));
+		Vector3 m2 = MultiplyVector(0.5f, SubtractVector(p3, p1));
+		return MakeHermitePolynomial(p1, m1, p2, m2);
+	}
+
+	// 点の間隔から各区間のノット幅 |pi+1 - pi|^alpha を求める (重なった点は1にする)
+	auto knotInterval = [alpha](const Vector3& a, const Vector3& b) {
+		float interval = std::pow(Length(SubtractVector(b, a)), alpha);
+		return (interval > 1e-6f) ? interval : 1.0f;
+	};
+	float dt0 = knotInterval(p0, p1);
+	float dt1 = knotInterval(p1, p2);
+	float dt2 = knotInterval(p2, p3);
+
+	// 非一様な Catmull-Rom の接線を [0, 1] の区間に合わせて dt1 倍する
+	Vector3 m1 = AddVector(SubtractVector(MultiplyVector(1.0f / dt0, SubtractVector(p1, p0)), MultiplyVector(1.0f / (dt0 + dt1), SubtractVector(p2, p0))),
+		MultiplyVector(1.0f / dt1, SubtractVector(p2, p1)));
+	Vector3 m2 = AddVector(SubtractVector(MultiplyVector(1.0f / dt1, SubtractVector(p2, p1)), MultiplyVector(1.0f / (dt1 + dt2), SubtractVector(p3, p1))),
+		MultiplyVector(1.0f / dt2, SubtractVector(p3, p2)));
+	return MakeHermitePolynomial(p1, MultiplyVector(dt1, m1), p2, MultiplyVector(dt1, m2));
+}
+
+// 全ての点を通る曲線の区間 (count - 1 個) を segments の後ろに追加する
+// 両端は端の点を折り返した点を前後の点として使う
+inline void MakeCatmullRomSegments(const Vector3* points, uint32_t count, float alpha, std::vector<CubicPolynomial>& segments) {
+	if (count < 2) {
+		return;
+	}
+	auto at = [&](int64_t index) -> Vector3 {
+		if (index < 0) {
+			return SubtractVector(MultiplyVector(2.0f, points[0]), points[1]);
+		}
+		if (index >= int64_t(count)) {
+			return SubtractVector(MultiplyVector(2.0f, points[count - 1]), points[count - 2]);
+		}
+		return points[index];
+	};
+	for (int64_t i = 0; i + 1 < int64_t(count); ++i) {
+		segments.push_back(MakeCatmullRomPolynomial(at(i - 1), at(i), at(i + 1), at(i + 2), alpha));
+	}
+}
+
+//=================================================================================================
+
+
+//=====================================  Bスプライン  ===============================================
+
+// 一様3次Bスプラインの区間 (制御点 p0～p3 の間) を多項式にする
+inline CubicPolynomial MakeUniformBSplinePolynomial(const Vector3& p0, const Vector3& p1, const Vector3& p2, const Vector3& p3) {
+	const float k = 1.0f / 6.0f;
+	CubicPolynomial result;
+	result.a = { k * (-p0.x + 3.0f * (p1.x - p2.x) + p3.x), k * (-p0.y + 3.0f * (p1.y - p2.y) + p3.y), k * (-p0.z + 3.0f * (p1.z - p2.z) + p3.z) };
+	result.b = { 0.5f * (p0.x - 2.0f * p1.x + p2.x), 0.5f * (p0.y - 2.0f * p1.y + p2.y), 0.5f * (p0.z - 2.0f * p1.z + p2.z) };
+	result.c = { 0.5f * (p2.x - p0.x), 0.5f * (p2.y - p0.y), 0.5f * (p2.z - p0.z) };
+	result.d = { k * (p0.x + 4.0f * p1.x + p2.x), k * (p0.y + 4.0f * p1.y + p2.y), k * (p0.z + 4.0f * p1.z + p2.z) };
+	return result;
+}
+
+// 一様3次Bスプラインの区間 (count - 3 個) を segments の後ろに追加する
+inline void MakeUniformBSplineSegments(const Vector3* points, uint32_t count, std::vector<CubicPolynomial>& segments) {
+	for (uint32_t i = 0; i + 3 < count; ++i) {
+		segments.push_back(MakeUniformBSplinePolynomial(points[i], points[i + 1], points[i + 2], points[i + 3]));
+	}
+}
+
+// 両端を通る (clamped) 一様なノット列を [0, 1] で作る。knots の数は count + degree + 1
+inline void MakeClampedKnots(uint32_t count, uint32_t degree, std::vector<float>& knots) {
+	assert(count > degree);
+	knots.resize(count + degree + 1);
+	uint32_t inner = count - degree;  // 区間の数
+	for (uint32_t i = 0; i < knots.size(); ++i) {
+		if (i <= degree) {
+			knots[i] = 0.0f;
+		}
+		else if (i >= count) {
+			knots[i] = 1.0f;
+		}
+		else {
+			knots[i] = float(i - degree) / float(inner);
+		}
+	}
+}
+
+// 非一様Bスプラインをド・ブーアのアルゴリズムで評価する
+// knots は count + degree + 1 個の単調増加の列で、t は knots[degree] ～ knots[count] の範囲
+inline Vector3 EvaluateBSpline(const Vector3* points, uint32_t count, uint32_t degree, const float* knots, float t) {
+	assert(degree >= 1 && degree < kMaxCurvePoints && count > degree);
+	t = std::clamp(t, knots[degree], knots[count]);
+
+	// knots[span] <= t < knots[span + 1] となる区間 (最後は閉区間)
+	uint32_t span = uint32_t(std::upper_bound(knots + degree, knots + count, t) - knots) - 1;
+	span = (std::min)(span, count - 1);
+
+	Vector3 work[kMaxCurvePoints];
+	for (uint32_t j = 0; j <= degree; ++j) {
+		work[j] = points[span - degree + j];
+	}
+	for (uint32_t r = 1; r <= degree; ++r) {
+		for (uint32_t j = degree; j >= r; --j) {
+			uint32_t i = span - degree + j;
+			float denominator = knots[i + degree + 1 - r] - knots[i];
+			float alpha = (denominator > 0.0f) ? (t - knots[i]) / denominator : 0.0f;
+			work[j] = Lerp(work[j - 1], work[j], alpha);
+		}
+	}
+	return work[degree];
+}
+
+//=================================================================================================
+
+
+//=====================================  区間をつないだ曲線  ==========================================
+// u (0 ～ 1) を区間の番号と区間内の t に分けて評価する
+inline Vector3 EvaluateCubicSegments(const CubicPolynomial* segments, uint32_t segmentCount, float u) {
+	assert(segmentCount > 0);
+	float s = std::clamp(u, 0.0f, 1.0f) * float(segmentCount);
+	uint32_t index = (std::min)(uint32_t(s), segmentCount - 1);
+	return EvaluateCubic(segments[index], s - float(index));
+}
+
+//=================================================================================================
+
+
+//==============================  まとめて評価 (1つの曲線・たくさんの t)  ==================================
+
+inline void EvaluateCubicArrayScalar(const CubicPolynomial& curve, const float* t, Vector3* out, uint32_t begin, uint32_t end) {
+	for (uint32_t i = begin; i < end; ++i) {
+		out[i] = EvaluateCubic(curve, t[i]);
+	}
+}
+
+#if MT3_SIMD_X86
+
+SIMD_TARGET_SSE41
+inline __m128 HornerSSE(__m128 a, __m128 b, __m128 c, __m128 d, __m128 t) {
+	return _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(a, t), b), t), c), t), d);
+}
+
+SIMD_TARGET_AVX2
+inline __m256 HornerAVX2(__m256 a, __m256 b, __m256 c, __m256 d, __m256 t) {
+	return _mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(a, t), b), t), c), t), d);
+}
+
+// t を4つずつ処理する。戻り値は処理した数
+SIMD_TARGET_SSE41
+inline uint32_t EvaluateCubicArraySSE(const CubicPolynomial& curve, const float* t, Vector3* out, uint32_t count) {
+	const __m128 ax = _mm_set1_ps(curve.a.x), bx = _mm_set1_ps(curve.b.x), cx = _mm_set1_ps(curve.c.x), dx = _mm_set1_ps(curve.d.x);
+	const __m128 ay = _mm_set1_ps(curve.a.y), by = _mm_set1_ps(curve.b.y), cy = _mm_set1_ps(curve.c.y), dy = _mm_set1_ps(curve.d.y);
+	const __m128 az = _mm_set1_ps(curve.a.z), bz = _mm_set1_ps(curve.b.z), cz = _mm_set1_ps(curve.c.z), dz = _mm_set1_ps(curve.d.z);
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128 tt = _mm_loadu_ps(t + i);
+		alignas(16) float x[4], y[4], z[4];
+		_mm_store_ps(x, HornerSSE(ax, bx, cx, dx, tt));
+		_mm_store_ps(y, HornerSSE(ay, by, cy, dy, tt));
+		_mm_store_ps(z, HornerSSE(az, bz, cz, dz, tt));
+		for (uint32_t lane = 0; lane < 4; ++lane) {
+			out[i + lane] = { x[lane], y[lane], z[lane] };
+		}
+	}
+	return i;
+}
+
+// t を8つずつ処理する。戻り値は処理した数
+SIMD_TARGET_AVX2
+inline uint32_t EvaluateCubicArrayAVX2(const CubicPolynomial& curve, const float* t, Vector3* out, uint32_t count) {
+	const __m256 ax = _mm256_set1_ps(curve.a.x), bx = _mm256_set1_ps(curve.b.x), cx = _mm256_set1_ps(curve.c.x), dx = _mm256_set1_ps(curve.d.x);
+	const __m256 ay = _mm256_set1_ps(curve.a.y), by = _mm256_set1_ps(curve.b.y), cy = _mm256_set1_ps(curve.c.y), dy = _mm256_set1_ps(curve.d.y);
+	const __m256 az = _mm256_set1_ps(curve.a.z), bz = _mm256_set1_ps(curve.b.z), cz = _mm256_set1_ps(curve.c.z), dz = _mm256_set1_ps(curve.d.z);
+	uint32_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 tt = _mm256_loadu_ps(t + i);
+		alignas(32) float x[8], y[8], z[8];
+		_mm256_store_ps(x, HornerAVX2(ax, bx, cx, dx, tt));
+		_mm256_store_ps(y, HornerAVX2(ay, by, cy, dy, tt));
+		_mm256_store_ps(z, HornerAVX2(az, bz, cz, dz, tt));
+		for (uint32_t lane = 0; lane < 8; ++lane) {
+			out[i + lane] = { x[lane], y[lane], z[lane] };
+		}
+	}
+	return i;
+}
+
+#endif
+
+// out[i] = curve(t[i])
+inline void EvaluateCubicArray(const CubicPolynomial& curve, const float* t, Vector3* out, uint32_t count) {
+	uint32_t done = 0;
+	switch (GetSimdLevel()) {
+#if MT3_SIMD_X86
+	case SimdLevel::AVX2: done = EvaluateCubicArrayAVX2(curve, t, out, count); break;
+	case SimdLevel::SSE41: done = EvaluateCubicArraySSE(curve, t, out, count); break;
+#endif
+	default: break;
+	}
+	EvaluateCubicArrayScalar(curve, t, out, done, count);
+}
+
+//=================================================================================================
+
+
+//============================  まとめて評価 (たくさんの曲線・それぞれの t)  ================================
+
+// 多数の曲線の係数を要素ごとの配列で持つ
+struct CubicCurvesSoA {
+	std::vector<float> ax, ay, az;
+	std::vector<float> bx, by, bz;
+	std::vector<float> cx, cy, cz;
+	std::vector<float> dx, dy, dz;
+
+	uint32_t Add(const CubicPolynomial& curve) {
+		ax.push_back(curve.a.x); ay.push_back(curve.a.y); az.push_back(curve.a.z);
+		bx.push_back(curve.b.x); by.push_back(curve.b.y); bz.push_back(curve.b.z);
+		cx.push_back(curve.c.x); cy.push_back(curve.c.y); cz.push_back(curve.c.z);
+		dx.push_back(curve.d.x); dy.push_back(curve.d.y); dz.push_back(curve.d.z);
+		return GetCount() - 1;
+	}
+	void Clear() { *this = CubicCurvesSoA(); }
+	uint32_t GetCount() const { return uint32_t(ax.size()); }
+};
+
+inline void EvaluateCubicCurvesScalar(const CubicCurvesSoA& curves, const float* t, Vector3* out, uint32_t begin, uint32_t end) {
+	for (uint32_t i = begin; i < end; ++i) {
+		out[i] = {
+			Horner(curves.ax[i], curves.bx[i], curves.cx[i], curves.dx[i], t[i]),
+			Horner(curves.ay[i], curves.by[i], curves.cy[i], curves.dy[i], t[i]),
+			Horner(curves.az[i], curves.bz[i], curves.cz[i], curves.dz[i], t[i]),
+		};
+	}
+}
+
+#if MT3_SIMD_X86
+
+SIMD_TARGET_SSE41
+inline uint32_t EvaluateCubicCurvesSSE(const CubicCurvesSoA& curves, const float* t, Vector3* out, uint32_t count) {
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128 tt = _mm_loadu_ps(t + i);
+		alignas(16) float x[4], y[4], z[4];
+		_mm_store_ps(x, HornerSSE(_mm_loadu_ps(&curves.ax[i]), _mm_loadu_ps(&curves.bx[i]), _mm_loadu_ps(&curves.cx[i]), _mm_loadu_ps(&curves.dx[i]), tt));
+		_mm_store_ps(y, HornerSSE(_mm_loadu_ps(&curves.ay[i]), _mm_loadu_ps(&curves.by[i]), _mm_loadu_ps(&curves.cy[i]), _mm_loadu_ps(&curves.dy[i]), tt));
+		_mm_store_ps(z, HornerSSE(_mm_loadu_ps(&curves.az[i]), _mm_loadu_ps(&curves.bz[i]), _mm_loadu_ps(&curves.cz[i]), _mm_loadu_ps(&curves.dz[i]), tt));
+		for (uint32_t lane = 0; lane < 4; ++lane) {
+			out[i + lane] = { x[lane], y[lane], z[lane] };
+		}
+	}
+	return i;
+}
+
+SIMD_TARGET_AVX2
+inline uint32_t EvaluateCubicCurvesAVX2(const CubicCurvesSoA& curves, const float* t, Vector3* out, uint32_t count) {
+	uint32_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 tt = _mm256_loadu_ps(t + i);
+		alignas(32) float x[8], y[8], z[8];
+		_mm256_store_ps(x, HornerAVX2(_mm256_loadu_ps(&curves.ax[i]), _mm256_loadu_ps(&curves.bx[i]), _mm256_loadu_ps(&curves.cx[i]), _mm256_loadu_ps(&curves.dx[i]), tt));
+		_mm256_store_ps(y, HornerAVX2(_mm256_loadu_ps(&curves.ay[i]), _mm256_loadu_ps(&curves.by[i]), _mm256_loadu_ps(&curves.cy[i]), _mm256_loadu_ps(&curves.dy[i]), tt));
+		_mm256_store_ps(z, HornerAVX2(_mm256_loadu_ps(&curves.az[i]), _mm256_loadu_ps(&curves.bz[i]), _mm256_loadu_ps(&curves.cz[i]), _mm256_loadu_ps(&curves.dz[i]), tt));
+		for (uint32_t lane = 0; lane < 8; ++lane) {
+			out[i + lane] = { x[lane], y[lane], z[lane] };
+		}
+	}
+	return i;
+}
+
+#endif
+
+// out[i] = curves[i](t[i])。t と out は曲線の数だけ必要
+inline void EvaluateCubicCurves(const CubicCurvesSoA& curves, const float* t, Vector3* out) {
+	uint32_t count = curves.GetCount();
+	uint32_t done = 0;
+	switch (GetSimdLevel()) {
+#if MT3_SIMD_X86
+	case SimdLevel::AVX2: done = EvaluateCubicCurvesAVX2(curves, t, out, count); break;
+	case SimdLevel::SSE41: done = EvaluateCubicCurvesSSE(curves, t, out, count); break;
+#endif
+	default: break;
+	}
+	EvaluateCubicCurvesScalar(curves, t, out, done, count);
+}
+
+//=================================================================================================
+
+
+//===================================  弧長パラメータ化  ============================================
+// 曲線を sampleCount 等分した点の累積距離を表にしておき、距離から t を二分探索と線形補間で求める
+// 一定速度で曲線上を移動させたいとき (カメラレールなど) に使う
+
+class ArcLengthTable {
+public:
+	// curve(t) (0 <= t <= 1) の表を作る
+	template <typename Curve>
+	void Build(Curve&& curve, uint32_t sampleCount = 64);
+
+	float GetLength() const { return lengths_.empty() ? 0.0f : lengths_.back(); }
+
+	// 始点からの距離 distance の位置の t
+	float ParameterAtDistance(float distance) const;
+	// 全体の長さに対する割合 fraction (0 ～ 1) の位置の t
+	float ParameterAtFraction(float fraction) const { return ParameterAtDistance(fraction * GetLength()); }
+
+private:
+	std::vector<float> lengths_;  //!< lengths_[i] は t = i / (lengths_.size() - 1) までの距離
+};
+
+template <typename Curve>
+void ArcLengthTable::Build(Curve&& curve, uint32_t sampleCount) {
+	assert(sampleCount >= 1);
+	lengths_.resize(sampleCount + 1);
+	lengths_[0] = 0.0f;
+	Vector3 previous = curve(0.0f);
+	for (uint32_t i = 1; i <= sampleCount; ++i) {
+		Vector3 point = curve(float(i) / float(sampleCount));
+		lengths_[i] = lengths_[i - 1] + Length(SubtractVector(point, previous));
+		previous = point;
+	}
+}
+
+inline float ArcLengthTable::ParameterAtDistance(float distance) const {
+	assert(!lengths_.empty());
+	uint32_t sampleCount = uint32_t(lengths_.size()) - 1;
+	if (distance <= 0.0f || sampleCount == 0) {
+		return 0.0f;
+	}
+	if (distance >= lengths_.back()) {
+		return 1.0f;
+	}
+	// lengths_[index] <= distance < lengths_[index + 1]
+	uint32_t index = uint32_t(std::upper_bound(lengths_.begin(), lengths_.end(), distance) - lengths_.begin()) - 1;
+	float segment = lengths_[index + 1] - lengths_[index];
+	float local = (segment > 0.0f) ? (distance - lengths_[index]) / segment : 0.0f;
+	return (float(index) + local) / float(sampleCount);
+}
+
+//=================================================================================================
@@ -0,0 +1,357 @@
+#pragma once
+#include "Geometry.h"
+#include "LineBatch.h"
+#include "Profiler.h"
+#include "ScreenTransform.h"
+#include "SphereMesh.h"
+#include <Novice.h>
+
+// Novice を使った表示・描画
+
+
+//===========================================  表示  ==============================================
+
+static const int kRowHeight = 20;
+static const int kColumnWidth = 60;
+inline void VectorScreenPrintf(int x, int y, const Vector3& vector) {
+	Novice::ScreenPrintf(x, y, "%.03f", vector.x);
+	Novice::ScreenPrintf(x + kColumnWidth, y, "%.03f", vector.y);
+	Novice::ScreenPrintf(x + kColumnWidth * 2, y, "%.03f", vector.z);
+}
+
+inline void MatrixScreenPrintf(int x, int y, const Matrix4x4& matrix) {
+	for (int row = 0; row < 4; ++row) {
+		for (int column = 0; column < 4; ++column) {
+			Novice::ScreenPrintf(x + column * kColumnWidth, y + row * kRowHeight, "%6.02f", matrix.m[row][column]);
+		}
+	}
+}
+
+//=================================================================================================
+
+
+//========================================  線の送り先  ============================================
+// 描画関数の線は全て SubmitLine を通る
+// SetLineBatch で LineBatch を渡している間はそこにためて、フレームの最後に Flush でまとめて描く
+// (渡していなければ今まで通りすぐに Novice::DrawLine で描く)
+// LineBatch はスレッドごとに設定する。ワーカースレッドでは必ず設定してから描画関数を呼ぶ (Novice はメインスレッドのみ)
+
+// Novice で描く描画側
+class NoviceLineBackend : public LineBackend {
+public:
+	void Submit(const ScreenLine* lines, uint32_t count) override {
+		for (uint32_t i = 0; i < count; ++i) {
+			Novice::DrawLine(lines[i].x0, lines[i].y0, lines[i].x1, lines[i].y1, lines[i].color);
+		}
+	}
+};
+
+inline LineBatch*& ActiveLineBatch() {
+	static thread_local LineBatch* batch = nullptr;
+	return batch;
+}
+
+// nullptr を渡すとすぐに描く状態に戻る
+inline void SetLineBatch(LineBatch* batch) {
+	ActiveLineBatch() = batch;
+}
+
+inline void SubmitLine(int x0, int y0, int x1, int y1, uint32_t color) {
+	if (LineBatch* batch = ActiveLineBatch()) {
+		batch->Add(x0, y0, x1, y1, color);
+	} else {
+		Novice::DrawLine(x0, y0, x1, y1, color);
+	}
+}
+
+// スクリーン座標に変換した点 (ToScreen / ToScreenArray の結果) の線分
+// LineBatch にためるときは両端の深度の平均を描く順番にし、Flush で奥の線から先に描く
+inline void SubmitLine(const Vector3& start, const Vector3& end, const ScreenTransform& screen, uint32_t color) {
+	if (LineBatch* batch = ActiveLineBatch()) {
+		batch->Add(int(start.x), int(start.y), int(end.x), int(end.y), color, DepthDrawOrder((start.z + end.z) * 0.5f, screen.depthMode));
+	} else {
+		Novice::DrawLine(int(start.x), int(start.y), int(end.x), int(end.y), color);
+	}
+}
+//=================================================================================================
+
+
+//=====================================  クリップ付きの線  ===========================================
+// ワールド座標の線分をニアクリップ面で切ってから変換して描く (視錐台の外なら何もしない)
+// カメラをまたぐ物を描くときに使う。全体がカメラの前にあると分かっていれば ToScreenArray でまとめて変換する方が速い
+inline void DrawClippedLine(Vector3 start, Vector3 end, const ScreenTransform& screen, uint32_t color) {
+	if (!ClipSegment(screen.frustum, start, end)) {
+		return;
+	}
+	Vector3 startScreen = ToScreen(start, screen);
+	Vector3 endScreen = ToScreen(end, screen);
+	SubmitLine(startScreen, endScreen, screen, color);
+}
+//=================================================================================================
+
+
+//=========================================  グリッド  =============================================
+// center はグリッドの中心 (WorldOrigin で原点を動かしているときは、ワールドの原点を ToLocal した位置)
+inline void DrawGrid(const ScreenTransform& screen, const Vector3& center = { 0.0f, 0.0f, 0.0f })
+{
+	MT3_PROFILE_ZONE("DrawGrid");
+	const float kGridHalfWidth = 2.0f;                                       // Gridの半分の幅
+	const uint32_t kSubdivision = 10;                                        // 分割数
+	const float kGridEvery = (kGridHalfWidth * 2.0f) / float(kSubdivision);  // 1つ分の長さ
+
+	if (!IsVisible(screen.frustum, AABB{ { center.x - kGridHalfWidth, center.y, center.z - kGridHalfWidth }, { center.x + kGridHalfWidth, center.y, center.z + kGridHalfWidth } })) {
+		return;
+	}
+
+	// 奥から手前への線を順々に引いていく
+	for (uint32_t xIndex = 0; xIndex <= kSubdivision; ++xIndex) {
+		float x = -kGridHalfWidth + (xIndex * kGridEvery);
+		unsigned int color = 0xAAAAAAFF;
+
+		Vector3 start{ center.x + x, center.y, center.z - kGridHalfWidth };
+		Vector3 end{ center.x + x, center.y, center.z + kGridHalfWidth };
+
+		if (x == 0.0f)
+		{
+			color = BLACK;
+		}
+
+		DrawClippedLine(start, end, screen, color);
+	}
+
+	for (uint32_t zIndex = 0; zIndex <= kSubdivision; ++zIndex) {
+		float z = -kGridHalfWidth + (zIndex * kGridEvery);
+		unsigned int color = 0xAAAAAAFF;
+
+		Vector3 start{ center.x - kGridHalfWidth, center.y, center.z + z };
+		Vector3 end{ center.x + kGridHalfWidth, center.y, center.z + z };
+
+		if (z == 0.0f)
+		{
+			color = BLACK;
+		}
+
+		DrawClippedLine(start, end, screen, color);
+	}
+}
+//=================================================================================================
+
+//=======================================  スフィア描画  ==========================================
+// 単位球の表 (SphereMesh.h) を拡大・平行移動して描く
+// subdivision が0なら画面上の大きさから分割数を選ぶ
+inline void DrawSphere(const Sphere& sphere, const ScreenTransform& screen, uint32_t color, uint32_t subdivision = 0) {
+	MT3_PROFILE_ZONE("DrawSphere");
+	if (!IsVisible(screen.frustum, sphere)) {
+		return;
+	}
+	if (subdivision == 0) {
+		subdivision = SelectSphereSubdivision(sphere, screen);
+	}
+	const SphereWireframe& wireframe = GetUnitSphereWireframe(subdivision);
+
+	// ニアクリップ面をまたぐときは辺ごとに切ってから描く
+	if (PlaneDistance(screen.frustum.planes[kFrustumNear], sphere.center) < sphere.radius) {
+		for (const WireframeEdge& edge : wireframe.edges) {
+			Vector3 start = AddVector(sphere.center, MultiplyVector(sphere.radius, wireframe.vertices[edge.start]));
+			Vector3 end = AddVector(sphere.center, MultiplyVector(sphere.radius, wireframe.vertices[edge.end]));
+			DrawClippedLine(start, end, screen, color);
+		}
+		return;
+	}
+
+	// 単位球 → ワールド → スクリーン をまとめた行列で、各頂点を1回だけ変換する
+	// 単位球 → ワールドは回転のない拡大と平行移動なので、MakeAffineMatrix (三角関数を使う) を通さずに作る
+	const float r = sphere.radius;
+	Matrix4x4 localMatrix = { {
+		{ r, 0.0f, 0.0f, 0.0f },
+		{ 0.0f, r, 0.0f, 0.0f },
+		{ 0.0f, 0.0f, r, 0.0f },
+		{ sphere.center.x, sphere.center.y, sphere.center.z, 1.0f },
+	} };
+	Matrix4x4 matrix = Multiply(localMatrix, screen.matrix);
+	Vector3 points[kMaxSphereVertices];
+	TransformArray(wireframe.vertices.data(), points, uint32_t(wireframe.vertices.size()), matrix);
+
+	for (const WireframeEdge& edge : wireframe.edges) {
+		const Vector3& start = points[edge.start];
+		const Vector3& end = points[edge.end];
+		SubmitLine(start, end, screen, color);
+	}
+}
+//=================================================================================================
+
+//***
+//========================================  線分の描画  ============================================
+inline void DrawLineSegment(const Segment& segment, const ScreenTransform& screen, int32_t color) {
+	MT3_PROFILE_ZONE("DrawLineSegment");
+	DrawClippedLine(segment.origin, AddVector(segment.origin, segment.diff), screen, color);
+}
+//=================================================================================================
+
+//========================================  平面の描画  ============================================
+inline void DrawPlane(const Plane& plane, const ScreenTransform& screen, uint32_t color) {
+	MT3_PROFILE_ZONE("DrawPlane");
+	Vector3 center = MultiplyVector(plane.distance, plane.normal);  // 1
+	Vector3 perpendiculars[4];
+	perpendiculars[0] = Normalize(Perpendicular(plane.normal));  // 2
+	perpendiculars[1] = { -perpendiculars[0].x, -perpendiculars[0].y, -perpendiculars[0].z };  // 3
+	perpendiculars[2] = Cross(plane.normal, perpendiculars[0]);  // 4
+	perpendiculars[3] = { -perpendiculars[2].x, -perpendiculars[2].y, -perpendiculars[2].z };  // 5
+	// 6
+	Vector3 points[4];
+	for (uint32_t index = 0; index < 4; ++index) {
+		Vector3 extend = MultiplyVector(2.0f, perpendiculars[index]);
+		Vector3 point = AddVector(center, extend);
+		points[index] = point;
+	}
+	// 4点は中心から半径2の円の上にある
+	if (!IsVisible(screen.frustum, Sphere{ center, 2.0f })) {
+		return;
+	}
+	if (!IsInFrontOfNearPlane(screen.frustum, points, 4)) {
+		DrawClippedLine(points[0], points[2], screen, color);
+		DrawClippedLine(points[0], points[3], screen, color);
+		DrawClippedLine(points[2], points[1], screen, color);
+		DrawClippedLine(points[3], points[1], screen, color);
+		return;
+	}
+	ToScreenArray(points, points, 4, screen);
+
+	SubmitLine(points[0], points[2], screen, color);
+	SubmitLine(points[0], points[3], screen, color);
+	SubmitLine(points[2], points[1], screen, color);
+	SubmitLine(points[3], points[1], screen, color);
+}
+//=================================================================================================
+
+//=======================================  三角形の描画  ============================================
+
+inline void DrawTriangle(const Triangle& triangle, const ScreenTransform& screen, uint32_t color) {
+	MT3_PROFILE_ZONE("DrawTriangle");
+	if (!IsVisible(screen.frustum, MakeAABB(triangle))) {
+		return;
+	}
+	// ニアクリップ面をまたぐと切った形は三角形でなくなるので、辺を1本ずつ描く
+	if (!IsInFrontOfNearPlane(screen.frustum, triangle.vertices, 3)) {
+		DrawClippedLine(triangle.vertices[0], triangle.vertices[1], screen, color);
+		DrawClippedLine(triangle.vertices[1], triangle.vertices[2], screen, color);
+		DrawClippedLine(triangle.vertices[2], triangle.vertices[0], screen, color);
+		return;
+	}
+	Vector3 screenVertices[3];
+	ToScreenArray(triangle.vertices, screenVertices, 3, screen);
+	// ワイヤーフレームの三角形は3本の線として送る (共有辺はまとめて描くときに1本になる)
+	SubmitLine(screenVertices[0], screenVertices[1], screen, color);
+	SubmitLine(screenVertices[1], screenVertices[2], screen, color);
+	SubmitLine(screenVertices[2], screenVertices[0], screen, color);
+}
+
+//=================================================================================================
+
+//========================================  aabbの描画  =============================================
+inline void DrawAABB(const AABB& aabb, const ScreenTransform& screen, uint32_t color) {
+	MT3_PROFILE_ZONE("DrawAABB");
+	if (!IsVisible(screen.frustum, aabb)) {
+		return;
+	}
+	Vector3 square1[4];
+	square1[0] = { aabb.min.x, aabb.min.y, aabb.min.z };
+	square1[1] = { aabb.min.x, aabb.min.y, aabb.max.z };
+	square1[2] = { aabb.max.x, aabb.min.y, aabb.max.z };
+	square1[3] = { aabb.max.x, aabb.min.y, aabb.min.z };
+	Vector3 square2[4];
+	square2[0] = { aabb.min.x, aabb.max.y, aabb.min.z };
+	square2[1] = { aabb.min.x, aabb.max.y, aabb.max.z };
+	square2[2] = { aabb.max.x, aabb.max.y, aabb.max.z };
+	square2[3] = { aabb.max.x, aabb.max.y, aabb.min.z };
+
+	if (!IsInFrontOfNearPlane(screen.frustum, square1, 4) || !IsInFrontOfNearPlane(screen.frustum, square2, 4)) {
+		for (uint32_t index = 0; index < 4; ++index) {
+			DrawClippedLine(square1[index], square2[index], screen, color);
+			DrawClippedLine(square1[index], square1[(index + 1) % 4], screen, color);
+			DrawClippedLine(square2[index], square2[(index + 1) % 4], screen, color);
+		}
+		return;
+	}
+
+	Vector3 screenSquare1[4];
+	Vector3 screenSquare2[4];
+	ToScreenArray(square1, screenSquare1, 4, screen);
+	ToScreenArray(square2, screenSquare2, 4, screen);
+
+	// 描画
+	for (uint32_t index = 0; index < 4; ++index) {
+		SubmitLine(screenSquare1[index], screenSquare2[index], screen, color);
+	}
+	SubmitLine(screenSquare1[0], screenSquare1[1], screen, color);
+	SubmitLine(screenSquare2[0], screenSquare2[1], screen, color);
+	SubmitLine(screenSquare1[0], screenSquare1[3], screen, color);
+	SubmitLine(screenSquare2[0], screenSquare2[3], screen, color);
+	SubmitLine(screenSquare1[2], screenSquare1[3], screen, color);
+	SubmitLine(screenSquare2[2], screenSquare2[3], screen, color);
+	SubmitLine(screenSquare1[1], screenSquare1[2], screen, color);
+	SubmitLine(screenSquare2[1], screenSquare2[2], screen, color);
+}
+//==================================================================================================
+
+
+//=====================================  ベジェ曲線の描画  ============================================
+static const float kBezierTolerance = 0.5f;     //!< 曲線と折れ線のずれの許容量 (ピクセル)
+static const uint32_t kBezierMaxSegments = 128;  //!< 分割数の上限
+
+// 画面上でのずれが tolerance 以下になる分割数 (Wang の式)
+// 2次ベジェ曲線を n 等分した折れ線と曲線のずれは最大 |p0 - 2p1 + p2| / (4n^2) なので、
+// 制御点をスクリーン座標に変換してから n = ceil(sqrt(|s0 - 2s1 + s2| / (4 * tolerance))) とする
+// (透視投影では近似だが、小さい曲線・遠い曲線ほど分割数が少なくなる)
+inline uint32_t BezierSegmentCount(const Vector3& controlPoint0, const Vector3& controlPoint1, const Vector3& controlPoint2,
+	const ScreenTransform& screen, float tolerance) {
+	Vector3 points[3] = { controlPoint0, controlPoint1, controlPoint2 };
+	ToScreenArray(points, points, 3, screen);
+
+	float x = points[0].x - 2.0f * points[1].x + points[2].x;
+	float y = points[0].y - 2.0f * points[1].y + points[2].y;
+	float n = std::ceil(std::sqrt(std::sqrt(x * x + y * y) / (4.0f * tolerance)));
+	if (!(n >= 1.0f)) {
+		return 1;  // 直線 (NaN もここに来る)
+	}
+	return (std::min)(kBezierMaxSegments, uint32_t(n));
+}
+
+// 分割した点をまとめてスクリーン座標に変換し、隣り合う点を結ぶ (各点の計算・変換は1回だけ)
+inline void DrawBezier(const Vector3& controlPoint0, const Vector3& controlPoint1, const Vector3& controlPoint2,
+	const ScreenTransform& screen, uint32_t color, float tolerance = kBezierTolerance) {
+	MT3_PROFILE_ZONE("DrawBezier");
+
+	// 曲線は制御点の凸包の中にあるので、制御点を囲むAABBで判定する
+	Vector3 controlPoints[3] = { controlPoint0, controlPoint1, controlPoint2 };
+	AABB bounds = {
+		{ (std::min)({ controlPoint0.x, controlPoint1.x, controlPoint2.x }), (std::min)({ controlPoint0.y, controlPoint1.y, controlPoint2.y }), (std::min)({ controlPoint0.z, controlPoint1.z, controlPoint2.z }) },
+		{ (std::max)({ controlPoint0.x, controlPoint1.x, controlPoint2.x }), (std::max)({ controlPoint0.y, controlPoint1.y, controlPoint2.y }), (std::max)({ controlPoint0.z, controlPoint1.z, controlPoint2.z }) },
+	};
+	if (!IsVisible(screen.frustum, bounds)) {
+		return;
+	}
+
+	// カメラをまたぐ曲線は、画面上の大きさが分からないので上限の分割数で描く
+	if (!IsInFrontOfNearPlane(screen.frustum, controlPoints, 3)) {
+		Vector3 points[kBezierMaxSegments + 1];
+		TessellateBezier(controlPoint0, controlPoint1, controlPoint2, kBezierMaxSegments, points);
+		for (uint32_t index = 0; index < kBezierMaxSegments; ++index) {
+			DrawClippedLine(points[index], points[index + 1], screen, color);
+		}
+		return;
+	}
+
+	uint32_t segmentCount = BezierSegmentCount(controlPoint0, controlPoint1, controlPoint2, screen, tolerance);
+
+	Vector3 points[kBezierMaxSegments + 1];
+	TessellateBezier(controlPoint0, controlPoint1, controlPoint2, segmentCount, points);
+	ToScreenArray(points, points, segmentCount + 1, screen);
+
+	for (uint32_t index = 0; index < segmentCount; ++index) {
+		const Vector3& start = points[index];
+		const Vector3& end = points[index + 1];
+		SubmitLine(start, end, screen, color);
+	}
+}
+//==================================================================================================
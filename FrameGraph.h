@@ -0,0 +1,96 @@
+#pragma once
+#include "JobSystem.h"
+#include <assert.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+
+// 1フレームの処理 (更新 → カリング → 頂点の生成 → 描画の準備 など) を依存関係つきのパスとして並べ、
+// JobSystem で実行する。依存しているパスが全て終わったパスから順にジョブとして積むので、
+// 依存関係のないパス同士は並列に動く。パスの中で ParallelFor を使ってもよい
+//
+//   FrameGraph frameGraph;
+//   uint32_t update = frameGraph.AddPass("update", [&] { ... });
+//   uint32_t cull = frameGraph.AddPass("cull", [&] { ... }, { update });
+//   frameGraph.Execute(jobSystem);  // 毎フレーム
+//
+// パスはどのスレッドで動くか分からないので、Novice の呼び出しは Execute の後にメインスレッドで行う
+
+class FrameGraph {
+public:
+	using PassFunction = std::function<void()>;
+
+	// 依存するパスは先に追加したものだけ (順番に追加すれば循環しない)。戻り値はパスの番号
+	uint32_t AddPass(const char* name, PassFunction function, std::initializer_list<uint32_t> dependencies = {});
+
+	// 全てのパスを実行し、終わるまで待つ
+	void Execute(JobSystem& jobSystem);
+
+	void Clear() {
+		passes_.clear();
+		remaining_.reset();
+	}
+
+	uint32_t GetPassCount() const { return uint32_t(passes_.size()); }
+	const char* GetPassName(uint32_t pass) const { return passes_[pass].name; }
+
+private:
+	struct Pass {
+		const char* name;
+		PassFunction function;
+		uint32_t dependencyCount;
+		std::vector<uint32_t> dependents;  //!< このパスが終わるのを待っているパス
+	};
+
+	void Schedule(JobSystem& jobSystem, JobCounter& counter, uint32_t pass);
+
+	std::vector<Pass> passes_;
+	std::unique_ptr<std::atomic<uint32_t>[]> remaining_;  //!< 実行中、各パスがあといくつのパスを待っているか
+};
+
+
+//==================================  パスの追加・実行  =============================================
+
+inline uint32_t FrameGraph::AddPass(const char* name, PassFunction function, std::initializer_list<uint32_t> dependencies) {
+	uint32_t index = GetPassCount();
+	for (uint32_t dependency : dependencies) {
+		assert(dependency < index);
+		passes_[dependency].dependents.push_back(index);
+	}
+	passes_.push_back({ name, std::move(function), uint32_t(dependencies.size()), {} });
+	// 待ちの数の入れ物はパスを追加するときに作り直す (Execute では数を入れ直すだけで、毎フレーム確保しない)
+	remaining_ = std::make_unique<std::atomic<uint32_t>[]>(passes_.size());
+	return index;
+}
+
+inline void FrameGraph::Execute(JobSystem& jobSystem) {
+	for (uint32_t pass = 0; pass < GetPassCount(); ++pass) {
+		remaining_[pass].store(passes_[pass].dependencyCount, std::memory_order_relaxed);
+	}
+
+	JobCounter counter;
+	for (uint32_t pass = 0; pass < GetPassCount(); ++pass) {
+		if (passes_[pass].dependencyCount == 0) {
+			Schedule(jobSystem, counter, pass);
+		}
+	}
+	jobSystem.Wait(counter);
+}
+
+// 終わったら、待っているパスのうち最後の依存だったものを積む
+// (次のパスを積んでからこのパスの分を減らすので、途中で counter が0になることはない)
+inline void FrameGraph::Schedule(JobSystem& jobSystem, JobCounter& counter, uint32_t pass) {
+	jobSystem.Run(counter, [this, &jobSystem, &counter, pass] {
+		passes_[pass].function();
+		for (uint32_t dependent : passes_[pass].dependents) {
+			if (remaining_[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+				Schedule(jobSystem, counter, dependent);
+			}
+		}
+	});
+}
+
+//=================================================================================================
@@ -0,0 +1,273 @@
+#pragma once
+#include "CollisionWorld.h"
+#include "SimdConfig.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstdint>
+
+// ビュープロジェクション行列から取り出した視錐台 (6枚の平面)
+// 平面の法線は内側向きで、Dot(normal, p) - distance >= 0 なら平面の内側
+// クリップ空間の -w <= x <= w, -w <= y <= w, 0 <= z <= w (MakePerspectiveFovMatrix の z は 0 ～ 1) をワールド座標で表したもの
+// ReverseZ では z = w がニアクリップ面になる。無限遠の射影ではファークリップ面は「常に内側」の平面になる
+
+enum FrustumPlane {
+	kFrustumLeft,
+	kFrustumRight,
+	kFrustumBottom,
+	kFrustumTop,
+	kFrustumNear,
+	kFrustumFar,
+	kFrustumPlaneCount,
+};
+
+struct Frustum {
+	Plane planes[kFrustumPlaneCount];
+};
+
+
+//======================================  視錐台の作成  ============================================
+
+// 行ベクトルなので、クリップ座標の各成分は行列の列との内積になる
+// (Gribb/Hartmann の方法。例えば左の面は x + w >= 0 なので 0列目 + 3列目)
+inline Frustum MakeFrustum(const Matrix4x4& viewProjectionMatrix, DepthMode depthMode = kDepthStandard) {
+	const Matrix4x4& m = viewProjectionMatrix;
+	auto column = [&m](int index, float sign) {
+		return Plane{
+			{ m.m[0][3] + sign * m.m[0][index], m.m[1][3] + sign * m.m[1][index], m.m[2][3] + sign * m.m[2][index] },
+			-(m.m[3][3] + sign * m.m[3][index]),
+		};
+	};
+
+	Frustum result;
+	result.planes[kFrustumLeft] = column(0, 1.0f);
+	result.planes[kFrustumRight] = column(0, -1.0f);
+	result.planes[kFrustumBottom] = column(1, 1.0f);
+	result.planes[kFrustumTop] = column(1, -1.0f);
+	Plane zeroPlane = { { m.m[0][2], m.m[1][2], m.m[2][2] }, -m.m[3][2] };  // z >= 0
+	Plane wPlane = column(2, -1.0f);                                         // z <= w
+	result.planes[kFrustumNear] = depthMode == kDepthStandard ? zeroPlane : wPlane;
+	result.planes[kFrustumFar] = depthMode == kDepthStandard ? wPlane : zeroPlane;
+
+	// 距離がワールドの長さになるように正規化する (球の半径と比べるため)
+	for (Plane& plane : result.planes) {
+		float length = Length(plane.normal);
+		if (length == 0.0f) {
+			// 無限遠のファークリップ面は法線が 0 になる。どの点でも内側になるようにする
+			plane.distance = -FLT_MAX;
+			continue;
+		}
+		plane.normal = MultiplyVector(1.0f / length, plane.normal);
+		plane.distance /= length;
+	}
+	return result;
+}
+
+//=================================================================================================
+
+
+//=====================================  1つずつの判定  ============================================
+
+// 平面までの符号付き距離 (内側が正)
+inline float PlaneDistance(const Plane& plane, const Vector3& point) {
+	return Dot(plane.normal, point) - plane.distance;
+}
+
+// 一部でも視錐台の中にあれば true (角の近くでは外にあっても true になることがある)
+inline bool IsVisible(const Frustum& frustum, const Sphere& sphere) {
+	for (const Plane& plane : frustum.planes) {
+		if (PlaneDistance(plane, sphere.center) < -sphere.radius) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// 各平面について、法線の方向に一番遠い頂点 (p-vertex) が外側なら見えない
+inline bool IsVisible(const Frustum& frustum, const AABB& aabb) {
+	for (const Plane& plane : frustum.planes) {
+		Vector3 p = {
+			plane.normal.x >= 0.0f ? aabb.max.x : aabb.min.x,
+			plane.normal.y >= 0.0f ? aabb.max.y : aabb.min.y,
+			plane.normal.z >= 0.0f ? aabb.max.z : aabb.min.z,
+		};
+		if (PlaneDistance(plane, p) < 0.0f) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// 全ての点がニアクリップ面より手前 (カメラから見て奥) にあれば true
+// このときはw除算をそのまま行ってよい
+inline bool IsInFrontOfNearPlane(const Frustum& frustum, const Vector3* points, uint32_t count) {
+	for (uint32_t i = 0; i < count; ++i) {
+		if (PlaneDistance(frustum.planes[kFrustumNear], points[i]) < 0.0f) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// 線分を描く前の処理
+// 両端が同じ平面の外側なら false (描かない)。ニアクリップ面をまたぐ場合は内側に切り詰める
+// w除算の前 (ワールド座標) で切るので、カメラの後ろの点で w が 0 や負になることはない
+inline bool ClipSegment(const Frustum& frustum, Vector3& start, Vector3& end) {
+	for (int index = 0; index < kFrustumPlaneCount; ++index) {
+		const Plane& plane = frustum.planes[index];
+		float startDistance = PlaneDistance(plane, start);
+		float endDistance = PlaneDistance(plane, end);
+		if (startDistance < 0.0f && endDistance < 0.0f) {
+			return false;
+		}
+		if (index != kFrustumNear || (startDistance >= 0.0f && endDistance >= 0.0f)) {
+			continue;
+		}
+		Vector3 intersection = Lerp(start, end, startDistance / (startDistance - endDistance));
+		if (startDistance < 0.0f) {
+			start = intersection;
+		} else {
+			end = intersection;
+		}
+	}
+	return true;
+}
+
+//=================================================================================================
+
+
+//==================================  たくさん (ビットマスク)  ======================================
+// CollisionWorld と同じく、見えるものの番号のビットを立てる
+// 平面はどの要素でも同じなので、AABBの p-vertex の選び方も平面ごとに1回決めればよい
+
+inline void FrustumVsSpheresScalar(const SphereSoA& spheres, const Frustum& frustum, uint32_t begin, uint32_t count, uint64_t* visibleMask) {
+	for (uint32_t i = begin; i < count; ++i) {
+		bool visible = true;
+		for (const Plane& plane : frustum.planes) {
+			float d = plane.normal.x * spheres.centerX[i] + plane.normal.y * spheres.centerY[i] + plane.normal.z * spheres.centerZ[i] - plane.distance;
+			visible = visible && d >= -spheres.radius[i];
+		}
+		if (visible) {
+			visibleMask[i / 64] |= uint64_t(1) << (i % 64);
+		}
+	}
+}
+
+inline void FrustumVsAABBsScalar(const AABBSoA& aabbs, const Frustum& frustum, uint32_t begin, uint32_t count, uint64_t* visibleMask) {
+	for (uint32_t i = begin; i < count; ++i) {
+		bool visible = true;
+		for (const Plane& plane : frustum.planes) {
+			float x = plane.normal.x >= 0.0f ? aabbs.maxX[i] : aabbs.minX[i];
+			float y = plane.normal.y >= 0.0f ? aabbs.maxY[i] : aabbs.minY[i];
+			float z = plane.normal.z >= 0.0f ? aabbs.maxZ[i] : aabbs.minZ[i];
+			visible = visible && plane.normal.x * x + plane.normal.y * y + plane.normal.z * z - plane.distance >= 0.0f;
+		}
+		if (visible) {
+			visibleMask[i / 64] |= uint64_t(1) << (i % 64);
+		}
+	}
+}
+
+#if MT3_SIMD_X86
+
+SIMD_TARGET_SSE41
+inline uint32_t FrustumVsSpheresSSE(const SphereSoA& spheres, const Frustum& frustum, uint32_t count, uint64_t* visibleMask) {
+	const __m128 zero = _mm_setzero_ps();
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128 cx = _mm_loadu_ps(&spheres.centerX[i]), cy = _mm_loadu_ps(&spheres.centerY[i]), cz = _mm_loadu_ps(&spheres.centerZ[i]);
+		__m128 negativeRadius = _mm_sub_ps(zero, _mm_loadu_ps(&spheres.radius[i]));
+		__m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (const Plane& plane : frustum.planes) {
+			__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.normal.x), cx), _mm_mul_ps(_mm_set1_ps(plane.normal.y), cy)), _mm_mul_ps(_mm_set1_ps(plane.normal.z), cz));
+			d = _mm_sub_ps(d, _mm_set1_ps(plane.distance));
+			visible = _mm_and_ps(visible, _mm_cmpge_ps(d, negativeRadius));
+		}
+		visibleMask[i / 64] |= uint64_t(_mm_movemask_ps(visible)) << (i % 64);
+	}
+	return i;
+}
+
+SIMD_TARGET_SSE41
+inline uint32_t FrustumVsAABBsSSE(const AABBSoA& aabbs, const Frustum& frustum, uint32_t count, uint64_t* visibleMask) {
+	const __m128 zero = _mm_setzero_ps();
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (const Plane& plane : frustum.planes) {
+			__m128 x = _mm_loadu_ps(plane.normal.x >= 0.0f ? &aabbs.maxX[i] : &aabbs.minX[i]);
+			__m128 y = _mm_loadu_ps(plane.normal.y >= 0.0f ? &aabbs.maxY[i] : &aabbs.minY[i]);
+			__m128 z = _mm_loadu_ps(plane.normal.z >= 0.0f ? &aabbs.maxZ[i] : &aabbs.minZ[i]);
+			__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.normal.x), x), _mm_mul_ps(_mm_set1_ps(plane.normal.y), y)), _mm_mul_ps(_mm_set1_ps(plane.normal.z), z));
+			d = _mm_sub_ps(d, _mm_set1_ps(plane.distance));
+			visible = _mm_and_ps(visible, _mm_cmpge_ps(d, zero));
+		}
+		visibleMask[i / 64] |= uint64_t(_mm_movemask_ps(visible)) << (i % 64);
+	}
+	return i;
+}
+
+SIMD_TARGET_AVX2
+inline uint32_t FrustumVsSpheresAVX2(const SphereSoA& spheres, const Frustum& frustum, uint32_t count, uint64_t* visibleMask) {
+	const __m256 zero = _mm256_setzero_ps();
+	uint32_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 cx = _mm256_loadu_ps(&spheres.centerX[i]), cy = _mm256_loadu_ps(&spheres.centerY[i]), cz = _mm256_loadu_ps(&spheres.centerZ[i]);
+		__m256 negativeRadius = _mm256_sub_ps(zero, _mm256_loadu_ps(&spheres.radius[i]));
+		__m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (const Plane& plane : frustum.planes) {
+			__m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.normal.x), cx), _mm256_mul_ps(_mm256_set1_ps(plane.normal.y), cy)), _mm256_mul_ps(_mm256_set1_ps(plane.normal.z), cz));
+			d = _mm256_sub_ps(d, _mm256_set1_ps(plane.distance));
+			visible = _mm256_and_ps(visible, _mm256_cmp_ps(d, negativeRadius, _CMP_GE_OQ));
+		}
+		visibleMask[i / 64] |= uint64_t(_mm256_movemask_ps(visible)) << (i % 64);
+	}
+	return i;
+}
+
+SIMD_TARGET_AVX2
+inline uint32_t FrustumVsAABBsAVX2(const AABBSoA& aabbs, const Frustum& frustum, uint32_t count, uint64_t* visibleMask) {
+	const __m256 zero = _mm256_setzero_ps();
+	uint32_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (const Plane& plane : frustum.planes) {
+			__m256 x = _mm256_loadu_ps(plane.normal.x >= 0.0f ? &aabbs.maxX[i] : &aabbs.minX[i]);
+			__m256 y = _mm256_loadu_ps(plane.normal.y >= 0.0f ? &aabbs.maxY[i] : &aabbs.minY[i]);
+			__m256 z = _mm256_loadu_ps(plane.normal.z >= 0.0f ? &aabbs.maxZ[i] : &aabbs.minZ[i]);
+			__m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.normal.x), x), _mm256_mul_ps(_mm256_set1_ps(plane.normal.y), y)), _mm256_mul_ps(_mm256_set1_ps(plane.normal.z), z));
+			d = _mm256_sub_ps(d, _mm256_set1_ps(plane.distance));
+			visible = _mm256_and_ps(visible, _mm256_cmp_ps(d, zero, _CMP_GE_OQ));
+		}
+		visibleMask[i / 64] |= uint64_t(_mm256_movemask_ps(visible)) << (i % 64);
+	}
+	return i;
+}
+
+#else
+
+// x86 以外では呼ばれない。DispatchSimd から参照するためだけの定義
+inline uint32_t FrustumVsSpheresSSE(const SphereSoA&, const Frustum&, uint32_t, uint64_t*) { return 0; }
+inline uint32_t FrustumVsAABBsSSE(const AABBSoA&, const Frustum&, uint32_t, uint64_t*) { return 0; }
+inline uint32_t FrustumVsSpheresAVX2(const SphereSoA&, const Frustum&, uint32_t, uint64_t*) { return 0; }
+inline uint32_t FrustumVsAABBsAVX2(const AABBSoA&, const Frustum&, uint32_t, uint64_t*) { return 0; }
+
+#endif
+
+// visibleMask には HitMaskWordCount(要素数) 個の領域が必要。戻り値は見える数
+inline uint32_t FrustumVsSpheres(const Frustum& frustum, const SphereSoA& spheres, uint64_t* visibleMask) {
+	const uint32_t count = uint32_t(spheres.radius.size());
+	return DispatchSimd(count, visibleMask,
+		[&](uint32_t begin) { FrustumVsSpheresScalar(spheres, frustum, begin, count, visibleMask); },
+		[&] { return FrustumVsSpheresSSE(spheres, frustum, count, visibleMask); },
+		[&] { return FrustumVsSpheresAVX2(spheres, frustum, count, visibleMask); });
+}
+
+inline uint32_t FrustumVsAABBs(const Frustum& frustum, const AABBSoA& aabbs, uint64_t* visibleMask) {
+	const uint32_t count = uint32_t(aabbs.minX.size());
+	return DispatchSimd(count, visibleMask,
+		[&](uint32_t begin) { FrustumVsAABBsScalar(aabbs, frustum, begin, count, visibleMask); },
+		[&] { return FrustumVsAABBsSSE(aabbs, frustum, count, visibleMask); },
+		[&] { return FrustumVsAABBsAVX2(aabbs, frustum, count, visibleMask); });
+}
+
+//=================================================================================================
@@ -0,0 +1,390 @@
+#pragma once
+#include "MakeMatrix.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+
+// ベクトル演算・プリミティブ・衝突判定 (Novice に依存しない)
+
+
+struct Sphere {
+	Vector3 center;  //!< 中心点
+	float radius;    //!< 半径
+};
+
+struct Line {
+	Vector3 origin;  //!< 始点
+	Vector3 diff;    //!< 終点への差分ベクトル
+};
+
+struct Ray {
+	Vector3 origin;  //!< 始点
+	Vector3 diff;    //!< 終点への差分ベクトル
+};
+
+struct Segment {
+	Vector3 origin;  //!< 始点
+	Vector3 diff;    //!< 終点への差分ベクトル
+};
+
+struct Plane {
+	Vector3 normal;  //!< 法線 
+	float distance;  //!< 距離
+};
+
+struct Triangle {
+	Vector3 vertices[3]; //!< 頂点
+	Vector3 normal;
+};
+
+struct AABB {
+	Vector3 min;
+	Vector3 max;
+};
+
+// 同じ配列の中の2つのプリミティブの組 (種類の違う組は CollisionWorld.h の SpherePrimitivePair)
+struct CollisionPair {
+	uint32_t a;  //!< 番号の小さい方
+	uint32_t b;  //!< 番号の大きい方
+};
+
+//======================================  ベクトルの加算  =========================================
+inline Vector3 AddVector(const Vector3& v1, const Vector3& v2) {
+	Vector3 result;
+	result = { v1.x + v2.x, v1.y + v2.y, v1.z + v2.z };
+	return result;
+}
+//=================================================================================================
+
+//=======================================  ベクトルの減算  ==========================================
+inline Vector3 SubtractVector(const Vector3& v1, const Vector3& v2) {
+	Vector3 result;
+	result = { v1.x - v2.x, v1.y - v2.y, v1.z - v2.z };
+	return result;
+}
+//=================================================================================================
+
+//=================================================================================================
+inline Vector3 MultiplyVector(const float& k, const Vector3& v) {
+	Vector3 result;
+	result = { k * v.x, k * v.y, k * v.z };
+	return result;
+}
+//=================================================================================================
+
+
+//===========================================  正規化  =============================================
+inline Vector3 Normalize(const Vector3& vector) {
+	Vector3 result;
+	float length = std::sqrt(vector.x * vector.x + vector.y * vector.y + vector.z * vector.z);
+	float mag = 1 / length;
+	result = { vector.x * mag, vector.y * mag, vector.z * mag };
+	return result;
+}
+//=================================================================================================
+
+//===========================================  内積  =============================================
+inline float Dot(const Vector3& v1, const Vector3& v2) {
+	float result;
+	result = v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
+	return result;
+}
+
+inline float DotFloat(const Vector3& vector, const float& a) {
+	float result;
+	result = vector.x * a + vector.y * a + vector.z * a;
+	return result;
+}
+//=================================================================================================
+
+//===========================================  距離  =============================================
+inline float Length(const Vector3& vector) {
+	float result;
+	result = std::sqrt(vector.x * vector.x + vector.y * vector.y + vector.z * vector.z);
+	return result;
+}
+//=================================================================================================
+
+//==========================================  線形補間  ============================================
+inline Vector3 Lerp(const Vector3& start, const Vector3& end, float t) {
+	Vector3 pos;
+
+	pos.x = (1.0f - t) * start.x + t * end.x;
+	pos.y = (1.0f - t) * start.y + t * end.y;
+	pos.z = (1.0f - t) * start.z + t * end.z;
+
+	return pos;
+}
+//=================================================================================================
+
+
+//======================================  正射影ベクトル  =========================================
+inline Vector3 Project(const Vector3& v1, const Vector3& v2) {
+	Vector3 result;
+	float t = (v1.x * v2.x + v1.y * v2.y + v1.z * v2.z) / (std::sqrt(v2.x * v2.x + v2.y * v2.y + v2.z * v2.z) * std::sqrt(v2.x * v2.x + v2.y * v2.y + v2.z * v2.z));
+	result = { v2.x * t, v2.y * t, v2.z * t };
+	return result;
+}
+//=================================================================================================
+
+//========================================  垂直なベクトル  =========================================
+inline Vector3 Perpendicular(const Vector3& vector) {
+	if (vector.x != 0.0f || vector.y != 0.0f) {
+		return { -vector.y, vector.x, 0.0f };
+	}
+	return { 0.0f, -vector.z, vector.y };
+}
+//=================================================================================================
+
+//=========================================  最近接点  =============================================
+inline Vector3 ClosestPoint(const Vector3& point, const Segment& segment) {
+	Vector3 result;
+	Vector3 project = Project(SubtractVector(point, segment.origin), segment.diff);
+	result = { segment.origin.x + project.x, segment.origin.y + project.y, segment.origin.z + project.z };
+	return result;
+}
+//=================================================================================================
+
+
+//======================================  球同士の衝突判定  ==========================================
+inline bool IsCollisionSphere(const Sphere& s1, const Sphere& s2) {
+	float x = (s2.center.x - s1.center.x) * (s2.center.x - s1.center.x);
+	float y = (s2.center.y - s1.center.y) * (s2.center.y - s1.center.y);
+	float z = (s2.center.z - s1.center.z) * (s2.center.z - s1.center.z);
+
+	// 距離の2乗と半径の和の2乗で比べる (sqrtを使わない)
+	float r = s1.radius + s2.radius;
+	if (r * r >= x + y + z) {
+		return true;
+	}
+	else {
+		return false;
+	}
+}
+//=================================================================================================
+
+//=====================================  球と平面の衝突判定  =========================================
+inline bool IsCollisionPlane(const Sphere& sphere, const Plane& plane) {
+	// 平面は Dot(normal, p) = distance (DrawPlane と IsCollisionSegment に合わせる)
+	float k = std::fabs(Dot(plane.normal, sphere.center) - plane.distance);
+
+	if (k <= sphere.radius) {
+		return true;
+	}
+	else {
+		return false;
+	}
+}
+//=================================================================================================
+
+//=====================================  線と平面の衝突判定  =========================================
+inline bool IsCollisionSegment(const Segment& segment, const Plane& plane) {
+	// まず垂直判定を行うために、法線と線の内積を求める
+	float dot = Dot(plane.normal, segment.diff);
+
+	// 垂直=平行であるので、衝突しているはずがない
+	if (dot == 0.0f) {
+		return false;
+	}
+
+	// tを求める
+	float t = (plane.distance - Dot(segment.origin, plane.normal)) / dot;
+
+	// tの値と線の種類によって衝突しているかを判断する
+	if (t >= 0 && t <= 1) {
+		return true;
+	}
+	else {
+		return false;
+	}
+}
+//=================================================================================================
+
+//====================================  線と三角形の衝突判定  ========================================
+
+inline bool IsCollisionTriangle(const Triangle& triangle, const Segment& segment) {
+
+	Vector3 v01 = SubtractVector(triangle.vertices[1], triangle.vertices[0]);
+	Vector3 v12 = SubtractVector(triangle.vertices[2], triangle.vertices[1]);
+	Vector3 v20 = SubtractVector(triangle.vertices[0], triangle.vertices[2]);
+
+	Plane plane;
+	plane.normal = Normalize(Cross(v01, v12));
+	plane.distance = Dot(plane.normal, triangle.vertices[0]);
+
+	float dot = Dot(plane.normal, segment.diff);
+	if (dot == 0.0f) {
+		return false;
+	}
+
+	float t = (plane.distance - Dot(segment.origin, plane.normal)) / dot;
+	Vector3 p = {
+		segment.origin.x + segment.diff.x * t,
+		segment.origin.y + segment.diff.y * t,
+		segment.origin.z + segment.diff.z * t
+	};
+
+	Vector3 v1p = { p.x - triangle.vertices[1].x, p.y - triangle.vertices[1].y, p.z - triangle.vertices[1].z };
+	Vector3 v2p = { p.x - triangle.vertices[2].x, p.y - triangle.vertices[2].y, p.z - triangle.vertices[2].z };
+	Vector3 v0p = { p.x - triangle.vertices[0].x, p.y - triangle.vertices[0].y, p.z - triangle.vertices[0].z };
+
+	// 各辺を結んだベクトルと、頂点と衝突点pを結んだベクトルのクロス積を取る
+	Vector3 cross01 = Cross(v01, v1p);
+	Vector3 cross12 = Cross(v12, v2p);
+	Vector3 cross20 = Cross(v20, v0p);
+
+	if (t >= 0 && t <= 1) {
+		if (Dot(cross01, plane.normal) >= 0.0f &&
+			Dot(cross12, plane.normal) >= 0.0f &&
+			Dot(cross20, plane.normal) >= 0.0f) {
+			return true;
+		}
+		else {
+			return false;
+		}
+	}
+	else {
+		return false;
+	}
+
+}
+
+//=================================================================================================
+
+//======================================  AABBの衝突判定  ==========================================
+inline bool isCollisionAABB(const AABB& a, const AABB& b) {
+	if ((a.min.x <= b.max.x && a.max.x >= b.min.x) && // x軸
+		(a.min.y <= b.max.y && a.max.y >= b.min.y) && // y軸
+		(a.min.z <= b.max.z && a.max.z >= b.min.z)) { // z軸
+		return true;
+	}
+
+	return false;
+}
+//=================================================================================================
+
+//=======================================  AABBの作成  ==============================================
+inline AABB MakeAABB(const Sphere& sphere) {
+	return {
+		{ sphere.center.x - sphere.radius, sphere.center.y - sphere.radius, sphere.center.z - sphere.radius },
+		{ sphere.center.x + sphere.radius, sphere.center.y + sphere.radius, sphere.center.z + sphere.radius },
+	};
+}
+
+inline AABB MakeAABB(const Triangle& triangle) {
+	AABB result = { triangle.vertices[0], triangle.vertices[0] };
+	for (uint32_t index = 1; index < 3; ++index) {
+		const Vector3& v = triangle.vertices[index];
+		result.min = { (std::min)(result.min.x, v.x), (std::min)(result.min.y, v.y), (std::min)(result.min.z, v.z) };
+		result.max = { (std::max)(result.max.x, v.x), (std::max)(result.max.y, v.y), (std::max)(result.max.z, v.z) };
+	}
+	return result;
+}
+
+// 2つのAABBを囲むAABB
+inline AABB MergeAABB(const AABB& a, const AABB& b) {
+	return {
+		{ (std::min)(a.min.x, b.min.x), (std::min)(a.min.y, b.min.y), (std::min)(a.min.z, b.min.z) },
+		{ (std::max)(a.max.x, b.max.x), (std::max)(a.max.y, b.max.y), (std::max)(a.max.z, b.max.z) },
+	};
+}
+//=================================================================================================
+
+//==================================  スラブ法の1軸分の範囲  =========================================
+// t0, t1 は線分がその軸の2枚の面を通る t ((面 - origin) * (1 / diff))
+// diff が0の軸で origin がちょうど面の上にあると 0 * inf = NaN になる。そのとき origin は面の上 (その軸の範囲の内側) なので、
+// その軸では t を制限しない (std::min/max に NaN を渡すと、引数の順番しだいで NaN が残って当たらなくなる)
+inline float SlabNear(float t0, float t1) {
+	return (std::isnan(t0) || std::isnan(t1)) ? -FLT_MAX : (std::min)(t0, t1);
+}
+
+inline float SlabFar(float t0, float t1) {
+	return (std::isnan(t0) || std::isnan(t1)) ? FLT_MAX : (std::max)(t0, t1);
+}
+//=================================================================================================
+
+//==================================  スフィアとAABBの衝突判定  ======================================
+inline bool isCollisionSphereAABB(const AABB& aabb, const Sphere& sphere) {
+	Vector3 closestPoint{ 
+		std::clamp(sphere.center.x, aabb.min.x, aabb.max.x), 
+		std::clamp(sphere.center.y, aabb.min.y, aabb.max.y), 
+		std::clamp(sphere.center.z, aabb.min.z, aabb.max.z)
+	};
+	// 細菌接点と球の中心との距離を求める
+	Vector3 length = {
+		closestPoint.x - sphere.center.x,
+		closestPoint.y - sphere.center.y,
+		closestPoint.z - sphere.center.z,
+	};
+	float distance = Length(length);
+	// 距離が半径よりも小さければ衝突
+	if (distance <= sphere.radius) {
+		return true;
+	}
+	return false;
+}
+//=================================================================================================
+
+//====================================  AABBと線分の衝突判定  =======================~~===============
+inline bool IsCollisionAABBSeg(const AABB& aabb, const Segment& segment) {
+//	float dot = Dot(plane.normal, segment.diff);
+	float tXmin = (aabb.min.x - segment.origin.x) / segment.diff.x;
+	float tXmax = (aabb.max.x - segment.origin.x) / segment.diff.x;
+	float tYmin = (aabb.min.y - segment.origin.y) / segment.diff.y;
+	float tYmax = (aabb.max.y - segment.origin.y) / segment.diff.y;
+	float tZmin = (aabb.min.z - segment.origin.z) / segment.diff.z;
+	float tZmax = (aabb.max.z - segment.origin.z) / segment.diff.z;
+
+	float tNearX = (std::min)(tXmin, tXmax);
+	float tNearY = (std::min)(tYmin, tYmax);
+	float tNearZ = (std::min)(tZmin, tZmax);
+	float tFarX = (std::max)(tXmin, tXmax);
+	float tFarY = (std::max)(tYmin, tYmax);
+	float tFarZ = (std::max)(tZmin, tZmax);
+
+	// AABBとの衝突点（貫通点）のtが小さい方
+	float tmin = (std::max)((std::max)(tNearX, tNearY), tNearZ);
+	// AABBとの衝突点（貫通点）のtが大きい方
+	float tmax = (std::min)((std::min)(tFarX, tFarY), tFarZ);
+	if (tmin <= tmax) {
+		return true;
+	}
+	return false;
+}
+
+//=================================================================================================
+
+
+//================================ 2次ベジェ曲線上の点を求める関数 ======================================
+inline Vector3 Bezier(const Vector3& p0, const Vector3& p1, const Vector3& p2, float t) {
+	Vector3 p0p1 = Lerp(p0, p1, t);
+	Vector3 p1p2 = Lerp(p1, p2, t);
+	Vector3 result = Lerp(p0p1, p1p2, t);
+
+	return result;
+}
+//==================================================================================================
+
+//=========================  2次ベジェ曲線を等間隔に分割した点を求める関数  ==============================
+// B(t) = p0 + 2t(p1 - p0) + t^2(p0 - 2p1 + p2) を前進差分で求める (1点あたり加算だけ)
+// out には segmentCount + 1 個の点が入る。最後の点は誤差が溜まらないように p2 をそのまま使う
+inline void TessellateBezier(const Vector3& p0, const Vector3& p1, const Vector3& p2, uint32_t segmentCount, Vector3* out) {
+	float h = 1.0f / float(segmentCount);
+	Vector3 a = { p0.x - 2.0f * p1.x + p2.x, p0.y - 2.0f * p1.y + p2.y, p0.z - 2.0f * p1.z + p2.z };
+	Vector3 b = { 2.0f * (p1.x - p0.x), 2.0f * (p1.y - p0.y), 2.0f * (p1.z - p0.z) };
+
+	// 1階差分 df = B(t + h) - B(t) の初期値と、2階差分 ddf (一定)
+	Vector3 point = p0;
+	Vector3 df = { b.x * h + a.x * h * h, b.y * h + a.y * h * h, b.z * h + a.z * h * h };
+	Vector3 ddf = { 2.0f * a.x * h * h, 2.0f * a.y * h * h, 2.0f * a.z * h * h };
+
+	out[0] = point;
+	for (uint32_t index = 1; index < segmentCount; ++index) {
+		point = { point.x + df.x, point.y + df.y, point.z + df.z };
+		df = { df.x + ddf.x, df.y + ddf.y, df.z + ddf.z };
+		out[index] = point;
+	}
+	out[segmentCount] = p2;
+}
+//==================================================================================================
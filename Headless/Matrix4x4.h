@@ -0,0 +1,11 @@
+#pragma once
+
+// KamataEngine (DirectXGame/math/Matrix4x4.h) が無い環境で使う同じレイアウトの定義
+// CMake で Novice を使わずにビルドするときだけインクルードパスに入る
+
+/// <summary>
+/// 4x4行列
+/// </summary>
+struct Matrix4x4 final {
+	float m[4][4];
+};
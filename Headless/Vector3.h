@@ -0,0 +1,13 @@
+#pragma once
+
+// KamataEngine (DirectXGame/math/Vector3.h) が無い環境で使う同じレイアウトの定義
+// CMake で Novice を使わずにビルドするときだけインクルードパスに入る
+
+/// <summary>
+/// 3次元ベクトル
+/// </summary>
+struct Vector3 final {
+	float x;
+	float y;
+	float z;
+};
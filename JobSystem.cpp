@@ -0,0 +1,142 @@
+#include "JobSystem.h"
+
+//=======================================  スレッド番号  ===========================================
+
+// メインスレッドは JobSystem を作ったときに0、ワーカーは起動時に自分の番号を入れる
+static thread_local uint32_t tThreadIndex = JobSystem::kNoThreadIndex;
+// ワーカーが属している JobSystem
+static thread_local const JobSystem* tWorkerOwner = nullptr;
+// このスレッドがメインスレッド (0番) になっている JobSystem の数。0に戻ったら番号を元に戻す
+static thread_local uint32_t tMainSlotCount = 0;
+
+uint32_t JobSystem::GetThreadIndex() {
+	return tThreadIndex;
+}
+
+bool JobSystem::IsOwnThread() const {
+	return tWorkerOwner == this || (ownsMainSlot_ && std::this_thread::get_id() == mainThreadId_);
+}
+
+//=================================================================================================
+
+
+//====================================  作成・終了  ================================================
+
+JobSystem::JobSystem(uint32_t threadCount) : mainThreadId_(std::this_thread::get_id()) {
+	// 0番になれるのは、どの JobSystem のワーカーでもないスレッドだけ
+	// (ワーカーが別の JobSystem を作ったときは番号を変えず、その JobSystem からは外のスレッドとして扱う)
+	ownsMainSlot_ = (tWorkerOwner == nullptr);
+	if (ownsMainSlot_) {
+		tThreadIndex = 0;
+		++tMainSlotCount;
+	}
+	if (threadCount == 0) {
+		threadCount = (std::max)(1u, std::thread::hardware_concurrency());
+	}
+	for (uint32_t i = 0; i < threadCount; ++i) {
+		queues_.push_back(std::make_unique<Queue>());
+	}
+	// 0番は呼び出し元のスレッドなので、ワーカーは1番から
+	for (uint32_t i = 1; i < threadCount; ++i) {
+		workers_.emplace_back([this, i] { WorkerLoop(i); });
+	}
+}
+
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex_);
+		quit_.store(true);
+	}
+	wake_.notify_all();
+	for (std::thread& worker : workers_) {
+		worker.join();
+	}
+	// 作ったスレッドで壊すときだけ戻す (他のスレッドの番号は書き換えられない)
+	if (ownsMainSlot_ && std::this_thread::get_id() == mainThreadId_ && --tMainSlotCount == 0) {
+		tThreadIndex = kNoThreadIndex;
+	}
+}
+
+//=================================================================================================
+
+
+//=====================================  ジョブの実行  =============================================
+
+void JobSystem::Run(JobCounter& counter, Job job) {
+	counter.pending_.fetch_add(1, std::memory_order_relaxed);
+	// 取り出す側が先に減らしても0を下回らないように、積む前に増やす
+	queuedCount_.fetch_add(1);
+
+	Queue& queue = *queues_[GetQueueIndex()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.entries.push_back({ std::move(job), &counter });
+	}
+
+	// 眠っているワーカーを1つ起こす (ロックを取ってから起こし、待ちに入る直前のワーカーを取りこぼさない)
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex_);
+	}
+	wake_.notify_one();
+}
+
+bool JobSystem::TryRunOne(uint32_t threadIndex) {
+	Entry entry;
+	bool found = false;
+
+	// 自分の列は後ろから
+	{
+		Queue& queue = *queues_[threadIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.entries.empty()) {
+			entry = std::move(queue.entries.back());
+			queue.entries.pop_back();
+			found = true;
+		}
+	}
+	// 他のスレッドの列からは前から盗む
+	for (uint32_t offset = 1; !found && offset < GetThreadCount(); ++offset) {
+		Queue& queue = *queues_[(threadIndex + offset) % GetThreadCount()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.entries.empty()) {
+			entry = std::move(queue.entries.front());
+			queue.entries.pop_front();
+			found = true;
+		}
+	}
+	if (!found) {
+		return false;
+	}
+
+	queuedCount_.fetch_sub(1);
+	entry.job();
+	entry.counter->pending_.fetch_sub(1, std::memory_order_release);
+	return true;
+}
+
+void JobSystem::Wait(JobCounter& counter) {
+	uint32_t threadIndex = GetQueueIndex();
+	while (!counter.IsDone()) {
+		if (!TryRunOne(threadIndex)) {
+			// 残りは他のスレッドが実行中
+			std::this_thread::yield();
+		}
+	}
+}
+
+void JobSystem::WorkerLoop(uint32_t threadIndex) {
+	tThreadIndex = threadIndex;
+	tWorkerOwner = this;
+	while (true) {
+		if (TryRunOne(threadIndex)) {
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(sleepMutex_);
+		wake_.wait(lock, [this] { return quit_.load() || queuedCount_.load() > 0; });
+		if (quit_.load() && queuedCount_.load() == 0) {
+			return;
+		}
+	}
+}
+
+//=================================================================================================
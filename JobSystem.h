@@ -0,0 +1,116 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ワークスティーリングのジョブシステム
+// スレッドごとにジョブの列を持ち、自分の列は後ろから (最後に積んだものから) 取り出し、
+// 自分の列が空になったら他のスレッドの列の前から (古いものから) 盗む
+// Wait で待っている間も、待っているスレッドがジョブを実行する (メインスレッドも働く)
+//
+//   JobSystem jobSystem;
+//   jobSystem.ParallelFor(count, 64, [&](uint32_t begin, uint32_t end) { ... });
+//
+// スレッド番号は、JobSystem を作ったスレッド (メインスレッド) が0、ワーカーが 1 ～ GetThreadCount() - 1
+// それ以外のスレッドは kNoThreadIndex。スレッドごとの入れ物 (ThreadLineBatches など) は
+// IsOwnThread() を確かめてから GetThreadIndex() で選ぶ (他のスレッドと0番を取り合わないように)
+// ワーカーが別の JobSystem を作っても、そのワーカーの番号は変わらない (作った JobSystem のメインスレッドにはならない)
+// メインスレッドの番号は、そのスレッドで作った JobSystem が全て壊れたときに kNoThreadIndex に戻る
+
+// Run したジョブのうち、まだ終わっていないものの数
+class JobCounter {
+public:
+	bool IsDone() const { return pending_.load(std::memory_order_acquire) == 0; }
+
+private:
+	friend class JobSystem;
+	std::atomic<uint32_t> pending_{ 0 };
+};
+
+class JobSystem {
+public:
+	using Job = std::function<void()>;
+
+	static const uint32_t kNoThreadIndex = UINT32_MAX;  //!< メインスレッドでもワーカーでもないスレッド
+
+	// threadCount は呼び出し元のスレッドも含めた数。0ならハードウェアのスレッド数
+	explicit JobSystem(uint32_t threadCount = 0);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	uint32_t GetThreadCount() const { return uint32_t(queues_.size()); }
+	static uint32_t GetThreadIndex();
+
+	// 今のスレッドが、この JobSystem を作ったスレッドかワーカーなら true
+	bool IsOwnThread() const;
+
+	// 今のスレッドの列に積む。counter はジョブが終わるまで残しておく
+	void Run(JobCounter& counter, Job job);
+
+	// counter のジョブが全て終わるまで、他のジョブを実行しながら待つ
+	void Wait(JobCounter& counter);
+
+	// [0, count) を grainSize 個ずつに分けて function(begin, end) を並列に呼び、全て終わるまで待つ
+	template <typename Function>
+	void ParallelFor(uint32_t count, uint32_t grainSize, Function&& function);
+
+private:
+	struct Entry {
+		Job job;
+		JobCounter* counter;
+	};
+
+	// 1スレッド分の列 (持ち主と盗むスレッドで取り合うのでロックする)
+	struct Queue {
+		std::mutex mutex;
+		std::deque<Entry> entries;
+	};
+
+	// 列の番号。この JobSystem のスレッドでなければ0番の列を使う (列はロックするので取り合っても壊れない)
+	uint32_t GetQueueIndex() const { return IsOwnThread() ? GetThreadIndex() : 0; }
+
+	bool TryRunOne(uint32_t threadIndex);
+	void WorkerLoop(uint32_t threadIndex);
+
+	std::vector<std::unique_ptr<Queue>> queues_;
+	std::vector<std::thread> workers_;
+	std::thread::id mainThreadId_;
+	bool ownsMainSlot_ = false;  //!< 作ったスレッドがこの JobSystem の0番か (ワーカーが作ったときは false)
+
+	std::atomic<uint32_t> queuedCount_{ 0 };  //!< 全ての列に積まれているジョブの数
+	std::atomic<bool> quit_{ false };
+	std::mutex sleepMutex_;
+	std::condition_variable wake_;
+};
+
+
+//=====================================  並列 for  =================================================
+
+template <typename Function>
+inline void JobSystem::ParallelFor(uint32_t count, uint32_t grainSize, Function&& function) {
+	if (count == 0) {
+		return;
+	}
+	grainSize = (std::max)(grainSize, 1u);
+
+	// 最後の区間は積まずにこのスレッドで実行する
+	JobCounter counter;
+	uint32_t last = (count - 1) / grainSize * grainSize;
+	for (uint32_t begin = 0; begin < last; begin += grainSize) {
+		uint32_t end = begin + grainSize;
+		Run(counter, [&function, begin, end] { function(begin, end); });
+	}
+	function(last, count);
+	Wait(counter);
+}
+
+//=================================================================================================
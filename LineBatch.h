@@ -0,0 +1,257 @@
+#pragma once
+#include "JobSystem.h"
+#include <algorithm>
+#include <assert.h>
+#include <cstdint>
+#include <vector>
+
+// スクリーン座標の線分をためておき、1フレームに1回まとめて描画側へ渡す
+// 渡す前に端点の向きをそろえて 深度のまとまり (奥から手前) → 色 → 深度 の順に並べ替え、
+// 同じ線分 (隣り合うAABBの共有辺など) は1本にする
+// 奥の線から先に描くので、後から上書きする描画側 (Novice、SoftwareRasterizer) では手前の線が上に残る
+// 色の切り替えを減らすため、深度の近い線 (同じまとまり) の中では色ごとにまとめる。
+// そのため、まとまりの中で色の違う線が重なるところだけは、奥と手前が入れ替わって描かれることがある
+// 描画側 (LineBackend) を差し替えられるので、Novice を使わないベンチマークなどでは
+// MemoryLineBackend でメモリに書き出すだけにできる
+
+struct ScreenLine {
+	int32_t x0, y0;
+	int32_t x1, y1;
+	uint32_t color;
+};
+
+inline bool operator==(const ScreenLine& a, const ScreenLine& b) {
+	return a.color == b.color && a.x0 == b.x0 && a.y0 == b.y0 && a.x1 == b.x1 && a.y1 == b.y1;
+}
+
+// 色 → 始点 → 終点 の順で比べる (同じ色の線が続くように並べる)
+inline bool operator<(const ScreenLine& a, const ScreenLine& b) {
+	if (a.color != b.color) return a.color < b.color;
+	if (a.x0 != b.x0) return a.x0 < b.x0;
+	if (a.y0 != b.y0) return a.y0 < b.y0;
+	if (a.x1 != b.x1) return a.x1 < b.x1;
+	return a.y1 < b.y1;
+}
+
+
+//=======================================  描画側  ================================================
+
+// LineBatch::Flush から1フレームに1回呼ばれる
+class LineBackend {
+public:
+	virtual ~LineBackend() = default;
+	virtual void Submit(const ScreenLine* lines, uint32_t count) = 0;
+};
+
+// 受け取った線分をメモリに書き出すだけの描画側 (描画結果の確認やベンチマーク用)
+class MemoryLineBackend : public LineBackend {
+public:
+	void Submit(const ScreenLine* lines, uint32_t count) override {
+		lines_.insert(lines_.end(), lines, lines + count);
+		++submitCount_;
+	}
+
+	const std::vector<ScreenLine>& GetLines() const { return lines_; }
+	uint32_t GetSubmitCount() const { return submitCount_; }
+	void Clear() {
+		lines_.clear();
+		submitCount_ = 0;
+	}
+
+private:
+	std::vector<ScreenLine> lines_;
+	uint32_t submitCount_ = 0;
+};
+
+//=================================================================================================
+
+
+//====================================  線分をためる入れ物  ========================================
+
+class LineBatch {
+public:
+	// depthOrder は描く順番 (小さいほど先に描く = 奥)。DepthDrawOrder (ScreenTransform.h) で深度から作る
+	// depthOrder の上位 kDepthBucketBits ビットが同じ線は色ごとにまとまる
+	void Add(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t color, uint32_t depthOrder = 0) {
+		// 向きをそろえて、逆向きに描かれた同じ線分も重複として取り除けるようにする
+		if (x1 < x0 || (x1 == x0 && y1 < y0)) {
+			std::swap(x0, x1);
+			std::swap(y0, y1);
+		}
+		lines_.push_back({ { x0, y0, x1, y1, color }, depthOrder });
+		// 16ビットに収まらない座標 (ニアクリップ面の近くで画面外へ大きくはみ出す線など) があるか
+		wideCoordinates_ = wideCoordinates_ || !IsShort(x0) || !IsShort(y0) || !IsShort(x1) || !IsShort(y1);
+	}
+
+	// 並べ替え・重複の削除をしてから backend に1回で渡し、空にする
+	void Flush(LineBackend& backend) {
+		if (wideCoordinates_) {
+			// 同じ線分は一番手前のものだけ残す (奥のものは上から描かれて見えなくなるので)
+			std::sort(lines_.begin(), lines_.end(), [](const BatchedLine& a, const BatchedLine& b) {
+				return a.line == b.line ? a.depthOrder < b.depthOrder : a.line < b.line;
+			});
+			// 後ろから unique すると各グループの最後 (一番手前) が残り、残ったものは後ろに詰まる
+			lines_.erase(lines_.begin(), std::unique(lines_.rbegin(), lines_.rend(), [](const BatchedLine& a, const BatchedLine& b) {
+				return a.line == b.line;
+			}).base());
+			std::sort(lines_.begin(), lines_.end());
+			sorted_.resize(lines_.size());
+			for (size_t i = 0; i < lines_.size(); ++i) {
+				sorted_[i] = lines_[i].line;
+			}
+		} else {
+			SortByKey();
+		}
+		wideCoordinates_ = false;
+		submittedCount_ = uint32_t(sorted_.size());
+		if (!sorted_.empty()) {
+			backend.Submit(sorted_.data(), submittedCount_);
+		}
+		// 容量は残すので、次のフレームからは確保しない
+		lines_.clear();
+		sorted_.clear();
+	}
+
+	// other にためた線分を後ろに移し、other を空にする (Flush で並べ替えるので順番は結果に影響しない)
+	void Append(LineBatch& other) {
+		lines_.insert(lines_.end(), other.lines_.begin(), other.lines_.end());
+		wideCoordinates_ = wideCoordinates_ || other.wideCoordinates_;
+		other.lines_.clear();
+		other.wideCoordinates_ = false;
+	}
+
+	// 描かずに捨てる
+	void Clear() {
+		lines_.clear();
+		wideCoordinates_ = false;
+	}
+
+	void Reserve(uint32_t count) {
+		lines_.reserve(count);
+		sorted_.reserve(count);
+	}
+
+	// 今ためている本数
+	uint32_t GetLineCount() const { return uint32_t(lines_.size()); }
+	// 直前の Flush で渡した本数 (重複を除いた後)
+	uint32_t GetSubmittedCount() const { return submittedCount_; }
+
+	// 色ごとにまとめる深度の範囲。DepthDrawOrder の上位16ビットは float の符号・指数・仮数の上位7ビットなので、
+	// 深度の差がおよそ 1/128 (相対) より小さい線が同じまとまりになる
+	static constexpr uint32_t kDepthBucketBits = 16;
+
+private:
+	static uint32_t DepthBucket(uint32_t depthOrder) { return depthOrder >> (32 - kDepthBucketBits); }
+
+	struct BatchedLine {
+		ScreenLine line;
+		uint32_t depthOrder;
+
+		// 深度のまとまり (奥から手前) → 色 → 深度 → 始点 → 終点
+		bool operator<(const BatchedLine& other) const {
+			if (DepthBucket(depthOrder) != DepthBucket(other.depthOrder)) return DepthBucket(depthOrder) < DepthBucket(other.depthOrder);
+			if (line.color != other.line.color) return line.color < other.line.color;
+			return depthOrder != other.depthOrder ? depthOrder < other.depthOrder : line < other.line;
+		}
+		bool operator==(const BatchedLine& other) const { return depthOrder == other.depthOrder && line == other.line; }
+	};
+
+	// 128ビットのキー。比較は整数2回で済む
+	struct SortKey {
+		uint64_t high;
+		uint64_t low;
+
+		bool operator<(const SortKey& other) const { return high != other.high ? high < other.high : low < other.low; }
+	};
+
+	static uint32_t KeyColor(const SortKey& key) { return uint32_t(key.high >> 16); }
+
+	static bool IsShort(int32_t value) { return value >= INT16_MIN && value <= INT16_MAX; }
+	// 符号付きの順序が符号なしの比較でも保たれるように、最上位ビットを反転して詰める
+	static uint64_t Pack(int32_t value) { return uint64_t(uint16_t(value) ^ 0x8000u); }
+	static int32_t Unpack(uint64_t value) { return int32_t(int16_t(uint16_t(value ^ 0x8000u))); }
+
+	// 座標がどれも16ビットに収まるときの並べ替え (BatchedLine で並べ替えるのと同じ結果になる)
+	// (深度のまとまり | 色 | 深度の残り, x0 | y0 | x1 | y1) のキーで並べ、
+	// 手前から見ていって、もう出てきた (色, 座標) の線分を落とす (ハッシュ表で調べるので並べ替えは1回で済む)
+	void SortByKey() {
+		static_assert(kDepthBucketBits == 16, "キーは深度のまとまりと残りを16ビットずつ持つ");
+		keys_.resize(lines_.size());
+		for (size_t i = 0; i < lines_.size(); ++i) {
+			const ScreenLine& line = lines_[i].line;
+			uint32_t depthOrder = lines_[i].depthOrder;
+			uint64_t high = uint64_t(DepthBucket(depthOrder)) << 48 | uint64_t(line.color) << 16 | (depthOrder & 0xFFFFu);
+			keys_[i] = { high, Pack(line.x0) << 48 | Pack(line.y0) << 32 | Pack(line.x1) << 16 | Pack(line.y1) };
+		}
+		std::sort(keys_.begin(), keys_.end());
+
+		// 開番地法のハッシュ表 (要素は残したキーの位置)。数の2倍以上の2のべき乗にして、探す回数を少なくする
+		size_t tableSize = 16;
+		while (tableSize < keys_.size() * 2) {
+			tableSize *= 2;
+		}
+		seen_.assign(tableSize, UINT32_MAX);
+		auto isSameLine = [](const SortKey& a, const SortKey& b) { return a.low == b.low && KeyColor(a) == KeyColor(b); };
+
+		size_t count = keys_.size();
+		for (size_t i = keys_.size(); i-- > 0;) {
+			const SortKey& key = keys_[i];
+			uint64_t hash = (key.low ^ uint64_t(KeyColor(key)) * 0x9E3779B97F4A7C15ull) * 0xBF58476D1CE4E5B9ull;
+			for (size_t slot = size_t(hash >> 32) & (tableSize - 1);; slot = (slot + 1) & (tableSize - 1)) {
+				if (seen_[slot] == UINT32_MAX) {
+					// 残すものを後ろから詰める (書く位置は i 以上で、まだ見ていないキーは上書きしない)
+					// 表には詰めた先の位置を入れる (そこは後から上書きされない)
+					keys_[--count] = key;
+					seen_[slot] = uint32_t(count);
+					break;
+				}
+				if (isSameLine(keys_[seen_[slot]], key)) {
+					break;  // もっと手前に同じ線分がある
+				}
+			}
+		}
+
+		sorted_.resize(keys_.size() - count);
+		for (size_t i = count; i < keys_.size(); ++i) {
+			const SortKey& key = keys_[i];
+			sorted_[i - count] = { Unpack(key.low >> 48), Unpack(key.low >> 32), Unpack(key.low >> 16), Unpack(key.low), KeyColor(key) };
+		}
+	}
+
+	std::vector<BatchedLine> lines_;
+	std::vector<ScreenLine> sorted_;  //!< Flush で描画側に渡す、並べ替えた後の線分
+	std::vector<SortKey> keys_;
+	std::vector<uint32_t> seen_;  //!< SortByKey で使うハッシュ表
+	bool wideCoordinates_ = false;
+	uint32_t submittedCount_ = 0;
+};
+
+//=================================================================================================
+
+
+//==================================  スレッドごとの入れ物  ========================================
+// 並列に描画関数を呼ぶときは、JobSystem のスレッドごとの LineBatch にためて、
+// 全てのジョブが終わった後で MergeInto で1つにまとめてから Flush する
+
+class ThreadLineBatches {
+public:
+	explicit ThreadLineBatches(const JobSystem& jobSystem) : jobSystem_(&jobSystem), batches_(jobSystem.GetThreadCount()) {}
+
+	// 今のスレッドの LineBatch。jobSystem のメインスレッドかワーカーから呼ぶ
+	LineBatch& Get() {
+		assert(jobSystem_->IsOwnThread());
+		return batches_[JobSystem::GetThreadIndex()];
+	}
+
+	void MergeInto(LineBatch& target) {
+		for (LineBatch& batch : batches_) {
+			target.Append(batch);
+		}
+	}
+
+private:
+	const JobSystem* jobSystem_;
+	std::vector<LineBatch> batches_;
+};
+
+//=================================================================================================
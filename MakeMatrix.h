@@ -1,22 +1,18 @@
 #pragma once
 #include "MatrixCalc.h"
+#include "VectorMatrix.h"
 #include <assert.h>
 #include <cmath>
+#include <cstdint>
 
 
 
 //=================================== 平行移動行列の作成関数 ======================================
 
-Matrix4x4 MakeTranslateMatrix(const Vector3& translate)
+// 定数を渡せばコンパイル時に計算される (中身は VectorMatrix.h のテンプレート版)
+constexpr Matrix4x4 MakeTranslateMatrix(const Vector3& translate)
 {
-	Matrix4x4 result;
-
-	result.m[0][0] = 1;             result.m[0][1] = 0;             result.m[0][2] = 0;             result.m[0][3] = 0;
-	result.m[1][0] = 0;             result.m[1][1] = 1;             result.m[1][2] = 0;             result.m[1][3] = 0;
-	result.m[2][0] = 0;             result.m[2][1] = 0;             result.m[2][2] = 1;             result.m[2][3] = 0;
-	result.m[3][0] = translate.x;   result.m[3][1] = translate.y;   result.m[3][2] = translate.z;   result.m[3][3] = 1;
-
-	return result;
+	return ToMatrix4x4(MakeTranslateMatrix(ToVec3f(translate)));
 }
 
 //=================================================================================================
@@ -24,17 +20,9 @@ Matrix4x4 MakeTranslateMatrix(const Vector3& translate)
 
 //=================================== 拡大縮小行列の作成関数 ======================================
 
-Matrix4x4 MakeScaleMatrix(const Vector3& scale)
+constexpr Matrix4x4 MakeScaleMatrix(const Vector3& scale)
 {
-	Matrix4x4 result;
-
-	result.m[0][0] = scale.x;        result.m[0][1] = 0;              result.m[0][2] = 0;            result.m[0][3] = 0;
-	result.m[1][0] = 0;              result.m[1][1] = scale.y;        result.m[1][2] = 0;            result.m[1][3] = 0;
-	result.m[2][0] = 0;              result.m[2][1] = 0;              result.m[2][2] = scale.z;      result.m[2][3] = 0;
-	result.m[3][0] = 0;              result.m[3][1] = 0;              result.m[3][2] = 0;            result.m[3][3] = 1;
-
-	return result;
-
+	return ToMatrix4x4(MakeScaleMatrix(ToVec3f(scale)));
 }
 
 //=================================================================================================
@@ -42,7 +30,7 @@ Matrix4x4 MakeScaleMatrix(const Vector3& scale)
 
 //======================================= 回転行列の作成関数 ======================================
 
-Matrix4x4 MakeRotateXMatrix(float radian)
+inline Matrix4x4 MakeRotateXMatrix(float radian)
 {
 	Matrix4x4 result;
 
@@ -56,7 +44,7 @@ Matrix4x4 MakeRotateXMatrix(float radian)
 }
 
 
-Matrix4x4 MakeRotateYMatrix(float radian)
+inline Matrix4x4 MakeRotateYMatrix(float radian)
 {
 	Matrix4x4 result;
 
@@ -70,7 +58,7 @@ Matrix4x4 MakeRotateYMatrix(float radian)
 }
 
 
-Matrix4x4 MakeRotateZMatrix(float radian)
+inline Matrix4x4 MakeRotateZMatrix(float radian)
 {
 	Matrix4x4 result;
 
@@ -88,9 +76,77 @@ Matrix4x4 MakeRotateZMatrix(float radian)
 
 //===================================== affine行列の作成関数 ======================================
 
-Matrix4x4 MakeAffineMatrix(const Vector3& scale, const Vector3& rotate, const Vector3& translate) {
-	Matrix4x4 rotateMatrix = Multiply(Multiply(MakeRotateXMatrix(rotate.x), MakeRotateYMatrix(rotate.y)), MakeRotateZMatrix(rotate.z));
-	return Multiply(Multiply(MakeScaleMatrix(scale), rotateMatrix), MakeTranslateMatrix(translate));
+// Scale * RotateX * RotateY * RotateZ * Translate を展開した式で直接作る
+// (4x4の積を使わず、sin/cosも各軸1回ずつで済む)
+inline Matrix4x4 MakeAffineMatrix(float sx, float sy, float sz, float sinX, float cosX, float sinY, float cosY, float sinZ, float cosZ,
+	float tx, float ty, float tz) {
+	Matrix4x4 result;
+
+	result.m[0][0] = sx * (cosY * cosZ);
+	result.m[0][1] = sx * (cosY * sinZ);
+	result.m[0][2] = sx * -sinY;
+	result.m[0][3] = 0;
+
+	result.m[1][0] = sy * (sinX * sinY * cosZ - cosX * sinZ);
+	result.m[1][1] = sy * (sinX * sinY * sinZ + cosX * cosZ);
+	result.m[1][2] = sy * (sinX * cosY);
+	result.m[1][3] = 0;
+
+	result.m[2][0] = sz * (cosX * sinY * cosZ + sinX * sinZ);
+	result.m[2][1] = sz * (cosX * sinY * sinZ - sinX * cosZ);
+	result.m[2][2] = sz * (cosX * cosY);
+	result.m[2][3] = 0;
+
+	result.m[3][0] = tx;
+	result.m[3][1] = ty;
+	result.m[3][2] = tz;
+	result.m[3][3] = 1;
+
+	return result;
+}
+
+inline Matrix4x4 MakeAffineMatrix(const Vector3& scale, const Vector3& rotate, const Vector3& translate) {
+	return MakeAffineMatrix(scale.x, scale.y, scale.z,
+		std::sin(rotate.x), std::cos(rotate.x), std::sin(rotate.y), std::cos(rotate.y), std::sin(rotate.z), std::cos(rotate.z),
+		translate.x, translate.y, translate.z);
+}
+
+// SRTをSoA(要素ごとの配列)で受け取る
+struct AffineSoA {
+	const float* scaleX;
+	const float* scaleY;
+	const float* scaleZ;
+	const float* rotateX;
+	const float* rotateY;
+	const float* rotateZ;
+	const float* translateX;
+	const float* translateY;
+	const float* translateZ;
+};
+
+// count個のアフィン行列をまとめて作る
+// sin/cosを先にブロック単位で計算しておき、コンパイラがベクトル化しやすい形にする
+inline void MakeAffineMatrices(const AffineSoA& srt, Matrix4x4* out, uint32_t count) {
+	const uint32_t kBlock = 64;
+	float sinX[kBlock], cosX[kBlock], sinY[kBlock], cosY[kBlock], sinZ[kBlock], cosZ[kBlock];
+
+	for (uint32_t begin = 0; begin < count; begin += kBlock) {
+		uint32_t n = (count - begin < kBlock) ? count - begin : kBlock;
+		for (uint32_t i = 0; i < n; ++i) {
+			sinX[i] = std::sin(srt.rotateX[begin + i]);
+			cosX[i] = std::cos(srt.rotateX[begin + i]);
+			sinY[i] = std::sin(srt.rotateY[begin + i]);
+			cosY[i] = std::cos(srt.rotateY[begin + i]);
+			sinZ[i] = std::sin(srt.rotateZ[begin + i]);
+			cosZ[i] = std::cos(srt.rotateZ[begin + i]);
+		}
+		for (uint32_t i = 0; i < n; ++i) {
+			uint32_t index = begin + i;
+			out[index] = MakeAffineMatrix(srt.scaleX[index], srt.scaleY[index], srt.scaleZ[index],
+				sinX[i], cosX[i], sinY[i], cosY[i], sinZ[i], cosZ[i],
+				srt.translateX[index], srt.translateY[index], srt.translateZ[index]);
+		}
+	}
 }
 
 //=================================================================================================
@@ -98,7 +154,7 @@ Matrix4x4 MakeAffineMatrix(const Vector3& scale, const Vector3& rotate, const Ve
 
 //=========================== 3次元ベクトルを同次座標として変更する ===============================
 
-Vector3 Transform(const Vector3& vector, const Matrix4x4& matrix)
+inline Vector3 Transform(const Vector3& vector, const Matrix4x4& matrix)
 {
 	Vector3 result;
 	result.x = vector.x * matrix.m[0][0] + vector.y * matrix.m[1][0] + vector.z * matrix.m[2][0] + 1.0f * matrix.m[3][0];
@@ -117,7 +173,7 @@ Vector3 Transform(const Vector3& vector, const Matrix4x4& matrix)
 
 //======================================= 転置行列の作成関数 ======================================
 
-Matrix4x4 Transpose(const Matrix4x4& m) {
+inline Matrix4x4 TransposeScalar(const Matrix4x4& m) {
 	Matrix4x4 result = {};
 	for (int i = 0; i < 4; i++) {
 		for (int j = 0; j < 4; j++) {
@@ -128,34 +184,71 @@ Matrix4x4 Transpose(const Matrix4x4& m) {
 	return result;
 }
 
-//=================================================================================================
-
+#if MT3_SIMD_X86
+SIMD_TARGET_SSE41
+inline Matrix4x4 TransposeSSE(const Matrix4x4& m) {
+	__m128 row0 = _mm_loadu_ps(m.m[0]);
+	__m128 row1 = _mm_loadu_ps(m.m[1]);
+	__m128 row2 = _mm_loadu_ps(m.m[2]);
+	__m128 row3 = _mm_loadu_ps(m.m[3]);
+	_MM_TRANSPOSE4_PS(row0, row1, row2, row3);
 
-//======================================= 単位行列の作成関数 ======================================
+	Matrix4x4 result;
+	_mm_storeu_ps(result.m[0], row0);
+	_mm_storeu_ps(result.m[1], row1);
+	_mm_storeu_ps(result.m[2], row2);
+	_mm_storeu_ps(result.m[3], row3);
+	return result;
+}
 
-Matrix4x4 MakeIdentity4x4() {
-	Matrix4x4 result = {};
-	for (int i = 0; i < 4; i++) {
-		result.m[i][i] = 1;
-	}
+// 2行ずつ読み込み、128bitレーン内のunpackとレーン入れ替えで転置する
+SIMD_TARGET_AVX2
+inline Matrix4x4 TransposeAVX2(const Matrix4x4& m) {
+	__m256 row01 = _mm256_loadu_ps(m.m[0]);
+	__m256 row23 = _mm256_loadu_ps(m.m[2]);
+	__m256 low = _mm256_unpacklo_ps(row01, row23);   // (m00 m20 m01 m21 | m10 m30 m11 m31)
+	__m256 high = _mm256_unpackhi_ps(row01, row23);  // (m02 m22 m03 m23 | m12 m32 m13 m33)
+	__m256 a = _mm256_permute2f128_ps(low, high, 0x20);  // (m00 m20 m01 m21 | m02 m22 m03 m23)
+	__m256 b = _mm256_permute2f128_ps(low, high, 0x31);  // (m10 m30 m11 m31 | m12 m32 m13 m33)
+	__m256 col02 = _mm256_unpacklo_ps(a, b);  // (0列目 | 2列目)
+	__m256 col13 = _mm256_unpackhi_ps(a, b);  // (1列目 | 3列目)
 
+	Matrix4x4 result;
+	_mm256_storeu_ps(result.m[0], _mm256_permute2f128_ps(col02, col13, 0x20));
+	_mm256_storeu_ps(result.m[2], _mm256_permute2f128_ps(col02, col13, 0x31));
 	return result;
 }
+#endif
+
+inline Matrix4x4 Transpose(const Matrix4x4& m) {
+	switch (GetSimdLevel()) {
+#if MT3_SIMD_X86
+	case SimdLevel::AVX2:
+		return TransposeAVX2(m);
+	case SimdLevel::SSE41:
+		return TransposeSSE(m);
+#endif
+	default:
+		return TransposeScalar(m);
+	}
+}
 
 //=================================================================================================
 
 
-//====================================== 正射影行列の作成関数 =====================================
+//======================================= 単位行列の作成関数 ======================================
 
-Matrix4x4 MakeOrthographicMatrix(float left, float top, float right, float bottom, float nearClip, float farClip) {
-	Matrix4x4 result;
+constexpr Matrix4x4 MakeIdentity4x4() {
+	return ToMatrix4x4(MakeIdentity<4, float>());
+}
+
+//=================================================================================================
 
-	result.m[0][0] = 2 / (right - left);                  result.m[0][1] = 0;                                    result.m[0][2] = 0;                                   result.m[0][3] = 0;
-	result.m[1][0] = 0;                                   result.m[1][1] = 2 / (top - bottom);                   result.m[1][2] = 0;                                   result.m[1][3] = 0;
-	result.m[2][0] = 0;                                   result.m[2][1] = 0;                                    result.m[2][2] = 1 / (farClip - nearClip);            result.m[2][3] = 0;
-	result.m[3][0] = (left + right) / (left - right);     result.m[3][1] = (top + bottom) / (bottom - top);     result.m[3][2] = nearClip / (nearClip - farClip);     result.m[3][3] = 1;
 
-	return result;
+//====================================== 正射影行列の作成関数 =====================================
+
+constexpr Matrix4x4 MakeOrthographicMatrix(float left, float top, float right, float bottom, float nearClip, float farClip) {
+	return ToMatrix4x4(MakeOrthographicMatrix<float>(left, top, right, bottom, nearClip, farClip));
 }
 
 //=================================================================================================
@@ -163,29 +256,65 @@ Matrix4x4 MakeOrthographicMatrix(float left, float top, float right, float botto
 
 //===================================== 透視投影行列の作成関数 ====================================
 
-Matrix4x4 MakePerspectiveFovMatrix(float fovY, float aspectRatio, float nearClip, float farClip) {
-	Matrix4x4 result;
-	result.m[0][0] = 1 / aspectRatio * (1 / std::tan(fovY / 2));   result.m[0][1] = 0;                        result.m[0][2] = 0;                                                               result.m[0][3] = 0;
-	result.m[1][0] = 0;                                            result.m[1][1] = 1 / std::tan(fovY / 2);   result.m[1][2] = 0;                                                               result.m[1][3] = 0;
-	result.m[2][0] = 0;                                            result.m[2][1] = 0;                        result.m[2][2] = farClip / (farClip - nearClip);                                  result.m[2][3] = 1;
-	result.m[3][0] = 0;                                            result.m[3][1] = 0;                        result.m[3][2] = (-nearClip * farClip * std::cos(0.0f)) / (farClip - nearClip);   result.m[3][3] = 0;
+// 深度 (z/w) の向き
+// kDepthStandard: ニアクリップ面が 0、ファークリップ面が 1 (深度テストは LESS、クリアは 1)
+// kDepthReverseZ: ニアクリップ面が 1、ファークリップ面が 0 (深度テストは GREATER、クリアは 0)
+// float は 0 の近くほど細かいので、遠くほど深度が 0 に近づく ReverseZ のほうが遠くの深度の差が残る
+// どちらも MakeViewportMatrix(..., 0.0f, 1.0f) でそのまま 0 ～ 1 の深度になる
+enum DepthMode {
+	kDepthStandard,
+	kDepthReverseZ,
+};
+
+// a のほうが b よりカメラに近い深度なら true
+inline bool IsDepthCloser(float a, float b, DepthMode depthMode) {
+	return depthMode == kDepthStandard ? a < b : a > b;
+}
+
+// 深度バッファをクリアする値 (一番遠い深度)
+inline float DepthClearValue(DepthMode depthMode) {
+	return depthMode == kDepthStandard ? 1.0f : 0.0f;
+}
 
+// 透視投影の x, y は共通で、深度は z * depthScale + depthOffset を w (= z) で割った値になる
+inline Matrix4x4 MakePerspectiveMatrix(float fovY, float aspectRatio, float depthScale, float depthOffset) {
+	float cot = 1 / std::tan(fovY / 2);
+	Matrix4x4 result;
+	result.m[0][0] = 1 / aspectRatio * cot;   result.m[0][1] = 0;     result.m[0][2] = 0;             result.m[0][3] = 0;
+	result.m[1][0] = 0;                       result.m[1][1] = cot;   result.m[1][2] = 0;             result.m[1][3] = 0;
+	result.m[2][0] = 0;                       result.m[2][1] = 0;     result.m[2][2] = depthScale;    result.m[2][3] = 1;
+	result.m[3][0] = 0;                       result.m[3][1] = 0;     result.m[3][2] = depthOffset;   result.m[3][3] = 0;
 	return result;
 }
 
+// 深度はニアクリップ面で 0、ファークリップ面で 1
+inline Matrix4x4 MakePerspectiveFovMatrix(float fovY, float aspectRatio, float nearClip, float farClip) {
+	return MakePerspectiveMatrix(fovY, aspectRatio, farClip / (farClip - nearClip), -nearClip * farClip / (farClip - nearClip));
+}
+
+// 深度はニアクリップ面で 1、ファークリップ面で 0 (kDepthReverseZ)
+inline Matrix4x4 MakePerspectiveFovMatrixReverseZ(float fovY, float aspectRatio, float nearClip, float farClip) {
+	return MakePerspectiveMatrix(fovY, aspectRatio, -nearClip / (farClip - nearClip), nearClip * farClip / (farClip - nearClip));
+}
+
+// ファークリップ面を無限遠にしたもの (farClip → ∞ の極限)。深度はニアクリップ面で 0、無限遠で 1
+inline Matrix4x4 MakePerspectiveFovMatrixInfinite(float fovY, float aspectRatio, float nearClip) {
+	return MakePerspectiveMatrix(fovY, aspectRatio, 1.0f, -nearClip);
+}
+
+// ReverseZ でファークリップ面を無限遠にしたもの。深度は nearClip / z (ニアクリップ面で 1、無限遠で 0)
+// 深度の計算に引き算がなく、遠くまで float の精度が一番よく残る
+inline Matrix4x4 MakePerspectiveFovMatrixReverseZInfinite(float fovY, float aspectRatio, float nearClip) {
+	return MakePerspectiveMatrix(fovY, aspectRatio, 0.0f, nearClip);
+}
+
 //=================================================================================================
 
 
 //================================= ビューポート変換行列の作成関数 ================================
 
-Matrix4x4 MakeViewportMatrix(float left, float top, float width, float height, float minDepth, float maxDepth) {
-	Matrix4x4 result;
-    result.m[0][0] = width / 2;            result.m[0][1] = 0;                    result.m[0][2] = 0;                       result.m[0][3] = 0;
-	result.m[1][0] = 0;                    result.m[1][1] = -height / 2;          result.m[1][2] = 0;                       result.m[1][3] = 0;
-	result.m[2][0] = 0;                    result.m[2][1] = 0;                    result.m[2][2] = maxDepth - minDepth;     result.m[2][3] = 0;
-	result.m[3][0] = left + width / 2;     result.m[3][1] = top + height / 2;     result.m[3][2] = minDepth;                result.m[3][3] = 1;
-
-	return result;
+constexpr Matrix4x4 MakeViewportMatrix(float left, float top, float width, float height, float minDepth, float maxDepth) {
+	return ToMatrix4x4(MakeViewportMatrix<float>(left, top, width, height, minDepth, maxDepth));
 }
 
 //=================================================================================================
\ No newline at end of file
@@ -1,11 +1,13 @@
 #pragma once
 #include "Vector3.h"
 #include "Matrix4x4.h"
+#include "SimdConfig.h"
+#include <assert.h>
 
 
 
 //行列の加法
-Matrix4x4 Add(const Matrix4x4& m1, const Matrix4x4& m2) {
+inline Matrix4x4 Add(const Matrix4x4& m1, const Matrix4x4& m2) {
 	Matrix4x4 result = {};
 	for (int i = 0; i < 4; i++) {
 		for (int j = 0; j < 4; j++) {
@@ -16,7 +18,7 @@ Matrix4x4 Add(const Matrix4x4& m1, const Matrix4x4& m2) {
 }
 
 //行列の減法
-Matrix4x4 Subtract(const Matrix4x4& m1, const Matrix4x4& m2) {
+inline Matrix4x4 Subtract(const Matrix4x4& m1, const Matrix4x4& m2) {
 	Matrix4x4 result = {};
 	for (int i = 0; i < 4; i++) {
 		for (int j = 0; j < 4; j++) {
@@ -26,56 +28,270 @@ Matrix4x4 Subtract(const Matrix4x4& m1, const Matrix4x4& m2) {
 	return result;
 }
 
-//行列の積
-Matrix4x4 Multiply(const Matrix4x4& matrix1, const Matrix4x4& matrix2) {
-	Matrix4x4 result = {};
+//行列の積 (スカラー版)
+// SIMD版と同じ順番で足し合わせるので、結果はビット単位で一致する
+inline Matrix4x4 MultiplyScalar(const Matrix4x4& matrix1, const Matrix4x4& matrix2) {
+	Matrix4x4 result;
 	for (int i = 0; i < 4; i++) {
 		for (int j = 0; j < 4; j++) {
-			for (int k = 0; k < 4; k++) {
-				result.m[i][j] += matrix1.m[i][k] * matrix2.m[k][j];
-			}
+			result.m[i][j] = matrix1.m[i][0] * matrix2.m[0][j] + matrix1.m[i][1] * matrix2.m[1][j]
+				+ matrix1.m[i][2] * matrix2.m[2][j] + matrix1.m[i][3] * matrix2.m[3][j];
 		}
 	}
 	return result;
 }
 
+#if MT3_SIMD_X86
+//行列の積 (SSE4.1版) 1行ずつ、matrix2の各行をmatrix1の要素倍して足す
+SIMD_TARGET_SSE41
+inline Matrix4x4 MultiplySSE(const Matrix4x4& matrix1, const Matrix4x4& matrix2) {
+	const __m128 b0 = _mm_loadu_ps(matrix2.m[0]);
+	const __m128 b1 = _mm_loadu_ps(matrix2.m[1]);
+	const __m128 b2 = _mm_loadu_ps(matrix2.m[2]);
+	const __m128 b3 = _mm_loadu_ps(matrix2.m[3]);
+	Matrix4x4 result;
+	for (int i = 0; i < 4; i++) {
+		__m128 row = _mm_mul_ps(_mm_set1_ps(matrix1.m[i][0]), b0);
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(matrix1.m[i][1]), b1));
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(matrix1.m[i][2]), b2));
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(matrix1.m[i][3]), b3));
+		_mm_storeu_ps(result.m[i], row);
+	}
+	return result;
+}
+
+//行列の積 (AVX2版) 2行ずつ計算する
+SIMD_TARGET_AVX2
+inline Matrix4x4 MultiplyAVX2(const Matrix4x4& matrix1, const Matrix4x4& matrix2) {
+	const __m256 b0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(matrix2.m[0]));
+	const __m256 b1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(matrix2.m[1]));
+	const __m256 b2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(matrix2.m[2]));
+	const __m256 b3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(matrix2.m[3]));
+	Matrix4x4 result;
+	for (int i = 0; i < 4; i += 2) {
+		// (i行目 | i+1行目)
+		__m256 a = _mm256_loadu_ps(matrix1.m[i]);
+		__m256 row = _mm256_mul_ps(_mm256_permute_ps(a, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+		row = _mm256_add_ps(row, _mm256_mul_ps(_mm256_permute_ps(a, _MM_SHUFFLE(1, 1, 1, 1)), b1));
+		row = _mm256_add_ps(row, _mm256_mul_ps(_mm256_permute_ps(a, _MM_SHUFFLE(2, 2, 2, 2)), b2));
+		row = _mm256_add_ps(row, _mm256_mul_ps(_mm256_permute_ps(a, _MM_SHUFFLE(3, 3, 3, 3)), b3));
+		_mm256_storeu_ps(result.m[i], row);
+	}
+	return result;
+}
+#endif
+
+//行列の積
+inline Matrix4x4 Multiply(const Matrix4x4& matrix1, const Matrix4x4& matrix2) {
+	switch (GetSimdLevel()) {
+#if MT3_SIMD_X86
+	case SimdLevel::AVX2:
+		return MultiplyAVX2(matrix1, matrix2);
+	case SimdLevel::SSE41:
+		return MultiplySSE(matrix1, matrix2);
+#endif
+	default:
+		return MultiplyScalar(matrix1, matrix2);
+	}
+}
+
+//逆行列で使う2x2の小行列式
+// s は上2行、c は下2行から作る
+struct InverseMinors {
+	float s[6];
+	float c[6];
+	float invDet;  //!< 1 / 行列式
+};
+
+inline InverseMinors ComputeInverseMinors(const Matrix4x4& m) {
+	InverseMinors result;
+	result.s[0] = m.m[0][0] * m.m[1][1] - m.m[1][0] * m.m[0][1];
+	result.s[1] = m.m[0][0] * m.m[1][2] - m.m[1][0] * m.m[0][2];
+	result.s[2] = m.m[0][0] * m.m[1][3] - m.m[1][0] * m.m[0][3];
+	result.s[3] = m.m[0][1] * m.m[1][2] - m.m[1][1] * m.m[0][2];
+	result.s[4] = m.m[0][1] * m.m[1][3] - m.m[1][1] * m.m[0][3];
+	result.s[5] = m.m[0][2] * m.m[1][3] - m.m[1][2] * m.m[0][3];
+
+	result.c[0] = m.m[2][0] * m.m[3][1] - m.m[3][0] * m.m[2][1];
+	result.c[1] = m.m[2][0] * m.m[3][2] - m.m[3][0] * m.m[2][2];
+	result.c[2] = m.m[2][0] * m.m[3][3] - m.m[3][0] * m.m[2][3];
+	result.c[3] = m.m[2][1] * m.m[3][2] - m.m[3][1] * m.m[2][2];
+	result.c[4] = m.m[2][1] * m.m[3][3] - m.m[3][1] * m.m[2][3];
+	result.c[5] = m.m[2][2] * m.m[3][3] - m.m[3][2] * m.m[2][3];
+
+	float det = result.s[0] * result.c[5] - result.s[1] * result.c[4] + result.s[2] * result.c[3]
+		+ result.s[3] * result.c[2] - result.s[4] * result.c[1] + result.s[5] * result.c[0];
+	result.invDet = 1.0f / det;
+	return result;
+}
+
+//逆行列 (スカラー版)
+// 余因子を2x2の小行列式から組み立て、1/行列式は1回だけ求める
+// 各行は (a*b - c*d + e*f) の形を符号 (+,-,+,-) または (-,+,-,+) で反転したもので、SIMD版と同じ順番で計算する
+inline Matrix4x4 InverseScalar(const Matrix4x4& m) {
+	InverseMinors minors = ComputeInverseMinors(m);
+	const float* s = minors.s;
+	const float* c = minors.c;
+	// col[j] = (m[1][j], m[0][j], m[3][j], m[2][j])
+	const int rowOrder[4] = { 1, 0, 3, 2 };
+
+	Matrix4x4 result;
+	for (int j = 0; j < 4; j++) {
+		int r = rowOrder[j];
+		// 左2列は下2行の小行列式 c、右2列は上2行の小行列式 s を使う
+		const float* k = (j < 2) ? c : s;
+		float t0 = (m.m[r][1] * k[5] - m.m[r][2] * k[4]) + m.m[r][3] * k[3];
+		float t1 = (m.m[r][0] * k[5] - m.m[r][2] * k[2]) + m.m[r][3] * k[1];
+		float t2 = (m.m[r][0] * k[4] - m.m[r][1] * k[2]) + m.m[r][3] * k[0];
+		float t3 = (m.m[r][0] * k[3] - m.m[r][1] * k[1]) + m.m[r][2] * k[0];
+		bool negate = (j % 2) == 1;
+		result.m[0][j] = (negate ? -t0 : t0) * minors.invDet;
+		result.m[1][j] = (negate ? t1 : -t1) * minors.invDet;
+		result.m[2][j] = (negate ? -t2 : t2) * minors.invDet;
+		result.m[3][j] = (negate ? t3 : -t3) * minors.invDet;
+	}
+	return result;
+}
+
+#if MT3_SIMD_X86
+//逆行列 (SSE4.1版) 結果の1行を4レーンで計算する
+SIMD_TARGET_SSE41
+inline Matrix4x4 InverseSSE(const Matrix4x4& m) {
+	InverseMinors minors = ComputeInverseMinors(m);
+
+	// 転置して (m[1][j], m[0][j], m[3][j], m[2][j]) に並べ替える
+	__m128 t0 = _mm_loadu_ps(m.m[0]);
+	__m128 t1 = _mm_loadu_ps(m.m[1]);
+	__m128 t2 = _mm_loadu_ps(m.m[2]);
+	__m128 t3 = _mm_loadu_ps(m.m[3]);
+	_MM_TRANSPOSE4_PS(t0, t1, t2, t3);
+	__m128 col0 = _mm_shuffle_ps(t0, t0, _MM_SHUFFLE(2, 3, 0, 1));
+	__m128 col1 = _mm_shuffle_ps(t1, t1, _MM_SHUFFLE(2, 3, 0, 1));
+	__m128 col2 = _mm_shuffle_ps(t2, t2, _MM_SHUFFLE(2, 3, 0, 1));
+	__m128 col3 = _mm_shuffle_ps(t3, t3, _MM_SHUFFLE(2, 3, 0, 1));
+
+	// k[n] = (c[n], c[n], s[n], s[n])
+	__m128 k[6];
+	for (int n = 0; n < 6; n++) {
+		k[n] = _mm_blend_ps(_mm_set1_ps(minors.c[n]), _mm_set1_ps(minors.s[n]), 0xC);
+	}
+
+	const __m128 signEven = _mm_castsi128_ps(_mm_setr_epi32(0, int(0x80000000), 0, int(0x80000000)));
+	const __m128 signOdd = _mm_castsi128_ps(_mm_setr_epi32(int(0x80000000), 0, int(0x80000000), 0));
+	const __m128 invDet = _mm_set1_ps(minors.invDet);
+
+	__m128 row0 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(col1, k[5]), _mm_mul_ps(col2, k[4])), _mm_mul_ps(col3, k[3]));
+	__m128 row1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(col0, k[5]), _mm_mul_ps(col2, k[2])), _mm_mul_ps(col3, k[1]));
+	__m128 row2 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(col0, k[4]), _mm_mul_ps(col1, k[2])), _mm_mul_ps(col3, k[0]));
+	__m128 row3 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(col0, k[3]), _mm_mul_ps(col1, k[1])), _mm_mul_ps(col2, k[0]));
+
+	Matrix4x4 result;
+	_mm_storeu_ps(result.m[0], _mm_mul_ps(_mm_xor_ps(row0, signEven), invDet));
+	_mm_storeu_ps(result.m[1], _mm_mul_ps(_mm_xor_ps(row1, signOdd), invDet));
+	_mm_storeu_ps(result.m[2], _mm_mul_ps(_mm_xor_ps(row2, signEven), invDet));
+	_mm_storeu_ps(result.m[3], _mm_mul_ps(_mm_xor_ps(row3, signOdd), invDet));
+	return result;
+}
+
+// (下位128bit | 上位128bit) を作る
+SIMD_TARGET_AVX2
+inline __m256 CombineHalves(__m128 low, __m128 high) {
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(low), high, 1);
+}
+
+//逆行列 (AVX2版) 結果の2行を8レーンで計算する
+SIMD_TARGET_AVX2
+inline Matrix4x4 InverseAVX2(const Matrix4x4& m) {
+	InverseMinors minors = ComputeInverseMinors(m);
+
+	__m128 t0 = _mm_loadu_ps(m.m[0]);
+	__m128 t1 = _mm_loadu_ps(m.m[1]);
+	__m128 t2 = _mm_loadu_ps(m.m[2]);
+	__m128 t3 = _mm_loadu_ps(m.m[3]);
+	_MM_TRANSPOSE4_PS(t0, t1, t2, t3);
+	__m128 col[4] = {
+		_mm_shuffle_ps(t0, t0, _MM_SHUFFLE(2, 3, 0, 1)),
+		_mm_shuffle_ps(t1, t1, _MM_SHUFFLE(2, 3, 0, 1)),
+		_mm_shuffle_ps(t2, t2, _MM_SHUFFLE(2, 3, 0, 1)),
+		_mm_shuffle_ps(t3, t3, _MM_SHUFFLE(2, 3, 0, 1)),
+	};
+	__m128 k[6];
+	for (int n = 0; n < 6; n++) {
+		k[n] = _mm_blend_ps(_mm_set1_ps(minors.c[n]), _mm_set1_ps(minors.s[n]), 0xC);
+	}
+	const __m256 sign = _mm256_castsi256_ps(_mm256_setr_epi32(0, int(0x80000000), 0, int(0x80000000), int(0x80000000), 0, int(0x80000000), 0));
+	const __m256 invDet = _mm256_set1_ps(minors.invDet);
+
+	// 0行目と1行目
+	__m256 row01 = _mm256_add_ps(_mm256_sub_ps(
+		_mm256_mul_ps(CombineHalves(col[1], col[0]), CombineHalves(k[5], k[5])),
+		_mm256_mul_ps(CombineHalves(col[2], col[2]), CombineHalves(k[4], k[2]))),
+		_mm256_mul_ps(CombineHalves(col[3], col[3]), CombineHalves(k[3], k[1])));
+	// 2行目と3行目
+	__m256 row23 = _mm256_add_ps(_mm256_sub_ps(
+		_mm256_mul_ps(CombineHalves(col[0], col[0]), CombineHalves(k[4], k[3])),
+		_mm256_mul_ps(CombineHalves(col[1], col[1]), CombineHalves(k[2], k[1]))),
+		_mm256_mul_ps(CombineHalves(col[3], col[2]), CombineHalves(k[0], k[0])));
+
+	Matrix4x4 result;
+	_mm256_storeu_ps(result.m[0], _mm256_mul_ps(_mm256_xor_ps(row01, sign), invDet));
+	_mm256_storeu_ps(result.m[2], _mm256_mul_ps(_mm256_xor_ps(row23, sign), invDet));
+	return result;
+}
+#endif
+
 //逆行列
-Matrix4x4 Inverse(const Matrix4x4& m) {
-	float A = m.m[0][0] * m.m[1][1] * m.m[2][2] * m.m[3][3] + m.m[0][0] * m.m[1][2] * m.m[2][3] * m.m[3][1] + m.m[0][0] * m.m[1][3] * m.m[2][1] * m.m[3][2]
-		- m.m[0][0] * m.m[1][3] * m.m[2][2] * m.m[3][1] - m.m[0][0] * m.m[1][2] * m.m[2][1] * m.m[3][3] - m.m[0][0] * m.m[1][1] * m.m[2][3] * m.m[3][2]
-		- m.m[0][1] * m.m[1][0] * m.m[2][2] * m.m[3][3] - m.m[0][2] * m.m[1][0] * m.m[2][3] * m.m[3][1] - m.m[0][3] * m.m[1][0] * m.m[2][1] * m.m[3][2]
-		+ m.m[0][3] * m.m[1][0] * m.m[2][2] * m.m[3][1] + m.m[0][2] * m.m[1][0] * m.m[2][1] * m.m[3][3] + m.m[0][1] * m.m[1][0] * m.m[2][3] * m.m[3][2]
-		+ m.m[0][1] * m.m[1][2] * m.m[2][0] * m.m[3][3] + m.m[0][2] * m.m[1][3] * m.m[2][0] * m.m[3][1] + m.m[0][3] * m.m[1][1] * m.m[2][0] * m.m[3][2]
-		- m.m[0][3] * m.m[1][2] * m.m[2][0] * m.m[3][1] - m.m[0][2] * m.m[1][1] * m.m[2][0] * m.m[3][3] - m.m[0][1] * m.m[1][3] * m.m[2][0] * m.m[3][2]
-		- m.m[0][1] * m.m[1][2] * m.m[2][3] * m.m[3][0] - m.m[0][2] * m.m[1][3] * m.m[2][1] * m.m[3][0] - m.m[0][3] * m.m[1][1] * m.m[2][2] * m.m[3][0]
-		+ m.m[0][3] * m.m[1][2] * m.m[2][1] * m.m[3][0] + m.m[0][2] * m.m[1][1] * m.m[2][3] * m.m[3][0] + m.m[0][1] * m.m[1][3] * m.m[2][2] * m.m[3][0];
+inline Matrix4x4 Inverse(const Matrix4x4& m) {
+	switch (GetSimdLevel()) {
+#if MT3_SIMD_X86
+	case SimdLevel::AVX2:
+		return InverseAVX2(m);
+	case SimdLevel::SSE41:
+		return InverseSSE(m);
+#endif
+	default:
+		return InverseScalar(m);
+	}
+}
 
-	Matrix4x4 result = {};
-	result.m[0][0] = 1 / A * (m.m[1][1] * m.m[2][2] * m.m[3][3] + m.m[1][2] * m.m[2][3] * m.m[3][1] + m.m[1][3] * m.m[2][1] * m.m[3][2] - m.m[1][3] * m.m[2][2] * m.m[3][1] - m.m[1][2] * m.m[2][1] * m.m[3][3] - m.m[1][1] * m.m[2][3] * m.m[3][2]);
-	result.m[0][1] = 1 / A * (-m.m[0][1] * m.m[2][2] * m.m[3][3] - m.m[0][2] * m.m[2][3] * m.m[3][1] - m.m[0][3] * m.m[2][1] * m.m[3][2] + m.m[0][3] * m.m[2][2] * m.m[3][1] + m.m[0][2] * m.m[2][1] * m.m[3][3] + m.m[0][1] * m.m[2][3] * m.m[3][2]);
-	result.m[0][2] = 1 / A * (m.m[0][1] * m.m[1][2] * m.m[3][3] + m.m[0][2] * m.m[1][3] * m.m[3][1] + m.m[0][3] * m.m[1][1] * m.m[3][2] - m.m[0][3] * m.m[1][2] * m.m[3][1] - m.m[0][2] * m.m[1][1] * m.m[3][3] - m.m[0][1] * m.m[1][3] * m.m[3][2]);
-	result.m[0][3] = 1 / A * (-m.m[0][1] * m.m[1][2] * m.m[2][3] - m.m[0][2] * m.m[1][3] * m.m[2][1] - m.m[0][3] * m.m[1][1] * m.m[2][2] + m.m[0][3] * m.m[1][2] * m.m[2][1] + m.m[0][2] * m.m[1][1] * m.m[2][3] + m.m[0][1] * m.m[1][3] * m.m[2][2]);
-
-	result.m[1][0] = 1 / A * (-m.m[1][0] * m.m[2][2] * m.m[3][3] - m.m[1][2] * m.m[2][3] * m.m[3][0] - m.m[1][3] * m.m[2][0] * m.m[3][2] + m.m[1][3] * m.m[2][2] * m.m[3][0] + m.m[1][2] * m.m[2][0] * m.m[3][3] + m.m[1][0] * m.m[2][3] * m.m[3][2]);
-	result.m[1][1] = 1 / A * (m.m[0][0] * m.m[2][2] * m.m[3][3] + m.m[0][2] * m.m[2][3] * m.m[3][0] + m.m[0][3] * m.m[2][0] * m.m[3][2] - m.m[0][3] * m.m[2][2] * m.m[3][0] - m.m[0][2] * m.m[2][0] * m.m[3][3] - m.m[0][0] * m.m[2][3] * m.m[3][2]);
-	result.m[1][2] = 1 / A * (-m.m[0][0] * m.m[1][2] * m.m[3][3] - m.m[0][2] * m.m[1][3] * m.m[3][0] - m.m[0][3] * m.m[1][0] * m.m[3][2] + m.m[0][3] * m.m[1][2] * m.m[3][0] + m.m[0][2] * m.m[1][0] * m.m[3][3] + m.m[0][0] * m.m[1][3] * m.m[3][2]);
-	result.m[1][3] = 1 / A * (m.m[0][0] * m.m[1][2] * m.m[2][3] + m.m[0][2] * m.m[1][3] * m.m[2][0] + m.m[0][3] * m.m[1][0] * m.m[2][2] - m.m[0][3] * m.m[1][2] * m.m[2][0] - m.m[0][2] * m.m[1][0] * m.m[2][3] - m.m[0][0] * m.m[1][3] * m.m[2][2]);
-
-	result.m[2][0] = 1 / A * (m.m[1][0] * m.m[2][1] * m.m[3][3] + m.m[1][1] * m.m[2][3] * m.m[3][0] + m.m[1][3] * m.m[2][0] * m.m[3][1] - m.m[1][3] * m.m[2][1] * m.m[3][0] - m.m[1][1] * m.m[2][0] * m.m[3][3] - m.m[1][0] * m.m[2][3] * m.m[3][1]);
-	result.m[2][1] = 1 / A * (-m.m[0][0] * m.m[2][1] * m.m[3][3] - m.m[0][1] * m.m[2][3] * m.m[3][0] - m.m[0][3] * m.m[2][0] * m.m[3][1] + m.m[0][3] * m.m[2][1] * m.m[3][0] + m.m[0][1] * m.m[2][0] * m.m[3][3] + m.m[0][0] * m.m[2][3] * m.m[3][1]);
-	result.m[2][2] = 1 / A * (m.m[0][0] * m.m[1][1] * m.m[3][3] + m.m[0][1] * m.m[1][3] * m.m[3][0] + m.m[0][3] * m.m[1][0] * m.m[3][1] - m.m[0][3] * m.m[1][1] * m.m[3][0] - m.m[0][1] * m.m[1][0] * m.m[3][3] - m.m[0][0] * m.m[1][3] * m.m[3][1]);
-	result.m[2][3] = 1 / A * (-m.m[0][0] * m.m[1][1] * m.m[2][3] - m.m[0][1] * m.m[1][3] * m.m[2][0] - m.m[0][3] * m.m[1][0] * m.m[2][1] + m.m[0][3] * m.m[1][1] * m.m[2][0] + m.m[0][1] * m.m[1][0] * m.m[2][3] + m.m[0][0] * m.m[1][3] * m.m[2][1]);
-
-	result.m[3][0] = 1 / A * (-m.m[1][0] * m.m[2][1] * m.m[3][2] - m.m[1][1] * m.m[2][2] * m.m[3][0] - m.m[1][2] * m.m[2][0] * m.m[3][1] + m.m[1][2] * m.m[2][1] * m.m[3][0] + m.m[1][1] * m.m[2][0] * m.m[3][2] + m.m[1][0] * m.m[2][2] * m.m[3][1]);
-	result.m[3][1] = 1 / A * (m.m[0][0] * m.m[2][1] * m.m[3][2] + m.m[0][1] * m.m[2][2] * m.m[3][0] + m.m[0][2] * m.m[2][0] * m.m[3][1] - m.m[0][2] * m.m[2][1] * m.m[3][0] - m.m[0][1] * m.m[2][0] * m.m[3][2] - m.m[0][0] * m.m[2][2] * m.m[3][1]);
-	result.m[3][2] = 1 / A * (-m.m[0][0] * m.m[1][1] * m.m[3][2] - m.m[0][1] * m.m[1][2] * m.m[3][0] - m.m[0][2] * m.m[1][0] * m.m[3][1] + m.m[0][2] * m.m[1][1] * m.m[3][0] + m.m[0][1] * m.m[1][0] * m.m[3][2] + m.m[0][0] * m.m[1][2] * m.m[3][1]);
-	result.m[3][3] = 1 / A * (m.m[0][0] * m.m[1][1] * m.m[2][2] + m.m[0][1] * m.m[1][2] * m.m[2][0] + m.m[0][2] * m.m[1][0] * m.m[2][1] - m.m[0][2] * m.m[1][1] * m.m[2][0] - m.m[0][1] * m.m[1][0] * m.m[2][2] - m.m[0][0] * m.m[1][2] * m.m[2][1]);
+//アフィン行列の逆行列
+// 最後の列が(0,0,0,1)の行列(MakeAffineMatrixで作ったカメラ行列など)専用
+// 左上3x3の逆行列 R⁻¹ と、平行移動 -t·R⁻¹ だけを求める
+inline Matrix4x4 InverseAffine(const Matrix4x4& m) {
+	assert(m.m[0][3] == 0.0f && m.m[1][3] == 0.0f && m.m[2][3] == 0.0f && m.m[3][3] == 1.0f);
 
+	// 3x3の余因子
+	float c00 = m.m[1][1] * m.m[2][2] - m.m[1][2] * m.m[2][1];
+	float c01 = m.m[1][2] * m.m[2][0] - m.m[1][0] * m.m[2][2];
+	float c02 = m.m[1][0] * m.m[2][1] - m.m[1][1] * m.m[2][0];
+	float invDet = 1.0f / (m.m[0][0] * c00 + m.m[0][1] * c01 + m.m[0][2] * c02);
+
+	Matrix4x4 result;
+	result.m[0][0] = c00 * invDet;
+	result.m[0][1] = (m.m[0][2] * m.m[2][1] - m.m[0][1] * m.m[2][2]) * invDet;
+	result.m[0][2] = (m.m[0][1] * m.m[1][2] - m.m[0][2] * m.m[1][1]) * invDet;
+	result.m[1][0] = c01 * invDet;
+	result.m[1][1] = (m.m[0][0] * m.m[2][2] - m.m[0][2] * m.m[2][0]) * invDet;
+	result.m[1][2] = (m.m[0][2] * m.m[1][0] - m.m[0][0] * m.m[1][2]) * invDet;
+	result.m[2][0] = c02 * invDet;
+	result.m[2][1] = (m.m[0][1] * m.m[2][0] - m.m[0][0] * m.m[2][1]) * invDet;
+	result.m[2][2] = (m.m[0][0] * m.m[1][1] - m.m[0][1] * m.m[1][0]) * invDet;
+
+	const float tx = m.m[3][0];
+	const float ty = m.m[3][1];
+	const float tz = m.m[3][2];
+	for (int j = 0; j < 3; j++) {
+		result.m[3][j] = -(tx * result.m[0][j] + ty * result.m[1][j] + tz * result.m[2][j]);
+	}
+	result.m[0][3] = 0.0f;
+	result.m[1][3] = 0.0f;
+	result.m[2][3] = 0.0f;
+	result.m[3][3] = 1.0f;
 	return result;
 }
 
 // クロス積
-Vector3 Cross(Vector3 v1, Vector3 v2) {
+inline Vector3 Cross(Vector3 v1, Vector3 v2) {
 	Vector3 result;
 	result = { v1.y * v2.z - v1.z * v2.y, v1.z * v2.x - v1.x * v2.z, v1.x * v2.y - v1.y * v2.x };
 	return result;
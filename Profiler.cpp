@@ -0,0 +1,185 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <cstdio>
+
+//====================================  作成・バッファ  ============================================
+
+Profiler::Profiler() : startTimestamp_(ReadProfileTimestamp()), startTime_(std::chrono::steady_clock::now()) {}
+
+Profiler& GetProfiler() {
+	static Profiler profiler;
+	return profiler;
+}
+
+ProfileRingBuffer& Profiler::GetThreadBuffer() {
+	// スレッドが終わってもバッファは Profiler が持ち続ける (EndFrame でまだ読むかもしれないため)
+	static thread_local ProfileRingBuffer* tBuffer = nullptr;
+	if (tBuffer == nullptr) {
+		std::lock_guard<std::mutex> lock(buffersMutex_);
+		buffers_.push_back(std::make_unique<ProfileRingBuffer>(uint32_t(buffers_.size())));
+		tBuffer = buffers_.back().get();
+	}
+	return *tBuffer;
+}
+
+//=================================================================================================
+
+
+//=======================================  集計  ==================================================
+
+void Profiler::EndFrame() {
+	for (auto& [name, zone] : zones_) {
+		zone.callsThisFrame = 0;
+	}
+
+	std::vector<TraceEvent> frame;
+	frame.reserve(traceFrames_.empty() ? 0 : traceFrames_.back().size());
+	{
+		std::lock_guard<std::mutex> lock(buffersMutex_);
+		// 同じゾーンは続けて記録されることが多いので、直前と同じポインタなら名前を引き直さない
+		const char* lastName = nullptr;
+		ZoneHistory* lastZone = nullptr;
+		for (const std::unique_ptr<ProfileRingBuffer>& buffer : buffers_) {
+			uint32_t threadId = buffer->GetThreadId();
+			buffer->Drain([&](const ProfileEvent& event) {
+				if (event.name != lastName) {
+					lastName = event.name;
+					lastZone = &zones_[std::string_view(event.name)];
+				}
+				ZoneHistory& zone = *lastZone;
+				if (zone.name == nullptr) {
+					zone.name = event.name;
+					zone.durations.reserve(kHistorySize);
+				}
+				uint64_t duration = event.end - event.begin;
+				if (zone.durations.size() < kHistorySize) {
+					zone.durations.push_back(duration);
+				} else {
+					zone.durations[zone.next] = duration;
+				}
+				zone.next = (zone.next + 1) % kHistorySize;
+				++zone.callsThisFrame;
+				frame.push_back({ event.name, event.begin, event.end, threadId });
+			});
+		}
+	}
+
+	for (auto& [name, zone] : zones_) {
+		zone.callsPerFrame = zone.callsThisFrame;
+	}
+
+	traceFrames_.push_back(std::move(frame));
+	if (traceFrames_.size() > kTraceFrameCount) {
+		traceFrames_.pop_front();
+	}
+}
+
+double Profiler::GetTicksPerMicrosecond() const {
+	// 起動してからの刻みの数と steady_clock の時間の比。RDTSC の周波数を別に調べなくてよい
+	uint64_t ticks = ReadProfileTimestamp() - startTimestamp_;
+	double microseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - startTime_).count();
+	if (microseconds <= 0.0 || ticks == 0) {
+		return 1.0;
+	}
+	return double(ticks) / microseconds;
+}
+
+std::vector<ProfileZoneSummary> Profiler::GetSummaries() const {
+	double microsecondsPerTick = 1.0 / GetTicksPerMicrosecond();
+	std::vector<ProfileZoneSummary> summaries;
+	summaries.reserve(zones_.size());
+
+	std::vector<uint64_t> sorted;
+	for (const auto& [name, zone] : zones_) {
+		if (zone.durations.empty()) {
+			continue;
+		}
+		sorted = zone.durations;
+		size_t count = sorted.size();
+		// p がつく値は、その割合の回数がそれ以下で終わった時間
+		auto percentile = [&](double p) {
+			size_t index = (std::min)(count - 1, size_t(p * double(count)));
+			std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+			return double(sorted[index]) * microsecondsPerTick;
+		};
+
+		uint64_t total = 0;
+		uint64_t maxDuration = 0;
+		for (uint64_t duration : sorted) {
+			total += duration;
+			maxDuration = (std::max)(maxDuration, duration);
+		}
+
+		ProfileZoneSummary summary;
+		summary.name = zone.name;
+		summary.callsPerFrame = zone.callsPerFrame;
+		summary.average = double(total) / double(count) * microsecondsPerTick;
+		summary.p50 = percentile(0.50);
+		summary.p95 = percentile(0.95);
+		summary.p99 = percentile(0.99);
+		summary.max = double(maxDuration) * microsecondsPerTick;
+		summaries.push_back(summary);
+	}
+
+	std::sort(summaries.begin(), summaries.end(), [](const ProfileZoneSummary& a, const ProfileZoneSummary& b) {
+		return a.average > b.average;
+	});
+	return summaries;
+}
+
+uint32_t Profiler::GetDroppedCount() const {
+	std::lock_guard<std::mutex> lock(buffersMutex_);
+	uint32_t dropped = 0;
+	for (const std::unique_ptr<ProfileRingBuffer>& buffer : buffers_) {
+		dropped += buffer->GetDroppedCount();
+	}
+	return dropped;
+}
+
+void Profiler::Clear() {
+	{
+		std::lock_guard<std::mutex> lock(buffersMutex_);
+		for (const std::unique_ptr<ProfileRingBuffer>& buffer : buffers_) {
+			buffer->Drain([](const ProfileEvent&) {});
+		}
+	}
+	zones_.clear();
+	traceFrames_.clear();
+}
+
+//=================================================================================================
+
+
+//=====================================  Chrome trace  ===========================================
+
+bool Profiler::WriteChromeTrace(const std::string& path) const {
+	FILE* file = std::fopen(path.c_str(), "wb");
+	if (file == nullptr) {
+		return false;
+	}
+
+	// 時刻は起動してからのマイクロ秒。"ph":"X" は開始時刻と長さを持つ区間
+	double microsecondsPerTick = 1.0 / GetTicksPerMicrosecond();
+	std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", file);
+	bool first = true;
+	for (const std::vector<TraceEvent>& frame : traceFrames_) {
+		for (const TraceEvent& event : frame) {
+			std::fprintf(file, "%s\n{\"name\":\"", first ? "" : ",");
+			for (const char* c = event.name; *c != '\0'; ++c) {
+				if (*c == '"' || *c == '\\') {
+					std::fputc('\\', file);
+				}
+				std::fputc(*c, file);
+			}
+			std::fprintf(file, "\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%u}",
+				double(event.begin - startTimestamp_) * microsecondsPerTick,
+				double(event.end - event.begin) * microsecondsPerTick,
+				event.threadId);
+			first = false;
+		}
+	}
+	std::fputs("\n]}\n", file);
+	return std::fclose(file) == 0;
+}
+
+//=================================================================================================
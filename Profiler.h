@@ -0,0 +1,210 @@
+#pragma once
+#include "SimdConfig.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#if MT3_SIMD_X86 && !defined(_MSC_VER)
+#include <x86intrin.h>
+#endif
+
+// 処理時間を区間 (ゾーン) ごとに測るプロファイラ
+//
+//   void DrawGrid(...) {
+//       MT3_PROFILE_ZONE("DrawGrid");  // このスコープを抜けるまでを1回として記録する
+//       ...
+//   }
+//
+//   GetProfiler().SetEnabled(true);  // 既定では測らない (ベンチマークの結果を変えないため)
+//   GetProfiler().EndFrame();        // 毎フレームの最後に、記録した区間を集計する
+//
+// 時刻は RDTSC (x86 以外では steady_clock) で読み、スレッドごとのリングバッファに書く
+// 書くのはそのスレッドだけ、読むのは EndFrame を呼ぶスレッドだけなので、ロックは使わない
+// MT3_PROFILE を 0 にすると MT3_PROFILE_ZONE は何も残さない (CMake の MT3_ENABLE_PROFILER)
+// ゾーンの名前は文字列リテラルにする (ポインタをそのまま記録する)
+
+#ifndef MT3_PROFILE
+#define MT3_PROFILE 1
+#endif
+
+
+//========================================  時刻  =================================================
+
+inline uint64_t ReadProfileTimestamp() {
+#if MT3_SIMD_X86
+	return __rdtsc();
+#else
+	return uint64_t(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+//=================================================================================================
+
+
+//=================================  スレッドごとのリングバッファ  =================================
+
+struct ProfileEvent {
+	const char* name;
+	uint64_t begin;
+	uint64_t end;
+};
+
+// 書き込み1スレッド・読み出し1スレッドのリングバッファ。満杯のときは捨てて数だけ数える
+class ProfileRingBuffer {
+public:
+	static const uint32_t kCapacity = 1 << 14;
+
+	explicit ProfileRingBuffer(uint32_t threadId) : threadId_(threadId), events_(kCapacity) {}
+
+	void Push(const ProfileEvent& event) {
+		uint32_t head = head_.load(std::memory_order_relaxed);
+		if (head - tail_.load(std::memory_order_acquire) == kCapacity) {
+			dropped_.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		events_[head & (kCapacity - 1)] = event;
+		head_.store(head + 1, std::memory_order_release);
+	}
+
+	template <typename Function>
+	void Drain(Function&& function) {
+		uint32_t tail = tail_.load(std::memory_order_relaxed);
+		uint32_t head = head_.load(std::memory_order_acquire);
+		for (; tail != head; ++tail) {
+			function(events_[tail & (kCapacity - 1)]);
+		}
+		tail_.store(tail, std::memory_order_release);
+	}
+
+	uint32_t GetThreadId() const { return threadId_; }
+	uint32_t GetDroppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+	uint32_t threadId_;
+	std::vector<ProfileEvent> events_;
+	std::atomic<uint32_t> head_{ 0 };  //!< 次に書く位置 (書くスレッドだけが進める)
+	std::atomic<uint32_t> tail_{ 0 };  //!< 次に読む位置 (読むスレッドだけが進める)
+	std::atomic<uint32_t> dropped_{ 0 };
+};
+
+//=================================================================================================
+
+
+//=====================================  プロファイラ  ============================================
+
+// 1つのゾーンの、最近 kHistorySize 回分の時間の統計 (単位はマイクロ秒)
+struct ProfileZoneSummary {
+	const char* name;
+	uint32_t callsPerFrame;  //!< 直前のフレームで呼ばれた回数
+	double average;
+	double p50;
+	double p95;
+	double p99;
+	double max;
+};
+
+class Profiler {
+public:
+	static const uint32_t kHistorySize = 1024;  //!< ゾーンごとに残す回数
+	static const uint32_t kTraceFrameCount = 120;  //!< Chrome trace に書き出すフレーム数
+
+	Profiler();
+
+	void SetEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+	bool IsEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+	// 今のスレッドのバッファに書く (最初の呼び出しでバッファを作る)
+	void Record(const char* name, uint64_t begin, uint64_t end) { GetThreadBuffer().Push({ name, begin, end }); }
+
+	// 全てのスレッドのバッファを読み、ゾーンごとの統計と trace 用の記録に移す。毎フレームの最後に1つのスレッドから呼ぶ
+	void EndFrame();
+
+	// 平均の長い順
+	std::vector<ProfileZoneSummary> GetSummaries() const;
+
+	// 最近 kTraceFrameCount フレーム分を Chrome trace (chrome://tracing, Perfetto) の JSON で書き出す
+	bool WriteChromeTrace(const std::string& path) const;
+
+	void Clear();
+
+	uint32_t GetDroppedCount() const;
+	double GetTicksPerMicrosecond() const;
+
+private:
+	struct ZoneHistory {
+		const char* name = nullptr;
+		std::vector<uint64_t> durations;  //!< kHistorySize 個のリング
+		uint32_t next = 0;
+		uint32_t callsThisFrame = 0;
+		uint32_t callsPerFrame = 0;
+	};
+
+	struct TraceEvent {
+		const char* name;
+		uint64_t begin;
+		uint64_t end;
+		uint32_t threadId;
+	};
+
+	ProfileRingBuffer& GetThreadBuffer();
+
+	std::atomic<bool> enabled_{ false };
+
+	// バッファの登録 (スレッドごとに最初の1回だけ) と、EndFrame での読み出しの間だけロックする
+	mutable std::mutex buffersMutex_;
+	std::vector<std::unique_ptr<ProfileRingBuffer>> buffers_;
+
+	std::unordered_map<std::string_view, ZoneHistory> zones_;
+	std::deque<std::vector<TraceEvent>> traceFrames_;
+
+	// RDTSC の刻みを時間に直すための基準
+	uint64_t startTimestamp_;
+	std::chrono::steady_clock::time_point startTime_;
+};
+
+// プログラム全体で1つ
+Profiler& GetProfiler();
+
+//=================================================================================================
+
+
+//======================================  ゾーン  =================================================
+
+class ProfileZone {
+public:
+	explicit ProfileZone(const char* name) : name_(GetProfiler().IsEnabled() ? name : nullptr) {
+		if (name_ != nullptr) {
+			begin_ = ReadProfileTimestamp();
+		}
+	}
+
+	~ProfileZone() {
+		if (name_ != nullptr) {
+			GetProfiler().Record(name_, begin_, ReadProfileTimestamp());
+		}
+	}
+
+	ProfileZone(const ProfileZone&) = delete;
+	ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+	const char* name_;
+	uint64_t begin_ = 0;
+};
+
+#define MT3_PROFILE_CONCAT2(a, b) a##b
+#define MT3_PROFILE_CONCAT(a, b) MT3_PROFILE_CONCAT2(a, b)
+
+#if MT3_PROFILE
+#define MT3_PROFILE_ZONE(name) ProfileZone MT3_PROFILE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define MT3_PROFILE_ZONE(name) ((void)0)
+#endif
+
+//=================================================================================================
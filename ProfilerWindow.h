@@ -0,0 +1,55 @@
+#pragma once
+#include "Profiler.h"
+#include <imgui.h>
+
+// Profiler の集計を表示する ImGui のウィンドウ (main.cpp から毎フレーム呼ぶ)
+// 時間の単位はマイクロ秒。「Save trace」で最近のフレームを Chrome trace の JSON に書き出す
+inline void DrawProfilerWindow(const char* tracePath = "profile_trace.json") {
+	Profiler& profiler = GetProfiler();
+	static const char* saveResult = "";
+
+	ImGui::Begin("Profiler");
+
+	bool enabled = profiler.IsEnabled();
+	if (ImGui::Checkbox("enabled", &enabled)) {
+		profiler.SetEnabled(enabled);
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Clear")) {
+		profiler.Clear();
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Save trace")) {
+		saveResult = profiler.WriteChromeTrace(tracePath) ? "saved" : "failed";
+	}
+	ImGui::SameLine();
+	ImGui::Text("%s %s", tracePath, saveResult);
+
+	// リングバッファが満杯で捨てた数 (0でなければ EndFrame を呼ぶ間隔が長すぎる)
+	ImGui::Text("dropped: %u", profiler.GetDroppedCount());
+	ImGui::Separator();
+
+	if (ImGui::BeginTable("zones", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+		ImGui::TableSetupColumn("zone");
+		ImGui::TableSetupColumn("calls");
+		ImGui::TableSetupColumn("avg");
+		ImGui::TableSetupColumn("p50");
+		ImGui::TableSetupColumn("p95");
+		ImGui::TableSetupColumn("p99");
+		ImGui::TableSetupColumn("max");
+		ImGui::TableHeadersRow();
+		for (const ProfileZoneSummary& zone : profiler.GetSummaries()) {
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn(); ImGui::Text("%s", zone.name);
+			ImGui::TableNextColumn(); ImGui::Text("%u", zone.callsPerFrame);
+			ImGui::TableNextColumn(); ImGui::Text("%.2f", zone.average);
+			ImGui::TableNextColumn(); ImGui::Text("%.2f", zone.p50);
+			ImGui::TableNextColumn(); ImGui::Text("%.2f", zone.p95);
+			ImGui::TableNextColumn(); ImGui::Text("%.2f", zone.p99);
+			ImGui::TableNextColumn(); ImGui::Text("%.2f", zone.max);
+		}
+		ImGui::EndTable();
+	}
+
+	ImGui::End();
+}
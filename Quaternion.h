@@ -0,0 +1,216 @@
+#pragma once
+#include "MakeMatrix.h"
+#include "TransformBatch.h"
+#include <assert.h>
+#include <cmath>
+#include <cstdint>
+
+// クォータニオン (回転だけを4つの数で表す)
+// 積はハミルトン積で、Multiply(q1, q2) は q2 の回転の後に q1 の回転をする
+// (行列の Multiply(m1, m2) とは逆の順番になるので注意)
+// MakeRotateMatrix で作る行列は、他の行列と同じく行ベクトルに右から掛ける形
+//
+// 回転を補間するときは行列ではなくクォータニオンのまま Slerp/Nlerp し、
+// 最後に1回だけ MakeAffineMatrixQuaternion(scale, rotate, translate) で行列にする
+
+struct Quaternion {
+	float x, y, z, w;
+};
+
+
+//=======================================  基本の演算  =============================================
+
+inline Quaternion IdentityQuaternion() {
+	return { 0.0f, 0.0f, 0.0f, 1.0f };
+}
+
+inline Quaternion Multiply(const Quaternion& lhs, const Quaternion& rhs) {
+	return {
+		lhs.w * rhs.x + lhs.x * rhs.w + lhs.y * rhs.z - lhs.z * rhs.y,
+		lhs.w * rhs.y - lhs.x * rhs.z + lhs.y * rhs.w + lhs.z * rhs.x,
+		lhs.w * rhs.z + lhs.x * rhs.y - lhs.y * rhs.x + lhs.z * rhs.w,
+		lhs.w * rhs.w - lhs.x * rhs.x - lhs.y * rhs.y - lhs.z * rhs.z,
+	};
+}
+
+inline Quaternion Conjugate(const Quaternion& quaternion) {
+	return { -quaternion.x, -quaternion.y, -quaternion.z, quaternion.w };
+}
+
+inline float Dot(const Quaternion& q1, const Quaternion& q2) {
+	return q1.x * q2.x + q1.y * q2.y + q1.z * q2.z + q1.w * q2.w;
+}
+
+inline float Norm(const Quaternion& quaternion) {
+	return std::sqrt(Dot(quaternion, quaternion));
+}
+
+inline Quaternion Normalize(const Quaternion& quaternion) {
+	float norm = Norm(quaternion);
+	assert(norm != 0.0f);
+	float invNorm = 1.0f / norm;
+	return { quaternion.x * invNorm, quaternion.y * invNorm, quaternion.z * invNorm, quaternion.w * invNorm };
+}
+
+inline Quaternion Inverse(const Quaternion& quaternion) {
+	float normSquared = Dot(quaternion, quaternion);
+	assert(normSquared != 0.0f);
+	float invNormSquared = 1.0f / normSquared;
+	Quaternion conjugate = Conjugate(quaternion);
+	return { conjugate.x * invNormSquared, conjugate.y * invNormSquared, conjugate.z * invNormSquared, conjugate.w * invNormSquared };
+}
+
+//=================================================================================================
+
+
+//====================================  回転の作成  ===============================================
+
+// axis は正規化しておく
+inline Quaternion MakeRotateAxisAngleQuaternion(const Vector3& axis, float angle) {
+	float s = std::sin(angle * 0.5f);
+	return { axis.x * s, axis.y * s, axis.z * s, std::cos(angle * 0.5f) };
+}
+
+// MakeAffineMatrix と同じ X → Y → Z の順のオイラー角 (MakeRotateXMatrix * MakeRotateYMatrix * MakeRotateZMatrix と同じ回転)
+inline Quaternion MakeRotateQuaternion(const Vector3& rotate) {
+	float sx = std::sin(rotate.x * 0.5f), cx = std::cos(rotate.x * 0.5f);
+	float sy = std::sin(rotate.y * 0.5f), cy = std::cos(rotate.y * 0.5f);
+	float sz = std::sin(rotate.z * 0.5f), cz = std::cos(rotate.z * 0.5f);
+	// qz * qy * qx を展開した式
+	return {
+		sx * cy * cz - cx * sy * sz,
+		cx * sy * cz + sx * cy * sz,
+		cx * cy * sz - sx * sy * cz,
+		cx * cy * cz + sx * sy * sz,
+	};
+}
+
+// 回転だけの行列 (拡大縮小を含まない) から作る
+inline Quaternion MakeRotateQuaternion(const Matrix4x4& m) {
+	float trace = m.m[0][0] + m.m[1][1] + m.m[2][2];
+	// 一番大きい成分から求め、小さい値での割り算を避ける
+	if (trace > 0.0f) {
+		float s = std::sqrt(trace + 1.0f) * 2.0f;
+		return { (m.m[1][2] - m.m[2][1]) / s, (m.m[2][0] - m.m[0][2]) / s, (m.m[0][1] - m.m[1][0]) / s, 0.25f * s };
+	}
+	if (m.m[0][0] > m.m[1][1] && m.m[0][0] > m.m[2][2]) {
+		float s = std::sqrt(1.0f + m.m[0][0] - m.m[1][1] - m.m[2][2]) * 2.0f;
+		return { 0.25f * s, (m.m[0][1] + m.m[1][0]) / s, (m.m[0][2] + m.m[2][0]) / s, (m.m[1][2] - m.m[2][1]) / s };
+	}
+	if (m.m[1][1] > m.m[2][2]) {
+		float s = std::sqrt(1.0f + m.m[1][1] - m.m[0][0] - m.m[2][2]) * 2.0f;
+		return { (m.m[0][1] + m.m[1][0]) / s, 0.25f * s, (m.m[1][2] + m.m[2][1]) / s, (m.m[2][0] - m.m[0][2]) / s };
+	}
+	float s = std::sqrt(1.0f + m.m[2][2] - m.m[0][0] - m.m[1][1]) * 2.0f;
+	return { (m.m[0][2] + m.m[2][0]) / s, (m.m[1][2] + m.m[2][1]) / s, 0.25f * s, (m.m[0][1] - m.m[1][0]) / s };
+}
+
+//=================================================================================================
+
+
+//=====================================  行列への変換  ============================================
+
+// quaternion は正規化しておく
+inline Matrix4x4 MakeRotateMatrix(const Quaternion& quaternion) {
+	float x = quaternion.x, y = quaternion.y, z = quaternion.z, w = quaternion.w;
+	Matrix4x4 result;
+
+	result.m[0][0] = 1.0f - 2.0f * (y * y + z * z);   result.m[0][1] = 2.0f * (x * y + w * z);          result.m[0][2] = 2.0f * (x * z - w * y);          result.m[0][3] = 0;
+	result.m[1][0] = 2.0f * (x * y - w * z);          result.m[1][1] = 1.0f - 2.0f * (x * x + z * z);   result.m[1][2] = 2.0f * (y * z + w * x);          result.m[1][3] = 0;
+	result.m[2][0] = 2.0f * (x * z + w * y);          result.m[2][1] = 2.0f * (y * z - w * x);          result.m[2][2] = 1.0f - 2.0f * (x * x + y * y);   result.m[2][3] = 0;
+	result.m[3][0] = 0;                               result.m[3][1] = 0;                               result.m[3][2] = 0;                               result.m[3][3] = 1;
+
+	return result;
+}
+
+// Scale * MakeRotateMatrix(rotate) * Translate を展開した式で直接作る
+// ({ } で渡したときに MakeAffineMatrix(scale, rotate, translate) と曖昧にならないように名前を分ける)
+inline Matrix4x4 MakeAffineMatrixQuaternion(const Vector3& scale, const Quaternion& rotate, const Vector3& translate) {
+	Matrix4x4 result = MakeRotateMatrix(rotate);
+	const float s[3] = { scale.x, scale.y, scale.z };
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			result.m[i][j] *= s[i];
+		}
+	}
+	result.m[3][0] = translate.x;
+	result.m[3][1] = translate.y;
+	result.m[3][2] = translate.z;
+	return result;
+}
+
+//=================================================================================================
+
+
+//====================================  ベクトルの回転  ===========================================
+
+// v' = q v q* を展開した式 (t = 2 (u × v), v' = v + w t + u × t)
+inline Vector3 RotateVector(const Vector3& vector, const Quaternion& quaternion) {
+	Vector3 u = { quaternion.x, quaternion.y, quaternion.z };
+	Vector3 t = Cross(u, vector);
+	t = { t.x * 2.0f, t.y * 2.0f, t.z * 2.0f };
+	Vector3 ut = Cross(u, t);
+	return { vector.x + quaternion.w * t.x + ut.x, vector.y + quaternion.w * t.y + ut.y, vector.z + quaternion.w * t.z + ut.z };
+}
+
+// 全ての点を同じ回転で回す。行列にしてから TransformArray (SIMD版) でまとめて変換する
+// src と dst は同じ配列でもよい
+inline void RotateVectors(const Quaternion& quaternion, const Vector3* src, Vector3* dst, uint32_t count) {
+	TransformArray(src, dst, count, MakeRotateMatrix(quaternion));
+}
+
+// 点ごとに別の回転で回す (ボーンごとの向きなど)
+inline void RotateVectors(const Quaternion* quaternions, const Vector3* src, Vector3* dst, uint32_t count) {
+	for (uint32_t i = 0; i < count; ++i) {
+		dst[i] = RotateVector(src[i], quaternions[i]);
+	}
+}
+
+//=================================================================================================
+
+
+//=======================================  補間  ==================================================
+
+// 近い方の向き (内積が正になる方) で補間する
+// 線形補間して正規化する。角速度は一定にならないが、Slerp より速い
+inline Quaternion Nlerp(const Quaternion& q0, const Quaternion& q1, float t) {
+	float sign = Dot(q0, q1) < 0.0f ? -1.0f : 1.0f;
+	float t0 = 1.0f - t;
+	float t1 = t * sign;
+	return Normalize(Quaternion{ q0.x * t0 + q1.x * t1, q0.y * t0 + q1.y * t1, q0.z * t0 + q1.z * t1, q0.w * t0 + q1.w * t1 });
+}
+
+// 球面線形補間 (角速度が一定)。ほとんど同じ向きのときは sin(θ) が0に近くなるので Nlerp で代用する
+inline Quaternion Slerp(const Quaternion& q0, const Quaternion& q1, float t) {
+	float dot = Dot(q0, q1);
+	float sign = dot < 0.0f ? -1.0f : 1.0f;
+	dot *= sign;
+	if (dot > 0.9995f) {
+		return Nlerp(q0, q1, t);
+	}
+	float theta = std::acos(dot);
+	float invSinTheta = 1.0f / std::sin(theta);
+	float t0 = std::sin((1.0f - t) * theta) * invSinTheta;
+	float t1 = std::sin(t * theta) * invSinTheta * sign;
+	return { q0.x * t0 + q1.x * t1, q0.y * t0 + q1.y * t1, q0.z * t0 + q1.z * t1, q0.w * t0 + q1.w * t1 };
+}
+
+// Slerp の近似。t を2つの向きの角度に合わせて補正してから Nlerp する (acos/sin を使わない)
+// Slerp との向きの差は 2e-3 ラジアン以下で、アニメーションの補間には十分
+inline Quaternion SlerpFast(const Quaternion& q0, const Quaternion& q1, float t) {
+	float d = std::fabs(Dot(q0, q1));
+	float a = 1.0904f + d * (-3.2452f + d * (3.55645f - d * 1.43519f));
+	float b = 0.848013f + d * (-1.06021f + d * 0.215638f);
+	float k = a * (t - 0.5f) * (t - 0.5f) + b;
+	float correctedT = t + t * (t - 0.5f) * (t - 1.0f) * k;
+	return Nlerp(q0, q1, correctedT);
+}
+
+// count 個の組をまとめて補間する (ボーンやカメラのキーフレームなど)
+inline void SlerpArray(const Quaternion* q0, const Quaternion* q1, float t, Quaternion* out, uint32_t count) {
+	for (uint32_t i = 0; i < count; ++i) {
+		out[i] = SlerpFast(q0[i], q1[i], t);
+	}
+}
+
+//=================================================================================================
@@ -0,0 +1,76 @@
+#pragma once
+#include "Frustum.h"
+#include "TransformBatch.h"
+#include <bit>
+
+// ワールド座標 → スクリーン座標の変換をまとめたもの
+// ビューポート行列はアフィン変換なので、ビュープロジェクション行列と先に掛け合わせても
+// Transform(Transform(p, viewProjection), viewport) と同じ結果になり、w除算は1回で済む
+struct ScreenTransform {
+	Matrix4x4 matrix;  //!< ビュー × 射影 × ビューポート
+	Frustum frustum;   //!< 描画前のカリング・ニアクリップ用 (ビュー × 射影 から作る)
+	DepthMode depthMode = kDepthStandard;  //!< 射影行列の深度の向き (線を奥から順に描くときに使う)
+};
+
+
+//================================ スクリーン変換の作成関数 =======================================
+
+// depthMode は射影行列を作った関数に合わせる (MakePerspectiveFovMatrixReverseZ などなら kDepthReverseZ)
+inline ScreenTransform MakeScreenTransform(const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewportMatrix, DepthMode depthMode = kDepthStandard) {
+	ScreenTransform result;
+	result.matrix = Multiply(viewProjectionMatrix, viewportMatrix);
+	result.frustum = MakeFrustum(viewProjectionMatrix, depthMode);
+	result.depthMode = depthMode;
+	return result;
+}
+
+// 毎フレーム1回、ビュー・射影・ビューポート行列から作る
+inline ScreenTransform MakeScreenTransform(const Matrix4x4& viewMatrix, const Matrix4x4& projectionMatrix, const Matrix4x4& viewportMatrix,
+	DepthMode depthMode = kDepthStandard) {
+	return MakeScreenTransform(Multiply(viewMatrix, projectionMatrix), viewportMatrix, depthMode);
+}
+
+//=================================================================================================
+
+
+//============================== ワールド座標をスクリーン座標へ変換 ===============================
+
+inline Vector3 ToScreen(const Vector3& point, const ScreenTransform& screen) {
+	const Matrix4x4& m = screen.matrix;
+	float x = point.x * m.m[0][0] + point.y * m.m[1][0] + point.z * m.m[2][0] + m.m[3][0];
+	float y = point.x * m.m[0][1] + point.y * m.m[1][1] + point.z * m.m[2][1] + m.m[3][1];
+	float z = point.x * m.m[0][2] + point.y * m.m[1][2] + point.z * m.m[2][2] + m.m[3][2];
+	float w = point.x * m.m[0][3] + point.y * m.m[1][3] + point.z * m.m[2][3] + m.m[3][3];
+	assert(w != 0.0f);
+	float invW = 1.0f / w;
+	return { x * invW, y * invW, z * invW };
+}
+
+// 複数の点をまとめて変換する。src と dst は同じ配列でもよい
+inline void ToScreenArray(const Vector3* src, Vector3* dst, uint32_t count, const ScreenTransform& screen) {
+	TransformArray(src, dst, count, screen.matrix);
+}
+
+//=================================================================================================
+
+
+//======================================  深度で並べ替え  ==========================================
+
+// ビューポート変換後の深度 (0 ～ 1。向きは screen.depthMode)
+inline float ToDepth(const Vector3& point, const ScreenTransform& screen) {
+	const Matrix4x4& m = screen.matrix;
+	float z = point.x * m.m[0][2] + point.y * m.m[1][2] + point.z * m.m[2][2] + m.m[3][2];
+	float w = point.x * m.m[0][3] + point.y * m.m[1][3] + point.z * m.m[2][3] + m.m[3][3];
+	assert(w != 0.0f);
+	return z / w;
+}
+
+// 深度を、描く順番のキーにする (小さいほど奥。LineBatch::Add に渡すと、奥の線から先に描かれて手前の線が上になる)
+// float のビットを符号なしの比較で大小が保たれる形にし、depthMode で向きをそろえる
+inline uint32_t DepthDrawOrder(float depth, DepthMode depthMode) {
+	uint32_t bits = std::bit_cast<uint32_t>(depth);
+	uint32_t ordered = (bits & 0x80000000u) != 0 ? ~bits : bits | 0x80000000u;  // 深度の小さい順
+	return depthMode == kDepthStandard ? ~ordered : ordered;                      // 遠い順
+}
+
+//=================================================================================================
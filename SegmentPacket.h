@@ -0,0 +1,555 @@
+#pragma once
+#include "Geometry.h"
+#include "SimdConfig.h"
+#include <cstdint>
+#include <cfloat>
+
+// 4本/8本の線分をまとめて AABB・三角形と判定する (パケット判定)
+// 線分は SoA で持ち、diff の逆数と三角形の判定に使う軸・せん断の係数は作成時に1回だけ求めておく
+// t は線分上の位置 (0 = origin, 1 = origin + diff)
+
+
+//===================================  線分パケットの作成  ============================================
+
+template <uint32_t N>
+struct SegmentPacket {
+	alignas(32) float originX[N];
+	alignas(32) float originY[N];
+	alignas(32) float originZ[N];
+	alignas(32) float diffX[N];
+	alignas(32) float diffY[N];
+	alignas(32) float diffZ[N];
+	alignas(32) float invDiffX[N];  //!< 1 / diff.x
+	alignas(32) float invDiffY[N];  //!< 1 / diff.y
+	alignas(32) float invDiffZ[N];  //!< 1 / diff.z
+	// 三角形の判定で、線分の向きが z 軸になるように軸を並べ替えてせん断する (0, 1, 2 = x, y, z)
+	alignas(32) uint32_t axisX[N];
+	alignas(32) uint32_t axisY[N];
+	alignas(32) uint32_t axisZ[N];  //!< diff の絶対値が最も大きい軸
+	alignas(32) float shearX[N];    //!< diff[axisX] / diff[axisZ]
+	alignas(32) float shearY[N];    //!< diff[axisY] / diff[axisZ]
+	alignas(32) float shearZ[N];    //!< 1 / diff[axisZ]
+	uint32_t activeMask;            //!< 有効なレーン (count が N 未満のとき残りは無効)
+};
+
+using SegmentPacket4 = SegmentPacket<4>;
+using SegmentPacket8 = SegmentPacket<8>;
+
+// 最も近い交点
+template <uint32_t N>
+struct PacketHit {
+	alignas(32) float t[N];       //!< 交点の t (当たっていなければ FLT_MAX)
+	alignas(32) float u[N];       //!< 重心座標 (vertices[1] の重み)
+	alignas(32) float v[N];       //!< 重心座標 (vertices[2] の重み)
+	uint32_t primitive[N];        //!< 当たった三角形の番号
+};
+
+template <uint32_t N>
+SegmentPacket<N> MakeSegmentPacket(const Segment* segments, uint32_t count) {
+	SegmentPacket<N> packet;
+	packet.activeMask = 0;
+	for (uint32_t lane = 0; lane < N; ++lane) {
+		// 余ったレーンは長さ0の線分で埋める (activeMaskで除外する)
+		Segment segment = (lane < count) ? segments[lane] : Segment{ { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } };
+		packet.originX[lane] = segment.origin.x;
+		packet.originY[lane] = segment.origin.y;
+		packet.originZ[lane] = segment.origin.z;
+		packet.diffX[lane] = segment.diff.x;
+		packet.diffY[lane] = segment.diff.y;
+		packet.diffZ[lane] = segment.diff.z;
+		packet.invDiffX[lane] = 1.0f / segment.diff.x;
+		packet.invDiffY[lane] = 1.0f / segment.diff.y;
+		packet.invDiffZ[lane] = 1.0f / segment.diff.z;
+
+		const float diff[3] = { segment.diff.x, segment.diff.y, segment.diff.z };
+		float absX = std::fabs(diff[0]), absY = std::fabs(diff[1]), absZ = std::fabs(diff[2]);
+		uint32_t axisZ = (absX > absY) ? (absX > absZ ? 0 : 2) : (absY > absZ ? 1 : 2);
+		uint32_t axisX = (axisZ + 1) % 3;
+		uint32_t axisY = (axisX + 1) % 3;
+		// 向きが負のときは x と y を入れ替えて、並べ替えた後も右手系のままにする
+		if (diff[axisZ] < 0.0f) {
+			std::swap(axisX, axisY);
+		}
+		packet.axisX[lane] = axisX;
+		packet.axisY[lane] = axisY;
+		packet.axisZ[lane] = axisZ;
+		packet.shearX[lane] = diff[axisX] / diff[axisZ];
+		packet.shearY[lane] = diff[axisY] / diff[axisZ];
+		packet.shearZ[lane] = 1.0f / diff[axisZ];
+		if (lane < count) {
+			packet.activeMask |= 1u << lane;
+		}
+	}
+	return packet;
+}
+
+template <uint32_t N>
+void ResetPacketHit(PacketHit<N>& hit) {
+	for (uint32_t lane = 0; lane < N; ++lane) {
+		hit.t[lane] = FLT_MAX;
+		hit.u[lane] = 0.0f;
+		hit.v[lane] = 0.0f;
+		hit.primitive[lane] = UINT32_MAX;
+	}
+}
+
+//=================================================================================================
+
+
+//===================================  スカラー版 (1レーン)  ==========================================
+
+// スラブ法。交わっていれば tNear に入る位置を書き込む
+// 軸に平行な線分が面の上から始まるときの NaN は SlabNear / SlabFar (Geometry.h) で除く
+template <uint32_t N>
+bool IntersectLaneAABB(const SegmentPacket<N>& p, uint32_t lane, const AABB& aabb, float& tNear) {
+	float tx0 = (aabb.min.x - p.originX[lane]) * p.invDiffX[lane];
+	float tx1 = (aabb.max.x - p.originX[lane]) * p.invDiffX[lane];
+	float ty0 = (aabb.min.y - p.originY[lane]) * p.invDiffY[lane];
+	float ty1 = (aabb.max.y - p.originY[lane]) * p.invDiffY[lane];
+	float tz0 = (aabb.min.z - p.originZ[lane]) * p.invDiffZ[lane];
+	float tz1 = (aabb.max.z - p.originZ[lane]) * p.invDiffZ[lane];
+	float tmin = (std::max)((std::max)(SlabNear(tx0, tx1), SlabNear(ty0, ty1)), (std::max)(SlabNear(tz0, tz1), 0.0f));
+	float tmax = (std::min)((std::min)(SlabFar(tx0, tx1), SlabFar(ty0, ty1)), (std::min)(SlabFar(tz0, tz1), 1.0f));
+	tNear = tmin;
+	return tmin <= tmax;
+}
+
+// 三角形の判定は Woop, Benthin, Wald の水密な (watertight) 判定
+// 頂点を線分の始点からの位置にし、線分の向きが z 軸になるように軸を並べ替えてせん断してから、
+// xy 平面で3本の辺の関数 (edge0〜2。edgeN は頂点 N の向かいの辺) の符号を見る
+// 共有辺の関数はどちらの三角形でも同じ2頂点の同じ積から求まり、符号が逆になるだけなので、
+// 共有辺や共有頂点を通る線分はどちらかの三角形に必ず当たる (辺の上は両方に当たる)
+// そのため辺の関数の積と差は別々に丸める (FMA にまとめると符号が逆にならない)
+
+// 辺の関数 a.x * b.y - a.y * b.x
+inline float EdgeFunction(float ax, float ay, float bx, float by) {
+	return ax * by - ay * bx;
+}
+
+// 辺の関数が float で 0 になったときに double で計算し直す
+// float 同士の積は double なら丸めなしで求まるので、0 かどうかと符号は正しく決まる
+inline float EdgeFunctionDouble(float ax, float ay, float bx, float by) {
+	return float(double(ax) * double(by) - double(ay) * double(bx));
+}
+
+template <uint32_t N>
+bool IntersectLaneTriangle(const SegmentPacket<N>& p, uint32_t lane, const Triangle& triangle, PacketHit<N>& hit) {
+	const uint32_t axisX = p.axisX[lane], axisY = p.axisY[lane], axisZ = p.axisZ[lane];
+	float x[3], y[3], z[3];
+	for (int i = 0; i < 3; ++i) {
+		const Vector3& vertex = triangle.vertices[i];
+		const float relative[3] = { vertex.x - p.originX[lane], vertex.y - p.originY[lane], vertex.z - p.originZ[lane] };
+		x[i] = relative[axisX] - p.shearX[lane] * relative[axisZ];
+		y[i] = relative[axisY] - p.shearY[lane] * relative[axisZ];
+		z[i] = p.shearZ[lane] * relative[axisZ];
+	}
+
+	float edge0 = EdgeFunction(x[2], y[2], x[1], y[1]);
+	float edge1 = EdgeFunction(x[0], y[0], x[2], y[2]);
+	float edge2 = EdgeFunction(x[1], y[1], x[0], y[0]);
+	if (edge0 == 0.0f || edge1 == 0.0f || edge2 == 0.0f) {
+		edge0 = EdgeFunctionDouble(x[2], y[2], x[1], y[1]);
+		edge1 = EdgeFunctionDouble(x[0], y[0], x[2], y[2]);
+		edge2 = EdgeFunctionDouble(x[1], y[1], x[0], y[0]);
+	}
+	// 符号が混ざっていれば外側 (表裏どちらからでも当たる)
+	if ((edge0 < 0.0f || edge1 < 0.0f || edge2 < 0.0f) && (edge0 > 0.0f || edge1 > 0.0f || edge2 > 0.0f)) {
+		return false;
+	}
+
+	// 除算は当たったときだけ行い、t の範囲は det 倍したまま符号をそろえて比べる
+	float det = edge0 + edge1 + edge2;
+	float t = edge0 * z[0] + edge1 * z[1] + edge2 * z[2];
+	float absDet = std::fabs(det);
+	if (det < 0.0f) {
+		edge1 = -edge1;
+		edge2 = -edge2;
+		t = -t;
+	}
+	if (!(absDet > 0.0f && t >= 0.0f && t <= absDet)) {
+		return false;
+	}
+
+	float invDet = 1.0f / absDet;
+	float tHit = t * invDet;
+	if (!(tHit < hit.t[lane])) {
+		return false;
+	}
+	hit.t[lane] = tHit;
+	hit.u[lane] = edge1 * invDet;
+	hit.v[lane] = edge2 * invDet;
+	return true;
+}
+
+//=================================================================================================
+
+#if MT3_SIMD_X86
+
+//======================================  SSE版 (4レーン)  ============================================
+
+// SlabNear / SlabFar の4レーン版。NaN のレーンはその軸で t を制限しない
+SIMD_TARGET_SSE41
+inline __m128 SlabNearSSE(__m128 t0, __m128 t1) {
+	return _mm_blendv_ps(_mm_min_ps(t0, t1), _mm_set1_ps(-FLT_MAX), _mm_cmpunord_ps(t0, t1));
+}
+
+SIMD_TARGET_SSE41
+inline __m128 SlabFarSSE(__m128 t0, __m128 t1) {
+	return _mm_blendv_ps(_mm_max_ps(t0, t1), _mm_set1_ps(FLT_MAX), _mm_cmpunord_ps(t0, t1));
+}
+
+// lane から4本分を判定する。戻り値は当たったレーンのビット
+template <uint32_t N>
+SIMD_TARGET_SSE41
+inline uint32_t IntersectPacketAABBSSE(const SegmentPacket<N>& p, uint32_t lane, const AABB& aabb, float* tNear) {
+	__m128 ox = _mm_loadu_ps(p.originX + lane), oy = _mm_loadu_ps(p.originY + lane), oz = _mm_loadu_ps(p.originZ + lane);
+	__m128 ix = _mm_loadu_ps(p.invDiffX + lane), iy = _mm_loadu_ps(p.invDiffY + lane), iz = _mm_loadu_ps(p.invDiffZ + lane);
+
+	__m128 tx0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(aabb.min.x), ox), ix);
+	__m128 tx1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(aabb.max.x), ox), ix);
+	__m128 ty0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(aabb.min.y), oy), iy);
+	__m128 ty1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(aabb.max.y), oy), iy);
+	__m128 tz0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(aabb.min.z), oz), iz);
+	__m128 tz1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(aabb.max.z), oz), iz);
+
+	__m128 tmin = _mm_max_ps(_mm_max_ps(SlabNearSSE(tx0, tx1), SlabNearSSE(ty0, ty1)), _mm_max_ps(SlabNearSSE(tz0, tz1), _mm_setzero_ps()));
+	__m128 tmax = _mm_min_ps(_mm_min_ps(SlabFarSSE(tx0, tx1), SlabFarSSE(ty0, ty1)), _mm_min_ps(SlabFarSSE(tz0, tz1), _mm_set1_ps(1.0f)));
+	_mm_storeu_ps(tNear + lane, tmin);
+	return uint32_t(_mm_movemask_ps(_mm_cmple_ps(tmin, tmax))) << lane;
+}
+
+// 並べ替えた軸の値を選ぶ (isX のレーンは x、isY のレーンは y、それ以外は z)
+SIMD_TARGET_SSE41
+inline __m128 SelectAxisSSE(__m128 isX, __m128 isY, __m128 x, __m128 y, __m128 z) {
+	return _mm_blendv_ps(_mm_blendv_ps(z, y, isY), x, isX);
+}
+
+// 辺の関数が 0 になったレーンを double で計算し直す (SSE版・AVX2版で共通)
+// x, y は頂点ごとに width レーン分並べたもの
+inline void RecomputeEdgesDouble(uint32_t zeroMask, uint32_t width, const float* x, const float* y, float* edge0, float* edge1, float* edge2) {
+	for (uint32_t lane = 0; lane < width; ++lane) {
+		if (zeroMask & (1u << lane)) {
+			const float x0 = x[lane], x1 = x[width + lane], x2 = x[2 * width + lane];
+			const float y0 = y[lane], y1 = y[width + lane], y2 = y[2 * width + lane];
+			edge0[lane] = EdgeFunctionDouble(x2, y2, x1, y1);
+			edge1[lane] = EdgeFunctionDouble(x0, y0, x2, y2);
+			edge2[lane] = EdgeFunctionDouble(x1, y1, x0, y0);
+		}
+	}
+}
+
+template <uint32_t N>
+SIMD_TARGET_SSE41
+inline uint32_t IntersectPacketTriangleSSE(const SegmentPacket<N>& p, uint32_t lane, const Triangle& triangle, PacketHit<N>& hit) {
+	// レーンごとの軸の番号から、x/y を選ぶマスクを作る
+	__m128i one = _mm_set1_epi32(1);
+	__m128i axisX = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p.axisX + lane));
+	__m128i axisY = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p.axisY + lane));
+	__m128i axisZ = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p.axisZ + lane));
+	__m128 xIsX = _mm_castsi128_ps(_mm_cmpeq_epi32(axisX, _mm_setzero_si128())), xIsY = _mm_castsi128_ps(_mm_cmpeq_epi32(axisX, one));
+	__m128 yIsX = _mm_castsi128_ps(_mm_cmpeq_epi32(axisY, _mm_setzero_si128())), yIsY = _mm_castsi128_ps(_mm_cmpeq_epi32(axisY, one));
+	__m128 zIsX = _mm_castsi128_ps(_mm_cmpeq_epi32(axisZ, _mm_setzero_si128())), zIsY = _mm_castsi128_ps(_mm_cmpeq_epi32(axisZ, one));
+
+	__m128 ox = _mm_loadu_ps(p.originX + lane), oy = _mm_loadu_ps(p.originY + lane), oz = _mm_loadu_ps(p.originZ + lane);
+	__m128 shearX = _mm_loadu_ps(p.shearX + lane), shearY = _mm_loadu_ps(p.shearY + lane), shearZ = _mm_loadu_ps(p.shearZ + lane);
+	__m128 x[3], y[3], z[3];
+	for (int i = 0; i < 3; ++i) {
+		const Vector3& vertex = triangle.vertices[i];
+		__m128 rx = _mm_sub_ps(_mm_set1_ps(vertex.x), ox);
+		__m128 ry = _mm_sub_ps(_mm_set1_ps(vertex.y), oy);
+		__m128 rz = _mm_sub_ps(_mm_set1_ps(vertex.z), oz);
+		__m128 along = SelectAxisSSE(zIsX, zIsY, rx, ry, rz);
+		x[i] = _mm_sub_ps(SelectAxisSSE(xIsX, xIsY, rx, ry, rz), _mm_mul_ps(shearX, along));
+		y[i] = _mm_sub_ps(SelectAxisSSE(yIsX, yIsY, rx, ry, rz), _mm_mul_ps(shearY, along));
+		z[i] = _mm_mul_ps(shearZ, along);
+	}
+
+	__m128 edge0 = _mm_sub_ps(_mm_mul_ps(x[2], y[1]), _mm_mul_ps(y[2], x[1]));
+	__m128 edge1 = _mm_sub_ps(_mm_mul_ps(x[0], y[2]), _mm_mul_ps(y[0], x[2]));
+	__m128 edge2 = _mm_sub_ps(_mm_mul_ps(x[1], y[0]), _mm_mul_ps(y[1], x[0]));
+	__m128 zero = _mm_setzero_ps();
+	__m128 edgeZero = _mm_or_ps(_mm_or_ps(_mm_cmpeq_ps(edge0, zero), _mm_cmpeq_ps(edge1, zero)), _mm_cmpeq_ps(edge2, zero));
+	if (uint32_t zeroMask = uint32_t(_mm_movemask_ps(edgeZero))) {
+		alignas(16) float xs[12], ys[12], e0[4], e1[4], e2[4];
+		for (int i = 0; i < 3; ++i) {
+			_mm_store_ps(xs + 4 * i, x[i]);
+			_mm_store_ps(ys + 4 * i, y[i]);
+		}
+		_mm_store_ps(e0, edge0);
+		_mm_store_ps(e1, edge1);
+		_mm_store_ps(e2, edge2);
+		RecomputeEdgesDouble(zeroMask, 4, xs, ys, e0, e1, e2);
+		edge0 = _mm_load_ps(e0);
+		edge1 = _mm_load_ps(e1);
+		edge2 = _mm_load_ps(e2);
+	}
+
+	// 符号が混ざっていれば外側
+	__m128 negative = _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(edge0, zero), _mm_cmplt_ps(edge1, zero)), _mm_cmplt_ps(edge2, zero));
+	__m128 positive = _mm_or_ps(_mm_or_ps(_mm_cmpgt_ps(edge0, zero), _mm_cmpgt_ps(edge1, zero)), _mm_cmpgt_ps(edge2, zero));
+	__m128 det = _mm_add_ps(_mm_add_ps(edge0, edge1), edge2);
+	__m128 t = _mm_add_ps(_mm_add_ps(_mm_mul_ps(edge0, z[0]), _mm_mul_ps(edge1, z[1])), _mm_mul_ps(edge2, z[2]));
+
+	// det の符号ビットで辺の関数と t の符号をそろえる
+	__m128 signMask = _mm_set1_ps(-0.0f);
+	__m128 sign = _mm_and_ps(det, signMask);
+	__m128 absDet = _mm_andnot_ps(signMask, det);
+	edge1 = _mm_xor_ps(edge1, sign);
+	edge2 = _mm_xor_ps(edge2, sign);
+	t = _mm_xor_ps(t, sign);
+
+	// 無効なレーンは hit を書き換えないように最初から除く
+	__m128i laneBit = _mm_setr_epi32(1, 2, 4, 8);
+	__m128 active = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(int(p.activeMask >> lane)), laneBit), laneBit));
+	__m128 mask = _mm_and_ps(active, _mm_andnot_ps(_mm_and_ps(negative, positive), _mm_cmpgt_ps(absDet, zero)));
+	mask = _mm_and_ps(mask, _mm_cmpge_ps(t, zero));
+	mask = _mm_and_ps(mask, _mm_cmple_ps(t, absDet));
+	if (_mm_movemask_ps(mask) == 0) {
+		return 0;
+	}
+
+	__m128 invDet = _mm_div_ps(_mm_set1_ps(1.0f), absDet);
+	__m128 tHit = _mm_mul_ps(t, invDet);
+	__m128 tOld = _mm_loadu_ps(hit.t + lane);
+	mask = _mm_and_ps(mask, _mm_cmplt_ps(tHit, tOld));
+
+	_mm_storeu_ps(hit.t + lane, _mm_blendv_ps(tOld, tHit, mask));
+	_mm_storeu_ps(hit.u + lane, _mm_blendv_ps(_mm_loadu_ps(hit.u + lane), _mm_mul_ps(edge1, invDet), mask));
+	_mm_storeu_ps(hit.v + lane, _mm_blendv_ps(_mm_loadu_ps(hit.v + lane), _mm_mul_ps(edge2, invDet), mask));
+	return uint32_t(_mm_movemask_ps(mask)) << lane;
+}
+
+//=================================================================================================
+
+
+//=====================================  AVX2版 (8レーン)  ============================================
+
+SIMD_TARGET_AVX2
+inline __m256 SlabNearAVX2(__m256 t0, __m256 t1) {
+	return _mm256_blendv_ps(_mm256_min_ps(t0, t1), _mm256_set1_ps(-FLT_MAX), _mm256_cmp_ps(t0, t1, _CMP_UNORD_Q));
+}
+
+SIMD_TARGET_AVX2
+inline __m256 SlabFarAVX2(__m256 t0, __m256 t1) {
+	return _mm256_blendv_ps(_mm256_max_ps(t0, t1), _mm256_set1_ps(FLT_MAX), _mm256_cmp_ps(t0, t1, _CMP_UNORD_Q));
+}
+
+SIMD_TARGET_AVX2
+inline uint32_t IntersectPacketAABBAVX2(const SegmentPacket8& p, const AABB& aabb, float* tNear) {
+	__m256 ox = _mm256_loadu_ps(p.originX), oy = _mm256_loadu_ps(p.originY), oz = _mm256_loadu_ps(p.originZ);
+	__m256 ix = _mm256_loadu_ps(p.invDiffX), iy = _mm256_loadu_ps(p.invDiffY), iz = _mm256_loadu_ps(p.invDiffZ);
+
+	__m256 tx0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(aabb.min.x), ox), ix);
+	__m256 tx1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(aabb.max.x), ox), ix);
+	__m256 ty0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(aabb.min.y), oy), iy);
+	__m256 ty1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(aabb.max.y), oy), iy);
+	__m256 tz0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(aabb.min.z), oz), iz);
+	__m256 tz1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(aabb.max.z), oz), iz);
+
+	__m256 tmin = _mm256_max_ps(_mm256_max_ps(SlabNearAVX2(tx0, tx1), SlabNearAVX2(ty0, ty1)), _mm256_max_ps(SlabNearAVX2(tz0, tz1), _mm256_setzero_ps()));
+	__m256 tmax = _mm256_min_ps(_mm256_min_ps(SlabFarAVX2(tx0, tx1), SlabFarAVX2(ty0, ty1)), _mm256_min_ps(SlabFarAVX2(tz0, tz1), _mm256_set1_ps(1.0f)));
+	_mm256_storeu_ps(tNear, tmin);
+	return uint32_t(_mm256_movemask_ps(_mm256_cmp_ps(tmin, tmax, _CMP_LE_OQ)));
+}
+
+SIMD_TARGET_AVX2
+inline __m256 SelectAxisAVX2(__m256 isX, __m256 isY, __m256 x, __m256 y, __m256 z) {
+	return _mm256_blendv_ps(_mm256_blendv_ps(z, y, isY), x, isX);
+}
+
+SIMD_TARGET_AVX2
+inline uint32_t IntersectPacketTriangleAVX2(const SegmentPacket8& p, const Triangle& triangle, PacketHit<8>& hit) {
+	__m256i one = _mm256_set1_epi32(1);
+	__m256i axisX = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p.axisX));
+	__m256i axisY = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p.axisY));
+	__m256i axisZ = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p.axisZ));
+	__m256 xIsX = _mm256_castsi256_ps(_mm256_cmpeq_epi32(axisX, _mm256_setzero_si256())), xIsY = _mm256_castsi256_ps(_mm256_cmpeq_epi32(axisX, one));
+	__m256 yIsX = _mm256_castsi256_ps(_mm256_cmpeq_epi32(axisY, _mm256_setzero_si256())), yIsY = _mm256_castsi256_ps(_mm256_cmpeq_epi32(axisY, one));
+	__m256 zIsX = _mm256_castsi256_ps(_mm256_cmpeq_epi32(axisZ, _mm256_setzero_si256())), zIsY = _mm256_castsi256_ps(_mm256_cmpeq_epi32(axisZ, one));
+
+	__m256 ox = _mm256_loadu_ps(p.originX), oy = _mm256_loadu_ps(p.originY), oz = _mm256_loadu_ps(p.originZ);
+	__m256 shearX = _mm256_loadu_ps(p.shearX), shearY = _mm256_loadu_ps(p.shearY), shearZ = _mm256_loadu_ps(p.shearZ);
+	__m256 x[3], y[3], z[3];
+	for (int i = 0; i < 3; ++i) {
+		const Vector3& vertex = triangle.vertices[i];
+		__m256 rx = _mm256_sub_ps(_mm256_set1_ps(vertex.x), ox);
+		__m256 ry = _mm256_sub_ps(_mm256_set1_ps(vertex.y), oy);
+		__m256 rz = _mm256_sub_ps(_mm256_set1_ps(vertex.z), oz);
+		__m256 along = SelectAxisAVX2(zIsX, zIsY, rx, ry, rz);
+		x[i] = _mm256_sub_ps(SelectAxisAVX2(xIsX, xIsY, rx, ry, rz), _mm256_mul_ps(shearX, along));
+		y[i] = _mm256_sub_ps(SelectAxisAVX2(yIsX, yIsY, rx, ry, rz), _mm256_mul_ps(shearY, along));
+		z[i] = _mm256_mul_ps(shearZ, along);
+	}
+
+	__m256 edge0 = _mm256_sub_ps(_mm256_mul_ps(x[2], y[1]), _mm256_mul_ps(y[2], x[1]));
+	__m256 edge1 = _mm256_sub_ps(_mm256_mul_ps(x[0], y[2]), _mm256_mul_ps(y[0], x[2]));
+	__m256 edge2 = _mm256_sub_ps(_mm256_mul_ps(x[1], y[0]), _mm256_mul_ps(y[1], x[0]));
+	__m256 zero = _mm256_setzero_ps();
+	__m256 edgeZero = _mm256_or_ps(_mm256_or_ps(_mm256_cmp_ps(edge0, zero, _CMP_EQ_OQ), _mm256_cmp_ps(edge1, zero, _CMP_EQ_OQ)), _mm256_cmp_ps(edge2, zero, _CMP_EQ_OQ));
+	if (uint32_t zeroMask = uint32_t(_mm256_movemask_ps(edgeZero))) {
+		alignas(32) float xs[24], ys[24], e0[8], e1[8], e2[8];
+		for (int i = 0; i < 3; ++i) {
+			_mm256_store_ps(xs + 8 * i, x[i]);
+			_mm256_store_ps(ys + 8 * i, y[i]);
+		}
+		_mm256_store_ps(e0, edge0);
+		_mm256_store_ps(e1, edge1);
+		_mm256_store_ps(e2, edge2);
+		RecomputeEdgesDouble(zeroMask, 8, xs, ys, e0, e1, e2);
+		edge0 = _mm256_load_ps(e0);
+		edge1 = _mm256_load_ps(e1);
+		edge2 = _mm256_load_ps(e2);
+	}
+
+	__m256 negative = _mm256_or_ps(_mm256_or_ps(_mm256_cmp_ps(edge0, zero, _CMP_LT_OQ), _mm256_cmp_ps(edge1, zero, _CMP_LT_OQ)), _mm256_cmp_ps(edge2, zero, _CMP_LT_OQ));
+	__m256 positive = _mm256_or_ps(_mm256_or_ps(_mm256_cmp_ps(edge0, zero, _CMP_GT_OQ), _mm256_cmp_ps(edge1, zero, _CMP_GT_OQ)), _mm256_cmp_ps(edge2, zero, _CMP_GT_OQ));
+	__m256 det = _mm256_add_ps(_mm256_add_ps(edge0, edge1), edge2);
+	__m256 t = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(edge0, z[0]), _mm256_mul_ps(edge1, z[1])), _mm256_mul_ps(edge2, z[2]));
+
+	__m256 signMask = _mm256_set1_ps(-0.0f);
+	__m256 sign = _mm256_and_ps(det, signMask);
+	__m256 absDet = _mm256_andnot_ps(signMask, det);
+	edge1 = _mm256_xor_ps(edge1, sign);
+	edge2 = _mm256_xor_ps(edge2, sign);
+	t = _mm256_xor_ps(t, sign);
+
+	__m256i laneBit = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+	__m256 active = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(int(p.activeMask)), laneBit), laneBit));
+	__m256 mask = _mm256_and_ps(active, _mm256_andnot_ps(_mm256_and_ps(negative, positive), _mm256_cmp_ps(absDet, zero, _CMP_GT_OQ)));
+	mask = _mm256_and_ps(mask, _mm256_cmp_ps(t, zero, _CMP_GE_OQ));
+	mask = _mm256_and_ps(mask, _mm256_cmp_ps(t, absDet, _CMP_LE_OQ));
+	if (_mm256_movemask_ps(mask) == 0) {
+		return 0;
+	}
+
+	__m256 invDet = _mm256_div_ps(_mm256_set1_ps(1.0f), absDet);
+	__m256 tHit = _mm256_mul_ps(t, invDet);
+	__m256 tOld = _mm256_loadu_ps(hit.t);
+	mask = _mm256_and_ps(mask, _mm256_cmp_ps(tHit, tOld, _CMP_LT_OQ));
+
+	_mm256_storeu_ps(hit.t, _mm256_blendv_ps(tOld, tHit, mask));
+	_mm256_storeu_ps(hit.u, _mm256_blendv_ps(_mm256_loadu_ps(hit.u), _mm256_mul_ps(edge1, invDet), mask));
+	_mm256_storeu_ps(hit.v, _mm256_blendv_ps(_mm256_loadu_ps(hit.v), _mm256_mul_ps(edge2, invDet), mask));
+	return uint32_t(_mm256_movemask_ps(mask));
+}
+
+//=================================================================================================
+
+#endif
+
+
+//====================================  パケットとAABBの判定  ==========================================
+
+// 戻り値は当たったレーンのビット。tNear には各レーンがAABBに入る t を書き込む
+template <uint32_t N>
+uint32_t IntersectPacketAABB(const SegmentPacket<N>& packet, const AABB& aabb, float* tNear) {
+	static_assert(N % 4 == 0, "パケットの幅は4の倍数");
+	uint32_t mask = 0;
+	SimdLevel level = GetSimdLevel();
+#if MT3_SIMD_X86
+	if constexpr (N == 8) {
+		if (level == SimdLevel::AVX2) {
+			return IntersectPacketAABBAVX2(packet, aabb, tNear) & packet.activeMask;
+		}
+	}
+	if (level != SimdLevel::Scalar) {
+		for (uint32_t lane = 0; lane < N; lane += 4) {
+			mask |= IntersectPacketAABBSSE(packet, lane, aabb, tNear);
+		}
+		return mask & packet.activeMask;
+	}
+#endif
+	(void)level;
+	for (uint32_t lane = 0; lane < N; ++lane) {
+		if (IntersectLaneAABB(packet, lane, aabb, tNear[lane])) {
+			mask |= 1u << lane;
+		}
+	}
+	return mask & packet.activeMask;
+}
+
+//=================================================================================================
+
+
+//===================================  パケットと三角形の判定  =========================================
+
+// hit より近い交点が見つかったレーンを更新し、そのビットを返す
+template <uint32_t N>
+uint32_t IntersectPacketTriangle(const SegmentPacket<N>& packet, const Triangle& triangle, uint32_t primitive, PacketHit<N>& hit) {
+	static_assert(N % 4 == 0, "パケットの幅は4の倍数");
+	uint32_t mask = 0;
+	SimdLevel level = GetSimdLevel();
+#if MT3_SIMD_X86
+	bool done = false;
+	if constexpr (N == 8) {
+		if (level == SimdLevel::AVX2) {
+			mask = IntersectPacketTriangleAVX2(packet, triangle, hit);
+			done = true;
+		}
+	}
+	if (!done && level != SimdLevel::Scalar) {
+		for (uint32_t lane = 0; lane < N; lane += 4) {
+			mask |= IntersectPacketTriangleSSE(packet, lane, triangle, hit);
+		}
+		done = true;
+	}
+	if (!done)
+#endif
+	{
+		(void)level;
+		for (uint32_t lane = 0; lane < N; ++lane) {
+			if ((packet.activeMask & (1u << lane)) && IntersectLaneTriangle(packet, lane, triangle, hit)) {
+				mask |= 1u << lane;
+			}
+		}
+	}
+	// 無効なレーンは長さ0の線分だが、当たらないのは shear が 0/0 の NaN になるからにすぎない。
+	// それに頼らず activeMask で除く (各カーネルも無効なレーンの hit は書き換えない)
+	mask &= packet.activeMask;
+	for (uint32_t lane = 0; lane < N; ++lane) {
+		if (mask & (1u << lane)) {
+			hit.primitive[lane] = primitive;
+		}
+	}
+	return mask;
+}
+
+//=================================================================================================
+
+
+//==============================  大量の線分と三角形の最も近い交点  ===================================
+
+struct SegmentHit {
+	float t;            //!< 交点の t (当たっていなければ FLT_MAX)
+	float u;            //!< 重心座標 (vertices[1] の重み)
+	float v;            //!< 重心座標 (vertices[2] の重み)
+	uint32_t triangle;  //!< 当たった三角形の番号 (当たっていなければ UINT32_MAX)
+};
+
+// AVX2なら8本ずつ、それ以外は4本ずつパケットにして判定する
+template <uint32_t N>
+void RaycastTrianglesPacket(const Segment* segments, uint32_t segmentCount, const Triangle* triangles, uint32_t triangleCount, SegmentHit* hits) {
+	for (uint32_t begin = 0; begin < segmentCount; begin += N) {
+		uint32_t count = (std::min)(N, segmentCount - begin);
+		SegmentPacket<N> packet = MakeSegmentPacket<N>(segments + begin, count);
+		PacketHit<N> hit;
+		ResetPacketHit(hit);
+		for (uint32_t i = 0; i < triangleCount; ++i) {
+			IntersectPacketTriangle(packet, triangles[i], i, hit);
+		}
+		for (uint32_t lane = 0; lane < count; ++lane) {
+			hits[begin + lane] = { hit.t[lane], hit.u[lane], hit.v[lane], hit.primitive[lane] };
+		}
+	}
+}
+
+inline void RaycastTriangles(const Segment* segments, uint32_t segmentCount, const Triangle* triangles, uint32_t triangleCount, SegmentHit* hits) {
+	if (GetSimdLevel() == SimdLevel::AVX2) {
+		RaycastTrianglesPacket<8>(segments, segmentCount, triangles, triangleCount, hits);
+	}
+	else {
+		RaycastTrianglesPacket<4>(segments, segmentCount, triangles, triangleCount, hits);
+	}
+}
+
+//=================================================================================================
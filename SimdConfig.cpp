@@ -0,0 +1,55 @@
+#include "SimdConfig.h"
+
+//==================================== 使用する命令セットの判定 ===================================
+
+SimdLevel DetectSimdLevel() {
+#if MT3_SIMD_X86
+#if defined(_MSC_VER)
+	int info[4] = {};
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	bool sse41 = (info[2] & (1 << 19)) != 0;
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+
+	bool avx2 = false;
+	if (maxLeaf >= 7 && osxsave && avx) {
+		// OSがYMMレジスタの退避に対応しているか
+		if ((_xgetbv(0) & 0x6) == 0x6) {
+			__cpuidex(info, 7, 0);
+			avx2 = (info[1] & (1 << 5)) != 0;
+		}
+	}
+#else
+	__builtin_cpu_init();
+	bool sse41 = __builtin_cpu_supports("sse4.1");
+	bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+	if (avx2 && sse41) {
+		return SimdLevel::AVX2;
+	}
+	if (sse41) {
+		return SimdLevel::SSE41;
+	}
+#endif
+	return SimdLevel::Scalar;
+}
+
+// 判定結果はプロセスで1つだけ持つ
+static SimdLevel& CurrentSimdLevel() {
+	static SimdLevel level = DetectSimdLevel();
+	return level;
+}
+
+SimdLevel GetSimdLevel() {
+	return CurrentSimdLevel();
+}
+
+void SetSimdLevel(SimdLevel level) {
+	SimdLevel supported = DetectSimdLevel();
+	CurrentSimdLevel() = (level > supported) ? supported : level;
+}
+
+//=================================================================================================
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+
+//====================================== SIMD命令の設定 ===========================================
+
+// x86/x64 のときだけ SSE/AVX の組み込み関数を使う
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define MT3_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define MT3_SIMD_X86 0
+#endif
+
+// GCC/Clang ではコンパイルオプションより上の命令を使う関数に target 属性が必要
+// (MSVC は属性なしで組み込み関数を使える)
+#if MT3_SIMD_X86 && (defined(__GNUC__) || defined(__clang__))
+#define SIMD_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SIMD_TARGET_SSE41
+#define SIMD_TARGET_AVX2
+#endif
+
+//=================================================================================================
+
+
+//==================================== 使用する命令セットの判定 ===================================
+
+enum class SimdLevel {
+	Scalar,  //!< SIMDを使わない
+	SSE41,   //!< SSE4.1 (4要素)
+	AVX2,    //!< AVX2 (8要素)
+};
+
+// CPUIDで実行中のCPUが対応している命令セットを調べる
+SimdLevel DetectSimdLevel();
+
+// 起動時に判定した命令セットを返す
+SimdLevel GetSimdLevel();
+
+// 比較・デバッグ用に命令セットを下げる (CPUが対応していない命令セットには上げられない)
+void SetSimdLevel(SimdLevel level);
+
+//=================================================================================================
@@ -0,0 +1,471 @@
+#include "SoftwareRasterizer.h"
+#include "SimdConfig.h"
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+
+//========================================  座標の範囲  ============================================
+// 整数の計算が64ビットで溢れないように、これより外の座標は描く前に切り取る
+// (ニアクリップ面の近くで画面外へ大きくはみ出した線など。画面内のピクセルは変わらない)
+
+static const int32_t kGuardBand = 1 << 20;
+
+static bool IsInsideGuardBand(int32_t x, int32_t y) {
+	return x >= -kGuardBand && x <= kGuardBand && y >= -kGuardBand && y <= kGuardBand;
+}
+
+// Liang-Barsky 法で線分を [-kGuardBand, kGuardBand] の正方形に切り取る。全て外なら false
+static bool ClipToGuardBand(int32_t& x0, int32_t& y0, int32_t& x1, int32_t& y1) {
+	double dx = double(x1) - x0;
+	double dy = double(y1) - y0;
+	double p[4] = { -dx, dx, -dy, dy };
+	double q[4] = { double(x0) + kGuardBand, double(kGuardBand) - x0, double(y0) + kGuardBand, double(kGuardBand) - y0 };
+	double tMin = 0.0;
+	double tMax = 1.0;
+	for (int i = 0; i < 4; ++i) {
+		if (p[i] == 0.0) {
+			if (q[i] < 0.0) {
+				return false;
+			}
+			continue;
+		}
+		double t = q[i] / p[i];
+		if (p[i] < 0.0) {
+			tMin = (std::max)(tMin, t);
+		} else {
+			tMax = (std::min)(tMax, t);
+		}
+	}
+	if (tMin > tMax) {
+		return false;
+	}
+	double startX = x0, startY = y0;
+	x0 = int32_t(std::lround(startX + dx * tMin));
+	y0 = int32_t(std::lround(startY + dy * tMin));
+	x1 = int32_t(std::lround(startX + dx * tMax));
+	y1 = int32_t(std::lround(startY + dy * tMax));
+	return true;
+}
+
+//=================================================================================================
+
+
+//====================================  図形の追加・振り分け  =======================================
+
+SoftwareRasterizer::SoftwareRasterizer(Framebuffer& framebuffer, uint32_t tileSize)
+	: framebuffer_(framebuffer), tileSize_(tileSize) {
+	tileCountX_ = (framebuffer.GetWidth() + tileSize - 1) / tileSize;
+	tileCountY_ = (framebuffer.GetHeight() + tileSize - 1) / tileSize;
+	bins_.resize(GetTileCount());
+}
+
+void SoftwareRasterizer::DrawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t color) {
+	if (!IsInsideGuardBand(x0, y0) || !IsInsideGuardBand(x1, y1)) {
+		if (!ClipToGuardBand(x0, y0, x1, y1)) {
+			return;
+		}
+	}
+	Primitive line = { { x0, x1, 0 }, { y0, y1, 0 }, color, kPrimitiveLine };
+	Add(line, { (std::min)(x0, x1), (std::min)(y0, y1), (std::max)(x0, x1), (std::max)(y0, y1) });
+}
+
+void SoftwareRasterizer::DrawTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t color, RasterFillMode fillMode) {
+	if (fillMode == kRasterFillWireFrame) {
+		DrawLine(x0, y0, x1, y1, color);
+		DrawLine(x1, y1, x2, y2, color);
+		DrawLine(x2, y2, x0, y0, color);
+		return;
+	}
+	// 塗りつぶしは辺の式を64ビットで計算するので、範囲外の頂点を含む三角形は描かない
+	if (!IsInsideGuardBand(x0, y0) || !IsInsideGuardBand(x1, y1) || !IsInsideGuardBand(x2, y2)) {
+		return;
+	}
+	Primitive triangle = { { x0, x1, x2 }, { y0, y1, y2 }, color, kPrimitiveTriangle };
+	Add(triangle, { (std::min)({ x0, x1, x2 }), (std::min)({ y0, y1, y2 }), (std::max)({ x0, x1, x2 }), (std::max)({ y0, y1, y2 }) });
+}
+
+// 画面と重なる範囲のタイルに振り分ける
+void SoftwareRasterizer::Add(const Primitive& primitive, Rect bounds) {
+	int32_t width = int32_t(framebuffer_.GetWidth());
+	int32_t height = int32_t(framebuffer_.GetHeight());
+	if (bounds.maxX < 0 || bounds.maxY < 0 || bounds.minX >= width || bounds.minY >= height) {
+		return;
+	}
+	uint32_t tileMinX = uint32_t((std::max)(bounds.minX, 0)) / tileSize_;
+	uint32_t tileMinY = uint32_t((std::max)(bounds.minY, 0)) / tileSize_;
+	uint32_t tileMaxX = uint32_t((std::min)(bounds.maxX, width - 1)) / tileSize_;
+	uint32_t tileMaxY = uint32_t((std::min)(bounds.maxY, height - 1)) / tileSize_;
+
+	uint32_t index = GetPrimitiveCount();
+	primitives_.push_back(primitive);
+	for (uint32_t tileY = tileMinY; tileY <= tileMaxY; ++tileY) {
+		for (uint32_t tileX = tileMinX; tileX <= tileMaxX; ++tileX) {
+			bins_[tileY * tileCountX_ + tileX].push_back(index);
+		}
+	}
+}
+
+//=================================================================================================
+
+
+//=========================================  描画  ================================================
+
+void SoftwareRasterizer::Render(JobSystem* jobSystem) {
+	if (jobSystem != nullptr && jobSystem->GetThreadCount() > 1) {
+		jobSystem->ParallelFor(GetTileCount(), 1, [this](uint32_t begin, uint32_t end) {
+			for (uint32_t tile = begin; tile < end; ++tile) {
+				RasterizeTile(tile);
+			}
+		});
+	} else {
+		for (uint32_t tile = 0; tile < GetTileCount(); ++tile) {
+			RasterizeTile(tile);
+		}
+	}
+
+	// 容量は残すので、次のフレームからは確保しない
+	primitives_.clear();
+	for (std::vector<uint32_t>& bin : bins_) {
+		bin.clear();
+	}
+}
+
+void SoftwareRasterizer::RasterizeTile(uint32_t tile) {
+	int32_t minX = int32_t(tile % tileCountX_ * tileSize_);
+	int32_t minY = int32_t(tile / tileCountX_ * tileSize_);
+	Rect rect = {
+		minX, minY,
+		(std::min)(minX + int32_t(tileSize_), int32_t(framebuffer_.GetWidth())) - 1,
+		(std::min)(minY + int32_t(tileSize_), int32_t(framebuffer_.GetHeight())) - 1,
+	};
+	for (uint32_t index : bins_[tile]) {
+		const Primitive& primitive = primitives_[index];
+		if (primitive.type == kPrimitiveLine) {
+			RasterizeLine(primitive, rect);
+		} else {
+			RasterizeTriangle(primitive, rect);
+		}
+	}
+}
+
+//=================================================================================================
+
+
+//=========================================  線分  ================================================
+// 長い方の軸 (主軸) に1ピクセルずつ進み、i 歩目の短い方の軸の座標を
+//   minor = minor0 + 符号 * floor((2 i |dMinor| + |dMajor|) / (2 |dMajor|))   (四捨五入)
+// で決める。タイルの中に入る i から始めるときは最初だけ割り算で求め、後はブレゼンハムと同じく誤差を足していく
+// (どこから始めても同じピクセルになるので、タイルの分け方で結果が変わらない)
+
+void SoftwareRasterizer::RasterizeLine(const Primitive& line, const Rect& tile) {
+	int32_t x0 = line.x[0], y0 = line.y[0], x1 = line.x[1], y1 = line.y[1];
+	bool xMajor = std::abs(int64_t(x1) - x0) >= std::abs(int64_t(y1) - y0);
+	// 主軸を (major, minor) にそろえ、主軸の向きが正になるように端点を入れ替える
+	int64_t major0 = xMajor ? x0 : y0, major1 = xMajor ? x1 : y1;
+	int64_t minor0 = xMajor ? y0 : x0, minor1 = xMajor ? y1 : x1;
+	if (major1 < major0) {
+		std::swap(major0, major1);
+		std::swap(minor0, minor1);
+	}
+	int64_t tileMajorMin = xMajor ? tile.minX : tile.minY, tileMajorMax = xMajor ? tile.maxX : tile.maxY;
+	int64_t tileMinorMin = xMajor ? tile.minY : tile.minX, tileMinorMax = xMajor ? tile.maxY : tile.maxX;
+
+	int64_t majorLength = major1 - major0;
+	int64_t minorLength = std::abs(minor1 - minor0);
+	int64_t minorStep = minor1 < minor0 ? -1 : 1;
+
+	int64_t begin = (std::max)(int64_t(0), tileMajorMin - major0);
+	int64_t end = (std::min)(majorLength, tileMajorMax - major0);
+	if (begin > end) {
+		return;
+	}
+
+	int64_t denominator = 2 * majorLength;
+	int64_t offset = 0;
+	int64_t error = 0;
+	if (denominator != 0) {
+		int64_t numerator = 2 * begin * minorLength + majorLength;
+		offset = numerator / denominator;
+		error = numerator % denominator;
+	}
+
+	for (int64_t i = begin; i <= end; ++i) {
+		int64_t minor = minor0 + minorStep * offset;
+		if (minor >= tileMinorMin && minor <= tileMinorMax) {
+			int64_t major = major0 + i;
+			uint32_t x = uint32_t(xMajor ? major : minor);
+			uint32_t y = uint32_t(xMajor ? minor : major);
+			framebuffer_.GetRow(y)[x] = line.color;
+		} else if ((minorStep > 0 && minor > tileMinorMax) || (minorStep < 0 && minor < tileMinorMin)) {
+			break;  // この先はずっとタイルの外
+		}
+		error += 2 * minorLength;
+		if (error >= denominator) {
+			error -= denominator;
+			++offset;
+		}
+	}
+}
+
+//=================================================================================================
+
+
+//==================================  三角形 (1行分の塗りつぶし)  ===================================
+// edge[k] は x = begin のピクセルの中心での各辺の式の値、step[k] は x が1増えたときの変化量
+// 3つとも0以上 (符号ビットが全て0) なら内側。値は64ビットなので、SSE は2ピクセル、AVX2 は4ピクセルずつ調べる
+// SIMD版は処理したピクセル数を返し、残りはスカラー版で塗る
+
+static void FillSpanScalar(uint32_t* row, int32_t begin, int32_t end, const int64_t edge[3], const int64_t step[3], uint32_t color) {
+	int64_t e0 = edge[0], e1 = edge[1], e2 = edge[2];
+	for (int32_t x = begin; x <= end; ++x) {
+		if ((e0 | e1 | e2) >= 0) {
+			row[x] = color;
+		}
+		e0 += step[0];
+		e1 += step[1];
+		e2 += step[2];
+	}
+}
+
+#if MT3_SIMD_X86
+SIMD_TARGET_SSE41
+static int32_t FillSpanSSE(uint32_t* row, int32_t begin, int32_t end, const int64_t edge[3], const int64_t step[3], uint32_t color) {
+	const int32_t kLanes = 2;
+	int32_t count = (end - begin + 1) / kLanes * kLanes;
+	__m128i e0 = _mm_add_epi64(_mm_set1_epi64x(edge[0]), _mm_set_epi64x(step[0], 0));
+	__m128i e1 = _mm_add_epi64(_mm_set1_epi64x(edge[1]), _mm_set_epi64x(step[1], 0));
+	__m128i e2 = _mm_add_epi64(_mm_set1_epi64x(edge[2]), _mm_set_epi64x(step[2], 0));
+	const __m128i s0 = _mm_set1_epi64x(step[0] * kLanes);
+	const __m128i s1 = _mm_set1_epi64x(step[1] * kLanes);
+	const __m128i s2 = _mm_set1_epi64x(step[2] * kLanes);
+	for (int32_t i = 0; i < count; i += kLanes) {
+		// 符号ビットが立っているレーンが外側
+		int outside = _mm_movemask_pd(_mm_castsi128_pd(_mm_or_si128(_mm_or_si128(e0, e1), e2)));
+		if (outside != 0x3) {
+			for (int32_t lane = 0; lane < kLanes; ++lane) {
+				if ((outside & (1 << lane)) == 0) {
+					row[begin + i + lane] = color;
+				}
+			}
+		}
+		e0 = _mm_add_epi64(e0, s0);
+		e1 = _mm_add_epi64(e1, s1);
+		e2 = _mm_add_epi64(e2, s2);
+	}
+	return count;
+}
+
+SIMD_TARGET_AVX2
+static int32_t FillSpanAVX2(uint32_t* row, int32_t begin, int32_t end, const int64_t edge[3], const int64_t step[3], uint32_t color) {
+	const int32_t kLanes = 4;
+	int32_t count = (end - begin + 1) / kLanes * kLanes;
+	__m256i e0 = _mm256_add_epi64(_mm256_set1_epi64x(edge[0]), _mm256_set_epi64x(step[0] * 3, step[0] * 2, step[0], 0));
+	__m256i e1 = _mm256_add_epi64(_mm256_set1_epi64x(edge[1]), _mm256_set_epi64x(step[1] * 3, step[1] * 2, step[1], 0));
+	__m256i e2 = _mm256_add_epi64(_mm256_set1_epi64x(edge[2]), _mm256_set_epi64x(step[2] * 3, step[2] * 2, step[2], 0));
+	const __m256i s0 = _mm256_set1_epi64x(step[0] * kLanes);
+	const __m256i s1 = _mm256_set1_epi64x(step[1] * kLanes);
+	const __m256i s2 = _mm256_set1_epi64x(step[2] * kLanes);
+	const __m128i colors = _mm_set1_epi32(int(color));
+	// 各64ビットレーンの上位32ビット (符号を含む) を下位4要素に集める
+	const __m256i gatherHigh = _mm256_set_epi32(7, 5, 3, 1, 7, 5, 3, 1);
+	for (int32_t i = 0; i < count; i += kLanes) {
+		__m256i outside = _mm256_or_si256(_mm256_or_si256(e0, e1), e2);
+		// 符号ビットが0のレーンだけ書く (maskstore はマスクの最上位ビットが1の要素を書く)
+		__m128i mask = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(outside, gatherHigh));
+		mask = _mm_xor_si128(mask, _mm_set1_epi32(-1));
+		_mm_maskstore_epi32(reinterpret_cast<int*>(row + begin + i), mask, colors);
+		e0 = _mm256_add_epi64(e0, s0);
+		e1 = _mm256_add_epi64(e1, s1);
+		e2 = _mm256_add_epi64(e2, s2);
+	}
+	return count;
+}
+#endif
+
+static void FillSpan(uint32_t* row, int32_t begin, int32_t end, const int64_t edge[3], const int64_t step[3], uint32_t color) {
+	int32_t count = 0;
+	switch (GetSimdLevel()) {
+#if MT3_SIMD_X86
+	case SimdLevel::AVX2:
+		count = FillSpanAVX2(row, begin, end, edge, step, color);
+		break;
+	case SimdLevel::SSE41:
+		count = FillSpanSSE(row, begin, end, edge, step, color);
+		break;
+#endif
+	default:
+		break;
+	}
+	if (begin + count <= end) {
+		int64_t rest[3] = { edge[0] + step[0] * count, edge[1] + step[1] * count, edge[2] + step[2] * count };
+		FillSpanScalar(row, begin + count, end, rest, step, color);
+	}
+}
+
+//=================================================================================================
+
+
+//======================================  三角形の塗りつぶし  ======================================
+// 辺 a → b の式 E(p) = (bx - ax)(py - ay) - (by - ay)(px - ax) をピクセルの中心 (x + 0.5, y + 0.5) で求める
+// 0.5 を整数で扱うため、座標を全て2倍して計算する
+// 辺の上のピクセルは上の辺と左の辺だけに含め、隣り合う三角形で二重に塗らない (トップレフトルール)
+
+void SoftwareRasterizer::RasterizeTriangle(const Primitive& triangle, const Rect& tile) {
+	int64_t x[3] = { triangle.x[0], triangle.x[1], triangle.x[2] };
+	int64_t y[3] = { triangle.y[0], triangle.y[1], triangle.y[2] };
+	// 内側で E が正になる向き (画面上で時計回り) にそろえる
+	int64_t area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+	if (area == 0) {
+		return;
+	}
+	if (area < 0) {
+		std::swap(x[1], x[2]);
+		std::swap(y[1], y[2]);
+	}
+
+	int32_t minX = (std::max)(tile.minX, int32_t((std::min)({ x[0], x[1], x[2] })));
+	int32_t maxX = (std::min)(tile.maxX, int32_t((std::max)({ x[0], x[1], x[2] })));
+	int32_t minY = (std::max)(tile.minY, int32_t((std::min)({ y[0], y[1], y[2] })));
+	int32_t maxY = (std::min)(tile.maxY, int32_t((std::max)({ y[0], y[1], y[2] })));
+	if (minX > maxX || minY > maxY) {
+		return;
+	}
+
+	int64_t rowEdge[3];
+	int64_t stepX[3];
+	int64_t stepY[3];
+	for (int k = 0; k < 3; ++k) {
+		int a = k, b = (k + 1) % 3;
+		int64_t dx = x[b] - x[a];
+		int64_t dy = y[b] - y[a];
+		bool topLeft = (dy == 0 && dx > 0) || dy < 0;
+		// (minX, minY) のピクセルの中心での値。上・左の辺でなければ、辺の上 (0) を外側にする
+		rowEdge[k] = dx * (2 * int64_t(minY) + 1 - 2 * y[a]) - dy * (2 * int64_t(minX) + 1 - 2 * x[a]) - (topLeft ? 0 : 1);
+		stepX[k] = -2 * dy;
+		stepY[k] = 2 * dx;
+	}
+
+	for (int32_t py = minY; py <= maxY; ++py) {
+		FillSpan(framebuffer_.GetRow(uint32_t(py)), minX, maxX, rowEdge, stepX, triangle.color);
+		for (int k = 0; k < 3; ++k) {
+			rowEdge[k] += stepY[k];
+		}
+	}
+}
+
+//=================================================================================================
+
+
+//=====================================  画像の書き出し  ===========================================
+
+bool Framebuffer::WritePPM(const std::string& path) const {
+	std::ofstream file(path, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+	file << "P6\n" << width_ << " " << height_ << "\n255\n";
+	std::vector<char> bytes(pixels_.size() * 3);
+	for (size_t i = 0; i < pixels_.size(); ++i) {
+		bytes[i * 3 + 0] = char(pixels_[i] >> 24);
+		bytes[i * 3 + 1] = char(pixels_[i] >> 16);
+		bytes[i * 3 + 2] = char(pixels_[i] >> 8);
+	}
+	file.write(bytes.data(), std::streamsize(bytes.size()));
+	return bool(file);
+}
+
+// PNG のチャンクの CRC
+static uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc = 0) {
+	static const std::vector<uint32_t> table = [] {
+		std::vector<uint32_t> result(256);
+		for (uint32_t n = 0; n < 256; ++n) {
+			uint32_t c = n;
+			for (int k = 0; k < 8; ++k) {
+				c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			}
+			result[n] = c;
+		}
+		return result;
+	}();
+	crc = ~crc;
+	for (size_t i = 0; i < size; ++i) {
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+static void AppendBigEndian(std::vector<uint8_t>& out, uint32_t value) {
+	out.push_back(uint8_t(value >> 24));
+	out.push_back(uint8_t(value >> 16));
+	out.push_back(uint8_t(value >> 8));
+	out.push_back(uint8_t(value));
+}
+
+static void AppendChunk(std::vector<uint8_t>& out, const char type[4], const std::vector<uint8_t>& data) {
+	AppendBigEndian(out, uint32_t(data.size()));
+	size_t begin = out.size();
+	out.insert(out.end(), type, type + 4);
+	out.insert(out.end(), data.begin(), data.end());
+	AppendBigEndian(out, Crc32(out.data() + begin, out.size() - begin));
+}
+
+bool Framebuffer::WritePNG(const std::string& path) const {
+	// 各行の先頭にフィルタの種類 (0 = なし) を付けた RGBA の並び
+	std::vector<uint8_t> raw;
+	raw.reserve(size_t(height_) * (width_ * 4 + 1));
+	for (uint32_t y = 0; y < height_; ++y) {
+		raw.push_back(0);
+		for (uint32_t x = 0; x < width_; ++x) {
+			AppendBigEndian(raw, GetPixel(x, y));
+		}
+	}
+
+	// zlib の無圧縮ブロック (1ブロック 65535 バイトまで) と Adler-32
+	std::vector<uint8_t> zlib = { 0x78, 0x01 };
+	const size_t kBlockSize = 65535;
+	for (size_t begin = 0; begin < raw.size() || begin == 0; begin += kBlockSize) {
+		size_t size = (std::min)(kBlockSize, raw.size() - begin);
+		bool last = begin + size >= raw.size();
+		zlib.push_back(last ? 1 : 0);
+		zlib.push_back(uint8_t(size));
+		zlib.push_back(uint8_t(size >> 8));
+		zlib.push_back(uint8_t(~size));
+		zlib.push_back(uint8_t(~size >> 8));
+		zlib.insert(zlib.end(), raw.begin() + begin, raw.begin() + begin + size);
+		if (last) {
+			break;
+		}
+	}
+	uint32_t a = 1, b = 0;
+	for (uint8_t byte : raw) {
+		a = (a + byte) % 65521;
+		b = (b + a) % 65521;
+	}
+	AppendBigEndian(zlib, (b << 16) | a);
+
+	std::vector<uint8_t> header;
+	AppendBigEndian(header, width_);
+	AppendBigEndian(header, height_);
+	header.insert(header.end(), { 8, 6, 0, 0, 0 });  // 8ビット RGBA、圧縮・フィルタ・インターレースは標準
+
+	std::vector<uint8_t> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	AppendChunk(png, "IHDR", header);
+	AppendChunk(png, "IDAT", zlib);
+	AppendChunk(png, "IEND", {});
+
+	std::ofstream file(path, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+	file.write(reinterpret_cast<const char*>(png.data()), std::streamsize(png.size()));
+	return bool(file);
+}
+
+bool Framebuffer::Write(const std::string& path) const {
+	if (path.size() >= 4 && path.compare(path.size() - 4, 4, ".ppm") == 0) {
+		return WritePPM(path);
+	}
+	return WritePNG(path);
+}
+
+//=================================================================================================
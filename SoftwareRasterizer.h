@@ -0,0 +1,129 @@
+#pragma once
+#include "JobSystem.h"
+#include "LineBatch.h"
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Novice の DrawLine / DrawTriangle と同じ図形を CPU でメモリ上の画像 (Framebuffer) に描く
+// DirectX のない Linux でも main.cpp と同じ1フレームを描き、画像で比べたり速さを測ったりできる
+//
+//   Framebuffer framebuffer(1280, 720);
+//   SoftwareRasterizer rasterizer(framebuffer);
+//   RasterLineBackend lineBackend(rasterizer);
+//   lineBatch.Flush(lineBackend);   // 線分を rasterizer にためる
+//   rasterizer.Render(&jobSystem);  // タイルごとに並列に描く
+//   framebuffer.Write("frame.png");
+//
+// 画面をタイルに分け、図形を重なるタイルに振り分けてから、タイルごとに描く
+// 1つのピクセルを書くのは1つのタイルだけなので、スレッド数に関係なく結果は同じになる
+// 色は Novice と同じ 0xRRGGBBAA。アルファでの合成はせず、後から描いたもので上書きする
+
+
+//=====================================  画像  ====================================================
+
+class Framebuffer {
+public:
+	Framebuffer(uint32_t width, uint32_t height) : width_(width), height_(height), pixels_(size_t(width) * height) {}
+
+	void Clear(uint32_t color) { std::fill(pixels_.begin(), pixels_.end(), color); }
+
+	uint32_t GetWidth() const { return width_; }
+	uint32_t GetHeight() const { return height_; }
+	uint32_t GetPixel(uint32_t x, uint32_t y) const { return pixels_[size_t(y) * width_ + x]; }
+	uint32_t* GetRow(uint32_t y) { return pixels_.data() + size_t(y) * width_; }
+	const std::vector<uint32_t>& GetPixels() const { return pixels_; }
+
+	// バイナリ PPM (P6)。アルファは書き出さない
+	bool WritePPM(const std::string& path) const;
+	// RGBA の PNG (圧縮はしない)
+	bool WritePNG(const std::string& path) const;
+	// 拡張子が .ppm なら PPM、それ以外は PNG で書き出す
+	bool Write(const std::string& path) const;
+
+private:
+	uint32_t width_;
+	uint32_t height_;
+	std::vector<uint32_t> pixels_;
+};
+
+//=================================================================================================
+
+
+//==================================  ソフトウェアラスタライザ  ====================================
+
+// Novice の FillMode と同じ意味 (mt3_core は Novice に依存しないので別に用意する)
+enum RasterFillMode {
+	kRasterFillSolid,      //!< 塗りつぶし
+	kRasterFillWireFrame,  //!< ワイヤーフレーム
+};
+
+class SoftwareRasterizer {
+public:
+	explicit SoftwareRasterizer(Framebuffer& framebuffer, uint32_t tileSize = 64);
+
+	// 両端のピクセルも描く
+	void DrawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t color);
+	// 塗りつぶしはピクセルの中心が内側にあるものを描く (辺の上はトップレフトルール)
+	void DrawTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t color, RasterFillMode fillMode);
+
+	// ためた図形を描いた順に描いて空にする。jobSystem を渡すとタイルごとに並列に描く
+	void Render(JobSystem* jobSystem = nullptr);
+
+	uint32_t GetPrimitiveCount() const { return uint32_t(primitives_.size()); }
+	uint32_t GetTileCount() const { return tileCountX_ * tileCountY_; }
+
+private:
+	enum PrimitiveType : uint32_t {
+		kPrimitiveLine,
+		kPrimitiveTriangle,
+	};
+
+	struct Primitive {
+		int32_t x[3];
+		int32_t y[3];
+		uint32_t color;
+		PrimitiveType type;
+	};
+
+	// 両端を含む範囲
+	struct Rect {
+		int32_t minX, minY;
+		int32_t maxX, maxY;
+	};
+
+	void Add(const Primitive& primitive, Rect bounds);
+	void RasterizeTile(uint32_t tile);
+	void RasterizeLine(const Primitive& line, const Rect& tile);
+	void RasterizeTriangle(const Primitive& triangle, const Rect& tile);
+
+	Framebuffer& framebuffer_;
+	uint32_t tileSize_;
+	uint32_t tileCountX_;
+	uint32_t tileCountY_;
+	std::vector<Primitive> primitives_;
+	std::vector<std::vector<uint32_t>> bins_;  //!< タイルごとの、重なる図形の番号 (描いた順)
+};
+
+//=================================================================================================
+
+
+//===================================  LineBatch の描画側  ==========================================
+
+// LineBatch::Flush で渡された線分を SoftwareRasterizer にためる (描くのは Render)
+class RasterLineBackend : public LineBackend {
+public:
+	explicit RasterLineBackend(SoftwareRasterizer& rasterizer) : rasterizer_(rasterizer) {}
+
+	void Submit(const ScreenLine* lines, uint32_t count) override {
+		for (uint32_t i = 0; i < count; ++i) {
+			rasterizer_.DrawLine(lines[i].x0, lines[i].y0, lines[i].x1, lines[i].y1, lines[i].color);
+		}
+	}
+
+private:
+	SoftwareRasterizer& rasterizer_;
+};
+
+//=================================================================================================
@@ -0,0 +1,310 @@
+#pragma once
+#include "Geometry.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <vector>
+#include <cmath>
+#include <cstdint>
+
+// 大きさの近い大量の球のための空間ハッシュグリッド
+// 球の中心が入るセルのハッシュで計数ソートし、近くのセルだけを調べる
+// 詳細判定は距離の2乗で行い、sqrtは使わない
+//
+// 近くのセルを探す範囲は「調べる半径 + グリッドの中の一番大きい半径」なので、
+// 半径がセルの大きさより大きい球はグリッドに入れず、別の列にして1つずつ調べる
+// (大きな球が1つあるだけで、全ての問い合わせが広い範囲のセルを調べることにならないように)
+// 大きな球の列は全ての問い合わせで総当たりになるので、cellSize は多くの球が収まる大きさにする
+
+class SpatialHashGrid {
+public:
+	// cellSize は球の直径くらいにすると調べるセルが少なくなる
+	// tableSize は2のべき乗
+	explicit SpatialHashGrid(float cellSize = 1.0f, uint32_t tableSize = 1 << 16);
+
+	void SetCellSize(float cellSize) { cellSize_ = cellSize; invCellSize_ = 1.0f / cellSize; }
+	float GetCellSize() const { return cellSize_; }
+
+	// 球を登録し直す。jobSystem を渡すと並列に構築する
+	// 作業用の配列はメンバーに残しておき、毎回 (毎フレーム) 作り直しても確保しない
+	void Build(const Sphere* spheres, uint32_t count, JobSystem* jobSystem = nullptr);
+
+	// 球(center, radius)と重なる球の番号を列挙する
+	template <typename Callback>
+	void QueryNeighbors(const Vector3& center, float radius, Callback&& callback) const;
+
+	// 重なっている球の組を列挙する
+	template <typename Allocator>
+	void QueryOverlapPairs(std::vector<CollisionPair, Allocator>& pairs) const;
+
+	uint32_t GetCount() const { return uint32_t(spheres_.size() + largeSpheres_.size()); }
+	// グリッドに入れなかった (半径がセルの大きさより大きい) 球の数
+	uint32_t GetLargeCount() const { return uint32_t(largeSpheres_.size()); }
+
+private:
+	// 1つのジョブにまかせる最小の球の数
+	static const uint32_t kMinSpheresPerThread = 4096;
+	// hashes_ で、グリッドに入れない球の印
+	static const uint32_t kLargeSphere = UINT32_MAX;
+
+	int CellCoord(float value) const { return int(std::floor(value * invCellSize_)); }
+	uint32_t HashCell(int x, int y, int z) const {
+		return ((uint32_t(x) * 73856093u) ^ (uint32_t(y) * 19349663u) ^ (uint32_t(z) * 83492791u)) & (tableSize_ - 1);
+	}
+	bool IsLarge(float radius) const { return radius > cellSize_; }
+
+	template <typename Callback>
+	void ForEachInRange(const Vector3& center, float range, Callback&& callback) const;
+
+	struct Cell {
+		int x;
+		int y;
+		int z;
+	};
+
+	float cellSize_;
+	float invCellSize_;
+	uint32_t tableSize_;
+	float maxRadius_ = 0.0f;  //!< グリッドに入っている球の一番大きい半径 (セルの大きさ以下)
+
+	std::vector<uint32_t> bucketStart_;  //!< バケットごとの開始位置 (tableSize_ + 1 個)
+	std::vector<Sphere> spheres_;        //!< バケット順に並べた球
+	std::vector<uint32_t> ids_;          //!< spheres_ の元の番号
+	std::vector<Cell> cells_;            //!< spheres_ の中心が入っているセル
+
+	std::vector<Sphere> largeSpheres_;   //!< グリッドに入れなかった球 (元の番号順)
+	std::vector<uint32_t> largeIds_;     //!< largeSpheres_ の元の番号
+
+	// Build の作業用 (大きさが足りているときは確保し直さない)
+	std::vector<uint32_t> hashes_;        //!< 入力の球ごとのバケット (kLargeSphere ならグリッドに入れない)
+	std::vector<uint32_t> histograms_;    //!< ジョブごとに tableSize_ 個の、バケットごとの数 → 書き込み位置
+	std::vector<uint32_t> chunkLarge_;    //!< ジョブごとの大きな球の数 → 書き込み位置
+	std::vector<float> chunkMaxRadius_;   //!< ジョブごとのグリッドに入る球の一番大きい半径
+};
+
+
+//=================================  球同士の判定 (距離の2乗)  ========================================
+inline bool IsCollisionSphereSquared(const Vector3& c1, float r1, const Vector3& c2, float r2) {
+	float x = c2.x - c1.x;
+	float y = c2.y - c1.y;
+	float z = c2.z - c1.z;
+	float r = r1 + r2;
+	return x * x + y * y + z * z <= r * r;
+}
+//=================================================================================================
+
+
+inline SpatialHashGrid::SpatialHashGrid(float cellSize, uint32_t tableSize)
+	: cellSize_(cellSize), invCellSize_(1.0f / cellSize), tableSize_(tableSize) {
+	assert(tableSize != 0 && (tableSize & (tableSize - 1)) == 0);
+}
+
+//=======================================  並列構築  ==============================================
+// 1. 各ジョブが担当範囲のハッシュとバケットごとの数を数える
+// 2. バケットの範囲ごとに、各ジョブの書き込み位置 (バケットの中での位置) とバケットの大きさを決める
+// 3. バケットの大きさを足し合わせて各バケットの開始位置を決める (ここだけ1スレッド)
+// 4. 各ジョブが担当範囲を並べ替え先へ書き込む (ジョブ順に並ぶので結果はスレッド数によらない)
+inline void SpatialHashGrid::Build(const Sphere* spheres, uint32_t count, JobSystem* jobSystem) {
+	MT3_PROFILE_ZONE("SpatialHashGrid::Build");
+	uint32_t chunkCount = 1;
+	if (jobSystem != nullptr) {
+		chunkCount = (std::max)(1u, (std::min)(jobSystem->GetThreadCount(), count / kMinSpheresPerThread));
+	}
+	uint32_t chunk = (count + chunkCount - 1) / chunkCount;
+
+	if (hashes_.size() < count) {
+		hashes_.resize(count);
+	}
+	if (histograms_.size() < size_t(chunkCount) * tableSize_) {
+		histograms_.resize(size_t(chunkCount) * tableSize_);
+	}
+	chunkLarge_.assign(chunkCount, 0);
+	chunkMaxRadius_.assign(chunkCount, 0.0f);
+
+	// task(0) ～ task(taskCount - 1) を実行する
+	auto runParallel = [&](uint32_t taskCount, auto&& task) {
+		if (jobSystem != nullptr && taskCount > 1) {
+			jobSystem->ParallelFor(taskCount, 1, [&](uint32_t begin, uint32_t end) {
+				for (uint32_t t = begin; t < end; ++t) {
+					task(t);
+				}
+			});
+		} else {
+			for (uint32_t t = 0; t < taskCount; ++t) {
+				task(t);
+			}
+		}
+	};
+
+	// 1. 数える (自分のヒストグラムはそのジョブが0にする)
+	runParallel(chunkCount, [&](uint32_t t) {
+		uint32_t begin = (std::min)(count, t * chunk);
+		uint32_t end = (std::min)(count, begin + chunk);
+		uint32_t* histogram = histograms_.data() + size_t(t) * tableSize_;
+		std::fill(histogram, histogram + tableSize_, 0u);
+		for (uint32_t i = begin; i < end; ++i) {
+			if (IsLarge(spheres[i].radius)) {
+				hashes_[i] = kLargeSphere;
+				chunkLarge_[t]++;
+				continue;
+			}
+			const Vector3& c = spheres[i].center;
+			hashes_[i] = HashCell(CellCoord(c.x), CellCoord(c.y), CellCoord(c.z));
+			histogram[hashes_[i]]++;
+			chunkMaxRadius_[t] = (std::max)(chunkMaxRadius_[t], spheres[i].radius);
+		}
+	});
+
+	// 2. バケットの中での各ジョブの書き込み位置と、バケットの大きさ (bucketStart_ に一旦入れる)
+	bucketStart_.resize(tableSize_ + 1);
+	uint32_t bucketChunk = (tableSize_ + chunkCount - 1) / chunkCount;
+	runParallel(chunkCount, [&](uint32_t t) {
+		uint32_t begin = (std::min)(tableSize_, t * bucketChunk);
+		uint32_t end = (std::min)(tableSize_, begin + bucketChunk);
+		for (uint32_t bucket = begin; bucket < end; ++bucket) {
+			uint32_t size = 0;
+			for (uint32_t c = 0; c < chunkCount; ++c) {
+				uint32_t& n = histograms_[size_t(c) * tableSize_ + bucket];
+				uint32_t chunkSize = n;
+				n = size;
+				size += chunkSize;
+			}
+			bucketStart_[bucket] = size;
+		}
+	});
+
+	// 3. バケットの開始位置と、大きな球の書き込み位置
+	uint32_t offset = 0;
+	for (uint32_t bucket = 0; bucket < tableSize_; ++bucket) {
+		uint32_t size = bucketStart_[bucket];
+		bucketStart_[bucket] = offset;
+		offset += size;
+	}
+	bucketStart_[tableSize_] = offset;
+
+	uint32_t largeCount = 0;
+	maxRadius_ = 0.0f;
+	for (uint32_t t = 0; t < chunkCount; ++t) {
+		uint32_t n = chunkLarge_[t];
+		chunkLarge_[t] = largeCount;
+		largeCount += n;
+		maxRadius_ = (std::max)(maxRadius_, chunkMaxRadius_[t]);
+	}
+
+	// 4. 並べ替え先へ書き込む
+	spheres_.resize(offset);
+	ids_.resize(offset);
+	cells_.resize(offset);
+	largeSpheres_.resize(largeCount);
+	largeIds_.resize(largeCount);
+	runParallel(chunkCount, [&](uint32_t t) {
+		uint32_t begin = (std::min)(count, t * chunk);
+		uint32_t end = (std::min)(count, begin + chunk);
+		uint32_t* cursor = histograms_.data() + size_t(t) * tableSize_;
+		uint32_t largeCursor = chunkLarge_[t];
+		for (uint32_t i = begin; i < end; ++i) {
+			uint32_t hash = hashes_[i];
+			if (hash == kLargeSphere) {
+				largeSpheres_[largeCursor] = spheres[i];
+				largeIds_[largeCursor] = i;
+				++largeCursor;
+				continue;
+			}
+			uint32_t destination = bucketStart_[hash] + cursor[hash]++;
+			const Vector3& c = spheres[i].center;
+			spheres_[destination] = spheres[i];
+			ids_[destination] = i;
+			cells_[destination] = { CellCoord(c.x), CellCoord(c.y), CellCoord(c.z) };
+		}
+	});
+}
+//=================================================================================================
+
+//====================================  近くのセルを列挙  ============================================
+// center から range 以内の各セルについて、そのセルに入っている球の並べ替え後の番号を列挙する
+// 別のセルが同じバケットに入ることがあるので、セル座標が一致するものだけを渡す
+// 範囲のセルの数が球の数より多いとき (大きな球の問い合わせ) は、全ての球を渡す (呼び出し側で詳細判定する)
+template <typename Callback>
+void SpatialHashGrid::ForEachInRange(const Vector3& center, float range, Callback&& callback) const {
+	int minX = CellCoord(center.x - range), maxX = CellCoord(center.x + range);
+	int minY = CellCoord(center.y - range), maxY = CellCoord(center.y + range);
+	int minZ = CellCoord(center.z - range), maxZ = CellCoord(center.z + range);
+
+	double cellCount = (double(maxX) - minX + 1.0) * (double(maxY) - minY + 1.0) * (double(maxZ) - minZ + 1.0);
+	if (cellCount > double(spheres_.size())) {
+		for (uint32_t i = 0; i < uint32_t(spheres_.size()); ++i) {
+			callback(i);
+		}
+		return;
+	}
+
+	for (int z = minZ; z <= maxZ; ++z) {
+		for (int y = minY; y <= maxY; ++y) {
+			for (int x = minX; x <= maxX; ++x) {
+				uint32_t bucket = HashCell(x, y, z);
+				for (uint32_t i = bucketStart_[bucket]; i < bucketStart_[bucket + 1]; ++i) {
+					const Cell& cell = cells_[i];
+					if (cell.x == x && cell.y == y && cell.z == z) {
+						callback(i);
+					}
+				}
+			}
+		}
+	}
+}
+//=================================================================================================
+
+//=======================================  近くの球の列挙  ==========================================
+template <typename Callback>
+void SpatialHashGrid::QueryNeighbors(const Vector3& center, float radius, Callback&& callback) const {
+	if (!spheres_.empty()) {
+		ForEachInRange(center, radius + maxRadius_, [&](uint32_t i) {
+			if (IsCollisionSphereSquared(center, radius, spheres_[i].center, spheres_[i].radius)) {
+				callback(ids_[i]);
+			}
+		});
+	}
+	for (uint32_t i = 0; i < uint32_t(largeSpheres_.size()); ++i) {
+		if (IsCollisionSphereSquared(center, radius, largeSpheres_[i].center, largeSpheres_[i].radius)) {
+			callback(largeIds_[i]);
+		}
+	}
+}
+//=================================================================================================
+
+//===================================  重なっている組の列挙  ==========================================
+template <typename Allocator>
+inline void SpatialHashGrid::QueryOverlapPairs(std::vector<CollisionPair, Allocator>& pairs) const {
+	MT3_PROFILE_ZONE("SpatialHashGrid::QueryOverlapPairs");
+	auto addPair = [&](uint32_t a, uint32_t b) {
+		pairs.push_back({ (std::min)(a, b), (std::max)(a, b) });
+	};
+
+	// グリッドの球同士
+	for (uint32_t i = 0; i < uint32_t(spheres_.size()); ++i) {
+		const Sphere& sphere = spheres_[i];
+		ForEachInRange(sphere.center, sphere.radius + maxRadius_, [&](uint32_t j) {
+			// 並べ替え後の番号が自分より大きいものだけ調べ、同じ組を2回出さない
+			if (j > i && IsCollisionSphereSquared(sphere.center, sphere.radius, spheres_[j].center, spheres_[j].radius)) {
+				addPair(ids_[i], ids_[j]);
+			}
+		});
+	}
+
+	// 大きな球と、グリッドの球・大きな球
+	for (uint32_t i = 0; i < uint32_t(largeSpheres_.size()); ++i) {
+		const Sphere& sphere = largeSpheres_[i];
+		if (!spheres_.empty()) {
+			ForEachInRange(sphere.center, sphere.radius + maxRadius_, [&](uint32_t j) {
+				if (IsCollisionSphereSquared(sphere.center, sphere.radius, spheres_[j].center, spheres_[j].radius)) {
+					addPair(largeIds_[i], ids_[j]);
+				}
+			});
+		}
+		for (uint32_t j = i + 1; j < uint32_t(largeSpheres_.size()); ++j) {
+			if (IsCollisionSphereSquared(sphere.center, sphere.radius, largeSpheres_[j].center, largeSpheres_[j].radius)) {
+				addPair(largeIds_[i], largeIds_[j]);
+			}
+		}
+	}
+}
+//=================================================================================================
@@ -0,0 +1,133 @@
+#pragma once
+#include "ScreenTransform.h"
+#include "Geometry.h"
+#include <assert.h>
+#include <array>
+#include <numbers>
+#include <vector>
+
+// 球のワイヤーフレーム用の頂点・辺の表
+// 半径1・原点中心の球を分割数ごとに1回だけ作り、描画では拡大・平行移動の行列を掛けるだけにする
+// 頂点は 南極・緯線 (kSubdivision - 1 本) の各経度・北極 の順で、極は1点にまとめる
+// (緯度 -π/2 から、経度 0 から、それぞれ π/n, 2π/n ずつ。元の DrawSphere と同じ点になる)
+
+struct WireframeEdge {
+	uint16_t start;
+	uint16_t end;
+};
+
+struct SphereWireframe {
+	uint32_t subdivision = 0;
+	std::vector<Vector3> vertices;
+	std::vector<WireframeEdge> edges;
+};
+
+// 使う分割数 (画面上の大きさで選ぶ。段階を少なくして切り替わりを目立たなくする)
+static const std::array<uint32_t, 6> kSphereSubdivisionLevels = { 4, 8, 12, 16, 24, 32 };
+static const uint32_t kMaxSphereSubdivision = 32;
+static const uint32_t kMaxSphereVertices = 2 + kMaxSphereSubdivision * (kMaxSphereSubdivision - 1);
+static const float kSphereTolerance = 0.5f;  //!< 輪郭と折れ線のずれの許容量 (ピクセル)
+
+
+//===================================  単位球の表を作る  ===========================================
+inline SphereWireframe MakeUnitSphereWireframe(uint32_t subdivision) {
+	assert(subdivision >= 2 && subdivision <= kMaxSphereSubdivision);
+	const float kLonEvery = 2 * std::numbers::pi_v<float> / subdivision;  // 経度
+	const float kLatEvery = std::numbers::pi_v<float> / subdivision;      // 緯度
+
+	SphereWireframe result;
+	result.subdivision = subdivision;
+
+	// 頂点
+	result.vertices.push_back({ 0.0f, -1.0f, 0.0f });  // 南極
+	for (uint32_t latIndex = 1; latIndex < subdivision; ++latIndex) {
+		float lat = -std::numbers::pi_v<float> / 2.0f + kLatEvery * latIndex;
+		for (uint32_t lonIndex = 0; lonIndex < subdivision; ++lonIndex) {
+			float lon = lonIndex * kLonEvery;
+			result.vertices.push_back({ std::cos(lat) * std::cos(lon), std::sin(lat), std::cos(lat) * std::sin(lon) });
+		}
+	}
+	result.vertices.push_back({ 0.0f, 1.0f, 0.0f });  // 北極
+
+	auto ring = [subdivision](uint32_t latIndex, uint32_t lonIndex) {
+		return uint16_t(1 + (latIndex - 1) * subdivision + lonIndex % subdivision);
+	};
+	uint16_t northPole = uint16_t(result.vertices.size() - 1);
+
+	// 経線 (南極 → 各緯線 → 北極)
+	for (uint32_t lonIndex = 0; lonIndex < subdivision; ++lonIndex) {
+		result.edges.push_back({ 0, ring(1, lonIndex) });
+		for (uint32_t latIndex = 1; latIndex + 1 < subdivision; ++latIndex) {
+			result.edges.push_back({ ring(latIndex, lonIndex), ring(latIndex + 1, lonIndex) });
+		}
+		result.edges.push_back({ ring(subdivision - 1, lonIndex), northPole });
+	}
+	// 緯線
+	for (uint32_t latIndex = 1; latIndex < subdivision; ++latIndex) {
+		for (uint32_t lonIndex = 0; lonIndex < subdivision; ++lonIndex) {
+			result.edges.push_back({ ring(latIndex, lonIndex), ring(latIndex, lonIndex + 1) });
+		}
+	}
+	return result;
+}
+
+// 分割数ごとの表 (最初に呼ばれたときに全ての段階を作る)
+inline const SphereWireframe& GetUnitSphereWireframe(uint32_t subdivision) {
+	static const std::array<SphereWireframe, kSphereSubdivisionLevels.size()> wireframes = [] {
+		std::array<SphereWireframe, kSphereSubdivisionLevels.size()> result;
+		for (size_t i = 0; i < kSphereSubdivisionLevels.size(); ++i) {
+			result[i] = MakeUnitSphereWireframe(kSphereSubdivisionLevels[i]);
+		}
+		return result;
+	}();
+
+	// subdivision 以上で一番近い段階を使う
+	for (const SphereWireframe& wireframe : wireframes) {
+		if (wireframe.subdivision >= subdivision) {
+			return wireframe;
+		}
+	}
+	return wireframes.back();
+}
+//=================================================================================================
+
+
+//=====================================  詳細度の選択  =============================================
+
+// 球の画面上の半径 (ピクセル) のおおよその値
+// 中心でのスクリーン座標のヤコビアンから、ワールドの各軸方向の長さ1が何ピクセルになるかを求め、最大のものを使う
+// 中心がカメラの後ろにあるときは負の値を返す
+inline float ProjectedSphereRadius(const Sphere& sphere, const ScreenTransform& screen) {
+	const Matrix4x4& m = screen.matrix;
+	const Vector3& c = sphere.center;
+	float x = c.x * m.m[0][0] + c.y * m.m[1][0] + c.z * m.m[2][0] + m.m[3][0];
+	float y = c.x * m.m[0][1] + c.y * m.m[1][1] + c.z * m.m[2][1] + m.m[3][1];
+	float w = c.x * m.m[0][3] + c.y * m.m[1][3] + c.z * m.m[2][3] + m.m[3][3];
+	if (w <= 0.0f) {
+		return -1.0f;
+	}
+	float invW = 1.0f / w;
+	float screenX = x * invW;
+	float screenY = y * invW;
+
+	float maxScale2 = 0.0f;
+	for (int axis = 0; axis < 3; ++axis) {
+		float dx = (m.m[axis][0] - screenX * m.m[axis][3]) * invW;
+		float dy = (m.m[axis][1] - screenY * m.m[axis][3]) * invW;
+		maxScale2 = (std::max)(maxScale2, dx * dx + dy * dy);
+	}
+	return sphere.radius * std::sqrt(maxScale2);
+}
+
+// 輪郭のずれが tolerance ピクセル以下になる分割数
+// 円を n 角形で近似したときのずれは r(1 - cos(π/n)) ≒ rπ^2 / (2n^2) なので n = π sqrt(r / (2 tolerance))
+inline uint32_t SelectSphereSubdivision(const Sphere& sphere, const ScreenTransform& screen, float tolerance = kSphereTolerance) {
+	float radius = ProjectedSphereRadius(sphere, screen);
+	if (radius < 0.0f) {
+		return kMaxSphereSubdivision;  // カメラの後ろ・近すぎる (大きさが分からないので一番細かくする)
+	}
+	float n = std::numbers::pi_v<float> * std::sqrt(radius / (2.0f * tolerance));
+	return GetUnitSphereWireframe(uint32_t(std::ceil((std::min)(n, float(kMaxSphereSubdivision))))).subdivision;
+}
+
+//=================================================================================================
@@ -0,0 +1,171 @@
+#pragma once
+#include "Arena.h"
+#include "Geometry.h"
+#include "Profiler.h"
+#include <vector>
+#include <unordered_set>
+#include <cstdint>
+
+// 移動するAABBのためのブロードフェーズ (Sweep and Prune)
+// 各軸の端点(min/max)の並びをフレームをまたいで保持し、毎フレーム挿入ソートで並べ直す
+// 少しずつしか動かない物体なら入れ替えはほとんど起きないので、ほぼ線形時間で候補の組を更新できる
+// 出力した組は isCollisionAABB などの詳細判定に渡す
+
+class SweepAndPrune {
+public:
+	// AABBを登録して番号を返す
+	uint32_t Add(const AABB& aabb);
+	// 登録を外す。外した番号は次の Add で再利用される
+	void Remove(uint32_t id);
+	// AABBを更新する (並べ直しは UpdatePairs で行う)
+	void Update(uint32_t id, const AABB& aabb);
+
+	// 端点を並べ直し、重なっている組を更新する。毎フレーム1回呼ぶ
+	void UpdatePairs();
+
+	SweepAndPrune() = default;
+	// 組の集合がメンバーのプールを指しているのでコピー・ムーブはしない
+	SweepAndPrune(const SweepAndPrune&) = delete;
+	SweepAndPrune& operator=(const SweepAndPrune&) = delete;
+
+	// 重なっている組を pairs の後ろに追加する
+	template <typename Allocator>
+	void GetPairs(std::vector<CollisionPair, Allocator>& pairs) const;
+
+	template <typename Callback>
+	void ForEachPair(Callback&& callback) const {
+		for (uint64_t key : pairs_) {
+			callback(uint32_t(key >> 32), uint32_t(key & 0xFFFFFFFF));
+		}
+	}
+
+	uint32_t GetPairCount() const { return uint32_t(pairs_.size()); }
+	const AABB& GetAABB(uint32_t id) const { return boxes_[id]; }
+
+private:
+	static const uint32_t kMaxFlag = 0x80000000;
+
+	struct Endpoint {
+		float value;
+		uint32_t data;  //!< 下位31bit: 番号 / 最上位bit: maxの端点なら1
+	};
+
+	static bool IsMax(const Endpoint& endpoint) { return (endpoint.data & kMaxFlag) != 0; }
+	static uint32_t GetId(const Endpoint& endpoint) { return endpoint.data & ~kMaxFlag; }
+	static uint64_t MakeKey(uint32_t a, uint32_t b) {
+		return (a < b) ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+	}
+
+	void SortAxis(int axis);
+
+	std::vector<Endpoint> axes_[3];      //!< 軸ごとの端点 (値の小さい順)
+	std::vector<AABB> boxes_;            //!< 番号ごとのAABB
+	std::vector<uint32_t> freeIds_;      //!< 再利用できる番号
+	// 重なっている組 (小さい番号を上位32bitに入れる)
+	// 毎フレーム挿入・削除されるので、ノードはプールから確保する (32バイトあれば主要な実装のノードが収まる)
+	FixedBlockPool pairNodePool_{ 32 };
+	std::pmr::unordered_set<uint64_t> pairs_{ &pairNodePool_ };
+};
+
+
+//=======================================  登録と更新  ============================================
+inline uint32_t SweepAndPrune::Add(const AABB& aabb) {
+	uint32_t id;
+	if (!freeIds_.empty()) {
+		id = freeIds_.back();
+		freeIds_.pop_back();
+		boxes_[id] = aabb;
+	}
+	else {
+		id = uint32_t(boxes_.size());
+		boxes_.push_back(aabb);
+	}
+
+	// 末尾(=無限遠)に追加しておけば、次の UpdatePairs の並べ直しで重なりが検出される
+	for (int axis = 0; axis < 3; ++axis) {
+		axes_[axis].push_back({ 0.0f, id });
+		axes_[axis].push_back({ 0.0f, id | kMaxFlag });
+	}
+	return id;
+}
+
+inline void SweepAndPrune::Remove(uint32_t id) {
+	for (int axis = 0; axis < 3; ++axis) {
+		std::vector<Endpoint>& endpoints = axes_[axis];
+		endpoints.erase(std::remove_if(endpoints.begin(), endpoints.end(), [id](const Endpoint& endpoint) {
+			return GetId(endpoint) == id;
+		}), endpoints.end());
+	}
+	for (auto it = pairs_.begin(); it != pairs_.end();) {
+		if (uint32_t(*it >> 32) == id || uint32_t(*it & 0xFFFFFFFF) == id) {
+			it = pairs_.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+	freeIds_.push_back(id);
+}
+
+inline void SweepAndPrune::Update(uint32_t id, const AABB& aabb) {
+	boxes_[id] = aabb;
+}
+//=================================================================================================
+
+//==================================  挿入ソートと組の更新  ===========================================
+inline void SweepAndPrune::SortAxis(int axis) {
+	std::vector<Endpoint>& endpoints = axes_[axis];
+
+	// 新しい座標を端点に書き写す
+	for (Endpoint& endpoint : endpoints) {
+		const AABB& box = boxes_[GetId(endpoint)];
+		endpoint.value = IsMax(endpoint) ? (&box.max.x)[axis] : (&box.min.x)[axis];
+	}
+
+	// 同じ値なら min を先にして、接しているだけの組も重なりとして扱う (isCollisionAABB と同じ)
+	auto less = [](const Endpoint& a, const Endpoint& b) {
+		return a.value < b.value || (a.value == b.value && !IsMax(a) && IsMax(b));
+	};
+
+	for (size_t i = 1; i < endpoints.size(); ++i) {
+		Endpoint current = endpoints[i];
+		size_t j = i;
+		while (j > 0 && less(current, endpoints[j - 1])) {
+			const Endpoint& previous = endpoints[j - 1];
+			uint32_t a = GetId(current);
+			uint32_t b = GetId(previous);
+			if (a != b) {
+				if (!IsMax(current) && IsMax(previous)) {
+					// minがmaxを追い越した → この軸で重なり始めた
+					if (isCollisionAABB(boxes_[a], boxes_[b])) {
+						pairs_.insert(MakeKey(a, b));
+					}
+				}
+				else if (IsMax(current) && !IsMax(previous)) {
+					// maxがminを追い越した → この軸で離れた
+					pairs_.erase(MakeKey(a, b));
+				}
+			}
+			endpoints[j] = previous;
+			--j;
+		}
+		endpoints[j] = current;
+	}
+}
+
+inline void SweepAndPrune::UpdatePairs() {
+	MT3_PROFILE_ZONE("SweepAndPrune::UpdatePairs");
+	for (int axis = 0; axis < 3; ++axis) {
+		SortAxis(axis);
+	}
+}
+
+template <typename Allocator>
+inline void SweepAndPrune::GetPairs(std::vector<CollisionPair, Allocator>& pairs) const {
+	MT3_PROFILE_ZONE("SweepAndPrune::GetPairs");
+	pairs.reserve(pairs.size() + pairs_.size());
+	ForEachPair([&](uint32_t a, uint32_t b) {
+		pairs.push_back({ a, b });
+	});
+}
+//=================================================================================================
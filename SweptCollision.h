@@ -0,0 +1,496 @@
+#pragma once
+#include "CollisionWorld.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+
+// 連続衝突判定 (CCD)。図形を move だけ動かしたとき、最初にぶつかる時刻・法線・接触点を求める
+// IsCollisionSphere などの「その瞬間に重なっているか」の判定では、速いものが薄い壁をすり抜ける
+// (1フレームに何回も細かく動かして判定する代わりに、1回で求める)
+//
+//   Vector3 move = MultiplyVector(deltaTime, velocity);
+//   SweepHit hit;
+//   if (SweepSphereVsPlane(sphere, move, plane, hit)) {
+//       move = MultiplyVector(hit.time, move);  // ぶつかった位置まで動かす
+//   }
+//   sphere.center = AddVector(sphere.center, move);
+//
+// 時刻 time は移動量に対する割合 (0 ～ 1)。始めから重なっているときは 0 になる
+// 法線 normal は相手の表面から動いている側を向く単位ベクトル、接触点 point はその時刻の相手の表面上の点
+
+
+struct SweepHit {
+	float time;      //!< 0 ～ 1
+	Vector3 normal;  //!< 相手 → 動いている図形の向き
+	Vector3 point;   //!< 接触点 (相手の表面上)
+};
+
+
+//===================================  内部で使う交差  =============================================
+
+// 半直線 origin + t * direction と球の、入る時刻 (t >= 0)。当たらなければ FLT_MAX
+inline float RaySphereTime(const Vector3& origin, const Vector3& direction, const Vector3& center, float radius) {
+	Vector3 m = SubtractVector(origin, center);
+	float a = Dot(direction, direction);
+	float b = Dot(m, direction);
+	float c = Dot(m, m) - radius * radius;
+	if (c <= 0.0f) {
+		return 0.0f;  // 始めから中にある
+	}
+	if (b >= 0.0f || a == 0.0f) {
+		return FLT_MAX;  // 離れていく
+	}
+	float discriminant = b * b - a * c;
+	if (discriminant < 0.0f) {
+		return FLT_MAX;
+	}
+	return (-b - std::sqrt(discriminant)) / a;
+}
+
+// 半直線とカプセル (線分 p-q を半径 radius だけ太らせたもの) の、入る時刻。当たらなければ FLT_MAX
+// 円柱の側面と両端の球を調べ、早い方を返す
+inline float RayCapsuleTime(const Vector3& origin, const Vector3& direction, const Vector3& p, const Vector3& q, float radius) {
+	float time = (std::min)(RaySphereTime(origin, direction, p, radius), RaySphereTime(origin, direction, q, radius));
+
+	// 円柱の側面: 軸に垂直な成分だけで2次方程式を解く
+	Vector3 axis = SubtractVector(q, p);
+	float axisLengthSquared = Dot(axis, axis);
+	if (axisLengthSquared == 0.0f) {
+		return time;
+	}
+	Vector3 m = SubtractVector(origin, p);
+	float md = Dot(m, axis), nd = Dot(direction, axis);
+	float a = axisLengthSquared * Dot(direction, direction) - nd * nd;
+	float b = axisLengthSquared * Dot(m, direction) - nd * md;
+	float c = axisLengthSquared * (Dot(m, m) - radius * radius) - md * md;
+	if (a == 0.0f || b >= 0.0f) {
+		return time;  // 軸と平行に動いている (端の球で判定済み) か、離れていく
+	}
+	float discriminant = b * b - a * c;
+	if (discriminant < 0.0f) {
+		return time;
+	}
+	float t = (std::max)(0.0f, (-b - std::sqrt(discriminant)) / a);
+	// 当たった点が円柱の範囲 (両端の間) にあるときだけ
+	float s = md + t * nd;
+	if (s >= 0.0f && s <= axisLengthSquared) {
+		time = (std::min)(time, t);
+	}
+	return time;
+}
+
+// 三角形の上で point に一番近い点
+inline Vector3 ClosestPointOnTriangle(const Vector3& point, const Vector3& a, const Vector3& b, const Vector3& c) {
+	Vector3 ab = SubtractVector(b, a), ac = SubtractVector(c, a), ap = SubtractVector(point, a);
+	float d1 = Dot(ab, ap), d2 = Dot(ac, ap);
+	if (d1 <= 0.0f && d2 <= 0.0f) {
+		return a;
+	}
+	Vector3 bp = SubtractVector(point, b);
+	float d3 = Dot(ab, bp), d4 = Dot(ac, bp);
+	if (d3 >= 0.0f && d4 <= d3) {
+		return b;
+	}
+	float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+		return AddVector(a, MultiplyVector(d1 / (d1 - d3), ab));
+	}
+	Vector3 cp = SubtractVector(point, c);
+	float d5 = Dot(ab, cp), d6 = Dot(ac, cp);
+	if (d6 >= 0.0f && d5 <= d6) {
+		return c;
+	}
+	float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+		return AddVector(a, MultiplyVector(d2 / (d2 - d6), ac));
+	}
+	float va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+		return AddVector(b, MultiplyVector((d4 - d3) / ((d4 - d3) + (d5 - d6)), SubtractVector(c, b)));
+	}
+	float denominator = 1.0f / (va + vb + vc);
+	return AddVector(a, AddVector(MultiplyVector(vb * denominator, ab), MultiplyVector(vc * denominator, ac)));
+}
+
+inline Vector3 ClosestPointOnAABB(const Vector3& point, const AABB& aabb) {
+	return {
+		std::clamp(point.x, aabb.min.x, aabb.max.x),
+		std::clamp(point.y, aabb.min.y, aabb.max.y),
+		std::clamp(point.z, aabb.min.z, aabb.max.z),
+	};
+}
+
+// 法線が決まらないとき (中心が相手の表面上や中にある) に使う、移動と逆の向き
+inline Vector3 SweepFallbackNormal(const Vector3& move) {
+	return Length(move) > 0.0f ? Normalize(MultiplyVector(-1.0f, move)) : Vector3{ 0.0f, 1.0f, 0.0f };
+}
+
+// 時刻 time の球の中心と、相手の表面上の一番近い点から法線と接触点を決める
+// 中心が表面上にある (距離が 0) ときは fallbackNormal を使う
+inline SweepHit MakeSweepHit(float time, const Vector3& center, const Vector3& surfacePoint, const Vector3& fallbackNormal) {
+	Vector3 diff = SubtractVector(center, surfacePoint);
+	float length = Length(diff);
+	Vector3 normal = length > 0.0f ? MultiplyVector(1.0f / length, diff) : fallbackNormal;
+	return { time, normal, surfacePoint };
+}
+
+//=================================================================================================
+
+
+//====================================  動く球との判定  ============================================
+
+// 平面は両面とも判定する (始めにいた側の面にぶつかる)
+inline bool SweepSphereVsPlane(const Sphere& sphere, const Vector3& move, const Plane& plane, SweepHit& hit) {
+	float startDistance = Dot(plane.normal, sphere.center) - plane.distance;
+	float side = startDistance >= 0.0f ? 1.0f : -1.0f;
+	Vector3 normal = MultiplyVector(side, plane.normal);
+	float time;
+	if (std::fabs(startDistance) <= sphere.radius) {
+		time = 0.0f;
+	} else {
+		// 平面に近づく速さ。離れていくか平行なら当たらない
+		float approach = -Dot(normal, move);
+		if (approach <= 0.0f) {
+			return false;
+		}
+		time = (std::fabs(startDistance) - sphere.radius) / approach;
+		if (time > 1.0f) {
+			return false;
+		}
+	}
+	Vector3 center = AddVector(sphere.center, MultiplyVector(time, move));
+	float distance = Dot(normal, center) - side * plane.distance;
+	hit = { time, normal, SubtractVector(center, MultiplyVector(distance, normal)) };
+	return true;
+}
+
+// 球を半径だけ広げた AABB (角と辺は丸い) と、球の中心の軌跡との交差
+// 広げた箱 (角の丸くない) の面で当たった位置が、元の箱のいくつの軸の外にあるかで
+// 面 (1つ)・辺 (2つ)・角 (3つ) に分け、辺と角は丸い部分 (カプセル) と判定し直す
+inline bool SweepSphereVsAABB(const Sphere& sphere, const Vector3& move, const AABB& aabb, SweepHit& hit) {
+	const float r = sphere.radius;
+	if (isCollisionSphereAABB(aabb, sphere)) {
+		Vector3 closest = ClosestPointOnAABB(sphere.center, aabb);
+		hit = MakeSweepHit(0.0f, sphere.center, closest, SweepFallbackNormal(move));
+		return true;
+	}
+
+	// 半径だけ広げた箱とのスラブ判定
+	const float origin[3] = { sphere.center.x, sphere.center.y, sphere.center.z };
+	const float direction[3] = { move.x, move.y, move.z };
+	const float boxMin[3] = { aabb.min.x, aabb.min.y, aabb.min.z };
+	const float boxMax[3] = { aabb.max.x, aabb.max.y, aabb.max.z };
+	float tEnter = 0.0f, tExit = 1.0f;
+	for (int axis = 0; axis < 3; ++axis) {
+		float lower = boxMin[axis] - r, upper = boxMax[axis] + r;
+		if (direction[axis] == 0.0f) {
+			if (origin[axis] < lower || origin[axis] > upper) {
+				return false;
+			}
+			continue;
+		}
+		float inverse = 1.0f / direction[axis];
+		float t0 = (lower - origin[axis]) * inverse, t1 = (upper - origin[axis]) * inverse;
+		if (t0 > t1) {
+			std::swap(t0, t1);
+		}
+		tEnter = (std::max)(tEnter, t0);
+		tExit = (std::min)(tExit, t1);
+		if (tEnter > tExit) {
+			return false;
+		}
+	}
+
+	// 広げた箱に入った点が、元の箱のどの軸の外にあるか
+	int below = 0, above = 0;
+	for (int axis = 0; axis < 3; ++axis) {
+		float p = origin[axis] + tEnter * direction[axis];
+		if (p < boxMin[axis]) below |= 1 << axis;
+		if (p > boxMax[axis]) above |= 1 << axis;
+	}
+	int outside = below | above;
+
+	auto corner = [&](int mask) {
+		// mask のビットが立っている軸は max、それ以外は min の頂点
+		return Vector3{
+			(mask & 1) ? aabb.max.x : aabb.min.x,
+			(mask & 2) ? aabb.max.y : aabb.min.y,
+			(mask & 4) ? aabb.max.z : aabb.min.z,
+		};
+	};
+
+	float time = tEnter;
+	int outsideCount = ((outside >> 0) & 1) + ((outside >> 1) & 1) + ((outside >> 2) & 1);
+	if (outsideCount == 2) {
+		// 辺: 外にない軸の向きの辺
+		int edgeAxis = outside ^ 7;
+		time = RayCapsuleTime(sphere.center, move, corner(above), corner(above | edgeAxis), r);
+	} else if (outsideCount == 3) {
+		// 角: その頂点から出る3本の辺
+		time = FLT_MAX;
+		for (int edgeAxis = 1; edgeAxis <= 4; edgeAxis <<= 1) {
+			time = (std::min)(time, RayCapsuleTime(sphere.center, move, corner(above), corner(above ^ edgeAxis), r));
+		}
+	}
+	if (time > 1.0f) {
+		return false;
+	}
+
+	Vector3 center = AddVector(sphere.center, MultiplyVector(time, move));
+	hit = MakeSweepHit(time, center, ClosestPointOnAABB(center, aabb), SweepFallbackNormal(move));
+	return true;
+}
+
+// 三角形の面 (両面) に当たるか、そうでなければ3本の辺 (カプセル) に当たる時刻
+inline bool SweepSphereVsTriangle(const Sphere& sphere, const Vector3& move, const Triangle& triangle, SweepHit& hit) {
+	const Vector3& a = triangle.vertices[0];
+	const Vector3& b = triangle.vertices[1];
+	const Vector3& c = triangle.vertices[2];
+	Vector3 fallback = SweepFallbackNormal(move);
+
+	Vector3 closest = ClosestPointOnTriangle(sphere.center, a, b, c);
+	Vector3 diff = SubtractVector(sphere.center, closest);
+	if (Dot(diff, diff) <= sphere.radius * sphere.radius) {
+		hit = MakeSweepHit(0.0f, sphere.center, closest, fallback);
+		return true;
+	}
+
+	float time = FLT_MAX;
+	Vector3 cross = Cross(SubtractVector(b, a), SubtractVector(c, a));
+	if (Length(cross) > 0.0f) {
+		// 面: 平面との判定で当たった位置が三角形の中なら、それが最初
+		Plane plane;
+		plane.normal = Normalize(cross);
+		plane.distance = Dot(plane.normal, a);
+		SweepHit planeHit;
+		if (SweepSphereVsPlane(sphere, move, plane, planeHit)) {
+			Vector3 onTriangle = ClosestPointOnTriangle(planeHit.point, a, b, c);
+			Vector3 offset = SubtractVector(onTriangle, planeHit.point);
+			if (Dot(offset, offset) <= 1e-10f * (1.0f + Dot(planeHit.point, planeHit.point))) {
+				hit = planeHit;
+				return true;
+			}
+		}
+	}
+	// 辺と頂点
+	time = (std::min)(time, RayCapsuleTime(sphere.center, move, a, b, sphere.radius));
+	time = (std::min)(time, RayCapsuleTime(sphere.center, move, b, c, sphere.radius));
+	time = (std::min)(time, RayCapsuleTime(sphere.center, move, c, a, sphere.radius));
+	if (time > 1.0f) {
+		return false;
+	}
+
+	Vector3 center = AddVector(sphere.center, MultiplyVector(time, move));
+	hit = MakeSweepHit(time, center, ClosestPointOnTriangle(center, a, b, c), fallback);
+	return true;
+}
+
+//=================================================================================================
+
+
+//===================================  動く AABB との判定  ==========================================
+
+// 軸ごとに「重なり始める時刻」と「離れる時刻」を求め、全ての軸で重なっている区間の始まりを当たった時刻にする
+inline bool SweepAABBVsAABB(const AABB& moving, const Vector3& move, const AABB& target, SweepHit& hit) {
+	const float movingMin[3] = { moving.min.x, moving.min.y, moving.min.z };
+	const float movingMax[3] = { moving.max.x, moving.max.y, moving.max.z };
+	const float targetMin[3] = { target.min.x, target.min.y, target.min.z };
+	const float targetMax[3] = { target.max.x, target.max.y, target.max.z };
+	const float direction[3] = { move.x, move.y, move.z };
+
+	float tEnter = -FLT_MAX, tExit = FLT_MAX;
+	int enterAxis = -1;
+	for (int axis = 0; axis < 3; ++axis) {
+		float t0, t1;
+		if (direction[axis] == 0.0f) {
+			if (movingMax[axis] < targetMin[axis] || movingMin[axis] > targetMax[axis]) {
+				return false;
+			}
+			continue;
+		}
+		float inverse = 1.0f / direction[axis];
+		if (direction[axis] > 0.0f) {
+			t0 = (targetMin[axis] - movingMax[axis]) * inverse;
+			t1 = (targetMax[axis] - movingMin[axis]) * inverse;
+		} else {
+			t0 = (targetMax[axis] - movingMin[axis]) * inverse;
+			t1 = (targetMin[axis] - movingMax[axis]) * inverse;
+		}
+		if (t0 > tEnter) {
+			tEnter = t0;
+			enterAxis = axis;
+		}
+		tExit = (std::min)(tExit, t1);
+	}
+	if (tEnter > tExit || tEnter > 1.0f || tExit < 0.0f) {
+		return false;
+	}
+
+	float normal[3] = { 0.0f, 0.0f, 0.0f };
+	float time = tEnter;
+	if (time <= 0.0f) {
+		// 始めから重なっている: めり込みが一番浅い軸で押し返す向きを法線にする
+		time = 0.0f;
+		float minPenetration = FLT_MAX;
+		for (int axis = 0; axis < 3; ++axis) {
+			float pushNegative = movingMax[axis] - targetMin[axis];  // -軸の向きに押し出す量
+			float pushPositive = targetMax[axis] - movingMin[axis];  // +軸の向きに押し出す量
+			if (pushNegative < minPenetration) {
+				minPenetration = pushNegative;
+				normal[0] = normal[1] = normal[2] = 0.0f;
+				normal[axis] = -1.0f;
+			}
+			if (pushPositive < minPenetration) {
+				minPenetration = pushPositive;
+				normal[0] = normal[1] = normal[2] = 0.0f;
+				normal[axis] = 1.0f;
+			}
+		}
+	} else {
+		normal[enterAxis] = direction[enterAxis] > 0.0f ? -1.0f : 1.0f;
+	}
+
+	// 接触点は、時刻 time の2つの箱の重なり (接触面) の中心
+	Vector3 offset = MultiplyVector(time, move);
+	Vector3 overlapMin = {
+		(std::max)(moving.min.x + offset.x, target.min.x),
+		(std::max)(moving.min.y + offset.y, target.min.y),
+		(std::max)(moving.min.z + offset.z, target.min.z),
+	};
+	Vector3 overlapMax = {
+		(std::min)(moving.max.x + offset.x, target.max.x),
+		(std::min)(moving.max.y + offset.y, target.max.y),
+		(std::min)(moving.max.z + offset.z, target.max.z),
+	};
+	hit = { time, { normal[0], normal[1], normal[2] }, Lerp(overlapMin, overlapMax, 0.5f) };
+	return true;
+}
+
+//=================================================================================================
+
+
+//==================================  たくさん動かす (まとめて)  =====================================
+// CollisionWorld に登録した止まっている図形に対して、たくさんの図形をそれぞれ動かしたときの最初の衝突を求める
+// 動いた範囲の AABB と重ならない AABB・三角形は詳細な判定をしない
+// 止まっている図形が多いときは、BVH::QuerySphereSweep で候補を絞ってから SweepSphereVsTriangle などを呼ぶ
+
+enum SweepTarget {
+	kSweepNone,      //!< 当たらなかった
+	kSweepPlane,
+	kSweepAABB,
+	kSweepTriangle,
+};
+
+struct SweepResult {
+	SweepHit hit;
+	SweepTarget target;  //!< 当たった相手の種類
+	uint32_t index;      //!< 当たった相手の、CollisionWorld での番号
+};
+
+// results[i] に spheres[i] を moves[i] だけ動かしたときの最初の衝突を入れる。戻り値は当たった数
+// jobSystem を渡すと動かす図形ごとに並列に判定する
+inline uint32_t SweepSpheres(const CollisionWorld& world, const Sphere* spheres, const Vector3* moves, uint32_t count, SweepResult* results,
+	JobSystem* jobSystem = nullptr) {
+	MT3_PROFILE_ZONE("SweepSpheres");
+	const AABBSoA& aabbs = world.GetAABBs();
+	const TriangleSoA& triangles = world.GetTriangles();
+	const PlaneSoA& planes = world.GetPlanes();
+
+	auto sweep = [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; ++i) {
+			const Sphere& sphere = spheres[i];
+			const Vector3& move = moves[i];
+			SweepResult best = { { FLT_MAX, {}, {} }, kSweepNone, 0 };
+			auto keep = [&](const SweepHit& hit, SweepTarget target, uint32_t index) {
+				if (hit.time < best.hit.time) {
+					best = { hit, target, index };
+				}
+			};
+			SweepHit hit;
+
+			for (uint32_t j = 0; j < world.GetPlaneCount(); ++j) {
+				Plane plane = { { planes.normalX[j], planes.normalY[j], planes.normalZ[j] }, planes.distance[j] };
+				if (SweepSphereVsPlane(sphere, move, plane, hit)) {
+					keep(hit, kSweepPlane, j);
+				}
+			}
+
+			AABB bounds = MergeAABB(MakeAABB(sphere), MakeAABB(Sphere{ AddVector(sphere.center, move), sphere.radius }));
+			for (uint32_t j = 0; j < world.GetAABBCount(); ++j) {
+				AABB aabb = { { aabbs.minX[j], aabbs.minY[j], aabbs.minZ[j] }, { aabbs.maxX[j], aabbs.maxY[j], aabbs.maxZ[j] } };
+				if (isCollisionAABB(bounds, aabb) && SweepSphereVsAABB(sphere, move, aabb, hit)) {
+					keep(hit, kSweepAABB, j);
+				}
+			}
+
+			for (uint32_t j = 0; j < world.GetTriangleCount(); ++j) {
+				Triangle triangle = {
+					{
+						{ triangles.x0[j], triangles.y0[j], triangles.z0[j] },
+						{ triangles.x1[j], triangles.y1[j], triangles.z1[j] },
+						{ triangles.x2[j], triangles.y2[j], triangles.z2[j] },
+					},
+					{},
+				};
+				if (isCollisionAABB(bounds, MakeAABB(triangle)) && SweepSphereVsTriangle(sphere, move, triangle, hit)) {
+					keep(hit, kSweepTriangle, j);
+				}
+			}
+			results[i] = best;
+		}
+	};
+
+	if (jobSystem != nullptr) {
+		jobSystem->ParallelFor(count, 64, sweep);
+	} else {
+		sweep(0, count);
+	}
+
+	uint32_t hits = 0;
+	for (uint32_t i = 0; i < count; ++i) {
+		hits += results[i].target != kSweepNone ? 1 : 0;
+	}
+	return hits;
+}
+
+// AABB を動かすときの同じ処理 (相手は CollisionWorld の AABB だけ)
+inline uint32_t SweepAABBs(const CollisionWorld& world, const AABB* movers, const Vector3* moves, uint32_t count, SweepResult* results,
+	JobSystem* jobSystem = nullptr) {
+	MT3_PROFILE_ZONE("SweepAABBs");
+	const AABBSoA& aabbs = world.GetAABBs();
+
+	auto sweep = [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; ++i) {
+			const AABB& mover = movers[i];
+			const Vector3& move = moves[i];
+			AABB moved = { AddVector(mover.min, move), AddVector(mover.max, move) };
+			AABB bounds = MergeAABB(mover, moved);
+			SweepResult best = { { FLT_MAX, {}, {} }, kSweepNone, 0 };
+			SweepHit hit;
+			for (uint32_t j = 0; j < world.GetAABBCount(); ++j) {
+				AABB aabb = { { aabbs.minX[j], aabbs.minY[j], aabbs.minZ[j] }, { aabbs.maxX[j], aabbs.maxY[j], aabbs.maxZ[j] } };
+				if (isCollisionAABB(bounds, aabb) && SweepAABBVsAABB(mover, move, aabb, hit) && hit.time < best.hit.time) {
+					best = { hit, kSweepAABB, j };
+				}
+			}
+			results[i] = best;
+		}
+	};
+
+	if (jobSystem != nullptr) {
+		jobSystem->ParallelFor(count, 64, sweep);
+	} else {
+		sweep(0, count);
+	}
+
+	uint32_t hits = 0;
+	for (uint32_t i = 0; i < count; ++i) {
+		hits += results[i].target != kSweepNone ? 1 : 0;
+	}
+	return hits;
+}
+
+//=================================================================================================
@@ -0,0 +1,280 @@
+#pragma once
+#include "MakeMatrix.h"
+#include "SimdConfig.h"
+#include <cstdint>
+
+// 複数の点をまとめて同次座標変換する
+// Transform() と同じ式で計算するが、w除算は 1/w を1回だけ求めて掛ける
+// (wが0の点はassertせず、無限大/NaNになる)
+
+
+//================================ 最後の列が(0,0,0,1)かどうか ====================================
+
+inline bool IsAffineMatrix(const Matrix4x4& m) {
+	return m.m[0][3] == 0.0f && m.m[1][3] == 0.0f && m.m[2][3] == 0.0f && m.m[3][3] == 1.0f;
+}
+
+//=================================================================================================
+
+
+//=================================== スカラー版 (AoS) ============================================
+
+inline void TransformArrayScalar(const Vector3* src, Vector3* dst, uint32_t count, const Matrix4x4& m) {
+	bool affine = IsAffineMatrix(m);
+	for (uint32_t i = 0; i < count; ++i) {
+		Vector3 v = src[i];
+		float x = v.x * m.m[0][0] + v.y * m.m[1][0] + v.z * m.m[2][0] + m.m[3][0];
+		float y = v.x * m.m[0][1] + v.y * m.m[1][1] + v.z * m.m[2][1] + m.m[3][1];
+		float z = v.x * m.m[0][2] + v.y * m.m[1][2] + v.z * m.m[2][2] + m.m[3][2];
+		if (!affine) {
+			float w = v.x * m.m[0][3] + v.y * m.m[1][3] + v.z * m.m[2][3] + m.m[3][3];
+			float invW = 1.0f / w;
+			x *= invW;
+			y *= invW;
+			z *= invW;
+		}
+		dst[i] = { x, y, z };
+	}
+}
+
+//=================================================================================================
+
+
+//=================================== スカラー版 (SoA) ============================================
+
+inline void TransformArraySoAScalar(const float* srcX, const float* srcY, const float* srcZ,
+	float* dstX, float* dstY, float* dstZ, uint32_t begin, uint32_t end, const Matrix4x4& m) {
+	bool affine = IsAffineMatrix(m);
+	for (uint32_t i = begin; i < end; ++i) {
+		float vx = srcX[i];
+		float vy = srcY[i];
+		float vz = srcZ[i];
+		float x = vx * m.m[0][0] + vy * m.m[1][0] + vz * m.m[2][0] + m.m[3][0];
+		float y = vx * m.m[0][1] + vy * m.m[1][1] + vz * m.m[2][1] + m.m[3][1];
+		float z = vx * m.m[0][2] + vy * m.m[1][2] + vz * m.m[2][2] + m.m[3][2];
+		if (!affine) {
+			float w = vx * m.m[0][3] + vy * m.m[1][3] + vz * m.m[2][3] + m.m[3][3];
+			float invW = 1.0f / w;
+			x *= invW;
+			y *= invW;
+			z *= invW;
+		}
+		dstX[i] = x;
+		dstY[i] = y;
+		dstZ[i] = z;
+	}
+}
+
+//=================================================================================================
+
+#if MT3_SIMD_X86
+
+//===================================== SSE版 ====================================================
+
+// 4点分の x, y, z をまとめて変換する (SoA と AoS で共有)
+SIMD_TARGET_SSE41
+inline void TransformLanesSSE(__m128& x, __m128& y, __m128& z, const Matrix4x4& m, bool affine) {
+	__m128 vx = x, vy = y, vz = z;
+	x = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, _mm_set1_ps(m.m[0][0])), _mm_mul_ps(vy, _mm_set1_ps(m.m[1][0]))), _mm_mul_ps(vz, _mm_set1_ps(m.m[2][0]))), _mm_set1_ps(m.m[3][0]));
+	y = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, _mm_set1_ps(m.m[0][1])), _mm_mul_ps(vy, _mm_set1_ps(m.m[1][1]))), _mm_mul_ps(vz, _mm_set1_ps(m.m[2][1]))), _mm_set1_ps(m.m[3][1]));
+	z = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, _mm_set1_ps(m.m[0][2])), _mm_mul_ps(vy, _mm_set1_ps(m.m[1][2]))), _mm_mul_ps(vz, _mm_set1_ps(m.m[2][2]))), _mm_set1_ps(m.m[3][2]));
+	if (!affine) {
+		__m128 w = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, _mm_set1_ps(m.m[0][3])), _mm_mul_ps(vy, _mm_set1_ps(m.m[1][3]))), _mm_mul_ps(vz, _mm_set1_ps(m.m[2][3]))), _mm_set1_ps(m.m[3][3]));
+		__m128 invW = _mm_div_ps(_mm_set1_ps(1.0f), w);
+		x = _mm_mul_ps(x, invW);
+		y = _mm_mul_ps(y, invW);
+		z = _mm_mul_ps(z, invW);
+	}
+}
+
+// 4点分の AoS (x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3) を x, y, z に並べ替える
+// 各点の成分はレーンが重ならないので、blend で集めてからレーン内で並べ替える
+SIMD_TARGET_SSE41
+inline void DeinterleaveSSE(__m128 a, __m128 b, __m128 c, __m128& x, __m128& y, __m128& z) {
+	__m128 xm = _mm_blend_ps(_mm_blend_ps(a, b, 0x4), c, 0x2);  // x0 x3 x2 x1
+	__m128 ym = _mm_blend_ps(_mm_blend_ps(a, b, 0x9), c, 0x4);  // y1 y0 y3 y2
+	__m128 zm = _mm_blend_ps(_mm_blend_ps(a, b, 0x2), c, 0x9);  // z2 z1 z0 z3
+	x = _mm_shuffle_ps(xm, xm, _MM_SHUFFLE(1, 2, 3, 0));
+	y = _mm_shuffle_ps(ym, ym, _MM_SHUFFLE(2, 3, 0, 1));
+	z = _mm_shuffle_ps(zm, zm, _MM_SHUFFLE(3, 0, 1, 2));
+}
+
+// DeinterleaveSSE の逆
+SIMD_TARGET_SSE41
+inline void InterleaveSSE(__m128 x, __m128 y, __m128 z, __m128& a, __m128& b, __m128& c) {
+	__m128 xm = _mm_shuffle_ps(x, x, _MM_SHUFFLE(1, 2, 3, 0));
+	__m128 ym = _mm_shuffle_ps(y, y, _MM_SHUFFLE(2, 3, 0, 1));
+	__m128 zm = _mm_shuffle_ps(z, z, _MM_SHUFFLE(3, 0, 1, 2));
+	a = _mm_blend_ps(_mm_blend_ps(xm, ym, 0x2), zm, 0x4);
+	b = _mm_blend_ps(_mm_blend_ps(xm, ym, 0x9), zm, 0x2);
+	c = _mm_blend_ps(_mm_blend_ps(xm, ym, 0x4), zm, 0x9);
+}
+
+// AoS: 4点 (12個の float) を読んで SoA に並べ替えてから計算し、端数はスカラー版で処理する
+SIMD_TARGET_SSE41
+inline void TransformArraySSE(const Vector3* src, Vector3* dst, uint32_t count, const Matrix4x4& m) {
+	static_assert(sizeof(Vector3) == sizeof(float) * 3, "Vector3 は float 3つが詰まっている前提");
+	bool affine = IsAffineMatrix(m);
+
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const float* in = &src[i].x;
+		__m128 x, y, z;
+		DeinterleaveSSE(_mm_loadu_ps(in), _mm_loadu_ps(in + 4), _mm_loadu_ps(in + 8), x, y, z);
+		TransformLanesSSE(x, y, z, m, affine);
+		__m128 a, b, c;
+		InterleaveSSE(x, y, z, a, b, c);
+		float* out = &dst[i].x;
+		_mm_storeu_ps(out, a);
+		_mm_storeu_ps(out + 4, b);
+		_mm_storeu_ps(out + 8, c);
+	}
+	TransformArrayScalar(src + i, dst + i, count - i, m);
+}
+
+// SoA: 4点ずつ計算し、端数はスカラー版で処理する
+SIMD_TARGET_SSE41
+inline void TransformArraySoASSE(const float* srcX, const float* srcY, const float* srcZ,
+	float* dstX, float* dstY, float* dstZ, uint32_t count, const Matrix4x4& m) {
+	bool affine = IsAffineMatrix(m);
+
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128 x = _mm_loadu_ps(srcX + i);
+		__m128 y = _mm_loadu_ps(srcY + i);
+		__m128 z = _mm_loadu_ps(srcZ + i);
+		TransformLanesSSE(x, y, z, m, affine);
+		_mm_storeu_ps(dstX + i, x);
+		_mm_storeu_ps(dstY + i, y);
+		_mm_storeu_ps(dstZ + i, z);
+	}
+	TransformArraySoAScalar(srcX, srcY, srcZ, dstX, dstY, dstZ, i, count, m);
+}
+
+//=================================================================================================
+
+
+//===================================== AVX2版 ===================================================
+
+// 8点分の x, y, z をまとめて変換する (SoA と AoS で共有)
+SIMD_TARGET_AVX2
+inline void TransformLanesAVX2(__m256& x, __m256& y, __m256& z, const Matrix4x4& m, bool affine) {
+	__m256 vx = x, vy = y, vz = z;
+	x = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, _mm256_set1_ps(m.m[0][0])), _mm256_mul_ps(vy, _mm256_set1_ps(m.m[1][0]))), _mm256_mul_ps(vz, _mm256_set1_ps(m.m[2][0]))), _mm256_set1_ps(m.m[3][0]));
+	y = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, _mm256_set1_ps(m.m[0][1])), _mm256_mul_ps(vy, _mm256_set1_ps(m.m[1][1]))), _mm256_mul_ps(vz, _mm256_set1_ps(m.m[2][1]))), _mm256_set1_ps(m.m[3][1]));
+	z = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, _mm256_set1_ps(m.m[0][2])), _mm256_mul_ps(vy, _mm256_set1_ps(m.m[1][2]))), _mm256_mul_ps(vz, _mm256_set1_ps(m.m[2][2]))), _mm256_set1_ps(m.m[3][2]));
+	if (!affine) {
+		__m256 w = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, _mm256_set1_ps(m.m[0][3])), _mm256_mul_ps(vy, _mm256_set1_ps(m.m[1][3]))), _mm256_mul_ps(vz, _mm256_set1_ps(m.m[2][3]))), _mm256_set1_ps(m.m[3][3]));
+		__m256 invW = _mm256_div_ps(_mm256_set1_ps(1.0f), w);
+		x = _mm256_mul_ps(x, invW);
+		y = _mm256_mul_ps(y, invW);
+		z = _mm256_mul_ps(z, invW);
+	}
+}
+
+// AoS: 8点 (24個の float) を読み、下位128ビットに前半4点、上位128ビットに後半4点を置いて
+// DeinterleaveSSE と同じ並べ替えを両方の128ビットで行う (レーンをまたぐ並べ替えは使わない)
+SIMD_TARGET_AVX2
+inline void TransformArrayAVX2(const Vector3* src, Vector3* dst, uint32_t count, const Matrix4x4& m) {
+	static_assert(sizeof(Vector3) == sizeof(float) * 3, "Vector3 は float 3つが詰まっている前提");
+	bool affine = IsAffineMatrix(m);
+
+	uint32_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const float* in = &src[i].x;
+		__m256 a = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(in)), _mm_loadu_ps(in + 12), 1);
+		__m256 b = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(in + 4)), _mm_loadu_ps(in + 16), 1);
+		__m256 c = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(in + 8)), _mm_loadu_ps(in + 20), 1);
+		__m256 xm = _mm256_blend_ps(_mm256_blend_ps(a, b, 0x44), c, 0x22);
+		__m256 ym = _mm256_blend_ps(_mm256_blend_ps(a, b, 0x99), c, 0x44);
+		__m256 zm = _mm256_blend_ps(_mm256_blend_ps(a, b, 0x22), c, 0x99);
+		__m256 x = _mm256_permute_ps(xm, _MM_SHUFFLE(1, 2, 3, 0));
+		__m256 y = _mm256_permute_ps(ym, _MM_SHUFFLE(2, 3, 0, 1));
+		__m256 z = _mm256_permute_ps(zm, _MM_SHUFFLE(3, 0, 1, 2));
+
+		TransformLanesAVX2(x, y, z, m, affine);
+
+		xm = _mm256_permute_ps(x, _MM_SHUFFLE(1, 2, 3, 0));
+		ym = _mm256_permute_ps(y, _MM_SHUFFLE(2, 3, 0, 1));
+		zm = _mm256_permute_ps(z, _MM_SHUFFLE(3, 0, 1, 2));
+		a = _mm256_blend_ps(_mm256_blend_ps(xm, ym, 0x22), zm, 0x44);
+		b = _mm256_blend_ps(_mm256_blend_ps(xm, ym, 0x99), zm, 0x22);
+		c = _mm256_blend_ps(_mm256_blend_ps(xm, ym, 0x44), zm, 0x99);
+		float* out = &dst[i].x;
+		_mm_storeu_ps(out, _mm256_castps256_ps128(a));
+		_mm_storeu_ps(out + 4, _mm256_castps256_ps128(b));
+		_mm_storeu_ps(out + 8, _mm256_castps256_ps128(c));
+		_mm_storeu_ps(out + 12, _mm256_extractf128_ps(a, 1));
+		_mm_storeu_ps(out + 16, _mm256_extractf128_ps(b, 1));
+		_mm_storeu_ps(out + 20, _mm256_extractf128_ps(c, 1));
+	}
+	TransformArrayScalar(src + i, dst + i, count - i, m);
+}
+
+// SoA: 8点ずつ計算し、端数はスカラー版で処理する
+SIMD_TARGET_AVX2
+inline void TransformArraySoAAVX2(const float* srcX, const float* srcY, const float* srcZ,
+	float* dstX, float* dstY, float* dstZ, uint32_t count, const Matrix4x4& m) {
+	bool affine = IsAffineMatrix(m);
+
+	uint32_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 x = _mm256_loadu_ps(srcX + i);
+		__m256 y = _mm256_loadu_ps(srcY + i);
+		__m256 z = _mm256_loadu_ps(srcZ + i);
+		TransformLanesAVX2(x, y, z, m, affine);
+		_mm256_storeu_ps(dstX + i, x);
+		_mm256_storeu_ps(dstY + i, y);
+		_mm256_storeu_ps(dstZ + i, z);
+	}
+	TransformArraySoAScalar(srcX, srcY, srcZ, dstX, dstY, dstZ, i, count, m);
+}
+
+//=================================================================================================
+
+#endif
+
+
+//================================ 点の配列をまとめて変換 (AoS) ===================================
+
+// src と dst は同じ配列でもよい
+inline void TransformArray(const Vector3* src, Vector3* dst, uint32_t count, const Matrix4x4& matrix) {
+	switch (GetSimdLevel()) {
+#if MT3_SIMD_X86
+	case SimdLevel::AVX2:
+		TransformArrayAVX2(src, dst, count, matrix);
+		return;
+	case SimdLevel::SSE41:
+		TransformArraySSE(src, dst, count, matrix);
+		return;
+#endif
+	default:
+		TransformArrayScalar(src, dst, count, matrix);
+		return;
+	}
+}
+
+//=================================================================================================
+
+
+//================================ 点の配列をまとめて変換 (SoA) ===================================
+
+// x, y, z を別々の配列で受け取る。src と dst は同じ配列でもよい
+inline void TransformArraySoA(const float* srcX, const float* srcY, const float* srcZ,
+	float* dstX, float* dstY, float* dstZ, uint32_t count, const Matrix4x4& matrix) {
+	switch (GetSimdLevel()) {
+#if MT3_SIMD_X86
+	case SimdLevel::AVX2:
+		TransformArraySoAAVX2(srcX, srcY, srcZ, dstX, dstY, dstZ, count, matrix);
+		return;
+	case SimdLevel::SSE41:
+		TransformArraySoASSE(srcX, srcY, srcZ, dstX, dstY, dstZ, count, matrix);
+		return;
+#endif
+	default:
+		TransformArraySoAScalar(srcX, srcY, srcZ, dstX, dstY, dstZ, 0, count, matrix);
+		return;
+	}
+}
+
+//=================================================================================================
@@ -0,0 +1,343 @@
+#pragma once
+#include "MatrixCalc.h"
+#include <assert.h>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+
+// 次元と要素の型をテンプレート引数にしたベクトル Vec<N, T> と行列 Mat<R, C, T>
+// 全て constexpr なので、定数の行列 (ビューポート変換など) はコンパイル時に計算できる
+// double も使えるので、精度が要るオフラインのツールでは Mat4d で計算してから MatCast<float> で落とす
+//
+//   constexpr Mat4f kViewport = MakeViewportMatrix<float>(0, 0, 1280, 720, 0, 1);
+//   Matrix4x4 viewport = ToMatrix4x4(kViewport);
+//
+// 行列は Matrix4x4 と同じく行ベクトルに右から掛ける (v * M) 形で、メモリ上の並びも同じ
+
+
+//=====================================  ベクトル  ================================================
+// 2～4次元は x, y, z, w で読めるように特殊化する
+
+template <size_t N, typename T>
+struct Vec {
+	T e[N];
+
+	constexpr T& operator[](size_t i) { return e[i]; }
+	constexpr const T& operator[](size_t i) const { return e[i]; }
+};
+
+template <typename T>
+struct Vec<2, T> {
+	T x, y;
+
+	constexpr T& operator[](size_t i) { return i == 0 ? x : y; }
+	constexpr const T& operator[](size_t i) const { return i == 0 ? x : y; }
+};
+
+template <typename T>
+struct Vec<3, T> {
+	T x, y, z;
+
+	constexpr T& operator[](size_t i) { return i == 0 ? x : (i == 1 ? y : z); }
+	constexpr const T& operator[](size_t i) const { return i == 0 ? x : (i == 1 ? y : z); }
+};
+
+template <typename T>
+struct Vec<4, T> {
+	T x, y, z, w;
+
+	constexpr T& operator[](size_t i) { return i == 0 ? x : (i == 1 ? y : (i == 2 ? z : w)); }
+	constexpr const T& operator[](size_t i) const { return i == 0 ? x : (i == 1 ? y : (i == 2 ? z : w)); }
+};
+
+using Vec2f = Vec<2, float>;
+using Vec3f = Vec<3, float>;
+using Vec4f = Vec<4, float>;
+using Vec2d = Vec<2, double>;
+using Vec3d = Vec<3, double>;
+using Vec4d = Vec<4, double>;
+
+//=================================================================================================
+
+
+//=====================================  行列  ====================================================
+
+template <size_t R, size_t C, typename T>
+struct Mat {
+	T m[R][C];
+};
+
+using Mat3f = Mat<3, 3, float>;
+using Mat4f = Mat<4, 4, float>;
+using Mat3d = Mat<3, 3, double>;
+using Mat4d = Mat<4, 4, double>;
+
+//=================================================================================================
+
+
+//===================================  展開用の補助  ==============================================
+// 大きさはコンパイル時に決まっているので、ループを書かずに index_sequence で全て展開する
+// (要素ごとに1回ずつ function(i) を呼ぶ。Debug ビルドでもループのカウンタが残らない)
+
+template <typename Function, size_t... I>
+constexpr void UnrollImpl(Function&& function, std::index_sequence<I...>) {
+	(function(I), ...);
+}
+
+template <size_t N, typename Function>
+constexpr void Unroll(Function&& function) {
+	UnrollImpl(function, std::make_index_sequence<N>{});
+}
+
+// a[0] * b[0] + a[1] * b[1] + ... を左から順に足す (MultiplyScalar と同じ順番)
+template <typename T, typename Function, size_t... I>
+constexpr T SumImpl(Function&& function, std::index_sequence<I...>) {
+	return (... + function(I));
+}
+
+template <size_t N, typename T, typename Function>
+constexpr T Sum(Function&& function) {
+	return SumImpl<T>(function, std::make_index_sequence<N>{});
+}
+
+//=================================================================================================
+
+
+//==================================  ベクトルの演算  =============================================
+
+template <size_t N, typename T>
+constexpr Vec<N, T> operator+(const Vec<N, T>& a, const Vec<N, T>& b) {
+	Vec<N, T> result{};
+	Unroll<N>([&](size_t i) { result[i] = a[i] + b[i]; });
+	return result;
+}
+
+template <size_t N, typename T>
+constexpr Vec<N, T> operator-(const Vec<N, T>& a, const Vec<N, T>& b) {
+	Vec<N, T> result{};
+	Unroll<N>([&](size_t i) { result[i] = a[i] - b[i]; });
+	return result;
+}
+
+template <size_t N, typename T>
+constexpr Vec<N, T> operator-(const Vec<N, T>& v) {
+	Vec<N, T> result{};
+	Unroll<N>([&](size_t i) { result[i] = -v[i]; });
+	return result;
+}
+
+template <size_t N, typename T>
+constexpr Vec<N, T> operator*(const Vec<N, T>& v, T k) {
+	Vec<N, T> result{};
+	Unroll<N>([&](size_t i) { result[i] = v[i] * k; });
+	return result;
+}
+
+template <size_t N, typename T>
+constexpr Vec<N, T> operator*(T k, const Vec<N, T>& v) {
+	return v * k;
+}
+
+template <size_t N, typename T>
+constexpr Vec<N, T> operator/(const Vec<N, T>& v, T k) {
+	Vec<N, T> result{};
+	Unroll<N>([&](size_t i) { result[i] = v[i] / k; });
+	return result;
+}
+
+template <size_t N, typename T>
+constexpr bool operator==(const Vec<N, T>& a, const Vec<N, T>& b) {
+	bool equal = true;
+	Unroll<N>([&](size_t i) { equal = equal && a[i] == b[i]; });
+	return equal;
+}
+
+template <size_t N, typename T>
+constexpr T Dot(const Vec<N, T>& a, const Vec<N, T>& b) {
+	return Sum<N, T>([&](size_t i) { return a[i] * b[i]; });
+}
+
+template <typename T>
+constexpr Vec<3, T> Cross(const Vec<3, T>& a, const Vec<3, T>& b) {
+	return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+template <size_t N, typename T>
+constexpr T LengthSquared(const Vec<N, T>& v) {
+	return Dot(v, v);
+}
+
+// std::sqrt は constexpr ではないので、長さと正規化は実行時だけ
+template <size_t N, typename T>
+inline T Length(const Vec<N, T>& v) {
+	return std::sqrt(LengthSquared(v));
+}
+
+template <size_t N, typename T>
+inline Vec<N, T> Normalize(const Vec<N, T>& v) {
+	T length = Length(v);
+	assert(length != 0);
+	return v / length;
+}
+
+//=================================================================================================
+
+
+//===================================  行列の演算  ================================================
+
+template <size_t N, typename T>
+constexpr Mat<N, N, T> MakeIdentity() {
+	Mat<N, N, T> result{};
+	Unroll<N>([&](size_t i) { result.m[i][i] = T(1); });
+	return result;
+}
+
+template <size_t R, size_t C, typename T>
+constexpr bool operator==(const Mat<R, C, T>& a, const Mat<R, C, T>& b) {
+	bool equal = true;
+	Unroll<R>([&](size_t i) {
+		Unroll<C>([&](size_t j) { equal = equal && a.m[i][j] == b.m[i][j]; });
+	});
+	return equal;
+}
+
+template <size_t R, size_t C, typename T>
+constexpr Mat<C, R, T> Transpose(const Mat<R, C, T>& matrix) {
+	Mat<C, R, T> result{};
+	Unroll<R>([&](size_t i) {
+		Unroll<C>([&](size_t j) { result.m[j][i] = matrix.m[i][j]; });
+	});
+	return result;
+}
+
+// 展開してインライン化されるので、SIMD 版の Multiply(Matrix4x4) を関数越しに呼ぶより速い
+// (float の4x4なら MultiplyScalar と同じ順番で足すので、結果も一致する)
+template <size_t R, size_t K, size_t C, typename T>
+constexpr Mat<R, C, T> Multiply(const Mat<R, K, T>& a, const Mat<K, C, T>& b) {
+	Mat<R, C, T> result{};
+	Unroll<R>([&](size_t i) {
+		Unroll<C>([&](size_t j) {
+			result.m[i][j] = Sum<K, T>([&](size_t k) { return a.m[i][k] * b.m[k][j]; });
+		});
+	});
+	return result;
+}
+
+template <size_t R, size_t K, size_t C, typename T>
+constexpr Mat<R, C, T> operator*(const Mat<R, K, T>& a, const Mat<K, C, T>& b) {
+	return Multiply(a, b);
+}
+
+// 行ベクトル × 行列
+template <size_t R, size_t C, typename T>
+constexpr Vec<C, T> operator*(const Vec<R, T>& v, const Mat<R, C, T>& matrix) {
+	Vec<C, T> result{};
+	Unroll<C>([&](size_t j) {
+		result[j] = Sum<R, T>([&](size_t i) { return v[i] * matrix.m[i][j]; });
+	});
+	return result;
+}
+
+// 3次元ベクトルを同次座標として変換する (w で割る)
+template <typename T>
+constexpr Vec<3, T> Transform(const Vec<3, T>& v, const Mat<4, 4, T>& matrix) {
+	Vec<4, T> result = Vec<4, T>{ v.x, v.y, v.z, T(1) } * matrix;
+	assert(result.w != 0);
+	return { result.x / result.w, result.y / result.w, result.z / result.w };
+}
+
+//=================================================================================================
+
+
+//==========================  Matrix4x4 / Vector3 との変換  ========================================
+// メモリ上の並びが同じなので、コピーするだけ
+
+static_assert(sizeof(Mat4f) == sizeof(Matrix4x4), "Mat4f と Matrix4x4 の並びが一致しない");
+static_assert(sizeof(Vec3f) == sizeof(Vector3), "Vec3f と Vector3 の並びが一致しない");
+
+constexpr Matrix4x4 ToMatrix4x4(const Mat4f& matrix) {
+	return std::bit_cast<Matrix4x4>(matrix);
+}
+
+constexpr Mat4f ToMat4f(const Matrix4x4& matrix) {
+	return std::bit_cast<Mat4f>(matrix);
+}
+
+constexpr Vector3 ToVector3(const Vec3f& v) {
+	return { v.x, v.y, v.z };
+}
+
+constexpr Vec3f ToVec3f(const Vector3& v) {
+	return { v.x, v.y, v.z };
+}
+
+// 要素の型を変える (Mat4d → Mat4f など)
+template <typename U, size_t R, size_t C, typename T>
+constexpr Mat<R, C, U> MatCast(const Mat<R, C, T>& matrix) {
+	Mat<R, C, U> result{};
+	Unroll<R>([&](size_t i) {
+		Unroll<C>([&](size_t j) { result.m[i][j] = U(matrix.m[i][j]); });
+	});
+	return result;
+}
+
+template <typename U, size_t N, typename T>
+constexpr Vec<N, U> VecCast(const Vec<N, T>& v) {
+	Vec<N, U> result{};
+	Unroll<N>([&](size_t i) { result[i] = U(v[i]); });
+	return result;
+}
+
+//=================================================================================================
+
+
+//=================================  行列の作成関数  ==============================================
+// MakeMatrix.h の Matrix4x4 版はこれを float で呼ぶ
+
+template <typename T>
+constexpr Mat<4, 4, T> MakeTranslateMatrix(const Vec<3, T>& translate) {
+	Mat<4, 4, T> result = MakeIdentity<4, T>();
+	result.m[3][0] = translate.x;
+	result.m[3][1] = translate.y;
+	result.m[3][2] = translate.z;
+	return result;
+}
+
+template <typename T>
+constexpr Mat<4, 4, T> MakeScaleMatrix(const Vec<3, T>& scale) {
+	Mat<4, 4, T> result{};
+	result.m[0][0] = scale.x;
+	result.m[1][1] = scale.y;
+	result.m[2][2] = scale.z;
+	result.m[3][3] = T(1);
+	return result;
+}
+
+template <typename T>
+constexpr Mat<4, 4, T> MakeOrthographicMatrix(T left, T top, T right, T bottom, T nearClip, T farClip) {
+	Mat<4, 4, T> result{};
+	result.m[0][0] = T(2) / (right - left);
+	result.m[1][1] = T(2) / (top - bottom);
+	result.m[2][2] = T(1) / (farClip - nearClip);
+	result.m[3][0] = (left + right) / (left - right);
+	result.m[3][1] = (top + bottom) / (bottom - top);
+	result.m[3][2] = nearClip / (nearClip - farClip);
+	result.m[3][3] = T(1);
+	return result;
+}
+
+template <typename T>
+constexpr Mat<4, 4, T> MakeViewportMatrix(T left, T top, T width, T height, T minDepth, T maxDepth) {
+	Mat<4, 4, T> result{};
+	result.m[0][0] = width / T(2);
+	result.m[1][1] = -height / T(2);
+	result.m[2][2] = maxDepth - minDepth;
+	result.m[3][0] = left + width / T(2);
+	result.m[3][1] = top + height / T(2);
+	result.m[3][2] = minDepth;
+	result.m[3][3] = T(1);
+	return result;
+}
+
+//=================================================================================================
@@ -0,0 +1,112 @@
+#pragma once
+#include "Geometry.h"
+#include "VectorMatrix.h"
+#include <cmath>
+#include <cstdint>
+
+// 広いワールド (数十 km) をカメラの近くを原点にして描くための座標変換
+//
+// float は 10 km 離れると 1mm ほどの刻みしかなく、カメラ行列や逆行列の計算でさらに誤差が増える
+// そこでワールドの位置は double (Vec3d) で持ち、フレームの最初に1回だけ
+// 「カメラの近くの点 (原点) からの差」を double で計算して float に落とす
+// 描画関数 (DebugDraw.h) や衝突判定 (CollisionWorld.h など) は今まで通り float のまま、原点からの座標で扱う
+//
+//   worldOrigin.Rebase(cameraWorld);                     // 原点をカメラに合わせる
+//   Vector3 camera = worldOrigin.ToLocal(cameraWorld);   // (0, 0, 0) になる
+//   worldOrigin.ToLocal(worldPoints, localPoints, count);
+//   Sphere sphere = worldOrigin.ToLocal(worldSphere);
+//
+// 頂点ごとの計算 (変換・クリップ・衝突判定) は float のままなので、double の負荷は原点からの差の計算だけ
+
+
+//=================================  ワールド座標の図形  ===========================================
+// 位置だけ double で持つ (大きさ・向きはワールドのどこでも同じ精度で足りる)
+
+struct WorldSphere {
+	Vec3d center;
+	float radius;
+};
+
+struct WorldAABB {
+	Vec3d min;
+	Vec3d max;
+};
+
+struct WorldPlane {
+	Vector3 normal;   //!< 正規化しておく
+	double distance;  //!< ワールドの原点からの距離
+};
+
+struct WorldSegment {
+	Vec3d origin;
+	Vector3 diff;
+};
+
+//=================================================================================================
+
+
+//=====================================  ワールドの原点  ==========================================
+
+class WorldOrigin {
+public:
+	// rebaseDistance: 原点とカメラがこれより離れたら原点を動かす
+	// 0 なら毎フレーム動かす (カメラが常に原点にあり、ビュー行列に平行移動が入らない)
+	// 原点からの座標を CollisionWorld などにためているときは大きくして、Rebase が true を返したときだけ作り直す
+	explicit WorldOrigin(double rebaseDistance = 0.0) : rebaseDistance_(rebaseDistance) {}
+
+	// 原点を動かしたら true
+	bool Rebase(const Vec3d& cameraPosition) {
+		Vec3d diff = cameraPosition - origin_;
+		if (rebaseDistance_ > 0.0 && LengthSquared(diff) <= rebaseDistance_ * rebaseDistance_) {
+			return false;
+		}
+		origin_ = cameraPosition;
+		return true;
+	}
+
+	const Vec3d& GetOrigin() const { return origin_; }
+
+	//---------------------------------- ワールド → 原点から ----------------------------------
+
+	// 引き算を double で行ってから float にする (先に float にすると大きな値の下の桁が消える)
+	Vector3 ToLocal(const Vec3d& position) const {
+		return { float(position.x - origin_.x), float(position.y - origin_.y), float(position.z - origin_.z) };
+	}
+
+	void ToLocal(const Vec3d* src, Vector3* dst, uint32_t count) const {
+		for (uint32_t i = 0; i < count; ++i) {
+			dst[i] = ToLocal(src[i]);
+		}
+	}
+
+	Sphere ToLocal(const WorldSphere& sphere) const {
+		return { ToLocal(sphere.center), sphere.radius };
+	}
+
+	AABB ToLocal(const WorldAABB& aabb) const {
+		return { ToLocal(aabb.min), ToLocal(aabb.max) };
+	}
+
+	// n・(x + origin) = d なので、原点からの距離は d - n・origin
+	Plane ToLocal(const WorldPlane& plane) const {
+		double distance = plane.distance - (double(plane.normal.x) * origin_.x + double(plane.normal.y) * origin_.y + double(plane.normal.z) * origin_.z);
+		return { plane.normal, float(distance) };
+	}
+
+	Segment ToLocal(const WorldSegment& segment) const {
+		return { ToLocal(segment.origin), segment.diff };
+	}
+
+	//---------------------------------- 原点から → ワールド ----------------------------------
+
+	// 衝突判定の結果 (接触点など) をワールドに戻すとき
+	Vec3d ToWorld(const Vector3& position) const {
+		return { origin_.x + double(position.x), origin_.y + double(position.y), origin_.z + double(position.z) };
+	}
+
+private:
+	Vec3d origin_ = { 0.0, 0.0, 0.0 };
+	double rebaseDistance_;
+};
+
+//=================================================================================================
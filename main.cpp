@@ -1,4 +1,9 @@
 #include "MyMath.h"
+#include "Arena.h"
+#include "FrameGraph.h"
+#include "ProfilerWindow.h"
+#include "WorldOrigin.h"
+#include <span>
 #include <imgui.h>
 
 const char kWindowTitle[] = "LC1C_19_タイラタクヤ_タイトル";
@@ -11,28 +16,117 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	// ライブラリの初期化
 	Novice::Initialize(kWindowTitle, 1280, 720);
 
+	// 各処理の時間を測る (Profiler ウィンドウで止められる)
+	GetProfiler().SetEnabled(true);
+
 	// キー入力結果を受け取る箱
 	char keys[256] = { 0 };
 	char preKeys[256] = { 0 };
 
-	// カメラの座標
+	// カメラの座標 (位置はワールド座標なので double)
 	Vector3 cameraScale = { 1.0f, 1.0f, 1.0f };
 	Vector3 cameraRotate = { 0.26f, 0.0f, 0.0f };
-	Vector3 cameraTranslate = { 0.0f, 1.9f, -6.49f };
+	Vec3d cameraTranslate = { 0.0, 1.9, -6.49 };
 	const int kWindowWidth = 1280;
 	const int kWindowHeight = 720;
-
-	// 各点
-	Vector3 controlPoint[3] = {
-		{-0.8f, 0.58f, 1.0f},
-		{1.76f, 1.0f, -0.3f},
-		{0.94f, -0.7f, 2.3f},
+	// ビューポート変換 (定数なのでコンパイル時に計算される)
+	constexpr Matrix4x4 kViewportMatrix = MakeViewportMatrix(0.0f, 0.0f, float(kWindowWidth), float(kWindowHeight), 0.0f, 1.0f);
+
+	// 各点 (ワールド座標)
+	Vec3d controlPointWorld[3] = {
+		{-0.8, 0.58, 1.0},
+		{1.76, 1.0, -0.3},
+		{0.94, -0.7, 2.3},
 	};
 
+	// 描画はカメラの近くの原点からの float の座標で行う (ワールドの原点から遠くても精度が落ちない)
+	// カメラが原点から 1km 離れたら原点をカメラに移す (1km 以内なら float でも 0.1mm より細かい)
+	const double kRebaseDistance = 1000.0;
+	WorldOrigin worldOrigin(kRebaseDistance);
+	Vector3 controlPoint[3];  //!< controlPointWorld を原点からの座標にしたもの
+	Vector3 gridCenter;       //!< ワールドの原点を原点からの座標にしたもの
+
+	// ジョブシステム (メインスレッドも含めてハードウェアのスレッド数で動かす)
+	JobSystem jobSystem;
+
+	// 描画関数の線はスレッドごとにためて lineBatch にまとめ、フレームの最後に1回で描く
+	LineBatch lineBatch;
+	ThreadLineBatches threadLineBatches(jobSystem);
+	NoviceLineBackend lineBackend;
+
+	// フレームの間だけ使うメモリ (スレッドごと。BeginFrame の直後に空にする)
+	FrameArena frameArena(jobSystem);
+
+	//=====================================  1フレームの処理  ==========================================
+	// 更新 → カリング → 線の生成 → まとめる の順に依存するパス (Novice は呼ばない)
+
+	ScreenTransform screenTransform;
+	std::span<const uint32_t> visibleControlPoints;  //!< frameArena に置く
+	FrameGraph frameGraph;
+
+	uint32_t updatePass = frameGraph.AddPass("update", [&] {
+		// 必要なら原点をカメラに移し、ワールド座標をそこからの座標にする (double を使うのはここだけ)
+		worldOrigin.Rebase(cameraTranslate);
+		worldOrigin.ToLocal(controlPointWorld, controlPoint, 3);
+		gridCenter = worldOrigin.ToLocal(Vec3d{ 0.0, 0.0, 0.0 });
+		// カメラ
+		Matrix4x4 cameraMatrix;
+		{
+			MT3_PROFILE_ZONE("MakeAffineMatrix");
+			cameraMatrix = MakeAffineMatrix(cameraScale, cameraRotate, worldOrigin.ToLocal(cameraTranslate));
+		}
+		// ビュー
+		Matrix4x4 viewMatrix;
+		{
+			MT3_PROFILE_ZONE("InverseAffine");
+			viewMatrix = InverseAffine(cameraMatrix);
+		}
+		// 透視投影 (ReverseZ: 遠くの深度の精度を残す)
+		Matrix4x4 projectMatrix = MakePerspectiveFovMatrixReverseZ(0.45f, float(kWindowWidth) / float(kWindowHeight), 0.1f, 100.0f);
+		// ワールド → スクリーン (描画関数はこれで1回だけ変換する)
+		screenTransform = MakeScreenTransform(viewMatrix, projectMatrix, kViewportMatrix, kDepthReverseZ);
+	});
+
+	uint32_t cullPass = frameGraph.AddPass("cull", [&] {
+		LinearArena& arena = frameArena.GetThreadArena();
+		uint32_t* visible = arena.AllocateArray<uint32_t>(3);
+		uint32_t visibleCount = 0;
+		for (uint32_t index = 0; index < 3; ++index) {
+			if (IsVisible(screenTransform.frustum, Sphere{ controlPoint[index], 0.01f })) {
+				visible[visibleCount++] = index;
+			}
+		}
+		visibleControlPoints = { visible, visibleCount };
+	}, { updatePass });
+
+	uint32_t tessellatePass = frameGraph.AddPass("tessellate", [&] {
+		// 0: グリッド線、1: ベジェ曲線、2～: 見えているベジェ曲線の各点
+		jobSystem.ParallelFor(2 + uint32_t(visibleControlPoints.size()), 1, [&](uint32_t begin, uint32_t end) {
+			SetLineBatch(&threadLineBatches.Get());
+			for (uint32_t item = begin; item < end; ++item) {
+				if (item == 0) {
+					DrawGrid(screenTransform, gridCenter);
+				} else if (item == 1) {
+					DrawBezier(controlPoint[0], controlPoint[1], controlPoint[2], screenTransform, BLUE);
+				} else {
+					DrawSphere(Sphere{ controlPoint[visibleControlPoints[item - 2]], 0.01f }, screenTransform, BLACK);
+				}
+			}
+			SetLineBatch(nullptr);
+		});
+	}, { cullPass });
+
+	frameGraph.AddPass("submit", [&] {
+		threadLineBatches.MergeInto(lineBatch);
+	}, { tessellatePass });
+
+	//=================================================================================================
+
 	// ウィンドウの×ボタンが押されるまでループ
 	while (Novice::ProcessMessage() == 0) {
 		// フレームの開始
 		Novice::BeginFrame();
+		frameArena.Reset();
 
 		// キー入力を受け取る
 		memcpy(preKeys, keys, 256);
@@ -44,19 +138,11 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 		/// 
 
 
-		//========================================  ビュー関連  ===========================================
-
-		// カメラ
-		Matrix4x4 cameraMatrix = MakeAffineMatrix(cameraScale, cameraRotate, cameraTranslate);
-		// ビュー
-		Matrix4x4 viewMatrix = Inverse(cameraMatrix);
-		// 透視投影
-		Matrix4x4 projectMatrix = MakePerspectiveFovMatrix(0.45f, float(kWindowWidth) / float(kWindowHeight), 0.1f, 100.0f);
-		Matrix4x4 viewProjectionMatrix = Multiply(viewMatrix, projectMatrix);
-		// ビューポート変換
-		Matrix4x4 viewportMatrix = MakeViewportMatrix(0, 0, float(kWindowWidth), float(kWindowHeight), 0.0f, 1.0f);
-
-		//=================================================================================================
+		// ビュー関連の計算から線の生成まで (ジョブシステムで並列に行う)
+		{
+			MT3_PROFILE_ZONE("FrameGraph::Execute");
+			frameGraph.Execute(jobSystem);
+		}
 
 	
 		///
@@ -68,16 +154,11 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 		///
 
 
-		// グリッド線の描画
-		DrawGrid(viewProjectionMatrix, viewportMatrix);
-
-		// ベジェ曲線の描画
-		DrawBezier(controlPoint[0], controlPoint[1], controlPoint[2], viewProjectionMatrix, viewportMatrix, BLUE);
-
-		// ベジェ曲線の各点の描画
-		DrawSphere(Sphere{ controlPoint[0], 0.01f }, viewProjectionMatrix, viewportMatrix, BLACK);
-		DrawSphere(Sphere{ controlPoint[1], 0.01f }, viewProjectionMatrix, viewportMatrix, BLACK);
-		DrawSphere(Sphere{ controlPoint[2], 0.01f }, viewProjectionMatrix, viewportMatrix, BLACK);
+		// グリッド線・ベジェ曲線・ベジェ曲線の各点 (更新処理でためた線をまとめて描く)
+		{
+			MT3_PROFILE_ZONE("LineBatch::Flush");
+			lineBatch.Flush(lineBackend);
+		}
 
 
 		// ImGui
@@ -85,19 +166,25 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 		if (ImGui::CollapsingHeader("camera")) {
 			ImGui::DragFloat3("cameraScale", &cameraScale.x, 0.01f);
 			ImGui::DragFloat3("cameraRotate", &cameraRotate.x, 0.01f);
-			ImGui::DragFloat3("cameraTranslate", &cameraTranslate.x, 0.01f);
+			ImGui::DragScalarN("cameraTranslate", ImGuiDataType_Double, &cameraTranslate.x, 3, 0.01f);
 		}
 		if (ImGui::CollapsingHeader("Bezier")) {
-			ImGui::DragFloat3("controlPoint[0]", &controlPoint[0].x, 0.01f);
-			ImGui::DragFloat3("controlPoint[1]", &controlPoint[1].x, 0.01f);
-			ImGui::DragFloat3("controlPoint[2]", &controlPoint[2].x, 0.01f);
+			ImGui::DragScalarN("controlPoint[0]", ImGuiDataType_Double, &controlPointWorld[0].x, 3, 0.01f);
+			ImGui::DragScalarN("controlPoint[1]", ImGuiDataType_Double, &controlPointWorld[1].x, 3, 0.01f);
+			ImGui::DragScalarN("controlPoint[2]", ImGuiDataType_Double, &controlPointWorld[2].x, 3, 0.01f);
 		}
 		ImGui::End();
 
+		// 前のフレームまでに測った時間
+		DrawProfilerWindow();
+
 		///
 		/// ↑描画処理ここまで
 		///
 
+		// このフレームで測った時間を集計する
+		GetProfiler().EndFrame();
+
 		// フレームの終了
 		Novice::EndFrame();
 